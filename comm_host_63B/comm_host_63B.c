@@ -25,66 +25,267 @@
 
 #include "oled_ssd1306_63B.h"
 #include "sle_server_63B.h"
+#include "sle_server_conn.h"
+#include "sle_server_rxq.h"
 
 #define STACK_SIZE (4096)
 #define DISPLAY_TASK_STACK_SIZE (2048)
+#define DISPLAY_LINE_MAX (4)     // 屏幕下半部分最多显示的产线数
+#define DISPLAY_LINE_PAGE_CYCLES (4) // 产线超过一屏时分页轮流显示，每页停留的刷新周期数
+#define DISPLAY_PERIOD_MS (500)
+// 链路调试页: 每隔N个刷新周期插入一次，停留M个周期；N为0时不显示
+#define DISPLAY_DEBUG_EVERY (20)
+#define DISPLAY_DEBUG_CYCLES (4)
+// 速率趋势页: 与调试页使用同一周期，错开半个周期插入
+#define DISPLAY_TREND_OFFSET (10)
+#define DISPLAY_TREND_CYCLES (4)
 
 /****************************
          显示任务
 ****************************/
+// 时延按0.1ms显示
+static void FormatLatency(char *buf, size_t size, uint32_t us)
+{
+    snprintf(buf, size, "%u.%u", us / 1000, (us % 1000) / 100);
+}
+
+// 链路调试页: RSSI、请求/确认计数、时延分位、断开原因、已连接与寻找中的时长
+static void DisplayDebugPage(void)
+{
+    sle_cargo_telem_t t = {0};
+    char line[22];  // 6x8字体每行最多21个字符
+    char max[10];
+    char p50[10];
+    char p99[10];
+    uint32_t now = osKernelGetTickCount();
+    uint8_t cap = 0;
+    uint8_t conn_count = sle_server_get_conn_count(&cap);
+    sle_server_get_telemetry(&t);
+    uint32_t up = sle_cargo_telem_link_ms(&t, SLE_CARGO_LINK_CONNECTED, now) / 1000;
+    uint32_t search = sle_cargo_telem_link_ms(&t, SLE_CARGO_LINK_SEARCHING, now) / 1000;
+
+    OledFillScreen(0);
+    snprintf(line, sizeof(line), "LINK %u/%u UP %u%%", conn_count, cap,
+             (up + search > 0) ? (uint32_t)((uint64_t)up * 100 / (up + search)) : 0);
+    OledShowString(0, 0, line, FONT6_X8);
+    if (t.rssi_samples > 0) {
+        snprintf(line, sizeof(line), "RSSI %d avg %d", t.rssi_last, sle_cargo_telem_rssi_avg(&t));
+        OledShowString(0, 1, line, FONT6_X8);
+        snprintf(line, sizeof(line), "RSSI %d..%d", t.rssi_min, t.rssi_max);
+        OledShowString(0, 2, line, FONT6_X8);
+    } else {
+        OledShowString(0, 1, "RSSI --", FONT6_X8);
+    }
+    snprintf(line, sizeof(line), "REQ %u OK %u", t.issued, t.confirmed);
+    OledShowString(0, 3, line, FONT6_X8);
+    FormatLatency(max, sizeof(max), t.lat_max_us);
+    snprintf(line, sizeof(line), "FAIL %u MAX %sms", t.failed, max);
+    OledShowString(0, 4, line, FONT6_X8);
+    FormatLatency(p50, sizeof(p50), sle_cargo_telem_lat_percentile(&t, 50));
+    FormatLatency(p99, sizeof(p99), sle_cargo_telem_lat_percentile(&t, 99));
+    snprintf(line, sizeof(line), "P50 %s P99 %sms", p50, p99);
+    OledShowString(0, 5, line, FONT6_X8);
+    // 断开次数和最常见的两种原因
+    int len = snprintf(line, sizeof(line), "DISC %u", t.disconnects);
+    for (uint8_t i = 0; i < t.disc_kinds && i < 2 && len > 0 && len < (int)sizeof(line); i++) {
+        len += snprintf(line + len, sizeof(line) - len, " %02x:%u", t.disc[i].reason, t.disc[i].count);
+    }
+    OledShowString(0, 6, line, FONT6_X8);
+    snprintf(line, sizeof(line), "UP %us SRCH %us", up, search);
+    OledShowString(0, 7, line, FONT6_X8);
+}
+
+// 把一组件数画成一行字符趋势图，按组内最大值分8级，非0的点至少画一级
+static void FormatSpark(char *buf, const uint32_t *points, uint8_t count)
+{
+    static const char levels[] = " .:-=+*#";
+    uint32_t max = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        max = (points[i] > max) ? points[i] : max;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        uint32_t level = (max > 0) ? (uint32_t)((uint64_t)points[i] * 7 / max) : 0;
+        buf[i] = levels[(points[i] > 0 && level == 0) ? 1 : level];
+    }
+    buf[count] = '\0';
+}
+
+// 速率趋势页: 各地区最近1分钟/10分钟/1小时的每分钟件数，1小时和1天的趋势，1天内的峰值
+static void DisplayTrendPage(void)
+{
+    static const char *names[SLE_CARGO_REGION_MAX] = { "JS", "ZJ", "SH" };
+    static sle_server_rate_summary_t s;
+    char line[22];  // 6x8字体每行最多21个字符
+    char spark[SLE_SERVER_RATE_SPARK_POINTS + 1];
+    sle_server_get_rate_summary(&s);
+
+    OledFillScreen(0);
+    OledShowString(0, 0, "RATE/MIN  1M 10M  1H", FONT6_X8);
+    uint32_t all[SLE_SERVER_RATE_WINDOWS] = {0};
+    for (uint8_t r = 0; r < SLE_CARGO_REGION_MAX; r++) {
+        snprintf(line, sizeof(line), "%-8s%4u%4u%4u", names[r], s.per_min[SLE_SERVER_RATE_1M][r],
+                 s.per_min[SLE_SERVER_RATE_10M][r], s.per_min[SLE_SERVER_RATE_1H][r]);
+        OledShowString(0, 1 + r, line, FONT6_X8);
+        for (uint8_t w = 0; w < SLE_SERVER_RATE_WINDOWS; w++) {
+            all[w] += s.per_min[w][r];
+        }
+    }
+    snprintf(line, sizeof(line), "%-8s%4u%4u%4u", "ALL", all[SLE_SERVER_RATE_1M], all[SLE_SERVER_RATE_10M],
+             all[SLE_SERVER_RATE_1H]);
+    OledShowString(0, 4, line, FONT6_X8);
+    FormatSpark(spark, s.hour, SLE_SERVER_RATE_SPARK_POINTS);
+    snprintf(line, sizeof(line), "1H %s", spark);
+    OledShowString(0, 5, line, FONT6_X8);
+    FormatSpark(spark, s.day, SLE_SERVER_RATE_SPARK_POINTS);
+    snprintf(line, sizeof(line), "1D %s", spark);
+    OledShowString(0, 6, line, FONT6_X8);
+    if (s.peak_per_min > 0) {
+        snprintf(line, sizeof(line), "PEAK %u/m %um ago", s.peak_per_min, s.peak_age_min);
+    } else {
+        snprintf(line, sizeof(line), "PEAK --");
+    }
+    OledShowString(0, 7, line, FONT6_X8);
+}
+
+// 压测结果页: 吞吐、帧率、丢失、乱序/重复和到达抖动
+static void DisplayBenchPage(const sle_cargo_bench_report_t *r)
+{
+    char line[22];  // 6x8字体每行最多21个字符
+    char jitter[10];
+    uint32_t loss = sle_cargo_bench_loss_bp(r);
+
+    OledFillScreen(0);
+    snprintf(line, sizeof(line), "BENCH #%u %s", r->run_id, ((r->flags & SLE_CARGO_BENCH_LAST) != 0) ? "DONE" : "RUN");
+    OledShowString(0, 0, line, FONT6_X8);
+    snprintf(line, sizeof(line), "LEN %uB %ums", r->frame_len, r->elapsed_ms);
+    OledShowString(0, 1, line, FONT6_X8);
+    snprintf(line, sizeof(line), "FRAMES %u", r->frames);
+    OledShowString(0, 2, line, FONT6_X8);
+    snprintf(line, sizeof(line), "RATE %ukbps", sle_cargo_bench_bps(r) / 1000);
+    OledShowString(0, 3, line, FONT6_X8);
+    uint32_t fps = (r->elapsed_ms > 0) ? (uint32_t)((uint64_t)r->frames * 1000 / r->elapsed_ms) : 0;
+    snprintf(line, sizeof(line), "FPS %u", fps);
+    OledShowString(0, 4, line, FONT6_X8);
+    snprintf(line, sizeof(line), "LOST %u %u.%02u%%", r->lost, loss / 100, loss % 100);
+    OledShowString(0, 5, line, FONT6_X8);
+    snprintf(line, sizeof(line), "REORD %u DUP %u", r->reordered, r->dups);
+    OledShowString(0, 6, line, FONT6_X8);
+    FormatLatency(jitter, sizeof(jitter), r->jitter_us);
+    snprintf(line, sizeof(line), "JITTER %sms", jitter);
+    OledShowString(0, 7, line, FONT6_X8);
+}
+
 static void DisplayTask(void *arg)
 {
     unused(arg);
     
     printf("=== DisplayTask START ===\r\n");
     
+    uint32_t cycle = 0;
+    bool drawn = false;          // 屏幕上是货物页
+    uint32_t drawn_gen = 0;      // 货物页所显示快照的代数
+    uint32_t drawn_slot = 0;     // 货物页所显示的翻页时段
+    uint8_t drawn_pages = 0;     // 货物页的产线页数
     while (1) {
-        cargo_info_t cargo_info = {0};
+        // 调试页期间不回报上屏状态，客户端看到的显示滞后如实增加
+        cycle++;
+        // 广播调度按显示周期检查是否该放慢广播
+        sle_server_announce_update();
+        // 压测运行中及结束后一段时间只显示压测结果页
+        sle_cargo_bench_report_t bench;
+        if (sle_server_bench_poll(&bench)) {
+            DisplayBenchPage(&bench);
+            drawn = false;
+            osDelay(DISPLAY_PERIOD_MS);
+            continue;
+        }
+        if (DISPLAY_DEBUG_EVERY > 0 && (cycle % DISPLAY_DEBUG_EVERY) < DISPLAY_DEBUG_CYCLES) {
+            DisplayDebugPage();
+            drawn = false;
+            osDelay(DISPLAY_PERIOD_MS);
+            continue;
+        }
+        if (DISPLAY_DEBUG_EVERY > 0 &&
+            (cycle + DISPLAY_DEBUG_EVERY - DISPLAY_TREND_OFFSET) % DISPLAY_DEBUG_EVERY < DISPLAY_TREND_CYCLES) {
+            DisplayTrendPage();
+            drawn = false;
+            osDelay(DISPLAY_PERIOD_MS);
+            continue;
+        }
+
+        // 快照没有变化时不必读取和重画；否则一次读出全场合计、各产线和连接数，三者属于同一时刻
+        // 产线超过一屏时到了翻页时刻也要重画
+        static sle_server_cargo_view_t view;
+        uint32_t page_slot = cycle / DISPLAY_LINE_PAGE_CYCLES;
+        bool page_due = (drawn_pages > 1 && page_slot != drawn_slot);
+        if ((drawn && !page_due && sle_server_get_cargo_generation() == drawn_gen) ||
+            !sle_server_get_cargo_view(&view)) {
+            osDelay(DISPLAY_PERIOD_MS);
+            continue;
+        }
+        drawn = true;
+        drawn_gen = view.generation;
+        drawn_slot = page_slot;
+        drawn_pages = (uint8_t)((view.count + DISPLAY_LINE_MAX - 1) / DISPLAY_LINE_MAX);
+        const cargo_info_t *cargo_info = &view.hall;
+        char line[22];  // 6x8字体每行最多21个字符
         
         // 清空屏幕
         OledFillScreen(0);
         
-        // 显示标题
-        OledShowString(0, 0, "CARGO SORT", FONT6_X8);
+        // 显示标题和接入的分拣板数
+        snprintf(line, sizeof(line), "CARGO HALL %u/%u", view.count, view.cap);
+        OledShowString(0, 0, line, FONT6_X8);
         
-        // 获取货物信息并显示
-        bool connected = sle_server_is_connected();
-        if (connected && sle_server_get_cargo_info(&cargo_info)) {
-            // 显示连接状态
-            OledShowString(0, 1, "SLE: OK", FONT6_X8);
+        // 获取全场合计并显示
+        bool connected = (view.count > 0);
+        if (connected && cargo_info->valid) {
+            // 全场合计
+            snprintf(line, sizeof(line), "JS:%u ZJ:%u", cargo_info->jiangsu, cargo_info->zhejiang);
+            OledShowString(0, 1, line, FONT6_X8);
             
-            // 显示货物分拣信息 - 使用简化字符串
-            char line[16];  // 减小缓冲区
-            memset(line, 0, sizeof(line));  // 确保清零
-            snprintf(line, sizeof(line), "JS:%u", cargo_info.jiangsu);
+            snprintf(line, sizeof(line), "SH:%u ALL:%u", cargo_info->shanghai,
+                     cargo_info->jiangsu + cargo_info->zhejiang + cargo_info->shanghai);
             OledShowString(0, 2, line, FONT6_X8);
+
+            // 最近一件货物的产线、编号和与该产线上一件的间隔
+            if (cargo_info->events > 0) {
+                snprintf(line, sizeof(line), "L%u ID:%02X %ums", cargo_info->line, cargo_info->last_id,
+                         cargo_info->last_gap_ms);
+                OledShowString(0, 3, line, FONT6_X8);
+            }
+
+            // 各产线: 江苏/浙江/上海，超过一屏时按页轮流显示
+            uint8_t first = (uint8_t)((drawn_slot % drawn_pages) * DISPLAY_LINE_MAX);
+            uint8_t line_count = (view.count - first < DISPLAY_LINE_MAX) ? (view.count - first) : DISPLAY_LINE_MAX;
+            const cargo_info_t *lines = &view.lines[first];
+            for (uint8_t i = 0; i < line_count; i++) {
+                if (lines[i].valid) {
+                    snprintf(line, sizeof(line), "L%u %u/%u/%u", lines[i].line, lines[i].jiangsu,
+                             lines[i].zhejiang, lines[i].shanghai);
+                } else {
+                    snprintf(line, sizeof(line), "L%u wait data", lines[i].line);
+                }
+                OledShowString(0, 4 + i, line, FONT6_X8);
+            }
             
-            memset(line, 0, sizeof(line));
-            snprintf(line, sizeof(line), "ZJ:%u", cargo_info.zhejiang);
-            OledShowString(0, 3, line, FONT6_X8);
-            
-            memset(line, 0, sizeof(line));
-            snprintf(line, sizeof(line), "SH:%u", cargo_info.shanghai);
-            OledShowString(0, 4, line, FONT6_X8);
-            
-            printf("Display cargo: JS=%u, ZJ=%u, SH=%u\r\n", 
-                   cargo_info.jiangsu, cargo_info.zhejiang, cargo_info.shanghai);
+            printf("Display cargo: lines=%u-%u/%u JS=%u, ZJ=%u, SH=%u gen=%u\r\n", first + 1,
+                   first + line_count, view.count, cargo_info->jiangsu, cargo_info->zhejiang, cargo_info->shanghai, view.generation);
+
+            // 回报本页已上屏的各产线状态，各WS63据此判断显示屏是否为最新；其他页的产线翻到时再回报
+            sle_server_display_shown(lines, line_count);
         } else {
             // 显示连接状态和等待信息
             if (connected) {
                 OledShowString(0, 1, "SLE: OK", FONT6_X8);
                 OledShowString(0, 2, "Wait data", FONT6_X8);
-                OledShowString(0, 3, "        ", FONT6_X8);  // 清空行
-                OledShowString(0, 4, "        ", FONT6_X8);  // 清空行
             } else {
                 OledShowString(0, 1, "SLE: Wait", FONT6_X8);
                 OledShowString(0, 2, "Connect  ", FONT6_X8);
-                OledShowString(0, 3, "        ", FONT6_X8);  // 清空行
-                OledShowString(0, 4, "        ", FONT6_X8);  // 清空行
             }
         }
         
-        osDelay(500); // 0.5秒更新一次
+        osDelay(DISPLAY_PERIOD_MS); // 0.5秒更新一次
     }
 }
 
@@ -106,6 +307,15 @@ static void MainEntry(void *arg)
     OledInit();
     printf("OLED initialization completed\r\n");
     
+#if SLE_SERVER_CONN_LOADTEST
+    // 负载测试在协议栈启动前运行，服务器初始化时会重新清空连接表
+    sle_server_conn_loadtest(SLE_SERVER_CONN_MAX, 500);
+#endif
+#if SLE_SERVER_LATCH_STRESS
+    // 快照读写压力测试，只用独立的快照，不涉及协议栈
+    sle_server_latch_stress(2000);
+#endif
+
     // 星闪服务器初始化
     printf("Initializing SLE Server...\r\n");
     errcode_t ret = sle_server_63B_init();
@@ -136,8 +346,57 @@ static void MainEntry(void *arg)
     // 主任务保持运行
     while (1) {
         osDelay(5000); // 每5秒输出一次状态
-        printf("Main task running, SLE connected: %s\r\n", 
-               sle_server_is_connected() ? "true" : "false");
+        uint8_t cap = 0;
+        uint8_t count = sle_server_get_conn_count(&cap);
+        printf("Main task running, SLE connections: %u/%u\r\n", count, cap);
+
+        // 链路遥测: RSSI每个周期读取一次，结果异步计入，下个周期打印
+        static char telem_line[SLE_CARGO_TELEM_LINE_LEN];
+        sle_cargo_telem_t telem;
+        sle_server_get_telemetry(&telem);
+        sle_cargo_telem_format(&telem, osKernelGetTickCount(), telem_line, sizeof(telem_line));
+        printf("SLE telemetry: %s\r\n", telem_line);
+        sle_server_sample_rssi();
+
+        // 广播调度: 当前档位及各调度的重连耗时和广播事件数
+        static char adv_line[256];
+        sle_server_announce_info_t adv;
+        sle_server_get_announce_info(&adv);
+        sle_server_announce_format(&adv, adv_line, sizeof(adv_line));
+        printf("SLE announce: %s\r\n", adv_line);
+
+        // 写请求队列: 排队深度、高水位、丢弃数和回调/排队时延
+        static char rxq_line[192];
+        sle_server_rxq_stats_t rxq;
+        sle_server_rxq_get_stats(&rxq);
+        sle_server_rxq_format(&rxq, rxq_line, sizeof(rxq_line));
+        printf("SLE rx queue: %s\r\n", rxq_line);
+
+        // 可读特征值: 对应的快照代数、编码次数、合并掉的更新和应答的读请求
+        sle_server_live_stats_t live;
+        sle_server_get_live_stats(&live);
+        printf("SLE live value: gen=%u encodes=%u coalesced=%u reads=%u\r\n", live.generation, live.encodes,
+               live.coalesced, live.reads);
+
+        // 板间对时: 各分拣板时钟的偏差、频差和往返，以及串口收到货物到63B应用、到上屏的单向时延
+        static sle_server_latency_t lat;
+        static char clock_line[SLE_CARGO_CLOCK_LINE_LEN];
+        uint32_t now = osKernelGetTickCount();
+        sle_server_get_latency(&lat);
+        for (uint8_t i = 0; i < lat.count; i++) {
+            sle_cargo_clock_format(&lat.clock[i], now, clock_line, sizeof(clock_line));
+            printf("SLE clock L%u: %s\r\n", lat.line[i], clock_line);
+        }
+        char rx50[10];
+        char rx99[10];
+        char disp50[10];
+        char disp99[10];
+        FormatLatency(rx50, sizeof(rx50), sle_cargo_clock_lat_percentile(&lat.rx, 50));
+        FormatLatency(rx99, sizeof(rx99), sle_cargo_clock_lat_percentile(&lat.rx, 99));
+        FormatLatency(disp50, sizeof(disp50), sle_cargo_clock_lat_percentile(&lat.display, 50));
+        FormatLatency(disp99, sizeof(disp99), sle_cargo_clock_lat_percentile(&lat.display, 99));
+        printf("SLE one-way: uart->rx n=%u p50=%sms p99=%sms | uart->display n=%u p50=%sms p99=%sms early=%u\r\n",
+               lat.rx.count, rx50, rx99, lat.display.count, disp50, disp99, lat.rx.early + lat.display.early);
     }
 }
 
@@ -14,6 +14,16 @@
  */
 
 #include "sle_server_63B.h"
+#include "sle_cargo_proto.h"
+#include "sle_cargo_sync.h"
+#include "sle_server_conn.h"
+#include "sle_server_announce.h"
+#include "sle_server_rxq.h"
+#include "sle_cargo_frag.h"
+#include "sle_cargo_connparam.h"
+#include "sle_cargo_latch.h"
+#include "sle_cargo_history.h"
+#include "sle_cargo_clock.h"
 #include "securec.h"
 #include "soc_osal.h"
 #include "sle_errcode.h"
@@ -21,6 +31,7 @@
 #include "sle_device_discovery.h"
 #include "sle_ssap_server.h"
 #include "cmsis_os2.h"
+#include "systick.h"
 #include "common_def.h"
 #include <stdio.h>
 #include <string.h>
@@ -32,18 +43,96 @@
 #define SLE_MTU_SIZE_DEFAULT 512
 #define SLE_ADV_HANDLE_DEFAULT 1
 
+// 通过notify发送大消息: 协议栈缓冲区满时的重试间隔与整条消息的超时
+#define SLE_SERVER_BULK_RETRY_MS 10
+#define SLE_SERVER_BULK_TIMEOUT_MS 2000
+// 重组完成的日志消息最多打印的字符数
+#define SLE_SERVER_BULK_LOG_PREVIEW 64
+// 压测结束后结果页保留的时长
+#define SLE_SERVER_BENCH_SHOW_MS 30000
+// 接收任务的栈大小，队列空闲时检查溢出的间隔，溢出日志的最小间隔
+#define SLE_SERVER_RX_TASK_STACK_SIZE 4096
+#define SLE_SERVER_RX_IDLE_MS 100
+#define SLE_SERVER_RX_DROP_LOG_MS 1000
+// 速率历史任务: 推进历史并分块导出，发送大消息时会阻塞，不放在接收任务和显示任务中
+#define SLE_SERVER_HIST_TASK_STACK_SIZE 2048
+#define SLE_SERVER_HIST_POLL_MS 500
+// 可读特征值最短的重新编码间隔，突发写入合并为一次更新
+#define SLE_SERVER_LIVE_MIN_MS 100
+// 速率摘要: 各统计窗口的细粒度桶数，趋势图每个点合并的桶数 (1小时/1天各18个点)
+#define SLE_SERVER_RATE_BUCKETS_1M 6
+#define SLE_SERVER_RATE_BUCKETS_10M 60
+#define SLE_SERVER_RATE_BUCKETS_1H 360
+#define SLE_SERVER_RATE_HOUR_PER_POINT 20
+#define SLE_SERVER_RATE_DAY_PER_POINT 80
+// 对时请求间隔: 同步后每2秒一次，刚接入时加快，尽快攒够样本
+#define SLE_SERVER_CLOCK_PING_MS 2000
+#define SLE_SERVER_CLOCK_FAST_MS 250
+
 // UUID定义 - 使用官方标准UUID  
 #define SLE_UUID_SERVER_SERVICE 0xABCD
 #define SLE_UUID_SERVER_NTF_REPORT 0x1122
 
 // 全局变量
-static cargo_info_t g_cargo_info = {0};
-static osMutexId_t g_cargo_mutex = NULL;
-static uint16_t g_sle_conn_hdl = 0;
+static osMutexId_t g_cargo_mutex = NULL;                  // 保护连接表
 static uint8_t g_server_id = 0;
 static uint16_t g_service_handle = 0;
 static uint16_t g_property_handle = 0;
-static bool g_sle_connected = false;
+static bool g_bulk_busy = false;                          // 大消息发送中，受g_cargo_mutex保护
+static sle_cargo_frag_tx_t g_bulk_tx;                     // 由持有g_bulk_busy的任务独占
+static uint8_t g_bulk_frame[SLE_CARGO_FRAG_FRAME_MAX];
+static sle_cargo_telem_t g_telem;                         // 链路遥测，受g_cargo_mutex保护
+static sle_cargo_bench_rx_t g_bench_rx;                   // 压测接收统计，受g_cargo_mutex保护
+static uint16_t g_bench_report_seq = 0;                   // 压测报告帧序号，受g_cargo_mutex保护
+// 货物状态快照: 在g_cargo_mutex内发布，显示任务等读者不加锁读取，不会阻塞接收任务
+static sle_server_cargo_view_t g_view_copy[2];
+static sle_server_cargo_view_t g_view_next;               // 发布前在此组装，受g_cargo_mutex保护
+static sle_cargo_latch_t g_view_latch;
+// 0x1122 特征的当前值: 全场合计编码成的快照帧，由接收任务限速更新，读请求回调不加锁读取
+static uint8_t g_live_copy[2][SLE_CARGO_SNAPSHOT_LEN];
+static sle_cargo_latch_t g_live_latch;
+static sle_server_live_stats_t g_live_stats;              // 更新侧只由接收任务写，reads只由读回调写
+static uint32_t g_live_tick = 0;                          // 最近一次编码的时刻
+
+// 速率历史的一次导出，分多块发送
+typedef struct {
+    bool pending;
+    uint16_t conn_id;
+    uint8_t tier;
+    uint16_t remaining;     // 还要导出的桶数
+    uint32_t end_ms;        // 下一块第一个桶的结束时刻，历史推进后据此重新定位
+    uint16_t sent;          // 已导出的桶数
+    uint16_t chunks;
+} sle_server_hist_export_t;
+
+// 分拣速率历史及其导出请求，受g_cargo_mutex保护；导出块缓冲区只由速率历史任务使用
+static sle_cargo_history_t g_history;
+static sle_server_hist_export_t g_hist_export;
+static uint8_t g_hist_chunk[SLE_CARGO_FRAG_MSG_MAX];
+// 单向时延: 分拣板串口收到货物到63B应用、到上屏，受g_cargo_mutex保护
+static sle_cargo_clock_lat_t g_lat_rx;
+static sle_cargo_clock_lat_t g_lat_display;
+
+static errcode_t sle_server_send_ack(uint16_t conn_id, uint8_t flags);
+static void sle_server_announce_apply(uint32_t interval);
+static errcode_t sle_server_notify_raw(uint16_t conn_id, uint8_t *msg, uint16_t msg_len);
+static void sle_server_history_poll(void);
+
+// 连接表或计数变化后发布新快照，调用者持有g_cargo_mutex
+static void sle_server_view_publish_locked(void)
+{
+    sle_server_cargo_view_t *view = &g_view_next;
+    (void)memset_s(view, sizeof(*view), 0, sizeof(*view));
+    sle_server_conn_hall_totals(&view->hall);
+    for (uint8_t i = 0; i < SLE_SERVER_CONN_MAX; i++) {
+        sle_server_conn_t *conn = sle_server_conn_at(i);
+        if (conn != NULL) {
+            view->lines[view->count++] = conn->info;
+        }
+    }
+    view->cap = sle_server_conn_get_cap();
+    sle_cargo_latch_publish(&g_view_latch, view);
+}
 
 // 基础UUID设置
 static uint8_t g_sle_base[] = {0x73, 0x6C, 0x65, 0x5F, 0x74, 0x65, 0x73, 0x74, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
@@ -73,115 +162,448 @@ static void sle_uuid_setu2(uint16_t u2, sle_uuid_t *out)
     encode2byte_little(&out->uuid[14], u2);
 }
 
-// 解析接收到的货物数据
-static bool parse_cargo_data(const char *data, uint16_t len, cargo_info_t *cargo)
+// 向压测发送端回报结果，并按表格一行打印；本轮第一次回报前先打印表头
+static void sle_server_bench_report(uint16_t conn_id, uint8_t line, const sle_cargo_bench_report_t *report,
+                                    uint16_t seq, bool header)
 {
-    if (data == NULL || cargo == NULL || len == 0) {
-        return false;
+    uint8_t msg[SLE_CARGO_BENCH_REPORT_LEN];
+    uint16_t msg_len = sle_cargo_encode_bench_report(msg, sizeof(msg), seq, report);
+    errcode_t ret = (msg_len > 0) ? sle_server_notify_raw(conn_id, msg, msg_len) : ERRCODE_FAIL;
+
+    uint32_t loss = sle_cargo_bench_loss_bp(report);
+    uint8_t phy = SLE_CARGO_PHY_1M;
+    if (g_cargo_mutex != NULL) {
+        osMutexAcquire(g_cargo_mutex, osWaitForever);
+        sle_server_conn_t *conn = sle_server_conn_find(conn_id);
+        phy = (conn != NULL) ? conn->phy : phy;
+        osMutexRelease(g_cargo_mutex);
     }
-    
-    // 拷贝数据到本地缓冲区确保字符串结束
-    char buffer[256] = {0};
-    if (len >= sizeof(buffer)) {
-        len = sizeof(buffer) - 1;
+    if (header) {
+        printf("[sle_server_63B] bench 产线 | run |  len |  frames |   kbps |  lost |  loss%%  | reord |  dup | "
+               "jitter |     ms | phy\r\n");
     }
-    memcpy_s(buffer, sizeof(buffer), data, len);
-    buffer[len] = '\0';
-    
-    printf("[sle_server_63B] parsing cargo data: %s\r\n", buffer);
-    
-    // 解析格式: "J:xxx,Z:xxx,S:xxx,T:timestamp"
-    uint32_t jiangsu = 0, zhejiang = 0, shanghai = 0;
-    uint64_t timestamp = 0;
-    
-    char *token = strtok(buffer, ",");
-    int parsed_count = 0;
-    
-    while (token != NULL && parsed_count < 4) {
-        if (strncmp(token, "J:", 2) == 0) {
-            jiangsu = (uint32_t)atoi(token + 2);
-            parsed_count++;
-        } else if (strncmp(token, "Z:", 2) == 0) {
-            zhejiang = (uint32_t)atoi(token + 2);
-            parsed_count++;
-        } else if (strncmp(token, "S:", 2) == 0) {
-            shanghai = (uint32_t)atoi(token + 2);
-            parsed_count++;
-        } else if (strncmp(token, "T:", 2) == 0) {
-            timestamp = (uint64_t)atoll(token + 2);
-            parsed_count++;
+    printf("[sle_server_63B] bench L%u   | %3u | %4u | %7u | %6u | %5u | %3u.%02u | %5u | %4u | %6u | %6u | %s%s%s\r\n",
+           line, report->run_id, report->frame_len, report->frames, sle_cargo_bench_bps(report) / 1000, report->lost,
+           loss / 100, loss % 100, report->reordered, report->dups, report->jitter_us, report->elapsed_ms,
+           sle_cargo_phy_name(phy), ((report->flags & SLE_CARGO_BENCH_LAST) != 0) ? " final" : "", (ret != ERRCODE_SUCC) ? " (未送达)" : "");
+}
+
+// 压测帧: 只在锁内统计，不打印、不回确认帧、不计入遥测，避免日志和确认拖慢被测链路
+static void sle_server_on_bench(uint16_t conn_id, const uint8_t *data, uint16_t len, uint64_t rx_us)
+{
+    sle_cargo_frame_t frame;
+    if (g_cargo_mutex == NULL || sle_cargo_decode(data, len, &frame) != SLE_CARGO_OK) {
+        return;
+    }
+
+    sle_cargo_bench_report_t report;
+    bool due = false;
+    bool header = false;
+    uint8_t line = 0;
+    uint16_t seq = 0;
+    osMutexAcquire(g_cargo_mutex, osWaitForever);
+    sle_server_conn_t *conn = sle_server_conn_find(conn_id);
+    if (conn != NULL) {
+        line = conn->line;
+        uint32_t now = osKernelGetTickCount();
+        due = sle_cargo_bench_rx_push(&g_bench_rx, conn_id, &frame.bench, now, (uint32_t)rx_us);
+        if (due) {
+            header = (g_bench_rx.report_tick == g_bench_rx.first_tick);
+            sle_cargo_bench_rx_report(&g_bench_rx, now, &report);
+            seq = g_bench_report_seq++;
         }
-        token = strtok(NULL, ",");
     }
-    
-    if (parsed_count >= 3) { // 至少要有J、Z、S三个数据
-        cargo->jiangsu = jiangsu;
-        cargo->zhejiang = zhejiang;
-        cargo->shanghai = shanghai;
-        cargo->timestamp = timestamp;
-        cargo->valid = true;
-        printf("[sle_server_63B] parsed cargo: J=%u, Z=%u, S=%u, T=%llu\r\n", 
-               jiangsu, zhejiang, shanghai, timestamp);
-        return true;
+    osMutexRelease(g_cargo_mutex);
+
+    if (due) {
+        sle_server_bench_report(conn_id, line, &report, seq, header);
     }
-    
-    printf("[sle_server_63B] parse failed, parsed_count=%d\r\n", parsed_count);
-    return false;
 }
 
-// 写入回调 - 接收客户端发送的货物数据
-static void ssaps_write_request_cbk(uint8_t server_id, uint16_t conn_id, 
-                                    ssaps_req_write_cb_t *write_cb_para, errcode_t status)
+// 一条产线的计数更新后把各地区的增量计入速率历史，调用者持有g_cargo_mutex。
+// 产线接入后的第一帧只建立基准，断开期间和分拣板重启造成的跳变不计入
+static void sle_server_history_feed_locked(const cargo_info_t *before, const cargo_info_t *after, uint32_t now)
 {
-    printf("[sle_server_63B] ===== 写请求回调被触发 =====\r\n");
-    printf("[sle_server_63B] server_id=%d, conn_id=%d, status=0x%x\r\n", 
-           server_id, conn_id, status);
-    
-    if (status != ERRCODE_SUCC) {
-        printf("[sle_server_63B] ❌ 写请求失败，状态码=0x%x\r\n", status);
+    if (!before->valid || !after->valid) {
         return;
     }
-    
-    if (write_cb_para == NULL) {
-        printf("[sle_server_63B] write_cb_para is NULL\r\n");
+    uint32_t delta[SLE_CARGO_REGION_MAX] = {
+        (after->jiangsu > before->jiangsu) ? after->jiangsu - before->jiangsu : 0,
+        (after->zhejiang > before->zhejiang) ? after->zhejiang - before->zhejiang : 0,
+        (after->shanghai > before->shanghai) ? after->shanghai - before->shanghai : 0,
+    };
+    if (delta[SLE_CARGO_REGION_JIANGSU] == 0 && delta[SLE_CARGO_REGION_ZHEJIANG] == 0 &&
+        delta[SLE_CARGO_REGION_SHANGHAI] == 0) {
         return;
     }
-    
-    printf("[sle_server_63B] write request: handle=0x%04x, type=%d, length=%d\r\n",
-           write_cb_para->handle, write_cb_para->type, write_cb_para->length);
-    
-    if (write_cb_para->value == NULL || write_cb_para->length == 0) {
-        printf("[sle_server_63B] invalid data: value=%p, length=%d\r\n", 
-               write_cb_para->value, write_cb_para->length);
+    sle_cargo_history_add(&g_history, delta, now);
+}
+
+// 速率历史导出请求: 只登记，由速率历史任务分块发送，不占用接收任务；同一时间只服务一个请求
+static void sle_server_on_hist_req(uint16_t conn_id, const uint8_t *data, uint16_t len)
+{
+    sle_cargo_frame_t frame;
+    if (sle_cargo_decode(data, len, &frame) != SLE_CARGO_OK || frame.hist_req.tier >= SLE_CARGO_HIST_TIERS) {
+        printf("[sle_server_63B] invalid history request from 0x%04x\r\n", conn_id);
         return;
     }
-    
-    // 打印接收到的原始数据（用于调试）
-    printf("[sle_server_63B] received raw data: ");
-    for (uint16_t i = 0; i < write_cb_para->length && i < 64; i++) {
-        printf("%c", write_cb_para->value[i]);
+
+    uint8_t tier = frame.hist_req.tier;
+    bool accepted = false;
+    uint16_t filled = 0;
+    osMutexAcquire(g_cargo_mutex, osWaitForever);
+    sle_server_conn_t *conn = sle_server_conn_find(conn_id);
+    if (conn != NULL && conn->wire == SLE_CARGO_WIRE_BINARY && !g_hist_export.pending) {
+        sle_cargo_history_advance(&g_history, osKernelGetTickCount());
+        const sle_cargo_hist_tier_t *t = &g_history.tier[tier];
+        filled = t->filled;
+        if (filled > 0) {
+            sle_server_hist_export_t *ex = &g_hist_export;
+            (void)memset_s(ex, sizeof(*ex), 0, sizeof(*ex));
+            ex->conn_id = conn_id;
+            ex->tier = tier;
+            ex->remaining = (frame.hist_req.buckets > 0 && frame.hist_req.buckets < filled) ?
+                            frame.hist_req.buckets : filled;
+            ex->end_ms = t->start_ms;
+            ex->pending = true;
+            accepted = true;
+        }
     }
-    printf("\r\n");
-    
-    // 解析货物数据
-    cargo_info_t new_cargo = {0};
-    if (parse_cargo_data((const char *)write_cb_para->value, write_cb_para->length, &new_cargo)) {
-        // 更新全局货物信息
-        if (g_cargo_mutex != NULL) {
-            osMutexAcquire(g_cargo_mutex, osWaitForever);
-            g_cargo_info = new_cargo;
-            osMutexRelease(g_cargo_mutex);
-            
-            printf("[sle_server_63B] ✓ Cargo data updated: J=%u, Z=%u, S=%u\r\n",
-                   new_cargo.jiangsu, new_cargo.zhejiang, new_cargo.shanghai);
+    osMutexRelease(g_cargo_mutex);
+    printf("[sle_server_63B] history request from 0x%04x: tier=%u buckets=%u (have %u) %s\r\n", conn_id, tier,
+           frame.hist_req.buckets, filled, accepted ? "queued" : "rejected");
+}
+
+// 对时回复: t4 取写入回调的时刻，扣除在写请求队列中的等待，不打印
+static void sle_server_on_clock(uint16_t conn_id, const uint8_t *data, uint16_t len, uint64_t rx_us)
+{
+    sle_cargo_frame_t frame;
+    if (g_cargo_mutex == NULL || sle_cargo_decode(data, len, &frame) != SLE_CARGO_OK ||
+        (frame.clock.flags & SLE_CARGO_CLOCK_PONG) == 0) {
+        return;
+    }
+    uint32_t t4 = osKernelGetTickCount() - (uint32_t)((uapi_systick_get_us() - rx_us) / 1000);
+
+    osMutexAcquire(g_cargo_mutex, osWaitForever);
+    sle_server_conn_t *conn = sle_server_conn_find(conn_id);
+    if (conn != NULL) {
+        (void)sle_cargo_clock_sample(&conn->clock, frame.clock.t1, frame.clock.t2, frame.clock.t3, t4);
+    }
+    osMutexRelease(g_cargo_mutex);
+}
+
+// 接收任务处理一条写请求 - 客户端发送的货物数据
+static void sle_server_on_write(uint16_t conn_id, const uint8_t *data, uint16_t len, uint64_t rx_us)
+{
+    switch (sle_cargo_frame_type(data, len)) {
+        case SLE_CARGO_FRAME_BENCH:
+            sle_server_on_bench(conn_id, data, len, rx_us);
+            return;
+        case SLE_CARGO_FRAME_HIST_REQ:
+            sle_server_on_hist_req(conn_id, data, len);
+            return;
+        case SLE_CARGO_FRAME_CLOCK:
+            sle_server_on_clock(conn_id, data, len, rx_us);
+            return;
+        default:
+            break;
+    }
+
+    if (g_cargo_mutex == NULL) {
+        printf("[sle_server_63B] cargo mutex is NULL\r\n");
+        return;
+    }
+
+    // 按连接分别解码和重建计数，各分拣板互不影响
+    sle_cargo_frame_t frame;
+    sle_cargo_rx_result_t result = SLE_CARGO_RX_STALE;
+    cargo_info_t info = {0};
+    sle_cargo_rx_t rx = {0};
+    sle_cargo_err_t err = SLE_CARGO_ERR_PARAM;
+    sle_cargo_frag_rx_result_t frag_res = SLE_CARGO_FRAG_RX_DROPPED;
+    sle_cargo_frag_msg_t msg = {0};
+    char preview[SLE_SERVER_BULK_LOG_PREVIEW + 1] = {0};
+    uint32_t now = osKernelGetTickCount();
+    osMutexAcquire(g_cargo_mutex, osWaitForever);
+    sle_server_conn_t *conn = sle_server_conn_find(conn_id);
+    if (conn != NULL) {
+        cargo_info_t before = conn->info;
+        err = sle_server_conn_on_write(conn, data, len, now, &frame, &result);
+        if (err == SLE_CARGO_OK && result == SLE_CARGO_RX_APPLIED) {
+            sle_server_history_feed_locked(&before, &conn->info, now);
+            if (conn->info.origin_valid) {
+                sle_cargo_clock_lat_add(&g_lat_rx, conn->info.origin_tick, now);
+            }
+        }
+        if (err == SLE_CARGO_OK && frame.type == SLE_CARGO_FRAME_FRAG) {
+            // 分片数据指向写请求队列的消息，须在归还前拷入重组池；完整消息在锁内处理后立即释放槽位
+            frag_res = sle_server_conn_on_fragment(conn, &frame.frag, now, &msg);
+            if (frag_res == SLE_CARGO_FRAG_RX_COMPLETE) {
+                if (msg.kind == SLE_CARGO_BULK_LOG) {
+                    uint16_t n = (msg.len < SLE_SERVER_BULK_LOG_PREVIEW) ? msg.len : SLE_SERVER_BULK_LOG_PREVIEW;
+                    (void)memcpy_s(preview, sizeof(preview) - 1, msg.data, n);
+                }
+                sle_server_conn_release_message(&msg);
+            }
+        }
+        info = conn->info;
+        rx = conn->rx;
+        if (err == SLE_CARGO_OK && frame.type != SLE_CARGO_FRAME_FRAG) {
+            sle_server_view_publish_locked();
+        }
+    }
+    osMutexRelease(g_cargo_mutex);
+
+    if (conn == NULL) {
+        printf("[sle_server_63B] write from unknown conn_id=0x%04x ignored\r\n", conn_id);
+        return;
+    }
+    if (err != SLE_CARGO_OK) {
+        printf("[sle_server_63B] ✗ Failed to parse cargo data: %s\r\n", sle_cargo_err_str(err));
+        return;
+    }
+
+    // 分片不回确认帧，写请求本身的确认已足够驱动发送端
+    if (frame.type == SLE_CARGO_FRAME_FRAG) {
+        if (frag_res == SLE_CARGO_FRAG_RX_COMPLETE && msg.kind == SLE_CARGO_BULK_SORT_HISTORY) {
+            printf("[sle_server_63B] L%u bulk #%u sort history: %u records (%u bytes)\r\n", info.line, msg.msg_id,
+                   msg.len / SLE_CARGO_EVENT_LEN, msg.len);
+        } else if (frag_res == SLE_CARGO_FRAG_RX_COMPLETE && msg.kind == SLE_CARGO_BULK_LOG) {
+            printf("[sle_server_63B] L%u bulk #%u log (%u bytes): %s\r\n", info.line, msg.msg_id, msg.len, preview);
+        } else if (frag_res == SLE_CARGO_FRAG_RX_COMPLETE) {
+            printf("[sle_server_63B] L%u bulk #%u kind=%u: %u bytes\r\n", info.line, msg.msg_id, msg.kind, msg.len);
+        } else if (frag_res == SLE_CARGO_FRAG_RX_DROPPED) {
+            printf("[sle_server_63B] L%u fragment #%u @%u dropped\r\n", info.line, frame.frag.msg_id,
+                   frame.frag.offset);
+        }
+        return;
+    }
+
+    if (result == SLE_CARGO_RX_APPLIED) {
+#if SLE_SERVER_RX_LOG
+        if (frame.type == SLE_CARGO_FRAME_EVENTS) {
+            printf("[sle_server_63B] L%u events x%u (dup %u): last id=%02X region=%u gap=%ums\r\n", info.line,
+                   frame.event_count, rx.event_dups, info.last_id, info.last_region, info.last_gap_ms);
         } else {
-            printf("[sle_server_63B] cargo mutex is NULL\r\n");
+            printf("[sle_server_63B] L%u %s seq=%u: J=%u, Z=%u, S=%u, T=%u\r\n", info.line,
+                   (frame.type == SLE_CARGO_FRAME_DELTA) ? "delta" : "keyframe", frame.seq,
+                   info.jiangsu, info.zhejiang, info.shanghai, frame.snapshot.tick);
         }
+#endif
+    } else if (result == SLE_CARGO_RX_NEED_KEYFRAME && frame.type == SLE_CARGO_FRAME_EVENTS) {
+        printf("[sle_server_63B] L%u events x%u not contiguous with J+Z+S, waiting for next snapshot (gaps=%u)\r\n",
+               info.line, frame.event_count, rx.event_gaps);
+    } else if (result == SLE_CARGO_RX_NEED_KEYFRAME) {
+        printf("[sle_server_63B] L%u delta seq=%u base=%u not applicable, waiting for keyframe\r\n",
+               info.line, frame.seq, frame.base_seq);
+    } else {
+        printf("[sle_server_63B] L%u stale frame seq=%u ignored\r\n", info.line, frame.seq);
+    }
+
+    // 每次写入后回报接收状态，客户端据此计算往返时延并选择性重发；旧版文本客户端不认识确认帧。
+    // 解锁期间连接可能已断开、槽位已给了别的分拣板，重新查找，不沿用之前的表项
+    if (frame.wire == SLE_CARGO_WIRE_BINARY) {
+        osMutexAcquire(g_cargo_mutex, osWaitForever);
+        conn = sle_server_conn_find(conn_id);
+        if (conn == NULL) {
+            osMutexRelease(g_cargo_mutex);
+            return;
+        }
+        uint8_t flags = sle_server_conn_write_flags(conn, &frame, result);
+        sle_cargo_telem_issued(&g_telem);
+        osMutexRelease(g_cargo_mutex);
+        errcode_t ret = sle_server_send_ack(conn_id, flags);
+        osMutexAcquire(g_cargo_mutex, osWaitForever);
+        sle_cargo_telem_confirmed(&g_telem, ret == ERRCODE_SUCC, (uint32_t)(uapi_systick_get_us() - rx_us));
+        osMutexRelease(g_cargo_mutex);
+    }
+}
+
+// 写请求队列溢出的补救: 有分拣数据被丢弃的连接立即回一个要求关键帧的确认帧，
+// 即使被丢弃的是最后一帧、之后没有新的写入，分拣板也会重发完整计数；溢出日志限速打印
+static void sle_server_rx_gap_poll(void)
+{
+    static uint32_t seen_drops = 0;
+    static uint32_t logged_drops = 0;
+    static uint32_t log_tick = 0;
+    static uint32_t keyframes = 0;
+    sle_server_rxq_stats_t stats;
+    sle_server_rxq_get_stats(&stats);
+    if (stats.drops == logged_drops) {
+        return;
+    }
+
+    uint16_t gaps[SLE_SERVER_CONN_MAX];
+    uint8_t count = 0;
+    if (stats.drops != seen_drops) {
+        seen_drops = stats.drops;
+        osMutexAcquire(g_cargo_mutex, osWaitForever);
+        for (uint8_t slot = 0; slot < SLE_SERVER_CONN_MAX; slot++) {
+            sle_server_conn_t *conn = sle_server_conn_at(slot);
+            if (conn != NULL && sle_server_rxq_gap(conn->conn_id) && conn->wire == SLE_CARGO_WIRE_BINARY) {
+                gaps[count++] = conn->conn_id;
+            }
+        }
+        osMutexRelease(g_cargo_mutex);
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        (void)sle_server_send_ack(gaps[i], SLE_CARGO_ACK_NEED_KEYFRAME);
+    }
+    keyframes += count;
+
+    uint32_t now = osKernelGetTickCount();
+    if (log_tick == 0 || (uint32_t)(now - log_tick) >= SLE_SERVER_RX_DROP_LOG_MS) {
+        printf("[sle_server_63B] write queue full: %u writes dropped (bench total %u), high=%u/%u, "
+               "keyframe requested x%u\r\n", stats.drops - logged_drops, stats.bench_drops, stats.high, stats.depth,
+               keyframes);
+        logged_drops = stats.drops;
+        log_tick = (now == 0) ? 1 : now;
+        keyframes = 0;
+    }
+}
+
+// 按最新快照重新编码可读特征值；距上次编码不足 SLE_SERVER_LIVE_MIN_MS 时先不编码，
+// 期间的多次更新合并，空闲时由接收任务的超时检查补上最后一次
+static void sle_server_live_poll(void)
+{
+    uint32_t gen = sle_server_get_cargo_generation();
+    if (gen == g_live_stats.generation) {
+        return;
+    }
+    uint32_t now = osKernelGetTickCount();
+    if (g_live_stats.encodes > 0 && (uint32_t)(now - g_live_tick) < SLE_SERVER_LIVE_MIN_MS) {
+        return;
+    }
+    static sle_server_cargo_view_t view;
+    if (!sle_server_get_cargo_view(&view)) {
+        return;
+    }
+    const cargo_info_t *hall = &view.hall;
+    sle_cargo_snapshot_t snap = { hall->jiangsu, hall->zhejiang, hall->shanghai, hall->update_tick };
+    uint8_t value[SLE_CARGO_SNAPSHOT_LEN];
+    if (sle_cargo_encode_snapshot(value, sizeof(value), (uint16_t)view.generation, &snap) == 0) {
+        return;
+    }
+    sle_cargo_latch_publish(&g_live_latch, value);
+    if (g_live_stats.encodes > 0 && view.generation > g_live_stats.generation + 1) {
+        g_live_stats.coalesced += view.generation - g_live_stats.generation - 1;
+    }
+    g_live_stats.generation = view.generation;
+    g_live_stats.encodes++;
+    g_live_tick = now;
+}
+
+// 读请求回调 - 0x1122 特征返回最新的全场合计快照帧，不加锁、不打印
+static void ssaps_read_request_cbk(uint8_t server_id, uint16_t conn_id, ssaps_req_read_cb_t *read_cb_para,
+                                   errcode_t status)
+{
+    if (status != ERRCODE_SUCC || read_cb_para == NULL || !read_cb_para->need_rsp ||
+        read_cb_para->handle != g_property_handle) {
+        return;
+    }
+    uint8_t value[SLE_CARGO_SNAPSHOT_LEN];
+    ssaps_send_rsp_t rsp = {0};
+    rsp.request_id = read_cb_para->request_id;
+    if (sle_cargo_latch_read(&g_live_latch, value, NULL)) {
+        rsp.status = ERRCODE_SUCC;
+        rsp.value = value;
+        rsp.value_len = sizeof(value);
     } else {
-        printf("[sle_server_63B] ✗ Failed to parse cargo data\r\n");
+        rsp.status = (uint8_t)ERRCODE_FAIL;
+    }
+    g_live_stats.reads++;
+    (void)ssaps_send_response(server_id, conn_id, &rsp);
+}
+
+// 对时: 向使用二进制协议的各分拣板周期发出对时请求，t1 在发出前一刻取；压测期间暂停，不占用被测链路
+static void sle_server_clock_poll(void)
+{
+    uint16_t due[SLE_SERVER_CONN_MAX];
+    uint16_t seqs[SLE_SERVER_CONN_MAX];
+    uint8_t count = 0;
+    uint32_t now = osKernelGetTickCount();
+    osMutexAcquire(g_cargo_mutex, osWaitForever);
+    bool bench = g_bench_rx.active && !g_bench_rx.finished;
+    for (uint8_t slot = 0; slot < SLE_SERVER_CONN_MAX && !bench; slot++) {
+        sle_server_conn_t *conn = sle_server_conn_at(slot);
+        if (conn == NULL || conn->wire != SLE_CARGO_WIRE_BINARY || (int32_t)(now - conn->clock_next_tick) < 0) {
+            continue;
+        }
+        conn->clock_next_tick = now + (sle_cargo_clock_synced(&conn->clock) ?
+                                       SLE_SERVER_CLOCK_PING_MS : SLE_SERVER_CLOCK_FAST_MS);
+        due[count] = conn->conn_id;
+        seqs[count] = conn->clock_seq++;
+        count++;
+    }
+    osMutexRelease(g_cargo_mutex);
+
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t msg[SLE_CARGO_CLOCK_LEN];
+        sle_cargo_clock_msg_t ping = {0};
+        ping.t1 = osKernelGetTickCount();
+        uint16_t msg_len = sle_cargo_encode_clock(msg, sizeof(msg), seqs[i], &ping);
+        if (msg_len > 0) {
+            (void)sle_server_notify_raw(due[i], msg, msg_len);
+        }
+    }
+}
+
+// 接收任务: 按到达顺序处理写请求队列，空闲时检查溢出并补上合并中的特征值更新
+static void sle_server_rx_task(void *arg)
+{
+    unused(arg);
+    while (1) {
+        sle_server_rxq_msg_t *msg = sle_server_rxq_get(SLE_SERVER_RX_IDLE_MS);
+        if (msg != NULL) {
+            sle_server_on_write(msg->conn_id, msg->data, msg->len, msg->rx_us);
+            sle_server_rxq_release(msg);
+        }
+        sle_server_rx_gap_poll();
+        sle_server_live_poll();
+        sle_server_clock_poll();
     }
 }
 
+// 速率历史任务: 优先级低于显示任务，导出时阻塞在大消息发送上不影响刷屏和上屏回报
+static void sle_server_hist_task(void *arg)
+{
+    unused(arg);
+    while (1) {
+        sle_server_history_poll();
+        osDelay(SLE_SERVER_HIST_POLL_MS);
+    }
+}
+
+// 写入回调 - 只拷贝并投递到写请求队列，不加锁、不打印，处理由接收任务完成
+static void ssaps_write_request_cbk(uint8_t server_id, uint16_t conn_id,
+                                    ssaps_req_write_cb_t *write_cb_para, errcode_t status)
+{
+    uint64_t rx_us = uapi_systick_get_us();
+    unused(server_id);
+    if (status != ERRCODE_SUCC || write_cb_para == NULL || write_cb_para->value == NULL) {
+        sle_server_rxq_reject();
+        return;
+    }
+    (void)sle_server_rxq_put(conn_id, write_cb_para->value, write_cb_para->length, rx_us);
+}
+
+// MTU协商结果，决定发往该连接的分片大小
+static void ssaps_mtu_changed_cbk(uint8_t server_id, uint16_t conn_id, ssap_exchange_info_t *mtu_size,
+                                  errcode_t status)
+{
+    unused(server_id);
+    if (status != ERRCODE_SUCC || mtu_size == NULL || g_cargo_mutex == NULL) {
+        return;
+    }
+    osMutexAcquire(g_cargo_mutex, osWaitForever);
+    sle_server_conn_t *conn = sle_server_conn_find(conn_id);
+    if (conn != NULL) {
+        conn->mtu = mtu_size->mtu_size;
+    }
+    osMutexRelease(g_cargo_mutex);
+    printf("[sle_server_63B] conn 0x%04x mtu=%u\r\n", conn_id, mtu_size->mtu_size);
+}
+
 // 其他必要的回调函数
 static void ssaps_add_service_cbk(uint8_t server_id, sle_uuid_t *uuid, uint16_t handle, errcode_t status)
 {
@@ -213,22 +635,73 @@ static void sle_connect_state_changed_cbk(uint16_t conn_id, const sle_addr_t *ad
     printf("[sle_server_63B] 客户端地址: %02x:%02x:%02x:%02x:%02x:%02x\r\n",
            addr->addr[0], addr->addr[1], addr->addr[2], addr->addr[3], addr->addr[4], addr->addr[5]);
     
+    uint8_t count = 0;
+    uint8_t cap = 0;
+    uint32_t interval = 0;
     if (conn_state == SLE_ACB_STATE_CONNECTED) {
-        g_sle_conn_hdl = conn_id;
-        g_sle_connected = true;
-        printf("[sle_server_63B] ✅ SLE连接成功，conn_id=0x%04x\r\n", conn_id);
+        osMutexAcquire(g_cargo_mutex, osWaitForever);
+        uint32_t now = osKernelGetTickCount();
+        sle_server_conn_t *conn = sle_server_conn_add(conn_id, addr->addr, now);
+        uint8_t line = (conn != NULL) ? conn->line : 0;
+        uint32_t ttr = 0;
+        bool measured = false;
+        sle_server_announce_info_t adv = {0};
+        count = sle_server_conn_count();
+        cap = sle_server_conn_get_cap();
+        if (conn != NULL) {
+            sle_cargo_telem_connected(&g_telem);
+            sle_cargo_telem_set_link(&g_telem, SLE_CARGO_LINK_CONNECTED, now);
+            sle_server_announce_get_info(&adv, now);
+            measured = sle_server_announce_connected(count < cap, now, &ttr);
+            sle_server_view_publish_locked();
+        }
+        osMutexRelease(g_cargo_mutex);
+
+        if (conn == NULL) {
+            // 已达连接上限: 断开多出的分拣板，让它去连其他显示板
+            printf("[sle_server_63B] ❌ 连接数已达上限 %u，断开 conn_id=0x%04x\r\n", cap, conn_id);
+            sle_disconnect_remote_device(addr);
+            return;
+        }
+        printf("[sle_server_63B] ✅ SLE连接成功，conn_id=0x%04x 产线=L%u (%u/%u)\r\n", conn_id, line, count, cap);
+        if (measured) {
+            // 固定格式便于从日志中筛选，对比各调度的重连耗时
+            printf("[sle_server_63B] ttr %ums schedule=%s step=%u reason=%s (开始广播到接入)\r\n", ttr,
+                   sle_server_announce_name(adv.timer_schedule), adv.step,
+                   (adv.reason == SLE_SERVER_ANNOUNCE_BOOT) ? "boot" :
+                   (adv.reason == SLE_SERVER_ANNOUNCE_DISCONNECT) ? "disconnect" : "cap");
+        }
+
+        // 建立连接后协议栈停止广播，未达上限时按当前档位继续广播以接入更多分拣板
+        if (count < cap) {
+            errcode_t ret = sle_start_announce(SLE_ADV_HANDLE_DEFAULT);
+            if (ret != ERRCODE_SUCC) {
+                printf("[sle_server_63B] 重启广播失败:0x%x\r\n", ret);
+            } else {
+                printf("[sle_server_63B] 继续广播，等待更多分拣板 (%u/%u)\r\n", count, cap);
+            }
+        }
     } else if (conn_state == SLE_ACB_STATE_DISCONNECTED) {
-        g_sle_conn_hdl = 0;
-        g_sle_connected = false;
-        printf("[sle_server_63B] ❌ SLE连接断开，原因=0x%02x\r\n", disc_reason);
-        
-        // 重新开始广播
-        printf("[sle_server_63B] 重新启动广播...\r\n");
-        errcode_t ret = sle_start_announce(SLE_ADV_HANDLE_DEFAULT);
-        if (ret != ERRCODE_SUCC) {
-            printf("[sle_server_63B] 重启广播失败:0x%x\r\n", ret);
-        } else {
-            printf("[sle_server_63B] 重启广播成功\r\n");
+        osMutexAcquire(g_cargo_mutex, osWaitForever);
+        uint32_t now = osKernelGetTickCount();
+        sle_server_conn_remove(conn_id);
+        sle_server_view_publish_locked();
+        count = sle_server_conn_count();
+        sle_cargo_telem_disconnected(&g_telem, (uint8_t)disc_reason);
+        if (count == 0) {
+            sle_cargo_telem_set_link(&g_telem, SLE_CARGO_LINK_SEARCHING, now);
+        }
+        cap = sle_server_conn_get_cap();
+        if (count < cap) {
+            interval = sle_server_announce_restart(SLE_SERVER_ANNOUNCE_DISCONNECT, now);
+        }
+        osMutexRelease(g_cargo_mutex);
+        printf("[sle_server_63B] ❌ SLE连接断开，conn_id=0x%04x 原因=0x%02x (%u/%u)\r\n",
+               conn_id, disc_reason, count, cap);
+
+        // 断开的分拣板会立即重新扫描，从最快的档位重新开始广播
+        if (count < cap) {
+            sle_server_announce_apply(interval);
         }
     }
     unused(addr);
@@ -242,6 +715,8 @@ static errcode_t sle_ssaps_register_cbks(void)
     ssaps_cbk.add_property_cb = ssaps_add_property_cbk;
     ssaps_cbk.start_service_cb = ssaps_start_service_cbk;
     ssaps_cbk.write_request_cb = ssaps_write_request_cbk;
+    ssaps_cbk.read_request_cb = ssaps_read_request_cbk;
+    ssaps_cbk.mtu_changed_cb = ssaps_mtu_changed_cbk;
     
     errcode_t ret = ssaps_register_callbacks(&ssaps_cbk);
     if (ret != ERRCODE_SUCC) {
@@ -251,10 +726,60 @@ static errcode_t sle_ssaps_register_cbks(void)
     return ERRCODE_SUCC;
 }
 
+// RSSI读取结果
+static void sle_read_rssi_cbk(uint16_t conn_id, int8_t rssi, errcode_t status)
+{
+    if (status != ERRCODE_SUCC || g_cargo_mutex == NULL) {
+        return;
+    }
+    osMutexAcquire(g_cargo_mutex, osWaitForever);
+    if (sle_server_conn_find(conn_id) != NULL) {
+        sle_cargo_telem_rssi(&g_telem, rssi);
+    }
+    osMutexRelease(g_cargo_mutex);
+}
+
+// 连接参数更新结果 (由客户端按分拣流量发起)
+static void sle_connect_param_update_cbk(uint16_t conn_id, errcode_t status,
+                                         const sle_connection_param_update_evt_t *param)
+{
+    if (status != ERRCODE_SUCC || param == NULL) {
+        printf("[sle_server_63B] conn_id=0x%04x 连接参数更新失败:0x%x\r\n", conn_id, status);
+        return;
+    }
+    printf("[sle_server_63B] conn_id=0x%04x 连接参数: interval=%uus latency=%u timeout=%ums (%s)\r\n", conn_id,
+           param->interval * 125, param->latency, param->supervision * 10,
+           sle_cargo_conn_profile_name(sle_cargo_conn_classify(param->interval, param->latency)));
+}
+
+// PHY切换结果 (由分拣板在批量传输前后发起)
+static void sle_set_phy_cbk(uint16_t conn_id, errcode_t status, const sle_set_phy_t *param)
+{
+    if (status != ERRCODE_SUCC || param == NULL) {
+        printf("[sle_server_63B] conn_id=0x%04x PHY切换失败:0x%x\r\n", conn_id, status);
+        return;
+    }
+    uint8_t line = 0;
+    if (g_cargo_mutex != NULL) {
+        osMutexAcquire(g_cargo_mutex, osWaitForever);
+        sle_server_conn_t *conn = sle_server_conn_find(conn_id);
+        if (conn != NULL) {
+            conn->phy = param->tx_phy;
+            line = conn->line;
+        }
+        osMutexRelease(g_cargo_mutex);
+    }
+    printf("[sle_server_63B] L%u conn_id=0x%04x PHY: tx=%s rx=%s\r\n", line, conn_id,
+           sle_cargo_phy_name(param->tx_phy), sle_cargo_phy_name(param->rx_phy));
+}
+
 static errcode_t sle_conn_register_cbks(void)
 {
     sle_connection_callbacks_t conn_cbks = {0};
     conn_cbks.connect_state_changed_cb = sle_connect_state_changed_cbk;
+    conn_cbks.read_rssi_cb = sle_read_rssi_cbk;
+    conn_cbks.connect_param_update_cb = sle_connect_param_update_cbk;
+    conn_cbks.set_phy_cb = sle_set_phy_cbk;
     
     errcode_t ret = sle_connection_register_callbacks(&conn_cbks);
     if (ret != ERRCODE_SUCC) {
@@ -289,13 +814,15 @@ static errcode_t sle_uuid_server_property_add(void)
     printf("[sle_server_63B] 正在添加特征到服务句柄=0x%04x\r\n", g_service_handle);
     
     property.permissions = SSAP_PERMISSION_READ | SSAP_PERMISSION_WRITE;
-    property.operate_indication = SSAP_OPERATE_INDICATION_BIT_READ | SSAP_OPERATE_INDICATION_BIT_WRITE;
+    // 写请求用于快照/增量帧，无响应写命令用于事件流，notify 用于回报接收状态
+    property.operate_indication = SSAP_OPERATE_INDICATION_BIT_READ | SSAP_OPERATE_INDICATION_BIT_WRITE |
+                                  SSAP_OPERATE_INDICATION_BIT_WRITE_NO_RSP | SSAP_OPERATE_INDICATION_BIT_NOTIFY;
     sle_uuid_setu2(SLE_UUID_SERVER_NTF_REPORT, &property.uuid);
     
     printf("[sle_server_63B] 特征权限: 读写=0x%02x, 操作指示=0x%02x, UUID=0x%04x\r\n",
            property.permissions, property.operate_indication, SLE_UUID_SERVER_NTF_REPORT);
     
-    // 不设置初始值，避免内存问题
+    // 特征值由应用保存，读请求在回调中以最新的全场合计快照帧回复 (见 ssaps_read_request_cbk)
     property.value = NULL;
     property.value_len = 0;
     
@@ -306,6 +833,20 @@ static errcode_t sle_uuid_server_property_add(void)
     }
     
     printf("[sle_server_63B] ✅ 特征添加成功，句柄=0x%04x\r\n", g_property_handle);
+
+    // 客户端配置描述符，默认开启notify
+    uint8_t ntf_value[] = {0x01, 0x00};
+    ssaps_desc_info_t descriptor = {0};
+    descriptor.permissions = SSAP_PERMISSION_READ | SSAP_PERMISSION_WRITE;
+    descriptor.type = SSAP_DESCRIPTOR_CLIENT_CONFIGURATION;
+    descriptor.operate_indication = SSAP_OPERATE_INDICATION_BIT_READ | SSAP_OPERATE_INDICATION_BIT_WRITE;
+    descriptor.value = ntf_value;
+    descriptor.value_len = sizeof(ntf_value);
+    ret = ssaps_add_descriptor_sync(g_server_id, g_service_handle, g_property_handle, &descriptor);
+    if (ret != ERRCODE_SUCC) {
+        // 没有描述符时写入仍然可用，只是客户端收不到确认帧
+        printf("[sle_server_63B] ⚠ 添加notify描述符失败, ret:0x%x\r\n", ret);
+    }
     return ERRCODE_SUCC;
 }
 
@@ -344,7 +885,7 @@ static errcode_t sle_server_add(void)
 }
 
 // 广播参数设置 - 参考官方教程
-static errcode_t sle_server_set_announce_param(void)
+static errcode_t sle_server_set_announce_param(uint32_t interval)
 {
     sle_announce_param_t param = {0};
     uint8_t mac[SLE_ADDR_LEN] = {0x04, 0x01, 0x06, 0x08, 0x06, 0x03};
@@ -358,18 +899,19 @@ static errcode_t sle_server_set_announce_param(void)
     param.announce_gt_role = SLE_ANNOUNCE_ROLE_T_CAN_NEGO;
     param.announce_level = SLE_ANNOUNCE_LEVEL_NORMAL;
     param.announce_channel_map = 0x07; // SLE_ADV_CHANNEL_MAP_DEFAULT
-    param.announce_interval_min = 0xC8;  // 25ms
-    param.announce_interval_max = 0xC8;  // 25ms
-    param.conn_interval_min = 0x64;      // 12.5ms - 按官方demo标准
-    param.conn_interval_max = 0x64;      // 12.5ms - 按官方demo标准
-    param.conn_max_latency = 0x1F3;      // 按官方demo标准
-    param.conn_supervision_timeout = 0x1F4; // 5000ms
+    param.announce_interval_min = interval;  // 由广播调度决定，单位0.125ms
+    param.announce_interval_max = interval;
+    param.conn_interval_min = SLE_CARGO_CONN_DEFAULT_INTERVAL;  // 与客户端一致，连接后由客户端按分拣流量调整
+    param.conn_interval_max = SLE_CARGO_CONN_DEFAULT_INTERVAL;
+    param.conn_max_latency = SLE_CARGO_CONN_DEFAULT_LATENCY;
+    param.conn_supervision_timeout = SLE_CARGO_CONN_TIMEOUT; // 5000ms
     param.announce_tx_power = 20;
     param.own_addr.type = 0;
     memcpy_s(param.own_addr.addr, SLE_ADDR_LEN, mac, SLE_ADDR_LEN);
     
-    printf("[sle_server_63B] 连接参数: interval=0x%x, latency=0x%x, timeout=0x%x\r\n",
-           param.conn_interval_min, param.conn_max_latency, param.conn_supervision_timeout);
+    printf("[sle_server_63B] 广播间隔: %ums, 连接参数: interval=0x%x, latency=0x%x, timeout=0x%x\r\n",
+           interval * SLE_SERVER_ANNOUNCE_UNIT_US / 1000, param.conn_interval_min, param.conn_max_latency,
+           param.conn_supervision_timeout);
     
     errcode_t ret = sle_set_announce_param(param.announce_handle, &param);
     if (ret != ERRCODE_SUCC) {
@@ -398,12 +940,15 @@ static errcode_t sle_server_set_announce_data(void)
     announce_data[announce_idx++] = 2;  // length
     announce_data[announce_idx++] = 0x02; // SLE_ADV_DATA_TYPE_ACCESS_MODE
     announce_data[announce_idx++] = 0;
+
+    // 协议能力字段，客户端据此在连接时选择二进制帧并在批量传输时协商PHY，老客户端会忽略该字段
+    announce_idx += sle_cargo_adv_put_proto(&announce_data[announce_idx], sizeof(announce_data) - announce_idx);
+
+    // 货物服务UUID，客户端被动扫描时只能看到广播数据，据此识别63B而不依赖固定地址
+    announce_idx += sle_cargo_adv_put_service(&announce_data[announce_idx], sizeof(announce_data) - announce_idx);
     
-    // 设置扫描响应数据 - 设备名称
-    seek_rsp_data[seek_idx++] = 16;  // length
-    seek_rsp_data[seek_idx++] = 0x0B; // SLE_ADV_DATA_TYPE_COMPLETE_LOCAL_NAME
-    memcpy_s(&seek_rsp_data[seek_idx], 32 - seek_idx, "CARGO_SERVER_63B", 16);
-    seek_idx += 16;
+    // 设置扫描响应数据 - 设备名称 (长度字段包含type字节)
+    seek_idx += sle_cargo_adv_put_name(&seek_rsp_data[seek_idx], sizeof(seek_rsp_data) - seek_idx);
     
     data.announce_data = announce_data;
     data.announce_data_len = announce_idx;
@@ -465,8 +1010,9 @@ static errcode_t sle_server_adv_init(void)
         return ret;
     }
     
-    // 设置广播参数
-    ret = sle_server_set_announce_param();
+    // 设置广播参数，从广播调度最快的档位开始
+    ret = sle_server_set_announce_param(sle_server_announce_restart(SLE_SERVER_ANNOUNCE_BOOT,
+                                                                    osKernelGetTickCount()));
     if (ret != ERRCODE_SUCC) {
         return ret;
     }
@@ -517,6 +1063,53 @@ errcode_t sle_server_63B_init(void)
         return ERRCODE_FAIL;
     }
     printf("[sle_server_63B] ✅ 互斥锁创建成功\r\n");
+
+    sle_server_conn_init(SLE_SERVER_CONN_CAP);
+    (void)memset_s(&g_view_next, sizeof(g_view_next), 0, sizeof(g_view_next));
+    g_view_next.cap = sle_server_conn_get_cap();
+    sle_cargo_latch_init(&g_view_latch, &g_view_copy[0], &g_view_copy[1], sizeof(g_view_next), &g_view_next);
+    sle_cargo_snapshot_t empty = {0};
+    uint8_t value[SLE_CARGO_SNAPSHOT_LEN] = {0};
+    (void)sle_cargo_encode_snapshot(value, sizeof(value), 0, &empty);
+    sle_cargo_latch_init(&g_live_latch, g_live_copy[0], g_live_copy[1], sizeof(value), value);
+    (void)memset_s(&g_live_stats, sizeof(g_live_stats), 0, sizeof(g_live_stats));
+    sle_cargo_history_init(&g_history, osKernelGetTickCount());
+    (void)memset_s(&g_hist_export, sizeof(g_hist_export), 0, sizeof(g_hist_export));
+    sle_cargo_telem_init(&g_telem, osKernelGetTickCount());
+    sle_cargo_telem_set_link(&g_telem, SLE_CARGO_LINK_SEARCHING, osKernelGetTickCount());
+    sle_server_announce_init(osKernelGetTickCount());
+
+    // 写请求队列和接收任务，须在注册写入回调之前就绪；优先级高于显示任务，写入不会排在刷屏之后。
+    // 接收任务一启动就会检查连接表、快照、历史和对时状态，须在上面的状态都初始化之后创建
+    if (!sle_server_rxq_init()) {
+        return ERRCODE_FAIL;
+    }
+    osThreadAttr_t rx_attr = {
+        .name = "SLERxTask",
+        .attr_bits = 0U,
+        .cb_mem = NULL,
+        .cb_size = 0U,
+        .stack_mem = NULL,
+        .stack_size = SLE_SERVER_RX_TASK_STACK_SIZE,
+        .priority = osPriorityAboveNormal,
+    };
+    if (osThreadNew((osThreadFunc_t)sle_server_rx_task, NULL, &rx_attr) == NULL) {
+        printf("[sle_server_63B] ❌ 创建接收任务失败\r\n");
+        return ERRCODE_FAIL;
+    }
+    osThreadAttr_t hist_attr = {
+        .name = "SLEHistTask",
+        .attr_bits = 0U,
+        .cb_mem = NULL,
+        .cb_size = 0U,
+        .stack_mem = NULL,
+        .stack_size = SLE_SERVER_HIST_TASK_STACK_SIZE,
+        .priority = osPriorityBelowNormal,
+    };
+    if (osThreadNew((osThreadFunc_t)sle_server_hist_task, NULL, &hist_attr) == NULL) {
+        printf("[sle_server_63B] ❌ 创建速率历史任务失败\r\n");
+        return ERRCODE_FAIL;
+    }
     
     // 1. 启用SLE
     printf("[sle_server_63B] 正在启用SLE协议栈...\r\n");
@@ -566,57 +1159,512 @@ errcode_t sle_server_63B_init(void)
     return ERRCODE_SUCC;
 }
 
-// 获取货物信息
+// 读取货物状态快照，不加锁
+bool sle_server_get_cargo_view(sle_server_cargo_view_t *view)
+{
+    if (view == NULL || g_cargo_mutex == NULL) {
+        return false;
+    }
+    return sle_cargo_latch_read(&g_view_latch, view, &view->generation);
+}
+
+// 货物状态快照的代数
+uint32_t sle_server_get_cargo_generation(void)
+{
+    return (g_cargo_mutex != NULL) ? sle_cargo_latch_generation(&g_view_latch) : 0;
+}
+
+// 获取可读特征值的更新统计
+void sle_server_get_live_stats(sle_server_live_stats_t *stats)
+{
+    if (stats != NULL) {
+        *stats = g_live_stats;
+    }
+}
+
+// 获取货物信息: 全场合计
 bool sle_server_get_cargo_info(cargo_info_t *cargo_info)
 {
     if (cargo_info == NULL) {
         return false;
     }
-    
-    if (g_cargo_mutex == NULL) {
+
+    sle_server_cargo_view_t view;
+    if (!sle_server_get_cargo_view(&view)) {
         return false;
     }
-    
+    *cargo_info = view.hall;
+    return cargo_info->valid;
+}
+
+// 获取各产线的货物信息
+uint8_t sle_server_get_line_info(cargo_info_t *lines, uint8_t max)
+{
+    if (lines == NULL) {
+        return 0;
+    }
+
+    sle_server_cargo_view_t view;
+    if (!sle_server_get_cargo_view(&view)) {
+        return 0;
+    }
+    uint8_t count = (view.count < max) ? view.count : max;
+    for (uint8_t i = 0; i < count; i++) {
+        lines[i] = view.lines[i];
+    }
+    return count;
+}
+
+// 获取连接数和上限
+uint8_t sle_server_get_conn_count(uint8_t *cap)
+{
+    sle_server_cargo_view_t view;
+    if (!sle_server_get_cargo_view(&view)) {
+        return 0;
+    }
+    if (cap != NULL) {
+        *cap = view.cap;
+    }
+    return view.count;
+}
+
+// 设置连接上限
+void sle_server_set_conn_cap(uint8_t cap)
+{
+    if (g_cargo_mutex == NULL) {
+        return;
+    }
+    uint32_t interval = 0;
     osMutexAcquire(g_cargo_mutex, osWaitForever);
-    *cargo_info = g_cargo_info;
+    sle_server_conn_set_cap(cap);
+    sle_server_view_publish_locked();
+    uint8_t count = sle_server_conn_count();
+    cap = sle_server_conn_get_cap();
+    if (count < cap) {
+        interval = sle_server_announce_restart(SLE_SERVER_ANNOUNCE_CAP, osKernelGetTickCount());
+    }
     osMutexRelease(g_cargo_mutex);
-    
-    return g_cargo_info.valid;
+
+    if (count < cap) {
+        sle_server_announce_apply(interval);
+    }
 }
 
-// 发送货物数据到客户端
-errcode_t sle_server_send_cargo_data(uint32_t jiangsu, uint32_t zhejiang, uint32_t shanghai)
+// 按新的间隔重新开始广播: 广播中不能修改参数，先停止 (已停止时忽略返回值)
+static void sle_server_announce_apply(uint32_t interval)
 {
-    if (!g_sle_connected || g_sle_conn_hdl == 0) {
-        printf("[sle_server_63B] not connected, cannot send data\r\n");
-        return ERRCODE_FAIL;
+    sle_stop_announce(SLE_ADV_HANDLE_DEFAULT);
+    errcode_t ret = sle_server_set_announce_param(interval);
+    if (ret == ERRCODE_SUCC) {
+        ret = sle_start_announce(SLE_ADV_HANDLE_DEFAULT);
     }
-    
-    // 构建货物数据包格式: "J:xxx,Z:xxx,S:xxx,T:timestamp"
-    char msg[128] = {0};
-    uint64_t timestamp = (uint64_t)osKernelGetTickCount();
-    snprintf(msg, sizeof(msg), "J:%u,Z:%u,S:%u,T:%llu", 
-             jiangsu, zhejiang, shanghai, timestamp);
-    
-    // 通过notify发送数据
+    if (ret != ERRCODE_SUCC) {
+        printf("[sle_server_63B] 重启广播失败:0x%x\r\n", ret);
+    }
+}
+
+// 广播调度周期检查
+void sle_server_announce_update(void)
+{
+    if (g_cargo_mutex == NULL) {
+        return;
+    }
+    osMutexAcquire(g_cargo_mutex, osWaitForever);
+    bool changed = sle_server_announce_poll(osKernelGetTickCount());
+    uint32_t interval = sle_server_announce_interval();
+    osMutexRelease(g_cargo_mutex);
+
+    if (changed) {
+        printf("[sle_server_63B] 暂无新的分拣板接入，广播间隔放慢到 %ums\r\n",
+               interval * SLE_SERVER_ANNOUNCE_UNIT_US / 1000);
+        sle_server_announce_apply(interval);
+    }
+}
+
+// 获取广播调度状态
+void sle_server_get_announce_info(sle_server_announce_info_t *info)
+{
+    if (info == NULL || g_cargo_mutex == NULL) {
+        return;
+    }
+    osMutexAcquire(g_cargo_mutex, osWaitForever);
+    sle_server_announce_get_info(info, osKernelGetTickCount());
+    osMutexRelease(g_cargo_mutex);
+}
+
+// 通过notify发送一帧到客户端，不打印
+static errcode_t sle_server_notify_raw(uint16_t conn_id, uint8_t *msg, uint16_t msg_len)
+{
     ssaps_ntf_ind_t param = {0};
     param.handle = g_property_handle;
     param.type = 0; // notification
-    param.value = (uint8_t *)msg;
-    param.value_len = (uint16_t)strlen(msg);
-    
-    errcode_t ret = ssaps_notify_indicate(g_server_id, g_sle_conn_hdl, &param);
+    param.value = msg;
+    param.value_len = msg_len;
+    return ssaps_notify_indicate(g_server_id, conn_id, &param);
+}
+
+// 通过notify发送一帧到客户端
+static errcode_t sle_server_notify(uint16_t conn_id, uint8_t *msg, uint16_t msg_len)
+{
+    errcode_t ret = sle_server_notify_raw(conn_id, msg, msg_len);
     if (ret != ERRCODE_SUCC) {
-        printf("[sle_server_63B] send notify failed:0x%x\r\n", ret);
-        return ret;
+        printf("[sle_server_63B] send notify to 0x%04x failed:0x%x\r\n", conn_id, ret);
     }
-    
-    printf("[sle_server_63B] sent cargo data: %s\r\n", msg);
+    return ret;
+}
+
+// 发送接收状态确认帧
+static errcode_t sle_server_send_ack(uint16_t conn_id, uint8_t flags)
+{
+    if (g_cargo_mutex == NULL) {
+        return ERRCODE_FAIL;
+    }
+
+    uint8_t msg[SLE_CARGO_ACK_LEN];
+    uint16_t msg_len = 0;
+    uint8_t line = 0;
+    sle_cargo_ack_t ack = {0};
+    osMutexAcquire(g_cargo_mutex, osWaitForever);
+    sle_server_conn_t *conn = sle_server_conn_find(conn_id);
+    if (conn != NULL && conn->wire == SLE_CARGO_WIRE_BINARY) {
+        msg_len = sle_server_conn_build_ack(conn, flags, osKernelGetTickCount(), msg, sizeof(msg), &ack);
+        line = conn->line;
+    }
+    osMutexRelease(g_cargo_mutex);
+    if (msg_len == 0) {
+        return ERRCODE_FAIL;
+    }
+
+    errcode_t ret = sle_server_notify(conn_id, msg, msg_len);
+#if SLE_SERVER_RX_LOG
+    if (ret == ERRCODE_SUCC) {
+        printf("[sle_server_63B] L%u ack seq=%u total=%u flags=0x%02x lag=%ums\r\n", line, ack.last_seq, ack.total,
+               ack.flags, ack.display_lag_ms);
+    }
+#else
+    unused(line);
+#endif
+    return ret;
+}
+
+// 显示任务回报已上屏的各产线状态
+void sle_server_display_shown(const cargo_info_t *lines, uint8_t count)
+{
+    if (lines == NULL || g_cargo_mutex == NULL) {
+        return;
+    }
+
+    uint32_t now = osKernelGetTickCount();
+    for (uint8_t i = 0; i < count; i++) {
+        osMutexAcquire(g_cargo_mutex, osWaitForever);
+        bool shown = sle_server_conn_display_shown(sle_server_conn_find(lines[i].conn_id), &lines[i], now);
+        if (shown && lines[i].origin_valid) {
+            sle_cargo_clock_lat_add(&g_lat_display, lines[i].origin_tick, now);
+        }
+        osMutexRelease(g_cargo_mutex);
+
+        // 新状态上屏后通知对应的分拣板，客户端由此得知显示屏已是最新
+        if (shown) {
+            sle_server_send_ack(lines[i].conn_id, 0);
+        }
+    }
+}
+
+// 获取链路遥测
+void sle_server_get_telemetry(sle_cargo_telem_t *telem)
+{
+    if (telem == NULL || g_cargo_mutex == NULL) {
+        return;
+    }
+    osMutexAcquire(g_cargo_mutex, osWaitForever);
+    *telem = g_telem;
+    osMutexRelease(g_cargo_mutex);
+}
+
+// 获取板间对时状态和单向时延分布
+void sle_server_get_latency(sle_server_latency_t *latency)
+{
+    if (latency == NULL || g_cargo_mutex == NULL) {
+        return;
+    }
+    (void)memset_s(latency, sizeof(*latency), 0, sizeof(*latency));
+    osMutexAcquire(g_cargo_mutex, osWaitForever);
+    for (uint8_t i = 0; i < SLE_SERVER_CONN_MAX; i++) {
+        sle_server_conn_t *conn = sle_server_conn_at(i);
+        if (conn != NULL) {
+            latency->line[latency->count] = conn->line;
+            latency->clock[latency->count] = conn->clock;
+            latency->count++;
+        }
+    }
+    latency->rx = g_lat_rx;
+    latency->display = g_lat_display;
+    osMutexRelease(g_cargo_mutex);
+}
+
+// 读取所有连接的RSSI
+void sle_server_sample_rssi(void)
+{
+    if (g_cargo_mutex == NULL) {
+        return;
+    }
+    uint16_t conn_ids[SLE_SERVER_CONN_MAX];
+    uint8_t count = 0;
+    osMutexAcquire(g_cargo_mutex, osWaitForever);
+    for (uint8_t i = 0; i < SLE_SERVER_CONN_MAX; i++) {
+        sle_server_conn_t *conn = sle_server_conn_at(i);
+        if (conn != NULL) {
+            conn_ids[count++] = conn->conn_id;
+        }
+    }
+    osMutexRelease(g_cargo_mutex);
+
+    for (uint8_t i = 0; i < count; i++) {
+        sle_read_remote_device_rssi(conn_ids[i]);
+    }
+}
+
+// 压测周期检查
+bool sle_server_bench_poll(sle_cargo_bench_report_t *report)
+{
+    if (report == NULL || g_cargo_mutex == NULL) {
+        return false;
+    }
+
+    uint32_t now = osKernelGetTickCount();
+    sle_cargo_bench_report_t final = {0};
+    uint16_t conn_id = 0;
+    uint8_t line = 0;
+    uint16_t seq = 0;
+    osMutexAcquire(g_cargo_mutex, osWaitForever);
+    bool expired = sle_cargo_bench_rx_expire(&g_bench_rx, now);
+    if (expired) {
+        // 没有收到最后一帧(发送端中途停止或断开): 以已收到的部分作为最终结果
+        sle_cargo_bench_rx_report(&g_bench_rx, now, &final);
+        conn_id = g_bench_rx.link;
+        seq = g_bench_report_seq++;
+        sle_server_conn_t *conn = sle_server_conn_find(conn_id);
+        line = (conn != NULL) ? conn->line : 0;
+    }
+    // 在副本上生成结果，不影响周期回报的时刻
+    sle_cargo_bench_rx_t rx = g_bench_rx;
+    osMutexRelease(g_cargo_mutex);
+
+    if (expired) {
+        sle_server_bench_report(conn_id, line, &final, seq, false);
+    }
+    sle_cargo_bench_rx_report(&rx, now, report);
+    return rx.active && (!rx.finished || (uint32_t)(now - rx.last_tick) < SLE_SERVER_BENCH_SHOW_MS);
+}
+
+// 获取分拣速率摘要
+void sle_server_get_rate_summary(sle_server_rate_summary_t *summary)
+{
+    static const uint16_t windows[SLE_SERVER_RATE_WINDOWS] = {
+        SLE_SERVER_RATE_BUCKETS_1M, SLE_SERVER_RATE_BUCKETS_10M, SLE_SERVER_RATE_BUCKETS_1H
+    };
+    if (summary == NULL) {
+        return;
+    }
+    (void)memset_s(summary, sizeof(*summary), 0, sizeof(*summary));
+    if (g_cargo_mutex == NULL) {
+        return;
+    }
+
+    osMutexAcquire(g_cargo_mutex, osWaitForever);
+    sle_cargo_history_advance(&g_history, osKernelGetTickCount());
+    for (uint8_t w = 0; w < SLE_SERVER_RATE_WINDOWS; w++) {
+        uint16_t n = sle_cargo_history_rate(&g_history, SLE_CARGO_HIST_FINE, windows[w], summary->per_min[w]);
+        summary->span_s[w] = (uint16_t)(n * SLE_CARGO_HIST_FINE_PERIOD_S);
+    }
+    sle_cargo_history_series(&g_history, SLE_CARGO_HIST_FINE, SLE_SERVER_RATE_SPARK_POINTS,
+                             SLE_SERVER_RATE_HOUR_PER_POINT, summary->hour);
+    sle_cargo_history_series(&g_history, SLE_CARGO_HIST_COARSE, SLE_SERVER_RATE_SPARK_POINTS,
+                             SLE_SERVER_RATE_DAY_PER_POINT, summary->day);
+    // 粗粒度一桶正好一分钟，逐桶找峰值
+    const sle_cargo_hist_tier_t *t = &g_history.tier[SLE_CARGO_HIST_COARSE];
+    sle_cargo_hist_bucket_t b;
+    for (uint16_t age = 1; sle_cargo_history_bucket(&g_history, SLE_CARGO_HIST_COARSE, age, &b); age++) {
+        uint32_t sum = (uint32_t)b.count[SLE_CARGO_REGION_JIANGSU] + b.count[SLE_CARGO_REGION_ZHEJIANG] +
+                       b.count[SLE_CARGO_REGION_SHANGHAI];
+        sum = sum * 60 / t->period_s;
+        if (sum > summary->peak_per_min) {
+            summary->peak_per_min = sum;
+            summary->peak_age_min = (uint16_t)(age * t->period_s / 60);
+        }
+    }
+    summary->saturated = g_history.saturated;
+    osMutexRelease(g_cargo_mutex);
+}
+
+// 速率历史周期检查: 推进历史使空闲时段计为0，有客户端请求导出时发送一块；发送时阻塞到发完，每次最多一块
+static void sle_server_history_poll(void)
+{
+    if (g_cargo_mutex == NULL) {
+        return;
+    }
+
+    sle_server_hist_export_t ex;
+    sle_cargo_hist_chunk_t chunk = {0};
+    uint16_t len = 0;
+    uint16_t next = 0;
+    osMutexAcquire(g_cargo_mutex, osWaitForever);
+    sle_cargo_history_advance(&g_history, osKernelGetTickCount());
+    if (g_hist_export.pending) {
+        // 上一块之后历史可能已推进，按结束时刻重新定位；要导出的桶已被覆盖时提前结束
+        sle_server_hist_export_t *cur = &g_hist_export;
+        uint16_t age = sle_cargo_history_age_at(&g_history, cur->tier, cur->end_ms);
+        if (age > 0) {
+            len = sle_cargo_history_export(&g_history, cur->tier, age, cur->remaining, g_hist_chunk,
+                                           sizeof(g_hist_chunk), &next);
+        }
+        uint16_t count = (len > 0) ? sle_cargo_history_decode(g_hist_chunk, len, &chunk, NULL, 0) : 0;
+        if (count > 0) {
+            cur->end_ms -= (uint32_t)count * g_history.tier[cur->tier].period_s * 1000;
+            cur->remaining = (count < cur->remaining) ? (uint16_t)(cur->remaining - count) : 0;
+            cur->sent += count;
+            cur->chunks++;
+        } else {
+            len = 0;
+        }
+        cur->pending = (len > 0 && next > 0 && cur->remaining > 0);
+    }
+    ex = g_hist_export;
+    osMutexRelease(g_cargo_mutex);
+    if (len == 0) {
+        return;
+    }
+
+    errcode_t ret = sle_server_send_bulk(ex.conn_id, SLE_CARGO_BULK_RATE_HISTORY, g_hist_chunk, len);
+    if (ret != ERRCODE_SUCC) {
+        osMutexAcquire(g_cargo_mutex, osWaitForever);
+        g_hist_export.pending = false;
+        osMutexRelease(g_cargo_mutex);
+        printf("[sle_server_63B] history export to 0x%04x aborted after %u buckets:0x%x\r\n", ex.conn_id,
+               ex.sent - chunk.count, ret);
+        return;
+    }
+    if (!ex.pending) {
+        printf("[sle_server_63B] history export to 0x%04x: tier=%u %u buckets in %u chunks\r\n", ex.conn_id,
+               ex.tier, ex.sent, ex.chunks);
+    }
+}
+
+// 按协商后的MTU分片，通过notify发送一条大消息
+errcode_t sle_server_send_bulk(uint16_t conn_id, uint8_t kind, const uint8_t *data, uint16_t len)
+{
+    if (g_cargo_mutex == NULL || data == NULL || len == 0 || len > SLE_CARGO_FRAG_MSG_MAX) {
+        return ERRCODE_FAIL;
+    }
+
+    uint32_t start = osKernelGetTickCount();
+    uint16_t mtu = 0;
+    bool started = false;
+    osMutexAcquire(g_cargo_mutex, osWaitForever);
+    sle_server_conn_t *conn = sle_server_conn_find(conn_id);
+    if (conn != NULL && conn->wire == SLE_CARGO_WIRE_BINARY && !g_bulk_busy) {
+        g_bulk_busy = sle_cargo_frag_tx_start(&g_bulk_tx, kind, data, len, start);
+        started = g_bulk_busy;
+        mtu = conn->mtu;
+    }
+    osMutexRelease(g_cargo_mutex);
+    if (!started) {
+        return ERRCODE_FAIL;
+    }
+
+    // notify没有对端确认，提交成功即视为送达；确认帧由协议栈回调线程发出，缓冲区满时让出CPU让它们先走
+    errcode_t ret = ERRCODE_SUCC;
+    while (sle_cargo_frag_tx_pending(&g_bulk_tx)) {
+        uint16_t n = sle_cargo_frag_tx_next(&g_bulk_tx, mtu, g_bulk_frame, sizeof(g_bulk_frame));
+        if (n == 0) {
+            ret = ERRCODE_FAIL;
+            break;
+        }
+        ret = sle_server_notify_raw(conn_id, g_bulk_frame, n);
+        if (ret == ERRCODE_SUCC) {
+            sle_cargo_frag_tx_on_confirm(&g_bulk_tx, true, osKernelGetTickCount());
+            continue;
+        }
+        sle_cargo_frag_tx_cancel(&g_bulk_tx);
+        osMutexAcquire(g_cargo_mutex, osWaitForever);
+        bool connected = (sle_server_conn_find(conn_id) != NULL);
+        osMutexRelease(g_cargo_mutex);
+        if (!connected || (uint32_t)(osKernelGetTickCount() - start) >= SLE_SERVER_BULK_TIMEOUT_MS) {
+            break;
+        }
+        osDelay(SLE_SERVER_BULK_RETRY_MS);
+    }
+
+    osMutexAcquire(g_cargo_mutex, osWaitForever);
+    bool done = !g_bulk_tx.active;
+    uint16_t sent = g_bulk_tx.offset;
+    sle_cargo_frag_tx_reset(&g_bulk_tx);
+    g_bulk_busy = false;
+    osMutexRelease(g_cargo_mutex);
+    if (!done) {
+        printf("[sle_server_63B] bulk to 0x%04x failed after %u/%u bytes:0x%x\r\n", conn_id, sent, len, ret);
+        return (ret == ERRCODE_SUCC) ? ERRCODE_FAIL : ret;
+    }
+    printf("[sle_server_63B] bulk to 0x%04x: %u bytes, mtu=%u, %ums\r\n", conn_id, len, mtu, g_bulk_tx.last_ms);
     return ERRCODE_SUCC;
 }
 
+// 发送货物数据到所有客户端
+errcode_t sle_server_send_cargo_data(uint32_t jiangsu, uint32_t zhejiang, uint32_t shanghai)
+{
+    if (g_cargo_mutex == NULL) {
+        return ERRCODE_FAIL;
+    }
+
+    // 按各对端使用的编码格式回发: 二进制快照帧或 "J:xxx,Z:xxx,S:xxx,T:timestamp"
+    static uint16_t tx_seq = 0;
+    sle_cargo_snapshot_t snap = { jiangsu, zhejiang, shanghai, osKernelGetTickCount() };
+    uint8_t bin[SLE_CARGO_SNAPSHOT_LEN] = {0};
+    uint8_t text[SLE_CARGO_TEXT_MAX_LEN] = {0};
+    uint16_t bin_len = sle_cargo_encode_snapshot(bin, sizeof(bin), tx_seq++, &snap);
+    uint16_t text_len = sle_cargo_encode_text((char *)text, sizeof(text), &snap);
+    if (bin_len == 0 || text_len == 0) {
+        printf("[sle_server_63B] encode cargo data failed\r\n");
+        return ERRCODE_FAIL;
+    }
+
+    uint16_t conn_ids[SLE_SERVER_CONN_MAX];
+    sle_cargo_wire_t wires[SLE_SERVER_CONN_MAX];
+    uint8_t count = 0;
+    osMutexAcquire(g_cargo_mutex, osWaitForever);
+    for (uint8_t i = 0; i < SLE_SERVER_CONN_MAX; i++) {
+        sle_server_conn_t *conn = sle_server_conn_at(i);
+        if (conn != NULL) {
+            conn_ids[count] = conn->conn_id;
+            wires[count] = conn->wire;
+            count++;
+        }
+    }
+    osMutexRelease(g_cargo_mutex);
+
+    if (count == 0) {
+        printf("[sle_server_63B] not connected, cannot send data\r\n");
+        return ERRCODE_FAIL;
+    }
+
+    // 通过notify发送数据，某个连接失败不影响其他连接
+    errcode_t result = ERRCODE_SUCC;
+    for (uint8_t i = 0; i < count; i++) {
+        bool binary = (wires[i] == SLE_CARGO_WIRE_BINARY);
+        errcode_t ret = binary ? sle_server_notify(conn_ids[i], bin, bin_len) :
+                                 sle_server_notify(conn_ids[i], text, text_len);
+        if (ret != ERRCODE_SUCC) {
+            result = ret;
+        }
+    }
+    
+    printf("[sle_server_63B] sent cargo data to %u clients: J=%u, Z=%u, S=%u\r\n", count, jiangsu, zhejiang,
+           shanghai);
+    return result;
+}
+
 // 获取连接状态
 bool sle_server_is_connected(void)
 {
-    return g_sle_connected;
+    return sle_server_get_conn_count(NULL) > 0;
 }
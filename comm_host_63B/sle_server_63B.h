@@ -19,6 +19,11 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "errcode.h"
+#include "sle_cargo_telemetry.h"
+#include "sle_cargo_bench.h"
+#include "sle_server_announce.h"
+#include "sle_cargo_history.h"
+#include "sle_cargo_clock.h"
 
 #ifdef __cplusplus
 #if __cplusplus
@@ -32,9 +37,83 @@ typedef struct {
     uint32_t zhejiang;   // 浙江货物数量 (01) 
     uint32_t shanghai;   // 上海货物数量 (02)
     uint64_t timestamp;  // 时间戳
+    uint16_t seq;        // 最近应用的帧序号
+    uint32_t gaps;       // 检测到的帧序号缺口次数
+    uint32_t events;     // 已计入的逐件分拣事件数
+    uint8_t last_id;     // 最近一件货物的编号
+    uint8_t last_region; // 最近一件货物的去向 (0江苏 1浙江 2上海，bit7表示无编号)
+    uint32_t last_gap_ms;// 最近两件货物的到达间隔 (发送端时钟)
+    uint32_t version;    // 状态更新次数，显示任务据此判断是否已上屏
+    uint32_t update_tick;// 本地更新时刻 (osKernelGetTickCount)
+    uint32_t origin_tick;// 分拣板串口收到最近一件货物的时刻换算到本地时钟，origin_valid 时有效
+    bool origin_valid;   // 本次更新来自事件帧且该分拣板已完成对时
+    uint16_t conn_id;    // 来源连接，全场合计中为最近更新的连接
+    uint8_t line;        // 产线编号 (接入槽位 1~N)，全场合计中为最近更新的产线
     bool valid;          // 数据有效标志
 } cargo_info_t;
 
+// 连接表容量
+#define SLE_SERVER_CONN_MAX 8
+
+// 0x1122 特征值的更新统计
+typedef struct {
+    uint32_t generation; // 特征值对应的快照代数
+    uint32_t encodes;    // 重新编码次数
+    uint32_t coalesced;  // 合并掉、没有单独编码的快照数
+    uint32_t reads;      // 应答的读请求数
+} sle_server_live_stats_t;
+
+// 分拣速率统计窗口: 最近1分钟、10分钟、1小时，取自10秒一桶的细粒度历史
+typedef enum {
+    SLE_SERVER_RATE_1M = 0,
+    SLE_SERVER_RATE_10M,
+    SLE_SERVER_RATE_1H,
+    SLE_SERVER_RATE_WINDOWS,
+} sle_server_rate_window_t;
+
+// 趋势图的点数，正好占满一行去掉标签后的宽度
+#define SLE_SERVER_RATE_SPARK_POINTS 18
+
+// 分拣速率摘要，供显示屏趋势页使用
+typedef struct {
+    uint32_t per_min[SLE_SERVER_RATE_WINDOWS][SLE_CARGO_REGION_MAX]; // 各窗口内各地区每分钟件数
+    uint16_t span_s[SLE_SERVER_RATE_WINDOWS];       // 各窗口实际覆盖的秒数，开机不久时小于窗口长度
+    uint32_t hour[SLE_SERVER_RATE_SPARK_POINTS];    // 最近1小时每200秒的合计件数，[0]最早
+    uint32_t day[SLE_SERVER_RATE_SPARK_POINTS];     // 最近1天每80分钟的合计件数，[0]最早
+    uint32_t peak_per_min;                          // 最近1天件数最多的一分钟
+    uint16_t peak_age_min;                          // 该分钟距今的分钟数
+    uint32_t saturated;                             // 因桶计数饱和少计的次数
+} sle_server_rate_summary_t;
+
+// 板间对时与单向时延: 各产线分拣板的时钟估计，以及从分拣板串口收到货物起算的时延分布
+typedef struct {
+    uint8_t count;                                  // 已接入的产线数
+    uint8_t line[SLE_SERVER_CONN_MAX];              // 产线编号
+    sle_cargo_clock_t clock[SLE_SERVER_CONN_MAX];   // 对应产线分拣板时钟相对本地的估计
+    sle_cargo_clock_lat_t rx;                       // 串口收到 -> 63B应用到计数
+    sle_cargo_clock_lat_t display;                  // 串口收到 -> 上屏
+} sle_server_latency_t;
+
+// 板上快照读写压力测试开关，默认关闭；板上任务只在tick边界被抢占，读写真正并行的情形由主机测试
+// sle_cargo_common/test/sle_cargo_latch_test.c 覆盖
+#ifndef SLE_SERVER_LATCH_STRESS
+#define SLE_SERVER_LATCH_STRESS 0
+#endif
+
+// 逐个写入打印应用结果和回发的确认帧，默认关闭；缺基准、过期帧、解码失败和大消息始终打印
+#ifndef SLE_SERVER_RX_LOG
+#define SLE_SERVER_RX_LOG 0
+#endif
+
+// 货物状态快照: 全场合计、各产线计数和连接数，读取时保证是同一时刻的完整状态
+typedef struct {
+    cargo_info_t hall;
+    cargo_info_t lines[SLE_SERVER_CONN_MAX];
+    uint8_t count;       // 已接入的产线数
+    uint8_t cap;         // 连接上限
+    uint32_t generation; // 快照的代数，读取时填写，每发布一次加1
+} sle_server_cargo_view_t;
+
 /**
  * @brief  星闪服务器初始化
  * @retval 错误码
@@ -42,20 +121,68 @@ typedef struct {
 errcode_t sle_server_63B_init(void);
 
 /**
- * @brief  获取最新的货物分拣信息
+ * @brief  读取货物状态快照，不加锁，不会阻塞处理写请求的接收任务
+ * @param  view: 输出的快照，generation 为其代数
+ * @retval 是否读到一致的快照，读取期间状态连续更新多次时返回false
+ */
+bool sle_server_get_cargo_view(sle_server_cargo_view_t *view);
+
+/**
+ * @brief  货物状态快照的当前代数，不变时显示任务可跳过读取和刷屏
+ * @retval 代数
+ */
+uint32_t sle_server_get_cargo_generation(void);
+
+/**
+ * @brief  获取 0x1122 特征值的更新统计。该特征可直接读取，返回全场合计的二进制快照帧，
+ *         帧序号为快照代数的低16位，时间为63B最近一次更新计数的时刻
+ * @param  stats: 输出
+ */
+void sle_server_get_live_stats(sle_server_live_stats_t *stats);
+
+/**
+ * @brief  获取全场合计的货物分拣信息 (所有已接入产线之和)
  * @param  cargo_info: 输出的货物信息
  * @retval 是否获取成功
  */
 bool sle_server_get_cargo_info(cargo_info_t *cargo_info);
 
+/**
+ * @brief  获取各产线的货物分拣信息，按产线编号排列
+ * @param  lines: 输出数组
+ * @param  max: 数组容量
+ * @retval 实际产线数
+ */
+uint8_t sle_server_get_line_info(cargo_info_t *lines, uint8_t max);
+
+/**
+ * @brief  显示任务上屏后回报已显示的各产线状态，显示了新状态时向对应客户端发送确认帧
+ * @param  lines: 刚刚显示的各产线货物信息
+ * @param  count: 产线数
+ */
+void sle_server_display_shown(const cargo_info_t *lines, uint8_t count);
+
 /**
  * @brief  获取星闪连接状态
- * @retval true=已连接，false=未连接
+ * @retval true=至少一个客户端已连接，false=未连接
  */
 bool sle_server_is_connected(void);
 
 /**
- * @brief  发送货物数据到星闪客户端
+ * @brief  获取当前连接数
+ * @param  cap: 输出连接上限，可为NULL
+ * @retval 已连接的客户端数
+ */
+uint8_t sle_server_get_conn_count(uint8_t *cap);
+
+/**
+ * @brief  设置连接上限，未达上限时继续广播
+ * @param  cap: 连接上限 (1~SLE_SERVER_CONN_MAX)
+ */
+void sle_server_set_conn_cap(uint8_t cap);
+
+/**
+ * @brief  发送货物数据到所有已连接的星闪客户端
  * @param  jiangsu: 江苏货物数量
  * @param  zhejiang: 浙江货物数量
  * @param  shanghai: 上海货物数量
@@ -63,6 +190,68 @@ bool sle_server_is_connected(void);
  */
 errcode_t sle_server_send_cargo_data(uint32_t jiangsu, uint32_t zhejiang, uint32_t shanghai);
 
+/**
+ * @brief  获取链路遥测。请求计数和时延对应二进制写入到确认帧发出: 收到一次写入计一个请求，确认帧提交成功/失败计确认/失败
+ * @param  telem: 输出的遥测，所有连接合计
+ */
+void sle_server_get_telemetry(sle_cargo_telem_t *telem);
+
+/**
+ * @brief  读取所有连接的RSSI，结果异步计入遥测，由主任务周期调用
+ */
+void sle_server_sample_rssi(void);
+
+/**
+ * @brief  按协商后的MTU分片，通过notify向一个客户端发送一条大消息 (分拣历史、日志等)，发完才返回
+ * @param  conn_id: 目标连接
+ * @param  kind: 消息内容类型 (sle_cargo_bulk_kind_t)
+ * @param  data: 消息内容
+ * @param  len: 消息长度，不超过 SLE_CARGO_FRAG_MSG_MAX
+ * @retval 错误码，已有消息在发送或超时未发完时返回失败
+ */
+errcode_t sle_server_send_bulk(uint16_t conn_id, uint8_t kind, const uint8_t *data, uint16_t len);
+
+/**
+ * @brief  获取分拣速率摘要: 各窗口的平均速率、1小时和1天的趋势及1天内的峰值
+ * @param  summary: 输出
+ */
+void sle_server_get_rate_summary(sle_server_rate_summary_t *summary);
+
+/**
+ * @brief  获取板间对时状态和单向时延分布。63B周期向各分拣板发出对时请求，
+ *         对时完成后事件帧携带的串口收到时刻换算到本地时钟，得到真实的单向时延
+ * @param  latency: 输出
+ */
+void sle_server_get_latency(sle_server_latency_t *latency);
+
+/**
+ * @brief  压测周期检查: 空闲超时结束本轮并回报最终结果，由显示任务周期调用
+ * @param  report: 输出的当前结果
+ * @retval 压测正在运行或结束不久，显示任务据此切换到压测页
+ */
+bool sle_server_bench_poll(sle_cargo_bench_report_t *report);
+
+/**
+ * @brief  广播调度周期检查: 到时切换到下一档间隔，由显示任务周期调用
+ */
+void sle_server_announce_update(void);
+
+/**
+ * @brief  获取广播调度状态和各调度的重连耗时统计
+ * @param  info: 输出
+ */
+void sle_server_get_announce_info(sle_server_announce_info_t *info);
+
+#if SLE_SERVER_LATCH_STRESS
+/**
+ * @brief  快照读写压力测试: 一个写者连续发布、两个读者连续读取，写者和读者轮流以高优先级打断对方，
+ *         校验读到的每份快照都完整一致且代数不倒退，输出读写次数、重读次数和撕裂次数
+ * @param  duration_ms: 每一轮的时长
+ * @retval 是否通过
+ */
+bool sle_server_latch_stress(uint32_t duration_ms);
+#endif
+
 #ifdef __cplusplus
 #if __cplusplus
 }
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2024 HiSilicon Technologies CO., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "sle_server_announce.h"
+#include <stdio.h>
+#include <string.h>
+
+// 一个退避档位: 本轮开始后 start_ms 起使用 interval
+typedef struct {
+    uint32_t start_ms;
+    uint32_t interval;
+} announce_step_t;
+
+static const announce_step_t g_adaptive_steps[SLE_SERVER_ANNOUNCE_STEPS] = {
+    { 0, 0xA0 },        // 20ms
+    { 10000, 0x320 },   // 100ms
+    { 60000, 0xFA0 },   // 500ms
+};
+
+static sle_server_announce_info_t g_announce;
+static uint32_t g_seg_tick = 0;     // 当前这段广播的开始时刻，用于累计时长和事件数
+static uint32_t g_seg_us = 0;       // 不足一个间隔的余量
+
+static uint32_t announce_step_interval(uint8_t schedule, uint8_t step)
+{
+    if (schedule == SLE_SERVER_ANNOUNCE_FIXED) {
+        return SLE_SERVER_ANNOUNCE_FIXED_INTERVAL;
+    }
+    return g_adaptive_steps[step].interval;
+}
+
+// 把上次累计以来的广播时长按当前间隔折算为事件数
+static void announce_account(uint32_t now)
+{
+    if (!g_announce.active) {
+        g_seg_tick = now;
+        return;
+    }
+    sle_server_announce_stats_t *st = &g_announce.stats[g_announce.schedule];
+    uint32_t ms = now - g_seg_tick;
+    uint32_t interval_us = announce_step_interval(g_announce.schedule, g_announce.step) *
+                           SLE_SERVER_ANNOUNCE_UNIT_US;
+    st->on_ms += ms;
+    g_seg_us += ms * 1000;
+    st->events += g_seg_us / interval_us;
+    g_seg_us %= interval_us;
+    g_seg_tick = now;
+}
+
+void sle_server_announce_init(uint32_t now)
+{
+    memset(&g_announce, 0, sizeof(g_announce));
+    g_announce.schedule = (SLE_SERVER_ANNOUNCE_SCHEDULE == SLE_SERVER_ANNOUNCE_FIXED) ?
+                          SLE_SERVER_ANNOUNCE_FIXED : SLE_SERVER_ANNOUNCE_ADAPTIVE;
+    g_announce.burst_tick = now;
+    g_seg_tick = now;
+    g_seg_us = 0;
+}
+
+uint32_t sle_server_announce_restart(uint8_t reason, uint32_t now)
+{
+    announce_account(now);
+    if (SLE_SERVER_ANNOUNCE_SCHEDULE == SLE_SERVER_ANNOUNCE_ALTERNATE && reason == SLE_SERVER_ANNOUNCE_DISCONNECT) {
+        g_announce.schedule = (g_announce.schedule == SLE_SERVER_ANNOUNCE_FIXED) ?
+                              SLE_SERVER_ANNOUNCE_ADAPTIVE : SLE_SERVER_ANNOUNCE_FIXED;
+    }
+    g_announce.step = 0;
+    g_announce.reason = reason;
+    g_announce.active = true;
+    g_announce.burst_tick = now;
+    if (reason != SLE_SERVER_ANNOUNCE_CAP && !g_announce.timing) {
+        g_announce.timing = true;
+        g_announce.timer_tick = now;
+        g_announce.timer_schedule = g_announce.schedule;
+    }
+    return sle_server_announce_interval();
+}
+
+bool sle_server_announce_connected(bool resume, uint32_t now, uint32_t *ttr_ms)
+{
+    announce_account(now);
+    g_announce.active = resume;
+
+    if (!g_announce.timing) {
+        return false;
+    }
+    g_announce.timing = false;
+    uint32_t ms = now - g_announce.timer_tick;
+    sle_server_announce_stats_t *st = &g_announce.stats[g_announce.timer_schedule];
+    st->reconnects++;
+    st->ttr_last_ms = ms;
+    st->ttr_total_ms += ms;
+    if (ms > st->ttr_max_ms) {
+        st->ttr_max_ms = ms;
+    }
+    if (ttr_ms != NULL) {
+        *ttr_ms = ms;
+    }
+    return true;
+}
+
+bool sle_server_announce_poll(uint32_t now)
+{
+    if (!g_announce.active || g_announce.schedule == SLE_SERVER_ANNOUNCE_FIXED) {
+        return false;
+    }
+    uint32_t elapsed = now - g_announce.burst_tick;
+    uint8_t step = g_announce.step;
+    while (step + 1 < SLE_SERVER_ANNOUNCE_STEPS && elapsed >= g_adaptive_steps[step + 1].start_ms) {
+        step++;
+    }
+    if (step == g_announce.step) {
+        return false;
+    }
+    announce_account(now);
+    g_announce.step = step;
+    return true;
+}
+
+uint32_t sle_server_announce_interval(void)
+{
+    return announce_step_interval(g_announce.schedule, g_announce.step);
+}
+
+void sle_server_announce_get_info(sle_server_announce_info_t *info, uint32_t now)
+{
+    if (info == NULL) {
+        return;
+    }
+    announce_account(now);
+    *info = g_announce;
+}
+
+const char *sle_server_announce_name(uint8_t schedule)
+{
+    return (schedule == SLE_SERVER_ANNOUNCE_FIXED) ? "fixed" : "adaptive";
+}
+
+uint16_t sle_server_announce_format(const sle_server_announce_info_t *info, char *buf, uint16_t cap)
+{
+    if (info == NULL || buf == NULL || cap == 0) {
+        return 0;
+    }
+    uint32_t interval_us = announce_step_interval(info->schedule, info->step) * SLE_SERVER_ANNOUNCE_UNIT_US;
+    int n = snprintf(buf, cap, "%s %s step=%u %ums", sle_server_announce_name(info->schedule),
+                     info->active ? "on" : "off", info->step, interval_us / 1000);
+    for (uint8_t i = 0; i < SLE_SERVER_ANNOUNCE_ALTERNATE && n > 0 && n < cap; i++) {
+        const sle_server_announce_stats_t *st = &info->stats[i];
+        uint32_t avg = (st->reconnects > 0) ? (st->ttr_total_ms / st->reconnects) : 0;
+        n += snprintf(buf + n, cap - n, " | %s ttr n=%u last=%u avg=%u max=%u on=%us events=%u",
+                      sle_server_announce_name(i), st->reconnects, st->ttr_last_ms, avg, st->ttr_max_ms,
+                      st->on_ms / 1000, st->events);
+    }
+    if (n < 0) {
+        buf[0] = '\0';
+        return 0;
+    }
+    return (uint16_t)((n < cap) ? n : (cap - 1));
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2024 HiSilicon Technologies CO., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SLE_SERVER_ANNOUNCE_H
+#define SLE_SERVER_ANNOUNCE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+#endif /* __cplusplus */
+
+// 广播调度: 启动或断开后先以短间隔密集广播，之后逐级放慢到空闲间隔，
+// 既让分拣板尽快重新发现显示板，又不在长时间无人接入时持续占用射频
+typedef enum {
+    SLE_SERVER_ANNOUNCE_FIXED = 0,      // 固定25ms (原行为)
+    SLE_SERVER_ANNOUNCE_ADAPTIVE,       // 密集后逐级退避
+    SLE_SERVER_ANNOUNCE_ALTERNATE,      // 每次断开轮换上面两种，用于对比重连耗时
+} sle_server_announce_schedule_t;
+
+#ifndef SLE_SERVER_ANNOUNCE_SCHEDULE
+#define SLE_SERVER_ANNOUNCE_SCHEDULE    SLE_SERVER_ANNOUNCE_ADAPTIVE
+#endif
+
+// 广播间隔单位 0.125ms
+#define SLE_SERVER_ANNOUNCE_UNIT_US     125
+#define SLE_SERVER_ANNOUNCE_FIXED_INTERVAL  0xC8    // 25ms
+// 退避档位: 开始后 0s 20ms，10s 100ms，60s 起 500ms
+#define SLE_SERVER_ANNOUNCE_STEPS       3
+
+// 重启一轮广播的原因
+typedef enum {
+    SLE_SERVER_ANNOUNCE_BOOT = 0,
+    SLE_SERVER_ANNOUNCE_DISCONNECT,
+    SLE_SERVER_ANNOUNCE_CAP,            // 提高连接上限，空出了槽位
+    SLE_SERVER_ANNOUNCE_REASON_MAX,
+} sle_server_announce_reason_t;
+
+// 一种调度的统计
+typedef struct {
+    uint32_t reconnects;                // 测得的重连次数
+    uint32_t ttr_last_ms;               // 最近一次: 开始广播到有分拣板接入
+    uint32_t ttr_max_ms;
+    uint32_t ttr_total_ms;
+    uint32_t on_ms;                     // 广播累计时长
+    uint32_t events;                    // 估算的广播事件数 (时长/间隔)，反映射频占用
+} sle_server_announce_stats_t;
+
+typedef struct {
+    uint8_t schedule;                   // 当前这一轮使用的调度 (FIXED 或 ADAPTIVE)
+    uint8_t step;                       // 当前档位
+    uint8_t reason;                     // 本轮的起因
+    bool active;                        // 正在广播
+    uint32_t burst_tick;                // 本轮开始时刻
+    bool timing;                        // 正在计时重连
+    uint32_t timer_tick;
+    uint8_t timer_schedule;             // 计时开始时的调度
+    sle_server_announce_stats_t stats[SLE_SERVER_ANNOUNCE_ALTERNATE];
+} sle_server_announce_info_t;
+
+/**
+ * @brief  清空调度状态和统计
+ * @note   调度本身不加锁，调用者负责与协议栈回调之间的互斥
+ * @param  now: 当前时刻(ms)
+ */
+void sle_server_announce_init(uint32_t now);
+
+/**
+ * @brief  从最快的档位开始新的一轮广播；启动或断开时同时开始重连计时 (已在计时则保留原起点)
+ * @param  reason: 起因 (sle_server_announce_reason_t)
+ * @param  now: 当前时刻(ms)
+ * @retval 应当使用的广播间隔 (0.125ms)
+ */
+uint32_t sle_server_announce_restart(uint8_t reason, uint32_t now);
+
+/**
+ * @brief  连接建立后协议栈停止广播，之后按需继续当前这一轮 (不回到最快档位)
+ * @param  resume: 未达连接上限，继续广播
+ * @param  now: 当前时刻(ms)
+ * @param  ttr_ms: 正在计时时输出本次重连耗时
+ * @retval 本次是否测得重连耗时
+ */
+bool sle_server_announce_connected(bool resume, uint32_t now, uint32_t *ttr_ms);
+
+/**
+ * @brief  按时间切换档位
+ * @param  now: 当前时刻(ms)
+ * @retval 档位是否变化，变化时调用者需要按 sle_server_announce_interval 重新设置广播参数
+ */
+bool sle_server_announce_poll(uint32_t now);
+
+/**
+ * @brief  当前档位的广播间隔
+ * @retval 间隔 (0.125ms)
+ */
+uint32_t sle_server_announce_interval(void);
+
+/**
+ * @brief  获取调度状态和统计，当前仍在广播的时长计入统计
+ * @param  info: 输出
+ * @param  now: 当前时刻(ms)
+ */
+void sle_server_announce_get_info(sle_server_announce_info_t *info, uint32_t now);
+
+/**
+ * @brief  调度名称
+ * @param  schedule: 调度
+ * @retval 名称
+ */
+const char *sle_server_announce_name(uint8_t schedule);
+
+/**
+ * @brief  格式化为一行文本，用于日志
+ * @param  info: 调度状态和统计
+ * @param  buf: 输出缓冲区
+ * @param  cap: 缓冲区容量
+ * @retval 写入的长度(不含结尾的'\0')
+ */
+uint16_t sle_server_announce_format(const sle_server_announce_info_t *info, char *buf, uint16_t cap);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* __cplusplus */
+
+#endif /* SLE_SERVER_ANNOUNCE_H */
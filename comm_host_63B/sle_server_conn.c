@@ -0,0 +1,297 @@
+/*
+ * Copyright (c) 2024 HiSilicon Technologies CO., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "sle_server_conn.h"
+#include <string.h>
+
+static sle_server_conn_t g_conn_table[SLE_SERVER_CONN_MAX];
+static uint8_t g_conn_cap = SLE_SERVER_CONN_CAP;
+static sle_cargo_frag_rx_t g_conn_frag_rx;
+
+static uint16_t clamp_lag(uint32_t ms)
+{
+    return (ms < SLE_CARGO_ACK_LAG_UNKNOWN) ? (uint16_t)ms : (SLE_CARGO_ACK_LAG_UNKNOWN - 1);
+}
+
+void sle_server_conn_init(uint8_t cap)
+{
+    memset(g_conn_table, 0, sizeof(g_conn_table));
+    sle_cargo_frag_rx_reset(&g_conn_frag_rx);
+    sle_server_conn_set_cap(cap);
+}
+
+void sle_server_conn_set_cap(uint8_t cap)
+{
+    if (cap == 0 || cap > SLE_SERVER_CONN_MAX) {
+        return;
+    }
+    g_conn_cap = cap;
+}
+
+uint8_t sle_server_conn_get_cap(void)
+{
+    return g_conn_cap;
+}
+
+uint8_t sle_server_conn_count(void)
+{
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < SLE_SERVER_CONN_MAX; i++) {
+        if (g_conn_table[i].used) {
+            count++;
+        }
+    }
+    return count;
+}
+
+sle_server_conn_t *sle_server_conn_add(uint16_t conn_id, const uint8_t *addr, uint32_t now)
+{
+    // 同一连接重复上报时复用原表项
+    sle_server_conn_t *conn = sle_server_conn_find(conn_id);
+    if (conn == NULL) {
+        if (sle_server_conn_count() >= g_conn_cap) {
+            return NULL;
+        }
+        for (uint8_t i = 0; i < SLE_SERVER_CONN_MAX; i++) {
+            if (!g_conn_table[i].used) {
+                conn = &g_conn_table[i];
+                memset(conn, 0, sizeof(*conn));
+                conn->line = i + 1;
+                break;
+            }
+        }
+        if (conn == NULL) {
+            return NULL;
+        }
+    }
+
+    conn->used = true;
+    conn->conn_id = conn_id;
+    if (addr != NULL) {
+        memcpy(conn->addr, addr, SLE_SERVER_CONN_ADDR_LEN);
+    }
+    conn->wire = SLE_CARGO_WIRE_TEXT;   // 收到对端第一帧后再确定编码格式
+    sle_cargo_rx_reset(&conn->rx);      // 等待新连接的第一个关键帧
+    memset(&conn->info, 0, sizeof(conn->info));
+    conn->info.conn_id = conn_id;
+    conn->info.line = conn->line;
+    conn->display_version = 0;
+    conn->display_lag_ms = SLE_CARGO_ACK_LAG_UNKNOWN;
+    conn->mtu = 0;
+    conn->phy = SLE_CARGO_PHY_1M;
+    sle_cargo_clock_init(&conn->clock);   // 重新接入的可能是重启过的分拣板
+    conn->clock_next_tick = now;
+    conn->connect_tick = now;
+    conn->last_write_tick = now;
+    return conn;
+}
+
+void sle_server_conn_remove(uint16_t conn_id)
+{
+    sle_server_conn_t *conn = sle_server_conn_find(conn_id);
+    if (conn != NULL) {
+        conn->used = false;
+        sle_cargo_frag_rx_drop_link(&g_conn_frag_rx, conn_id);
+    }
+}
+
+sle_server_conn_t *sle_server_conn_find(uint16_t conn_id)
+{
+    for (uint8_t i = 0; i < SLE_SERVER_CONN_MAX; i++) {
+        if (g_conn_table[i].used && g_conn_table[i].conn_id == conn_id) {
+            return &g_conn_table[i];
+        }
+    }
+    return NULL;
+}
+
+sle_server_conn_t *sle_server_conn_at(uint8_t slot)
+{
+    if (slot >= SLE_SERVER_CONN_MAX || !g_conn_table[slot].used) {
+        return NULL;
+    }
+    return &g_conn_table[slot];
+}
+
+sle_cargo_err_t sle_server_conn_on_write(sle_server_conn_t *conn, const uint8_t *data, uint16_t len, uint32_t now,
+                                         sle_cargo_frame_t *frame, sle_cargo_rx_result_t *result)
+{
+    if (conn == NULL || frame == NULL || result == NULL) {
+        return SLE_CARGO_ERR_PARAM;
+    }
+
+    conn->writes++;
+    conn->bytes += len;
+    conn->last_write_tick = now;
+
+    // 直接在协议栈缓冲区上解码，二进制帧与旧版文本帧共用同一个解码器
+    sle_cargo_err_t err = sle_cargo_decode(data, len, frame);
+    if (err != SLE_CARGO_OK) {
+        conn->decode_errors++;
+        return err;
+    }
+
+    conn->wire = frame->wire;
+    if (frame->type == SLE_CARGO_FRAME_FRAG) {
+        *result = SLE_CARGO_RX_STALE;
+        return SLE_CARGO_OK;
+    }
+
+    // 关键帧直接覆盖，增量帧在已确认基准上重建，事件按编号幂等计入
+    sle_cargo_rx_t *rx = &conn->rx;
+    sle_cargo_event_t prev_event = rx->last_event;
+    uint32_t prev_events = rx->events;
+    *result = sle_cargo_rx_apply(rx, frame);
+    if (*result != SLE_CARGO_RX_APPLIED) {
+        return SLE_CARGO_OK;
+    }
+
+    cargo_info_t *info = &conn->info;
+    info->jiangsu = rx->state.jiangsu;
+    info->zhejiang = rx->state.zhejiang;
+    info->shanghai = rx->state.shanghai;
+    info->timestamp = rx->state.tick;
+    info->seq = rx->last_seq;
+    info->gaps = rx->gaps;
+    info->events = rx->events;
+    info->last_id = rx->last_event.item_id;
+    info->last_region = rx->last_event.region;
+    if (frame->type == SLE_CARGO_FRAME_EVENTS) {
+        // 到达间隔取最后两件: 同一批内有两件以上时都在本帧中，否则与上一批最后一件比较
+        if (rx->events - prev_events >= 2) {
+            sle_cargo_event_get(frame, frame->event_count - 2, &prev_event);
+        }
+        info->last_gap_ms = (rx->events >= 2) ? (rx->last_event.tick - prev_event.tick) : 0;
+    }
+    // 事件时刻是分拣板串口收到货物的时刻，对时完成后换算到本地时钟，供统计单向时延；关键帧可能是重发的旧状态，不计
+    info->origin_valid = (frame->type == SLE_CARGO_FRAME_EVENTS) &&
+                         sle_cargo_clock_to_local(&conn->clock, (uint32_t)info->timestamp, &info->origin_tick);
+    info->update_tick = now;
+    info->version++;
+    info->valid = true;
+    return SLE_CARGO_OK;
+}
+
+sle_cargo_frag_rx_result_t sle_server_conn_on_fragment(sle_server_conn_t *conn, const sle_cargo_frag_t *frag,
+                                                       uint32_t now, sle_cargo_frag_msg_t *msg)
+{
+    if (conn == NULL) {
+        return SLE_CARGO_FRAG_RX_DROPPED;
+    }
+    sle_cargo_frag_rx_result_t res = sle_cargo_frag_rx_push(&g_conn_frag_rx, conn->conn_id, frag, now, msg);
+    if (res == SLE_CARGO_FRAG_RX_COMPLETE) {
+        conn->bulk_messages++;
+    }
+    return res;
+}
+
+void sle_server_conn_release_message(const sle_cargo_frag_msg_t *msg)
+{
+    sle_cargo_frag_rx_release(&g_conn_frag_rx, msg);
+}
+
+const sle_cargo_frag_rx_t *sle_server_conn_frag_stats(void)
+{
+    return &g_conn_frag_rx;
+}
+
+uint8_t sle_server_conn_write_flags(const sle_server_conn_t *conn, const sle_cargo_frame_t *frame,
+                                    sle_cargo_rx_result_t result)
+{
+    if (conn == NULL || frame == NULL) {
+        return 0;
+    }
+    if (result == SLE_CARGO_RX_APPLIED && frame->type != SLE_CARGO_FRAME_EVENTS) {
+        return SLE_CARGO_ACK_RTT_VALID;
+    }
+    if (result == SLE_CARGO_RX_NEED_KEYFRAME) {
+        return (frame->type == SLE_CARGO_FRAME_EVENTS && conn->rx.synced) ?
+               SLE_CARGO_ACK_EVENT_GAP : SLE_CARGO_ACK_NEED_KEYFRAME;
+    }
+    return 0;
+}
+
+uint16_t sle_server_conn_build_ack(sle_server_conn_t *conn, uint8_t flags, uint32_t now, uint8_t *buf, uint16_t cap,
+                                   sle_cargo_ack_t *out)
+{
+    if (conn == NULL) {
+        return 0;
+    }
+
+    const cargo_info_t *info = &conn->info;
+    sle_cargo_ack_t ack = {0};
+    ack.last_seq = info->seq;
+    ack.total = info->jiangsu + info->zhejiang + info->shanghai;
+    ack.echo_tick = (uint32_t)info->timestamp;
+    ack.flags = flags | (conn->rx.synced ? SLE_CARGO_ACK_SYNCED : SLE_CARGO_ACK_NEED_KEYFRAME);
+    if (!info->valid) {
+        ack.display_lag_ms = SLE_CARGO_ACK_LAG_UNKNOWN;
+    } else if (conn->display_version == info->version) {
+        ack.flags |= SLE_CARGO_ACK_DISPLAY_CURRENT;
+        ack.display_lag_ms = conn->display_lag_ms;
+    } else {
+        ack.display_lag_ms = clamp_lag(now - info->update_tick);
+    }
+    if (out != NULL) {
+        *out = ack;
+    }
+    return sle_cargo_encode_ack(buf, cap, conn->ack_seq++, &ack);
+}
+
+bool sle_server_conn_display_shown(sle_server_conn_t *conn, const cargo_info_t *shown, uint32_t now)
+{
+    if (conn == NULL || shown == NULL || !shown->valid || shown->version == conn->display_version) {
+        return false;
+    }
+    conn->display_lag_ms = clamp_lag(now - shown->update_tick);
+    conn->display_version = shown->version;
+    return true;
+}
+
+void sle_server_conn_hall_totals(cargo_info_t *hall)
+{
+    if (hall == NULL) {
+        return;
+    }
+
+    memset(hall, 0, sizeof(*hall));
+    uint32_t latest = 0;
+    for (uint8_t i = 0; i < SLE_SERVER_CONN_MAX; i++) {
+        const sle_server_conn_t *conn = &g_conn_table[i];
+        if (!conn->used || !conn->info.valid) {
+            continue;
+        }
+        const cargo_info_t *info = &conn->info;
+        hall->jiangsu += info->jiangsu;
+        hall->zhejiang += info->zhejiang;
+        hall->shanghai += info->shanghai;
+        hall->gaps += info->gaps;
+        hall->events += info->events;
+        hall->version += info->version;
+        // 最近一件货物取最后更新的产线
+        if (!hall->valid || (int32_t)(info->update_tick - latest) >= 0) {
+            latest = info->update_tick;
+            hall->timestamp = info->timestamp;
+            hall->update_tick = info->update_tick;
+            hall->seq = info->seq;
+            hall->last_id = info->last_id;
+            hall->last_region = info->last_region;
+            hall->last_gap_ms = info->last_gap_ms;
+            hall->line = info->line;
+            hall->conn_id = info->conn_id;
+        }
+        hall->valid = true;
+    }
+}
@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2024 HiSilicon Technologies CO., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SLE_SERVER_CONN_H
+#define SLE_SERVER_CONN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sle_cargo_proto.h"
+#include "sle_cargo_sync.h"
+#include "sle_cargo_frag.h"
+#include "sle_cargo_phy.h"
+#include "sle_cargo_clock.h"
+#include "sle_server_63B.h"
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+#endif /* __cplusplus */
+
+// 默认允许同时接入的分拣板数量，连接表容量 SLE_SERVER_CONN_MAX 见 sle_server_63B.h
+#ifndef SLE_SERVER_CONN_CAP
+#define SLE_SERVER_CONN_CAP         4
+#endif
+
+#define SLE_SERVER_CONN_ADDR_LEN    6
+
+// 负载测试开关，默认关闭
+#ifndef SLE_SERVER_CONN_LOADTEST
+#define SLE_SERVER_CONN_LOADTEST    0
+#endif
+
+// 单个分拣板连接的状态和统计
+typedef struct {
+    bool used;
+    uint16_t conn_id;
+    uint8_t line;                               // 显示用的产线编号，按接入槽位 1~N
+    uint8_t addr[SLE_SERVER_CONN_ADDR_LEN];
+    sle_cargo_wire_t wire;                      // 对端最近一次使用的编码格式
+    sle_cargo_rx_t rx;                          // 由关键帧、增量帧和事件重建的计数
+    cargo_info_t info;                          // 最新计数，供显示和确认帧使用
+    uint32_t display_version;                   // 显示屏最近显示的状态版本
+    uint16_t display_lag_ms;
+    uint16_t ack_seq;
+    uint16_t mtu;                               // 协商后的MTU，0表示尚未协商
+    uint8_t phy;                                // 生效的PHY (sle_cargo_phy_t)，由分拣板按批量传输协商
+    sle_cargo_clock_t clock;                    // 分拣板时钟相对本地的估计，由对时回复更新
+    uint32_t clock_next_tick;                   // 下一次发出对时请求的时刻
+    uint16_t clock_seq;                         // 对时请求帧序号
+    // 统计
+    uint32_t writes;                            // 收到的写入次数
+    uint32_t bytes;                             // 收到的字节数
+    uint32_t decode_errors;                     // 解码失败次数
+    uint32_t bulk_messages;                     // 重组完成的大消息数
+    uint32_t connect_tick;                      // 接入时刻
+    uint32_t last_write_tick;                   // 最近一次写入时刻
+} sle_server_conn_t;
+
+/**
+ * @brief  清空连接表并设置连接上限
+ * @note   连接表本身不加锁，调用者负责与协议栈回调、显示任务之间的互斥
+ * @param  cap: 连接上限，1 ~ SLE_SERVER_CONN_MAX
+ */
+void sle_server_conn_init(uint8_t cap);
+
+/**
+ * @brief  设置连接上限，已接入的连接不受影响
+ * @param  cap: 连接上限，1 ~ SLE_SERVER_CONN_MAX
+ */
+void sle_server_conn_set_cap(uint8_t cap);
+
+/**
+ * @brief  获取连接上限
+ * @retval 连接上限
+ */
+uint8_t sle_server_conn_get_cap(void);
+
+/**
+ * @brief  获取当前连接数
+ * @retval 连接数
+ */
+uint8_t sle_server_conn_count(void);
+
+/**
+ * @brief  登记新连接
+ * @param  conn_id: 连接ID
+ * @param  addr: 对端地址
+ * @param  now: 当前时刻
+ * @retval 连接表项，已达上限时返回NULL
+ */
+sle_server_conn_t *sle_server_conn_add(uint16_t conn_id, const uint8_t *addr, uint32_t now);
+
+/**
+ * @brief  删除连接
+ * @param  conn_id: 连接ID
+ */
+void sle_server_conn_remove(uint16_t conn_id);
+
+/**
+ * @brief  按连接ID查找
+ * @param  conn_id: 连接ID
+ * @retval 连接表项，未找到时返回NULL
+ */
+sle_server_conn_t *sle_server_conn_find(uint16_t conn_id);
+
+/**
+ * @brief  按槽位遍历连接表
+ * @param  slot: 槽位，0 ~ SLE_SERVER_CONN_MAX-1
+ * @retval 连接表项，槽位空闲时返回NULL
+ */
+sle_server_conn_t *sle_server_conn_at(uint8_t slot);
+
+/**
+ * @brief  处理一次写入: 解码、应用到该连接的计数并更新统计；分片帧只解码，由 sle_server_conn_on_fragment 重组
+ * @param  conn: 连接表项
+ * @param  data: 写入数据
+ * @param  len: 数据长度
+ * @param  now: 当前时刻
+ * @param  frame: 输出的解码结果
+ * @param  result: 输出的应用结果，仅在返回 SLE_CARGO_OK 时有效
+ * @retval 解码结果
+ */
+sle_cargo_err_t sle_server_conn_on_write(sle_server_conn_t *conn, const uint8_t *data, uint16_t len, uint32_t now,
+                                         sle_cargo_frame_t *frame, sle_cargo_rx_result_t *result);
+
+/**
+ * @brief  把一个分片写入重组池 (所有连接共用，每个连接同时最多重组一条消息)
+ * @param  conn: 连接表项
+ * @param  frag: sle_server_conn_on_write 解码得到的分片
+ * @param  now: 当前时刻
+ * @param  msg: 消息完整时输出，处理完后调用 sle_server_conn_release_message
+ * @retval 重组结果
+ */
+sle_cargo_frag_rx_result_t sle_server_conn_on_fragment(sle_server_conn_t *conn, const sle_cargo_frag_t *frag,
+                                                       uint32_t now, sle_cargo_frag_msg_t *msg);
+
+/**
+ * @brief  释放已处理完的大消息
+ * @param  msg: sle_server_conn_on_fragment 输出的消息
+ */
+void sle_server_conn_release_message(const sle_cargo_frag_msg_t *msg);
+
+/**
+ * @brief  获取重组池统计
+ * @retval 重组池，只读
+ */
+const sle_cargo_frag_rx_t *sle_server_conn_frag_stats(void);
+
+/**
+ * @brief  根据一次写入的处理结果得到确认帧标志
+ * @param  conn: 连接表项
+ * @param  frame: 解码后的帧
+ * @param  result: 应用结果
+ * @retval SLE_CARGO_ACK_* 中与本次写入相关的标志
+ */
+uint8_t sle_server_conn_write_flags(const sle_server_conn_t *conn, const sle_cargo_frame_t *frame,
+                                    sle_cargo_rx_result_t result);
+
+/**
+ * @brief  编码该连接的确认帧
+ * @param  conn: 连接表项
+ * @param  flags: 附加标志
+ * @param  now: 当前时刻
+ * @param  buf: 输出缓冲区，容量至少 SLE_CARGO_ACK_LEN
+ * @param  cap: 缓冲区容量
+ * @param  out: 输出编码的确认内容，可为NULL
+ * @retval 帧长度，失败返回0
+ */
+uint16_t sle_server_conn_build_ack(sle_server_conn_t *conn, uint8_t flags, uint32_t now, uint8_t *buf, uint16_t cap,
+                                   sle_cargo_ack_t *out);
+
+/**
+ * @brief  记录显示屏已显示的状态
+ * @param  conn: 连接表项
+ * @param  shown: 刚显示的该连接货物信息
+ * @param  now: 当前时刻
+ * @retval true=显示了新状态
+ */
+bool sle_server_conn_display_shown(sle_server_conn_t *conn, const cargo_info_t *shown, uint32_t now);
+
+/**
+ * @brief  汇总所有连接得到全场合计
+ * @param  hall: 输出的合计，任一连接有数据时 valid 为 true
+ */
+void sle_server_conn_hall_totals(cargo_info_t *hall);
+
+#if SLE_SERVER_CONN_LOADTEST
+/**
+ * @brief  用多个模拟分拣板对连接表做负载测试，校验每条产线和全场合计并输出处理速率
+ * @param  clients: 模拟的分拣板数量
+ * @param  rounds: 每块板发送的帧数
+ */
+void sle_server_conn_loadtest(uint8_t clients, uint32_t rounds);
+#endif
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* __cplusplus */
+
+#endif /* SLE_SERVER_CONN_H */
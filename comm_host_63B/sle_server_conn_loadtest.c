@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2024 HiSilicon Technologies CO., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "sle_server_conn.h"
+
+#if SLE_SERVER_CONN_LOADTEST
+#include <stdio.h>
+#include <string.h>
+#include "systick.h"
+#include "sle_cargo_rand.h"
+
+#define LOADTEST_CONN_ID_BASE   0x0100
+#define LOADTEST_DROP_PERCENT   10      // 模拟空口丢帧的比例
+#define LOADTEST_EVENT_PERCENT  70      // 逐件事件与快照/增量帧的比例
+
+// 模拟的分拣板: 自己的计数和发送端状态
+typedef struct {
+    uint16_t conn_id;
+    uint32_t counts[SLE_CARGO_REGION_MAX];
+    sle_cargo_tx_t tx;
+    uint32_t tick;
+} loadtest_client_t;
+
+static loadtest_client_t g_clients[SLE_SERVER_CONN_MAX];
+static uint32_t g_rand_state = 0x20250707;
+static uint32_t g_writes = 0;
+static uint32_t g_dropped = 0;
+static uint64_t g_write_us = 0;
+
+// 固定初值，保证每次运行结果一致
+static uint32_t loadtest_rand(void)
+{
+    return sle_cargo_rand(&g_rand_state);
+}
+
+static uint32_t loadtest_total(const loadtest_client_t *client)
+{
+    return client->counts[SLE_CARGO_REGION_JIANGSU] + client->counts[SLE_CARGO_REGION_ZHEJIANG] +
+           client->counts[SLE_CARGO_REGION_SHANGHAI];
+}
+
+// 模拟协议栈写回调: 按比例丢帧，否则交给连接表处理，返回是否送达
+static bool loadtest_deliver(loadtest_client_t *client, const uint8_t *data, uint16_t len)
+{
+    if (loadtest_rand() % 100 < LOADTEST_DROP_PERCENT) {
+        g_dropped++;
+        return false;
+    }
+
+    sle_cargo_frame_t frame;
+    sle_cargo_rx_result_t result = SLE_CARGO_RX_STALE;
+    uint64_t t0 = uapi_systick_get_us();
+    sle_server_conn_t *conn = sle_server_conn_find(client->conn_id);
+    sle_cargo_err_t err = sle_server_conn_on_write(conn, data, len, client->tick, &frame, &result);
+    uint8_t flags = sle_server_conn_write_flags(conn, &frame, result);
+    g_write_us += uapi_systick_get_us() - t0;
+    g_writes++;
+
+    if (err != SLE_CARGO_OK) {
+        printf("[sle_server_loadtest] conn 0x%04x decode failed: %s\r\n", client->conn_id, sle_cargo_err_str(err));
+        return true;
+    }
+    // 与确认帧的处理相同: 对端缺少基准或事件不连续时补发关键帧
+    if (flags & (SLE_CARGO_ACK_NEED_KEYFRAME | SLE_CARGO_ACK_EVENT_GAP)) {
+        sle_cargo_tx_request_keyframe(&client->tx);
+    }
+    return true;
+}
+
+// 分拣一件货物并以单条事件帧发出
+static void loadtest_sort_item(loadtest_client_t *client)
+{
+    uint8_t region = (uint8_t)(loadtest_rand() % SLE_CARGO_REGION_MAX);
+    client->counts[region]++;
+
+    sle_cargo_event_t ev = {0};
+    ev.no = (uint16_t)loadtest_total(client);
+    ev.item_id = (uint8_t)loadtest_rand();
+    ev.region = region;
+    ev.tick = client->tick;
+
+    uint8_t buf[SLE_CARGO_EVENTS_MAX_LEN];
+    uint16_t len = sle_cargo_encode_events(buf, sizeof(buf), client->tx.next_seq, &ev, 1);
+    loadtest_deliver(client, buf, len);
+}
+
+// 发送快照或增量帧，写确认反映是否送达
+static void loadtest_sync(loadtest_client_t *client)
+{
+    sle_cargo_snapshot_t snap = {
+        client->counts[SLE_CARGO_REGION_JIANGSU],
+        client->counts[SLE_CARGO_REGION_ZHEJIANG],
+        client->counts[SLE_CARGO_REGION_SHANGHAI],
+        client->tick,
+    };
+    uint8_t buf[SLE_CARGO_SNAPSHOT_LEN];
+    uint16_t len = sle_cargo_tx_encode(&client->tx, &snap, buf, sizeof(buf));
+    if (len == 0) {
+        return;
+    }
+    sle_cargo_tx_on_confirm(&client->tx, loadtest_deliver(client, buf, len));
+}
+
+// 分拣板重新接入: 连接表项和发送端都从关键帧重新开始
+static void loadtest_reconnect(loadtest_client_t *client)
+{
+    static const uint8_t addr[SLE_SERVER_CONN_ADDR_LEN] = {0};
+    sle_server_conn_remove(client->conn_id);
+    if (sle_server_conn_add(client->conn_id, addr, client->tick) == NULL) {
+        printf("[sle_server_loadtest] reconnect of 0x%04x rejected\r\n", client->conn_id);
+    }
+    sle_cargo_tx_reset(&client->tx);
+}
+
+// 校验每条产线与对应分拣板一致，全场合计等于各板之和
+static uint32_t loadtest_verify(uint8_t clients)
+{
+    uint32_t fail = 0;
+    uint32_t sum[SLE_CARGO_REGION_MAX] = {0};
+    for (uint8_t i = 0; i < clients; i++) {
+        const loadtest_client_t *client = &g_clients[i];
+        const sle_server_conn_t *conn = sle_server_conn_find(client->conn_id);
+        for (uint8_t r = 0; r < SLE_CARGO_REGION_MAX; r++) {
+            sum[r] += client->counts[r];
+        }
+        if (conn == NULL || conn->info.jiangsu != client->counts[SLE_CARGO_REGION_JIANGSU] ||
+            conn->info.zhejiang != client->counts[SLE_CARGO_REGION_ZHEJIANG] ||
+            conn->info.shanghai != client->counts[SLE_CARGO_REGION_SHANGHAI]) {
+            fail++;
+            printf("[sle_server_loadtest] L%u mismatch: expect %u/%u/%u\r\n", i + 1,
+                   client->counts[SLE_CARGO_REGION_JIANGSU], client->counts[SLE_CARGO_REGION_ZHEJIANG],
+                   client->counts[SLE_CARGO_REGION_SHANGHAI]);
+            continue;
+        }
+        printf("[sle_server_loadtest] L%u %u/%u/%u writes=%u events=%u dups=%u gaps=%u\r\n", conn->line,
+               conn->info.jiangsu, conn->info.zhejiang, conn->info.shanghai, conn->writes, conn->rx.events,
+               conn->rx.event_dups, conn->rx.event_gaps);
+    }
+
+    cargo_info_t hall;
+    sle_server_conn_hall_totals(&hall);
+    if (hall.jiangsu != sum[SLE_CARGO_REGION_JIANGSU] || hall.zhejiang != sum[SLE_CARGO_REGION_ZHEJIANG] ||
+        hall.shanghai != sum[SLE_CARGO_REGION_SHANGHAI]) {
+        fail++;
+    }
+    printf("[sle_server_loadtest] hall %u/%u/%u expect %u/%u/%u\r\n", hall.jiangsu, hall.zhejiang, hall.shanghai,
+           sum[SLE_CARGO_REGION_JIANGSU], sum[SLE_CARGO_REGION_ZHEJIANG], sum[SLE_CARGO_REGION_SHANGHAI]);
+    return fail;
+}
+
+void sle_server_conn_loadtest(uint8_t clients, uint32_t rounds)
+{
+    static const uint8_t addr[SLE_SERVER_CONN_ADDR_LEN] = {0};
+    uint32_t fail = 0;
+
+    if (clients == 0 || clients > SLE_SERVER_CONN_MAX) {
+        return;
+    }
+
+    // 上限设为模拟板数，多出的一块必须被拒绝
+    sle_server_conn_init(clients);
+    memset(g_clients, 0, sizeof(g_clients));
+    g_writes = 0;
+    g_dropped = 0;
+    g_write_us = 0;
+    for (uint8_t i = 0; i < clients; i++) {
+        g_clients[i].conn_id = LOADTEST_CONN_ID_BASE + i;
+        sle_cargo_tx_reset(&g_clients[i].tx);
+        if (sle_server_conn_add(g_clients[i].conn_id, addr, 0) == NULL) {
+            fail++;
+        }
+    }
+    if (clients < SLE_SERVER_CONN_MAX && sle_server_conn_add(LOADTEST_CONN_ID_BASE + clients, addr, 0) != NULL) {
+        printf("[sle_server_loadtest] connection over cap was accepted\r\n");
+        fail++;
+    }
+
+    // 各分拣板的写入交错到达，中途一块板断线重连
+    for (uint32_t n = 0; n < rounds * clients; n++) {
+        loadtest_client_t *client = &g_clients[loadtest_rand() % clients];
+        client->tick += 1 + loadtest_rand() % 50;
+        if (n == rounds * clients / 2) {
+            loadtest_reconnect(client);
+        }
+        if (loadtest_rand() % 100 < LOADTEST_EVENT_PERCENT) {
+            loadtest_sort_item(client);
+        } else {
+            loadtest_sync(client);
+        }
+    }
+
+    // 收尾: 每块板补发关键帧直到送达，此后各产线应与分拣板完全一致
+    for (uint8_t i = 0; i < clients; i++) {
+        loadtest_client_t *client = &g_clients[i];
+        do {
+            sle_cargo_tx_request_keyframe(&client->tx);
+            client->tick++;
+            loadtest_sync(client);
+        } while (!client->tx.have_ack || client->tx.force_key);
+    }
+
+    fail += loadtest_verify(clients);
+    printf("[sle_server_loadtest] clients=%u writes=%u dropped=%u fail=%u\r\n", clients, g_writes, g_dropped, fail);
+    if (g_write_us > 0) {
+        printf("[sle_server_loadtest] write handling: %lluns/write, %llu writes/s\r\n",
+               g_write_us * 1000 / g_writes, (uint64_t)g_writes * 1000000 / g_write_us);
+    }
+}
+#endif
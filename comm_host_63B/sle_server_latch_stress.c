@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2024 HiSilicon Technologies CO., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "sle_server_63B.h"
+
+#if SLE_SERVER_LATCH_STRESS
+#include <stdio.h>
+#include <string.h>
+#include "cmsis_os2.h"
+#include "sle_cargo_latch.h"
+
+#define STRESS_READERS          2
+#define STRESS_BURST            32      // 高优先级一方每次醒来连续执行的次数
+#define STRESS_STACK_SIZE       2048
+
+// 一轮压力测试: 写者和读者谁的优先级高，高的一方每个tick醒来一次打断另一方
+typedef enum {
+    STRESS_WRITER_PREEMPTS = 0,
+    STRESS_READER_PREEMPTS,
+    STRESS_PHASE_MAX,
+} stress_phase_t;
+
+static const char *g_phase_names[STRESS_PHASE_MAX] = { "writer-preempts", "reader-preempts" };
+
+static sle_server_cargo_view_t g_copy[2];
+static sle_server_cargo_view_t g_next;                    // 只由写者使用
+static sle_server_cargo_view_t g_seen[STRESS_READERS];    // 每个读者一份
+static sle_cargo_latch_t g_latch;
+static volatile bool g_stop = false;
+static volatile uint8_t g_running = 0;
+static uint8_t g_phase = 0;
+static uint32_t g_writes = 0;
+static uint32_t g_reads[STRESS_READERS];
+static uint32_t g_torn[STRESS_READERS];
+static uint32_t g_backwards[STRESS_READERS];
+
+// 第n次发布的快照: 每个字段都由n推出，读到的快照中任意两个字段不一致即为撕裂
+static void stress_fill(sle_server_cargo_view_t *view, uint32_t n)
+{
+    memset(view, 0, sizeof(*view));
+    view->count = SLE_SERVER_CONN_MAX;
+    view->cap = (uint8_t)n;
+    for (uint8_t i = 0; i < SLE_SERVER_CONN_MAX; i++) {
+        cargo_info_t *info = &view->lines[i];
+        info->jiangsu = n + i;
+        info->zhejiang = n * 2 + i;
+        info->shanghai = n * 3 + i;
+        info->timestamp = ((uint64_t)n << 32) | n;
+        info->seq = (uint16_t)n;
+        info->version = n;
+        info->line = (uint8_t)(i + 1);
+        info->valid = true;
+        view->hall.jiangsu += info->jiangsu;
+        view->hall.zhejiang += info->zhejiang;
+        view->hall.shanghai += info->shanghai;
+    }
+    view->hall.version = n;
+    view->hall.timestamp = ((uint64_t)n << 32) | n;
+    view->hall.valid = true;
+}
+
+static bool stress_check(const sle_server_cargo_view_t *view)
+{
+    uint32_t n = view->hall.version;
+    if (view->count != SLE_SERVER_CONN_MAX || view->cap != (uint8_t)n || !view->hall.valid ||
+        view->hall.timestamp != (((uint64_t)n << 32) | n) || view->generation != n) {
+        return false;
+    }
+    uint32_t js = 0;
+    uint32_t zj = 0;
+    uint32_t sh = 0;
+    for (uint8_t i = 0; i < SLE_SERVER_CONN_MAX; i++) {
+        const cargo_info_t *info = &view->lines[i];
+        if (info->jiangsu != n + i || info->zhejiang != n * 2 + i || info->shanghai != n * 3 + i ||
+            info->version != n || info->seq != (uint16_t)n || info->line != i + 1 || !info->valid) {
+            return false;
+        }
+        js += info->jiangsu;
+        zj += info->zhejiang;
+        sh += info->shanghai;
+    }
+    return view->hall.jiangsu == js && view->hall.zhejiang == zj && view->hall.shanghai == sh;
+}
+
+static void stress_publish(void)
+{
+    g_writes++;
+    stress_fill(&g_next, g_writes);
+    sle_cargo_latch_publish(&g_latch, &g_next);
+}
+
+static void stress_writer(void *arg)
+{
+    (void)arg;
+    while (!g_stop) {
+        if (g_phase == STRESS_WRITER_PREEMPTS) {
+            for (uint8_t i = 0; i < STRESS_BURST; i++) {
+                stress_publish();
+            }
+            osDelay(1);
+        } else {
+            stress_publish();
+        }
+    }
+    __atomic_fetch_sub(&g_running, 1, __ATOMIC_RELAXED);
+}
+
+static void stress_read_one(uint8_t id, uint32_t *last)
+{
+    sle_server_cargo_view_t *view = &g_seen[id];
+    if (!sle_cargo_latch_read(&g_latch, view, &view->generation)) {
+        return;
+    }
+    g_reads[id]++;
+    if (!stress_check(view)) {
+        g_torn[id]++;
+    }
+    if (view->generation < *last) {
+        g_backwards[id]++;
+    }
+    *last = view->generation;
+}
+
+static void stress_reader(void *arg)
+{
+    uint8_t id = (uint8_t)(uintptr_t)arg;
+    uint32_t last = 0;
+    while (!g_stop) {
+        if (g_phase == STRESS_READER_PREEMPTS) {
+            for (uint8_t i = 0; i < STRESS_BURST; i++) {
+                stress_read_one(id, &last);
+            }
+            osDelay(1);
+        } else {
+            stress_read_one(id, &last);
+        }
+    }
+    __atomic_fetch_sub(&g_running, 1, __ATOMIC_RELAXED);
+}
+
+static bool stress_spawn(const char *name, osThreadFunc_t func, void *arg, osPriority_t priority)
+{
+    osThreadAttr_t attr = {
+        .name = name,
+        .attr_bits = 0U,
+        .cb_mem = NULL,
+        .cb_size = 0U,
+        .stack_mem = NULL,
+        .stack_size = STRESS_STACK_SIZE,
+        .priority = priority,
+    };
+    if (osThreadNew(func, arg, &attr) == NULL) {
+        printf("[latch_stress] create %s fail\r\n", name);
+        return false;
+    }
+    g_running++;
+    return true;
+}
+
+static bool stress_run_phase(uint8_t phase, uint32_t duration_ms)
+{
+    g_phase = phase;
+    g_stop = false;
+    g_running = 0;
+    g_writes = 0;
+    memset(g_reads, 0, sizeof(g_reads));
+    memset(g_torn, 0, sizeof(g_torn));
+    memset(g_backwards, 0, sizeof(g_backwards));
+    stress_fill(&g_next, 0);
+    sle_cargo_latch_init(&g_latch, &g_copy[0], &g_copy[1], sizeof(g_next), &g_next);
+
+    // 高优先级一方每个tick打断低优先级一方的拷贝，两轮分别覆盖读者被写者打断和写者被读者打断
+    osPriority_t writer_prio = (phase == STRESS_WRITER_PREEMPTS) ? osPriorityAboveNormal : osPriorityNormal;
+    osPriority_t reader_prio = (phase == STRESS_WRITER_PREEMPTS) ? osPriorityNormal : osPriorityAboveNormal;
+    (void)stress_spawn("LatchWriter", stress_writer, NULL, writer_prio);
+    for (uint8_t r = 0; r < STRESS_READERS; r++) {
+        (void)stress_spawn("LatchReader", stress_reader, (void *)(uintptr_t)r, reader_prio);
+    }
+    osDelay(duration_ms);
+    g_stop = true;
+    while (g_running > 0) {
+        osDelay(10);
+    }
+
+    uint32_t reads = 0;
+    uint32_t torn = 0;
+    uint32_t backwards = 0;
+    for (uint8_t r = 0; r < STRESS_READERS; r++) {
+        reads += g_reads[r];
+        torn += g_torn[r];
+        backwards += g_backwards[r];
+    }
+    printf("[latch_stress] %s: writes=%u reads=%u retries=%u fails=%u torn=%u backwards=%u %s\r\n",
+           g_phase_names[phase], g_writes, reads, g_latch.retries, g_latch.fails, torn, backwards,
+           (torn == 0 && backwards == 0 && reads > 0) ? "PASS" : "FAIL");
+    return torn == 0 && backwards == 0 && reads > 0;
+}
+
+bool sle_server_latch_stress(uint32_t duration_ms)
+{
+    bool pass = true;
+    for (uint8_t phase = 0; phase < STRESS_PHASE_MAX; phase++) {
+        pass = stress_run_phase(phase, duration_ms) && pass;
+    }
+    return pass;
+}
+#endif
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2024 HiSilicon Technologies CO., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "sle_server_rxq.h"
+#include "sle_cargo_proto.h"
+#include "securec.h"
+#include "cmsis_os2.h"
+#include "systick.h"
+#include <stdio.h>
+#include <string.h>
+
+#if SLE_SERVER_RXQ_DEPTH > 255
+#error "SLE_SERVER_RXQ_DEPTH must fit in a uint8_t slot index"
+#endif
+
+static sle_server_rxq_msg_t g_rxq_pool[SLE_SERVER_RXQ_DEPTH];
+static osMessageQueueId_t g_rxq_free = NULL;              // 空闲槽位编号
+static osMessageQueueId_t g_rxq_ready = NULL;             // 待处理槽位编号，按到达顺序
+static sle_server_rxq_stats_t g_rxq_stats;
+// 每组连接被丢弃的分拣数据帧数 (回调写) 与接收任务已处理到的值 (接收任务写)
+static volatile uint32_t g_rxq_conn_drops[SLE_SERVER_RXQ_CONN_SLOTS];
+static uint32_t g_rxq_conn_seen[SLE_SERVER_RXQ_CONN_SLOTS];
+
+bool sle_server_rxq_init(void)
+{
+    (void)memset_s(&g_rxq_stats, sizeof(g_rxq_stats), 0, sizeof(g_rxq_stats));
+    g_rxq_stats.depth = SLE_SERVER_RXQ_DEPTH;
+    g_rxq_free = osMessageQueueNew(SLE_SERVER_RXQ_DEPTH, sizeof(uint8_t), NULL);
+    g_rxq_ready = osMessageQueueNew(SLE_SERVER_RXQ_DEPTH, sizeof(uint8_t), NULL);
+    if (g_rxq_free == NULL || g_rxq_ready == NULL) {
+        printf("[sle_server_rxq] create queue fail\r\n");
+        return false;
+    }
+    for (uint8_t i = 0; i < SLE_SERVER_RXQ_DEPTH; i++) {
+        (void)osMessageQueuePut(g_rxq_free, &i, 0, 0);
+    }
+    return true;
+}
+
+// 丢弃一条写请求: 压测帧只计数，由压测接收端按序号计入丢包；分拣数据帧记到所属连接。
+// 先记连接再加总数，接收任务看到总数变化时连接上的记录已经可见
+static void rxq_drop(uint16_t conn_id, const uint8_t *data, uint16_t len)
+{
+    if (sle_cargo_frame_type(data, len) == SLE_CARGO_FRAME_BENCH) {
+        g_rxq_stats.bench_drops++;
+    } else {
+        g_rxq_conn_drops[conn_id % SLE_SERVER_RXQ_CONN_SLOTS]++;
+    }
+    g_rxq_stats.last_drop_tick = osKernelGetTickCount();
+    g_rxq_stats.drops++;
+}
+
+bool sle_server_rxq_put(uint16_t conn_id, const uint8_t *data, uint16_t len, uint64_t rx_us)
+{
+    if (g_rxq_ready == NULL || data == NULL || len == 0 || len > SLE_SERVER_RXQ_MSG_LEN) {
+        g_rxq_stats.invalid++;
+        return false;
+    }
+    uint8_t idx = 0;
+    if (osMessageQueueGet(g_rxq_free, &idx, NULL, 0) != osOK || idx >= SLE_SERVER_RXQ_DEPTH) {
+        rxq_drop(conn_id, data, len);
+        return false;
+    }
+    sle_server_rxq_msg_t *msg = &g_rxq_pool[idx];
+    msg->conn_id = conn_id;
+    msg->len = len;
+    msg->rx_us = rx_us;
+    (void)memcpy_s(msg->data, sizeof(msg->data), data, len);
+    // 待处理队列与消息池等长，取到空闲槽位后投递不会失败
+    (void)osMessageQueuePut(g_rxq_ready, &idx, 0, 0);
+
+    g_rxq_stats.posted++;
+    uint16_t queued = (uint16_t)osMessageQueueGetCount(g_rxq_ready);
+    if (queued > g_rxq_stats.high) {
+        g_rxq_stats.high = queued;
+    }
+    uint32_t cb_us = (uint32_t)(uapi_systick_get_us() - rx_us);
+    if (cb_us > g_rxq_stats.cb_max_us) {
+        g_rxq_stats.cb_max_us = cb_us;
+    }
+    return true;
+}
+
+void sle_server_rxq_reject(void)
+{
+    g_rxq_stats.invalid++;
+}
+
+sle_server_rxq_msg_t *sle_server_rxq_get(uint32_t timeout)
+{
+    uint8_t idx = 0;
+    if (g_rxq_ready == NULL || osMessageQueueGet(g_rxq_ready, &idx, NULL, timeout) != osOK ||
+        idx >= SLE_SERVER_RXQ_DEPTH) {
+        return NULL;
+    }
+    sle_server_rxq_msg_t *msg = &g_rxq_pool[idx];
+    uint32_t wait_us = (uint32_t)(uapi_systick_get_us() - msg->rx_us);
+    g_rxq_stats.wait_last_us = wait_us;
+    if (wait_us > g_rxq_stats.wait_max_us) {
+        g_rxq_stats.wait_max_us = wait_us;
+    }
+    return msg;
+}
+
+void sle_server_rxq_release(sle_server_rxq_msg_t *msg)
+{
+    if (msg == NULL || msg < g_rxq_pool || msg >= g_rxq_pool + SLE_SERVER_RXQ_DEPTH) {
+        return;
+    }
+    uint8_t idx = (uint8_t)(msg - g_rxq_pool);
+    g_rxq_stats.processed++;
+    (void)osMessageQueuePut(g_rxq_free, &idx, 0, 0);
+}
+
+bool sle_server_rxq_gap(uint16_t conn_id)
+{
+    uint8_t slot = conn_id % SLE_SERVER_RXQ_CONN_SLOTS;
+    uint32_t drops = g_rxq_conn_drops[slot];
+    if (drops == g_rxq_conn_seen[slot]) {
+        return false;
+    }
+    g_rxq_conn_seen[slot] = drops;
+    return true;
+}
+
+void sle_server_rxq_get_stats(sle_server_rxq_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    *stats = g_rxq_stats;
+    stats->queued = (g_rxq_ready != NULL) ? (uint16_t)osMessageQueueGetCount(g_rxq_ready) : 0;
+}
+
+uint16_t sle_server_rxq_format(const sle_server_rxq_stats_t *stats, char *buf, uint16_t cap)
+{
+    if (stats == NULL || buf == NULL || cap == 0) {
+        return 0;
+    }
+    int n = snprintf(buf, cap, "queued=%u/%u high=%u posted=%u done=%u drop=%u (bench %u) invalid=%u "
+                     "cb_max=%uus wait=%uus wait_max=%uus", stats->queued, stats->depth, stats->high, stats->posted,
+                     stats->processed, stats->drops, stats->bench_drops, stats->invalid, stats->cb_max_us,
+                     stats->wait_last_us, stats->wait_max_us);
+    if (n < 0) {
+        buf[0] = '\0';
+        return 0;
+    }
+    return (uint16_t)((n < cap) ? n : (cap - 1));
+}
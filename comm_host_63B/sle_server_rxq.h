@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2024 HiSilicon Technologies CO., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SLE_SERVER_RXQ_H
+#define SLE_SERVER_RXQ_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+#endif /* __cplusplus */
+
+// 写请求队列: 协议栈回调只把数据拷入预分配的消息池并投递，解码、加锁和打印都在接收任务中完成，
+// 回调耗时固定且很短，协议栈不会因显示任务持锁而停顿
+#ifndef SLE_SERVER_RXQ_DEPTH
+#define SLE_SERVER_RXQ_DEPTH        16
+#endif
+// 单条写请求的最大长度，与协商的MTU上限一致
+#define SLE_SERVER_RXQ_MSG_LEN      512
+// 丢弃计数按 conn_id 取模分组，冲突只会多请求一次关键帧
+#define SLE_SERVER_RXQ_CONN_SLOTS   16
+
+// 消息池中的一条写请求
+typedef struct {
+    uint16_t conn_id;
+    uint16_t len;
+    uint64_t rx_us;                         // 回调被调用的时刻
+    uint8_t data[SLE_SERVER_RXQ_MSG_LEN];
+} sle_server_rxq_msg_t;
+
+// 队列统计: 投递侧计数只由协议栈回调写，处理侧计数只由接收任务写，读取不加锁，仅用于观察
+typedef struct {
+    uint16_t depth;                         // 消息池容量
+    uint16_t queued;                        // 当前排队数
+    uint16_t high;                          // 排队数的历史最大值
+    uint32_t posted;
+    uint32_t processed;
+    uint32_t drops;                         // 消息池已满而丢弃的写请求
+    uint32_t bench_drops;                   // 其中的压测帧，计入压测丢包
+    uint32_t invalid;                       // 状态失败、空数据或超长而丢弃的写请求
+    uint32_t last_drop_tick;                // 最近一次丢弃的时刻
+    uint32_t cb_max_us;                     // 回调从进入到投递完成的最大耗时
+    uint32_t wait_max_us;                   // 回调到接收任务开始处理的最大排队时延
+    uint32_t wait_last_us;
+} sle_server_rxq_stats_t;
+
+/**
+ * @brief  创建消息池和队列，统计清零
+ * @retval 是否成功
+ */
+bool sle_server_rxq_init(void);
+
+/**
+ * @brief  在协议栈回调中调用: 拷贝一条写请求并投递，不阻塞、不打印
+ * @note   消息池已满时丢弃并计数，分拣数据的丢弃由接收任务通过 sle_server_rxq_gap 补救
+ * @param  conn_id: 连接ID
+ * @param  data: 写入数据，只在回调期间有效
+ * @param  len: 数据长度
+ * @param  rx_us: 回调被调用的时刻
+ * @retval 是否已投递
+ */
+bool sle_server_rxq_put(uint16_t conn_id, const uint8_t *data, uint16_t len, uint64_t rx_us);
+
+/**
+ * @brief  记录一次无法投递的写请求 (状态失败或没有数据)
+ */
+void sle_server_rxq_reject(void);
+
+/**
+ * @brief  在接收任务中调用: 取出下一条写请求
+ * @param  timeout: 等待时长(tick)，osWaitForever 表示一直等待
+ * @retval 写请求，处理完后调用 sle_server_rxq_release；超时返回NULL
+ */
+sle_server_rxq_msg_t *sle_server_rxq_get(uint32_t timeout);
+
+/**
+ * @brief  归还已处理完的写请求
+ * @param  msg: sle_server_rxq_get 取出的写请求
+ */
+void sle_server_rxq_release(sle_server_rxq_msg_t *msg);
+
+/**
+ * @brief  在接收任务中调用: 自上次检查以来该连接是否有分拣数据被丢弃，检查后清除
+ * @param  conn_id: 连接ID
+ * @retval 是否有丢弃
+ */
+bool sle_server_rxq_gap(uint16_t conn_id);
+
+/**
+ * @brief  获取队列统计
+ * @param  stats: 输出的统计
+ */
+void sle_server_rxq_get_stats(sle_server_rxq_stats_t *stats);
+
+/**
+ * @brief  格式化为一行文本，用于日志
+ * @param  stats: 队列统计
+ * @param  buf: 输出缓冲区
+ * @param  cap: 缓冲区容量
+ * @retval 写入的长度(不含结尾的'\0')
+ */
+uint16_t sle_server_rxq_format(const sle_server_rxq_stats_t *stats, char *buf, uint16_t cap);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* __cplusplus */
+
+#endif /* SLE_SERVER_RXQ_H */
@@ -31,6 +31,7 @@
 #include "wifi_sta_connect_ws63.h"
 
 #include "sle_client.h"
+#include "sle_cargo_proto.h"
 
 #define STACK_SIZE (4096)
 #define UART_TASK_STACK_SIZE (4096)
@@ -54,12 +55,24 @@ typedef struct {
 
 static global_cargo_data_t g_global_cargo = {0};
 
+// 逐件分拣事件队列: UartTask 写入，SleCargoTask 合并后通过星闪发送
+#define CARGO_EVENT_QUEUE_LEN   32
+#define CARGO_EVENT_BATCH_MS    13      // 一个连接间隔(12.5ms)内到达的事件合并为一次写入
+#define CARGO_EVENT_RETRY_MAX   8       // 发送繁忙时最多重试的连接间隔数
+#define CARGO_SNAPSHOT_MS       1000    // 定时快照/增量帧周期，用于对齐事件丢失后的计数
+// 链路统计的打印周期，与63B一致；为0时不打印，统计仍可由小程序的 _sle_stats 等命令查询
+#ifndef CARGO_STATS_MS
+#define CARGO_STATS_MS          5000
+#endif
+static osMessageQueueId_t g_cargo_event_queue = NULL;
+static uint32_t g_cargo_event_dropped = 0;
+
 // 函数前向声明
-static void update_global_cargo_data(int sort_type);
+static void update_global_cargo_data(int sort_type, int item_id);
 
 
 
-// 提供给星闪模块调用，用于获取当前货物分拣数量（使用全局数据）
+// 提供给星闪模块调用，用于获取当前货物分拣数量（使用全局数据）；会在协议栈回调中持锁调用，不打印
 void get_current_cargo_counts(uint32_t *js, uint32_t *zj, uint32_t *sh)
 {
     if (js == NULL || zj == NULL || sh == NULL) {
@@ -69,8 +82,14 @@ void get_current_cargo_counts(uint32_t *js, uint32_t *zj, uint32_t *sh)
     *js = g_global_cargo.jiangsu_count;
     *zj = g_global_cargo.zhejiang_count;
     *sh = g_global_cargo.shanghai_count;
-    
-    printf("获取当前货物数量: J=%u, Z=%u, S=%u\r\n", *js, *zj, *sh);
+}
+
+// 提供给星闪模块调用，初始化时恢复发件箱保存的计数，须在串口任务创建前调用
+void set_current_cargo_counts(uint32_t js, uint32_t zj, uint32_t sh)
+{
+    g_global_cargo.jiangsu_count = js;
+    g_global_cargo.zhejiang_count = zj;
+    g_global_cargo.shanghai_count = sh;
 }
 
 /****************************
@@ -169,7 +188,7 @@ static void UartTask(void *arg)
                     
                     if (sort_type >= 0 && sort_type <= 2) {
                         printf("根据方向%c映射到分拣类型: %d\r\n", direction, sort_type);
-                        update_global_cargo_data(sort_type);
+                        update_global_cargo_data(sort_type, id);
                         
                         // 发送确认响应给ctl_host
                         char response[32] = {0};
@@ -188,7 +207,7 @@ static void UartTask(void *arg)
                     int sort_type = uart_buff[5] - '0';
                     if (sort_type >= 0 && sort_type <= 2) {
                         printf("收到分拣指令: SORT:%d\r\n", sort_type);
-                        update_global_cargo_data(sort_type);
+                        update_global_cargo_data(sort_type, -1);
                         
                         // 发送确认响应给ctl_host
                         char response[32];
@@ -216,8 +235,8 @@ static uint8_t uart_rx_buffer[512];
 
 // 重复定义已删除，使用前面定义的 global_cargo_data_t
 
-// 统一的数据更新函数
-static void update_global_cargo_data(int sort_type) {
+// 统一的数据更新函数，item_id 为 -1 表示没有货物编号
+static void update_global_cargo_data(int sort_type, int item_id) {
     switch(sort_type) {
         case 0: 
             g_global_cargo.jiangsu_count++; 
@@ -240,10 +259,127 @@ static void update_global_cargo_data(int sort_type) {
            g_global_cargo.jiangsu_count, 
            g_global_cargo.zhejiang_count, 
            g_global_cargo.shanghai_count);
-    
 
+    // 生成分拣事件，编号取计入后的累计总数，63B据此去重
+    if (g_cargo_event_queue != NULL) {
+        sle_cargo_event_t ev = {0};
+        ev.no = (uint16_t)(g_global_cargo.jiangsu_count + g_global_cargo.zhejiang_count +
+                           g_global_cargo.shanghai_count);
+        ev.item_id = (item_id >= 0) ? (uint8_t)item_id : 0;
+        ev.region = (uint8_t)sort_type | ((item_id >= 0) ? 0 : SLE_CARGO_EVENT_NO_ID);
+        ev.tick = osKernelGetTickCount();
+        if (osMessageQueuePut(g_cargo_event_queue, &ev, 0, 0) != osOK) {
+            // 队列满时只丢事件，计数仍由定时快照带给63B
+            g_cargo_event_dropped++;
+            printf("分拣事件队列已满，丢弃事件 no=%u (累计丢弃%u)\r\n", ev.no, g_cargo_event_dropped);
+        }
+    }
 }
 
+// 取出并发送一批分拣事件: 收到第一条后等待一个连接间隔，把突发到达的事件合并为一次写入
+static void sle_cargo_flush_events(const sle_cargo_event_t *first)
+{
+    sle_cargo_event_t batch[SLE_CARGO_EVENT_BATCH_MAX];
+    uint8_t count = 0;
+
+    batch[count++] = *first;
+    osDelay(CARGO_EVENT_BATCH_MS);
+    while (count < SLE_CARGO_EVENT_BATCH_MAX &&
+           osMessageQueueGet(g_cargo_event_queue, &batch[count], NULL, 0) == osOK) {
+        count++;
+    }
+
+    // 未连接时由客户端存入发件箱，重连后按序回放；对端为旧版文本协议时事件不发送，计数由定时快照补齐
+    if (!sle_enabled) {
+        return;
+    }
+    // 所有对端的发送窗口或协议栈缓冲区都满时按连接间隔重试，期间新到的事件留在队列中；
+    // 只有部分对端繁忙时由客户端记入各自的积压，不在这里等待
+    errcode_t ret = sle_client_send_cargo_events(batch, count);
+    for (uint32_t i = 0; ret == SLE_CLIENT_ERRCODE_BUSY && i < CARGO_EVENT_RETRY_MAX; i++) {
+        osDelay(CARGO_EVENT_BATCH_MS);
+        ret = sle_client_send_cargo_events(batch, count);
+    }
+    if (ret != ERRCODE_SUCC) {
+        g_cargo_event_dropped += count;
+        printf("[SleCargoTask] %u 个分拣事件未能发送(0x%x)，由定时快照补齐 (累计丢弃%u)\r\n",
+               count, ret, g_cargo_event_dropped);
+    }
+}
+
+#if CARGO_STATS_MS > 0
+// 链路统计: 各63B的发送、确认、连接参数、PHY和大消息统计，以及连接状态机、服务发现、遥测、发件箱和扫描统计
+static void sle_cargo_print_stats(uint32_t now)
+{
+    // 每个63B一行: 发送窗口、写时延和确认往返时延分别统计，便于找出慢的链路
+    for (uint8_t i = 0; i < SLE_CLIENT_PEER_MAX; i++) {
+        sle_client_peer_info_t peer;
+        sle_client_tx_stats_t stats;
+        sle_client_ack_stats_t ack;
+        if (!sle_client_get_peer_info(i, &peer) || !sle_client_get_tx_stats(i, &stats) ||
+            !sle_client_get_ack_stats(i, &ack)) {
+            continue;
+        }
+        printf("[SleCargoTask] 63B#%u %02x:%02x 发送统计: req=%u cmd=%u ok=%u fail=%u retry=%u busy=%u "
+               "drop=%u 积压=%u 时延avg=%uus max=%uus 在途=%u/%u\r\n",
+               i + 1, peer.addr[4], peer.addr[5], stats.req_issued, stats.cmd_issued, stats.confirmed,
+               stats.failed, stats.retried, stats.busy, stats.dropped, stats.backlog, stats.lat_avg_us,
+               stats.lat_max_us, stats.inflight, stats.window);
+        printf("[SleCargoTask] 63B#%u 确认: acks=%u rtt=%u/%u/%ums 显示=%s(%ums) 重发事件=%u 补发关键帧=%u\r\n",
+               i + 1, ack.acks, ack.rtt_min_ms, ack.rtt_avg_ms, ack.rtt_max_ms,
+               (ack.flags & SLE_CARGO_ACK_DISPLAY_CURRENT) ? "最新" : "待刷新", ack.display_lag_ms,
+               ack.event_resends, ack.key_resends);
+        static char policy_line[320];
+        sle_cargo_conn_policy_t policy;
+        if (sle_client_get_conn_policy(i, &policy)) {
+            sle_cargo_conn_policy_format(&policy, policy_line, sizeof(policy_line));
+            printf("[SleCargoTask] 63B#%u 连接参数: %s\r\n", i + 1, policy_line);
+        }
+        sle_cargo_phy_link_t phy;
+        if (sle_client_get_phy(i, &phy)) {
+            sle_cargo_phy_format(&phy, policy_line, sizeof(policy_line));
+            printf("[SleCargoTask] 63B#%u PHY: %s\r\n", i + 1, policy_line);
+        }
+        sle_client_bulk_stats_t bulk;
+        if (sle_client_get_bulk_stats(i, &bulk) &&
+            (bulk.messages + bulk.failed + bulk.pending + bulk.rx_messages) > 0) {
+            printf("[SleCargoTask] 63B#%u 大消息: 完成=%u 字节=%u 分片=%u 重发=%u 失败=%u 上次=%ums 待发=%u "
+                   "收到=%u 重组丢弃=%u\r\n", i + 1, bulk.messages, bulk.bytes, bulk.fragments, bulk.restarts,
+                   bulk.failed, bulk.last_ms, bulk.pending, bulk.rx_messages, bulk.rx_dropped);
+        }
+    }
+    sle_client_reconnect_stats_t rc;
+    sle_client_get_reconnect_stats(&rc);
+    printf("[SleCargoTask] 连接状态机: 就绪=%u 重连耗时last=%ums avg=%llums 扫描超时=%u 阶段超时=%u 放弃=%u\r\n",
+           rc.ready_count, rc.ready_last_ms, (rc.ready_count > 0) ? rc.ready_sum_ms / rc.ready_count : 0,
+           rc.scan_timeouts, rc.state_timeouts, rc.aborts);
+    printf("[SleCargoTask] 服务发现: 次数=%u 查找请求=%u 耗时last=%uus avg=%lluus\r\n",
+           rc.discover_count, rc.discover_rounds_last, rc.discover_last_us,
+           (rc.discover_count > 0) ? rc.discover_sum_us / rc.discover_count : 0);
+    sle_cargo_telem_t telem;
+    char telem_line[SLE_CARGO_TELEM_LINE_LEN];
+    sle_client_get_telemetry(&telem);
+    sle_cargo_telem_format(&telem, now, telem_line, sizeof(telem_line));
+    printf("[SleCargoTask] 链路遥测: %s\r\n", telem_line);
+    sle_outbox_stats_t ob;
+    sle_client_get_outbox_stats(&ob);
+    if (ob.queued > 0) {
+        printf("[SleCargoTask] 发件箱: 深度=%u/%u 最大=%u 存入=%u 合并=%u 丢弃=%u 回放=%u 断开last=%ums "
+               "max=%ums 回放耗时last=%ums(%u条) max=%ums\r\n", ob.depth, ob.capacity, ob.depth_max,
+               ob.queued, ob.merged, ob.dropped, ob.replayed, ob.outage_last_ms, ob.outage_max_ms,
+               ob.drain_last_ms, ob.drain_last_entries, ob.drain_max_ms);
+    }
+    sle_client_scan_stats_t sc;
+    sle_client_get_scan_stats(&sc);
+    printf("[SleCargoTask] 扫描: 广播=%u 去重丢弃=%u 匹配=%u 候选=%u (上次 %u 选中rssi=%d) 地址表=%s "
+           "扫描到连接avg: 开 %llums x%u / 关 %llums x%u\r\n",
+           sc.seen, sc.filtered, sc.matched, sc.candidates, sc.last_window_candidates, sc.last_rssi,
+           sc.seen_cache ? "开" : "关",
+           (sc.ttc_on_count > 0) ? sc.ttc_on_sum_ms / sc.ttc_on_count : 0, sc.ttc_on_count,
+           (sc.ttc_off_count > 0) ? sc.ttc_off_sum_ms / sc.ttc_off_count : 0, sc.ttc_off_count);
+}
+#endif
+
 // 星闪货物数据发送任务
 static void SleCargoTask(void *arg)
 {
@@ -251,57 +387,63 @@ static void SleCargoTask(void *arg)
     
     printf("SLE Cargo Task started\r\n");
     static uint64_t last_sent_time = 0;
+#if CARGO_STATS_MS > 0
+    static uint64_t last_stats_time = 0;
+#endif
     
     while (1) {
-        // 每1秒发送一次货物数据给63B，或者数据有更新时立即发送
+        // 等待分拣事件，最长等到下一次定时发送
+        uint64_t elapsed = osKernelGetTickCount() - last_sent_time;
+        uint32_t wait = (elapsed >= CARGO_SNAPSHOT_MS) ? 0 : (uint32_t)(CARGO_SNAPSHOT_MS - elapsed);
+        sle_cargo_event_t ev;
+        if (g_cargo_event_queue == NULL) {
+            osDelay(wait);
+        } else if (osMessageQueueGet(g_cargo_event_queue, &ev, NULL, wait) == osOK) {
+            sle_cargo_flush_events(&ev);
+        }
+        if (osKernelGetTickCount() - last_sent_time < CARGO_SNAPSHOT_MS) {
+            continue;
+        }
+
+        // 每1秒发送一次快照/增量帧给63B，用于重连后对齐和补齐丢失的事件
         bool sle_conn_status = sle_client_is_connected();
         printf("[SleCargoTask] 检查发送条件: sle_enabled=%s, connected=%s\r\n", 
                sle_enabled ? "是" : "否", sle_conn_status ? "是" : "否");
         
+        uint64_t current_time = osKernelGetTickCount();
         if (sle_enabled && sle_conn_status) {
-            uint64_t current_time = osKernelGetTickCount();
-            
-            // 检查是否需要发送数据（定时发送或数据有更新）
-            bool should_send = false;
-            if (current_time - last_sent_time >= 1000) {  // 1秒定时发送
-                should_send = true;
-                printf("[SleCargoTask] 定时发送条件满足 (间隔=%llu ms)\r\n", current_time - last_sent_time);
-            }
-            // 如果是首次连接（last_sent_time为0），立即发送
-            if (last_sent_time == 0) {
-                should_send = true;
-                printf("[SleCargoTask] 首次连接，立即发送货物数据\r\n");
-            }
-            
-            printf("[SleCargoTask] 当前货物数据: J=%u, Z=%u, S=%u\r\n",
-                   g_global_cargo.jiangsu_count, g_global_cargo.zhejiang_count, g_global_cargo.shanghai_count);
-            
-            if (should_send) {
-                printf("[SleCargoTask] 开始发送货物数据...\r\n");
-                // 使用全局真实数据而非模拟数据
-                sle_client_send_cargo_data(
-                    g_global_cargo.jiangsu_count,
-                    g_global_cargo.zhejiang_count, 
-                    g_global_cargo.shanghai_count
-                );
-                
-                last_sent_time = current_time;
-                printf("[SleCargoTask] ✅ 通过星闪发送真实货物数据: J=%u, Z=%u, S=%u\r\n", 
-                       g_global_cargo.jiangsu_count, 
-                       g_global_cargo.zhejiang_count, 
-                       g_global_cargo.shanghai_count);
-            } else {
-                printf("[SleCargoTask] 暂不需要发送 (距上次发送%llu ms)\r\n", current_time - last_sent_time);
+            printf("[SleCargoTask] 开始发送货物数据...\r\n");
+            // 使用全局真实数据而非模拟数据
+            sle_client_send_cargo_data(
+                g_global_cargo.jiangsu_count,
+                g_global_cargo.zhejiang_count, 
+                g_global_cargo.shanghai_count
+            );
+            printf("[SleCargoTask] ✅ 通过星闪发送真实货物数据: J=%u, Z=%u, S=%u\r\n", 
+                   g_global_cargo.jiangsu_count, 
+                   g_global_cargo.zhejiang_count, 
+                   g_global_cargo.shanghai_count);
+
+#if CARGO_STATS_MS > 0
+            if ((uint32_t)(current_time - last_stats_time) >= CARGO_STATS_MS) {
+                sle_cargo_print_stats((uint32_t)current_time);
+                last_stats_time = current_time;
             }
+#endif
         } else {
             if (sle_enabled) {
-                printf("[SleCargoTask] SLE未连接，等待连接...\r\n");
+                // 快照存入发件箱，与队尾的快照合并，重连后排在断开期间的事件之后回放
+                sle_client_send_cargo_data(g_global_cargo.jiangsu_count, g_global_cargo.zhejiang_count,
+                                           g_global_cargo.shanghai_count);
+                sle_outbox_stats_t ob;
+                sle_client_get_outbox_stats(&ob);
+                printf("[SleCargoTask] SLE未连接，等待连接... 发件箱=%u/%u 已断开%ums 丢弃=%u\r\n", ob.depth,
+                       ob.capacity, ob.outage_ms, ob.dropped);
             } else {
                 printf("[SleCargoTask] SLE未启用，跳过数据发送\r\n");
             }
         }
-        
-        osDelay(1000); // 1秒检查一次
+        last_sent_time = current_time;
     }
 }
 
@@ -362,6 +504,11 @@ static void MainEntry(void *arg)
     printf("UART init...\r\n");
     usr_uart_config();
 
+#if SLE_CARGO_PROTO_BENCH
+    // 星闪货物帧编解码基准测试，对比文本与二进制格式
+    sle_cargo_proto_bench(1000);
+#endif
+
     // 初始化星闪功能
     printf("SLE init...\r\n");
     if (sle_client_init() == ERRCODE_SUCC) {
@@ -386,6 +533,11 @@ static void MainEntry(void *arg)
     printf("OLED display content updated\r\n");
 
     printf("Task Set start...\r\n");
+    g_cargo_event_queue = osMessageQueueNew(CARGO_EVENT_QUEUE_LEN, sizeof(sle_cargo_event_t), NULL);
+    if (g_cargo_event_queue == NULL) {
+        printf("[SleCargoTask] Failed to create cargo event queue!\n");
+    }
+
     osThreadAttr_t attr, attr2;
     
     // UART任务
@@ -14,6 +14,12 @@
  */
 
 #include "sle_client.h"
+#include "sle_cargo_proto.h"
+#include "sle_cargo_sync.h"
+#include "sle_cargo_history.h"
+#include "sle_cargo_rand.h"
+#include "sle_peer_cache.h"
+#include "sle_seen_cache.h"
 #include "common_def.h"
 #include "sle_device_discovery.h"
 #include "sle_connection_manager.h"
@@ -22,6 +28,7 @@
 #include "cmsis_os2.h"
 #include "soc_osal.h"
 #include "uart.h"
+#include "systick.h"
 
 // 官方星闪客户端实现 - 基于sle_02_trans_client
 
@@ -37,10 +44,6 @@
 // 使用头文件中的定义，避免重复定义
 // #define SLE_SEEK_INTERVAL_DEFAULT           0x100
 // #define SLE_SEEK_WINDOW_DEFAULT             0x100
-#define SLE_CONN_INTV_MIN_DEFAULT           0x64  // 12.5ms - 按官方demo标准
-#define SLE_CONN_INTV_MAX_DEFAULT           0x64  // 12.5ms - 按官方demo标准  
-#define SLE_CONN_MAX_LATENCY                0x1F3 // 按官方demo标准
-#define SLE_CONN_SUPERVISION_TIMEOUT        0x1f4
 
 #define SLE_MTU_SIZE_DEFAULT                512
 #define SLE_TASK_DELAY_MS                   2000
@@ -49,65 +52,869 @@
 #define SLE_UUID_SERVER_SERVICE             0xABCD
 #define SLE_UUID_SERVER_NTF_REPORT          0x1122
 
+// 63B注册服务和特征时使用的基础UUID("sle_test")，16位UUID按小端放在最后两字节
+#define SLE_UUID_BASE_PREFIX 0x73, 0x6C, 0x65, 0x5F, 0x74, 0x65, 0x73, 0x74, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+#define SLE_UUID_16_OFFSET                  14
+
+// 发送引擎: 写请求按提交顺序占用窗口槽位，写确认按同样顺序释放槽位并统计时延
+typedef struct {
+    uint8_t kind;                           // sle_cargo_frame_type_t
+    uint8_t retries;                        // 已重试次数
+    uint16_t len;
+    uint64_t submit_us;                     // 提交时刻，用于计算写时延
+    uint8_t data[SLE_CARGO_EVENTS_MAX_LEN]; // 帧内容，事件帧失败时原样重发
+} sle_client_tx_slot_t;
+
+// 缓存句柄的校验状态
+typedef enum {
+    SLE_PEER_HANDLES_DISCOVERED = 0,        // 本次连接完整发现得到
+    SLE_PEER_HANDLES_CACHED,                // 取自NV缓存，尚未校验
+    SLE_PEER_HANDLES_VERIFIED,              // 取自NV缓存，已在服务句柄范围内校验
+} sle_peer_handles_t;
+
+// 一个63B对端: 连接阶段、写句柄、发送窗口和确认通道状态都按对端独立，慢的链路不影响其他链路
+typedef struct {
+    sle_client_peer_state_t state;
+    uint32_t state_tick[SLE_CLIENT_PEER_STATE_MAX]; // 进入各阶段的时刻，见 sle_client_peer_info_t
+    uint32_t deadline;                      // 当前阶段的超时时刻
+    bool deadline_armed;
+    uint32_t reconnect_ms;
+    uint32_t scan_tick;                     // 找到该服务器的那轮扫描开始的时刻
+    bool scan_cache;                        // 那轮扫描是否启用了地址表
+    uint16_t conn_id;
+    sle_addr_t addr;
+    uint16_t write_id;
+    sle_cargo_wire_t wire;                  // 连接时根据服务器广播确定
+    uint8_t phy_caps;                       // 服务器广播的PHY能力位
+    // 快速重连: 句柄布局来源、服务句柄范围、连接到首次写入的耗时
+    sle_peer_handles_t handles;
+    bool prop_found;                        // 校验过程中找到了货物特征
+    bool service_found;                     // 完整发现中已找到货物服务，不再处理其他服务结果
+    uint8_t disc_rounds;                    // 本次发现发出的查找请求数
+    uint64_t disc_us;                       // 服务发现开始的时刻
+    uint16_t service_start;
+    uint16_t service_end;
+    uint16_t mtu;
+    uint64_t connect_us;
+    bool first_write_done;
+    uint32_t connect_to_write_us;
+    sle_cargo_tx_t cargo_tx;                // 增量帧/关键帧发送状态
+    sle_cargo_frag_tx_t bulk;               // 大消息分片发送状态
+    uint32_t bulk_phy_epoch;                // 当前大消息开始时的PHY编号，用于吞吐统计
+    uint32_t bulk_rx_messages;
+    bool bulk_rx;                           // 收到过63B的分片
+    uint32_t bulk_rx_tick;                  // 最近一次收到分片的时刻
+    uint16_t hist_req_seq;                  // 速率历史请求帧序号
+    // 发送窗口
+    sle_client_tx_slot_t tx_slots[SLE_CLIENT_TX_WINDOW_MAX];
+    uint8_t tx_head;
+    uint8_t tx_count;
+    sle_client_tx_stats_t tx_stats;
+    uint64_t tx_latency_sum_us;
+    uint16_t event_frame_seq;
+    // 最近发送的事件，用于选择性重发和补发积压
+    sle_cargo_event_t event_history[SLE_CLIENT_EVENT_HISTORY];
+    uint8_t event_history_head;
+    uint8_t event_history_count;
+    bool event_backlog;                     // 有因窗口已满而未发出的事件
+    uint16_t backlog_no;                    // 积压事件的起始编号
+    uint16_t backlog_end;                   // 积压事件的结束编号(不含)
+    // 63B确认通道
+    sle_client_ack_stats_t ack_stats;
+    uint64_t rtt_sum_ms;
+    uint32_t rtt_samples;
+    uint32_t resend_tick;
+    uint32_t resend_total;
+    bool resend_armed;
+    // 连接参数策略
+    sle_cargo_conn_policy_t conn_policy;
+    // PHY协商
+    sle_cargo_phy_link_t phy;
+} sle_client_peer_t;
+
+// 要连接的服务器: 连续失败次数和下次允许尝试的时刻
+typedef struct {
+    uint8_t addr[SLE_ADDR_LEN];
+    uint8_t fails;
+    bool pinned;                            // sle_client_add_server 固定的地址，不会被替换
+    bool deferred;                          // 本轮扫描中因退避被跳过，控制器不会再上报它
+    uint32_t retry_tick;                    // 退避中，此时刻之前扫描到也不连接
+    uint32_t lost_tick;                     // 上次断开或开始寻找的时刻，用于统计重连耗时
+} sle_client_server_t;
+
+// 候选窗口中的服务器
+typedef struct {
+    sle_addr_t addr;
+    int8_t rssi;                            // 窗口内最强的一次
+    sle_cargo_wire_t wire;
+    uint8_t phy_caps;
+} sle_client_candidate_t;
+
+// 连接状态机事件: 协议栈回调只更新对端表并投递事件，扫描、超时和初始数据发送都在客户端任务中完成
+typedef enum {
+    SLE_CLIENT_EVT_KICK = 0,                // 对端表有变化，重新检查扫描和超时
+    SLE_CLIENT_EVT_READY,                   // 对端就绪，发送初始数据
+} sle_client_evt_type_t;
+
+typedef struct {
+    uint8_t type;                           // sle_client_evt_type_t
+    uint8_t peer;                           // 对端表项序号
+    uint16_t conn_id;                       // 事件所属的连接，表项已被复用时丢弃事件
+} sle_client_evt_t;
+
+#define SLE_CLIENT_EVT_QUEUE_LEN            16
+// 收到速率历史块时打印的最新桶数 (细粒度为最近1分钟)
+#define SLE_CLIENT_HIST_PRINT_BUCKETS       6
+
+// 各阶段超时，0表示该阶段不限时
+static const uint32_t g_sle_state_timeout_ms[SLE_CLIENT_PEER_STATE_MAX] = {
+    0,
+    SLE_CLIENT_CONNECT_TIMEOUT_MS,
+    SLE_CLIENT_PAIR_TIMEOUT_MS,
+    SLE_CLIENT_EXCHANGE_TIMEOUT_MS,
+    SLE_CLIENT_DISCOVER_TIMEOUT_MS,
+    0,
+};
+
+static const char *g_sle_state_names[SLE_CLIENT_PEER_STATE_MAX] = {
+    "idle", "connecting", "pairing", "exchanging", "discovering", "ready",
+};
+
+// 货物服务和货物特征的完整UUID，查找时作为过滤条件，结果按整个UUID比较
+static const sle_uuid_t g_sle_service_uuid = {
+    .len = 2,
+    .uuid = { SLE_UUID_BASE_PREFIX, SLE_UUID_SERVER_SERVICE & 0xFF, SLE_UUID_SERVER_SERVICE >> 8 },
+};
+static const sle_uuid_t g_sle_property_uuid = {
+    .len = 2,
+    .uuid = { SLE_UUID_BASE_PREFIX, SLE_UUID_SERVER_NTF_REPORT & 0xFF, SLE_UUID_SERVER_NTF_REPORT >> 8 },
+};
+
 // 前向声明
 static void sle_start_scan(void);
 static void sle_client_exchange_info_cbk(uint8_t client_id, uint16_t conn_id, ssap_exchange_info_t *param, errcode_t status);
 static void sle_client_find_property_cbk(uint8_t client_id, uint16_t conn_id, ssapc_find_property_result_t *property, errcode_t status);
 static void sle_client_write_cfm_cbk(uint8_t client_id, uint16_t conn_id, ssapc_write_result_t *write_result, errcode_t status);
+static void sle_client_find_structure_cmp_cbk(uint8_t client_id, uint16_t conn_id,
+                                              ssapc_find_structure_result_t *structure_result, errcode_t status);
+static void sle_client_handle_ack(sle_client_peer_t *peer, const sle_cargo_ack_t *ack);
+static void sle_send_cargo_data_peer(sle_client_peer_t *peer, const sle_cargo_snapshot_t *snap);
+static void sle_drain_outbox_locked(uint32_t now);
+static void sle_conn_policy_apply_locked(sle_client_peer_t *peer, uint32_t now);
 
 // 全局变量
-static uint16_t g_sle_client_conn_id = 0;
-static sle_acb_state_t g_sle_client_conn_state = SLE_ACB_STATE_NONE;
-static uint16_t g_sle_client_ntf_id __attribute__((unused)) = 0;
-static uint16_t g_sle_client_write_id = 0;
-static uint16_t g_sle_client_server_id = 0;
-static sle_addr_t g_sle_remote_addr = {0};
-static ssapc_write_param_t g_sle_send_param = {0};
-
-// 期望连接的服务器地址 - 需要与服务器端保持一致
-static uint8_t g_sle_expected_addr[SLE_ADDR_LEN] = {0x04, 0x01, 0x06, 0x08, 0x06, 0x03};
-
-// 星闪扫描结果回调
+static sle_client_peer_t g_sle_peers[SLE_CLIENT_PEER_MAX];
+static uint8_t g_sle_tx_window = SLE_CLIENT_TX_WINDOW;
+static osMutexId_t g_sle_tx_mutex = NULL;   // 递归锁，保护对端表；写确认回调可能在提交过程中同步触发
+static bool g_sle_scanning = false;
+static uint32_t g_sle_scan_tick = 0;        // 本轮扫描开始的时刻
+static bool g_sle_seen_cache_on = SLE_CLIENT_SEEN_CACHE;
+static bool g_sle_scan_cache = SLE_CLIENT_SEEN_CACHE; // 本轮扫描实际使用的设置
+static sle_client_scan_stats_t g_sle_scan_stats = {0};
+static bool g_sle_connecting = false;       // 协议栈同一时刻只建立一个连接
+static sle_client_reconnect_stats_t g_sle_reconnect_stats = {0};
+static sle_cargo_frag_rx_t g_sle_frag_rx;   // 63B通过notify发来的大消息重组池
+static uint8_t g_sle_bulk_frame[SLE_CARGO_FRAG_FRAME_MAX]; // 分片编码缓冲区，持有发送锁时使用
+static sle_cargo_telem_t g_sle_telem;       // 链路遥测，所有对端合计
+static uint32_t g_sle_rssi_tick = 0;        // 下次读取RSSI的时刻
+static uint32_t g_sle_conn_idle_ms = SLE_CARGO_CONN_IDLE_MS;
+static bool g_sle_phy_on = (SLE_CLIENT_PHY_POLICY != 0);
+static sle_cargo_bench_tx_t g_sle_bench;    // 压测发送状态，持有发送锁时访问
+static uint16_t g_sle_bench_conn = 0;       // 压测目标连接
+static sle_client_write_mode_t g_sle_bench_mode = SLE_CLIENT_BENCH_MODE;
+static bool g_sle_bench_auto = SLE_CLIENT_BENCH; // 第一个对端就绪后自动运行一轮，运行后清除
+static uint8_t g_sle_bench_frame[SLE_CARGO_BENCH_FRAME_MAX]; // 压测帧编码缓冲区，持有发送锁时使用
+static sle_cargo_bench_report_t g_sle_bench_report;
+static bool g_sle_bench_reported = false;
+static bool g_sle_bench_armed = false;      // 已请求压测，等待目标的PHY切换完成后开始
+static sle_cargo_bench_cfg_t g_sle_bench_cfg;
+static uint32_t g_sle_bench_arm_tick = 0;
+static uint32_t g_sle_bench_epoch = 0;      // 本轮开始时目标的PHY编号
+static osMessageQueueId_t g_sle_evt_queue = NULL;
+static uint32_t g_sle_rand_state = 0;
+
+// 连接过或固定的服务器地址及其退避状态；63B按广播内容发现，换板或加板不需要改固件
+static sle_client_server_t g_sle_servers[SLE_CLIENT_SERVER_MAX];
+static uint8_t g_sle_server_count = 0;
+static sle_client_server_t g_sle_discover = {0}; // 寻找新服务器的退避状态，只使用退避字段
+static sle_client_candidate_t g_sle_candidates[SLE_CLIENT_CANDIDATE_MAX];
+static uint8_t g_sle_candidate_count = 0;
+static bool g_sle_window_open = false;
+static uint32_t g_sle_window_end = 0;
+
+static void sle_tx_lock(void)
+{
+    if (g_sle_tx_mutex != NULL) {
+        osMutexAcquire(g_sle_tx_mutex, osWaitForever);
+    }
+}
+
+static void sle_tx_unlock(void)
+{
+    if (g_sle_tx_mutex != NULL) {
+        osMutexRelease(g_sle_tx_mutex);
+    }
+}
+
+// 比较协议栈上报的UUID与预置UUID: 16字节UUID整体比较，2字节UUID只携带16位值，位于同一偏移
+static bool sle_uuid_equal(const sle_uuid_t *uuid, const sle_uuid_t *ref)
+{
+    if (uuid->len == SLE_UUID_LEN) {
+        return memcmp(uuid->uuid, ref->uuid, SLE_UUID_LEN) == 0;
+    }
+    if (uuid->len == 2) {
+        return memcmp(&uuid->uuid[SLE_UUID_16_OFFSET], &ref->uuid[SLE_UUID_16_OFFSET], 2) == 0;
+    }
+    return false;
+}
+
+// 日志中的对端编号 1~N
+static uint8_t sle_peer_no(const sle_client_peer_t *peer)
+{
+    return (uint8_t)(peer - g_sle_peers) + 1;
+}
+
+// 按连接ID查找已连接的对端，调用者持有发送锁
+static sle_client_peer_t *sle_peer_find(uint16_t conn_id)
+{
+    for (uint8_t i = 0; i < SLE_CLIENT_PEER_MAX; i++) {
+        if (g_sle_peers[i].state > SLE_CLIENT_PEER_CONNECTING && g_sle_peers[i].conn_id == conn_id) {
+            return &g_sle_peers[i];
+        }
+    }
+    return NULL;
+}
+
+// 按地址查找在用的对端，调用者持有发送锁
+static sle_client_peer_t *sle_peer_find_addr(const uint8_t *addr)
+{
+    for (uint8_t i = 0; i < SLE_CLIENT_PEER_MAX; i++) {
+        if (g_sle_peers[i].state != SLE_CLIENT_PEER_IDLE &&
+            memcmp(g_sle_peers[i].addr.addr, addr, SLE_ADDR_LEN) == 0) {
+            return &g_sle_peers[i];
+        }
+    }
+    return NULL;
+}
+
+// 按地址查找要连接的服务器，不在地址表中时返回NULL
+static sle_client_server_t *sle_server_find(const uint8_t *addr)
+{
+    for (uint8_t i = 0; i < g_sle_server_count; i++) {
+        if (memcmp(g_sle_servers[i].addr, addr, SLE_ADDR_LEN) == 0) {
+            return &g_sle_servers[i];
+        }
+    }
+    return NULL;
+}
+
+// 向客户端任务投递状态机事件，回调中调用，不等待队列空间；丢失的 KICK 由任务的周期检查补上
+static void sle_client_post(uint8_t type, uint8_t peer, uint16_t conn_id)
+{
+    if (g_sle_evt_queue == NULL) {
+        return;
+    }
+    sle_client_evt_t evt = {type, peer, conn_id};
+    if (osMessageQueuePut(g_sle_evt_queue, &evt, 0, 0) != osOK) {
+        printf("[sle_client] event queue full, event %u dropped\r\n", type);
+    }
+}
+
+// 退避时长: 第n次连续失败等待 基准*2^(n-1)，不超过上限，叠加±25%抖动避免多块板同时重连
+static uint32_t sle_backoff_ms(uint8_t fails)
+{
+    if (fails == 0) {
+        return 0;
+    }
+    uint32_t ms = SLE_CLIENT_BACKOFF_MAX_MS;
+    if (fails <= 16) {
+        ms = (uint32_t)SLE_CLIENT_BACKOFF_BASE_MS << (fails - 1);
+    }
+    if (ms > SLE_CLIENT_BACKOFF_MAX_MS) {
+        ms = SLE_CLIENT_BACKOFF_MAX_MS;
+    }
+    uint32_t jitter = ms / 2;
+    return ms - jitter / 2 + sle_cargo_rand(&g_sle_rand_state) % (jitter + 1);
+}
+
+// 一次连接尝试结束: 失败时增加失败计数并推迟下次尝试，成功时立即可以重连。调用者持有发送锁
+static void sle_server_schedule_locked(sle_client_server_t *server, bool failed, uint32_t now)
+{
+    if (failed) {
+        if (server->fails < UINT8_MAX) {
+            server->fails++;
+        }
+    } else {
+        server->fails = 0;
+    }
+    uint32_t delay = sle_backoff_ms(server->fails);
+    server->retry_tick = now + delay;
+    if (delay > 0) {
+        printf("[sle_client] %s %02x:%02x retry in %ums (fails=%u)\r\n",
+               (server == &g_sle_discover) ? "discovery" : "server", server->addr[4], server->addr[5], delay,
+               server->fails);
+    }
+}
+
+// 遥测中的链路状态: 任一对端已建立链路即为已连接，否则为寻找中。调用者持有发送锁
+static void sle_telem_link_update_locked(uint32_t now)
+{
+    uint8_t state = SLE_CARGO_LINK_SEARCHING;
+    for (uint8_t i = 0; i < SLE_CLIENT_PEER_MAX; i++) {
+        if (g_sle_peers[i].state > SLE_CLIENT_PEER_CONNECTING) {
+            state = SLE_CARGO_LINK_CONNECTED;
+            break;
+        }
+    }
+    sle_cargo_telem_set_link(&g_sle_telem, state, now);
+}
+
+// 切换对端阶段: 记录进入时刻并设置该阶段的超时，进入就绪时统计重连耗时。调用者持有发送锁
+static void sle_peer_set_state_locked(sle_client_peer_t *peer, sle_client_peer_state_t state)
+{
+    uint32_t now = osKernelGetTickCount();
+    peer->state = state;
+    peer->state_tick[state] = now;
+    peer->deadline_armed = (g_sle_state_timeout_ms[state] > 0);
+    peer->deadline = now + g_sle_state_timeout_ms[state];
+    sle_telem_link_update_locked(now);
+    if (state != SLE_CLIENT_PEER_READY) {
+        return;
+    }
+
+    peer->reconnect_ms = now - peer->state_tick[SLE_CLIENT_PEER_IDLE];
+    // 找到了新的服务器，继续寻找其他板不需要退避
+    sle_server_schedule_locked(&g_sle_discover, false, now);
+    sle_client_reconnect_stats_t *st = &g_sle_reconnect_stats;
+    st->ready_count++;
+    st->ready_last_ms = peer->reconnect_ms;
+    st->ready_sum_ms += peer->reconnect_ms;
+    printf("[sle_client] 63B#%u 就绪: 寻找->连接 %ums, 连接->就绪 %ums, 共 %ums (平均 %llums x%u)\r\n",
+           sle_peer_no(peer), peer->state_tick[SLE_CLIENT_PEER_CONNECTING] - peer->state_tick[SLE_CLIENT_PEER_IDLE],
+           now - peer->state_tick[SLE_CLIENT_PEER_CONNECTING], peer->reconnect_ms, st->ready_sum_ms / st->ready_count,
+           st->ready_count);
+    sle_client_post(SLE_CLIENT_EVT_READY, (uint8_t)(peer - g_sle_peers), peer->conn_id);
+}
+
+// 是否有已就绪的对端，调用者持有发送锁
+static bool sle_client_any_ready_locked(void)
+{
+    for (uint8_t i = 0; i < SLE_CLIENT_PEER_MAX; i++) {
+        if (g_sle_peers[i].state == SLE_CLIENT_PEER_READY) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 在用的对端数，调用者持有发送锁
+static uint8_t sle_peer_count(void)
+{
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < SLE_CLIENT_PEER_MAX; i++) {
+        if (g_sle_peers[i].state != SLE_CLIENT_PEER_IDLE) {
+            count++;
+        }
+    }
+    return count;
+}
+
+// 新连接开始前复位对端的发送状态，序号和统计保留
+static void sle_peer_reset_link(sle_client_peer_t *peer)
+{
+    sle_cargo_tx_reset(&peer->cargo_tx); // 重连后第一帧必须是关键帧
+    sle_cargo_frag_tx_reset(&peer->bulk);
+    peer->write_id = 0;
+    peer->handles = SLE_PEER_HANDLES_DISCOVERED;
+    peer->prop_found = false;
+    peer->first_write_done = false;
+    peer->tx_head = 0;
+    peer->tx_count = 0;
+    peer->tx_stats.inflight = 0;
+    peer->event_history_count = 0;
+    peer->event_backlog = false;
+    peer->resend_armed = false;
+    peer->bulk_rx = false;
+    peer->mtu = 0;                       // MTU交换成功前按最小长度分片
+}
+
+// 断开后协议栈不会再返回写确认，清空窗口；仍在途中的帧计为丢弃。
+// 未就绪或就绪后很快断开都计为一次失败，按退避时间重试。调用者持有发送锁
+static void sle_peer_release(sle_client_peer_t *peer)
+{
+    if (peer->tx_count > 0) {
+        printf("[sle_client] 63B#%u 连接断开，%u 个写请求未确认\r\n", sle_peer_no(peer), peer->tx_count);
+        peer->tx_stats.dropped += peer->tx_count;
+    }
+    uint32_t now = osKernelGetTickCount();
+    bool stable = (peer->state == SLE_CLIENT_PEER_READY) &&
+                  (now - peer->state_tick[SLE_CLIENT_PEER_READY]) >= SLE_CLIENT_BACKOFF_RESET_MS;
+    if (peer->state == SLE_CLIENT_PEER_CONNECTING) {
+        g_sle_connecting = false;
+    }
+    if (peer->bulk.active) {
+        printf("[sle_client] 63B#%u 连接断开，大消息未发完 (%u/%u 字节)\r\n", sle_peer_no(peer), peer->bulk.offset,
+               peer->bulk.len);
+    }
+    sle_cargo_frag_rx_drop_link(&g_sle_frag_rx, peer->conn_id);
+    sle_client_server_t *server = sle_server_find(peer->addr.addr);
+    if (server != NULL) {
+        server->lost_tick = now;
+        sle_server_schedule_locked(server, !stable, now);
+    }
+    sle_peer_reset_link(peer);
+    sle_peer_set_state_locked(peer, SLE_CLIENT_PEER_IDLE);
+    sle_client_post(SLE_CLIENT_EVT_KICK, 0, 0);
+}
+
+// 连接流程失败或超时: 主动断开并释放表项，稍后的断开回调按未知连接忽略。调用者持有发送锁
+static void sle_peer_abort_locked(sle_client_peer_t *peer, const char *why)
+{
+    printf("[sle_client] 63B#%u %s (%s)，断开后重试\r\n", sle_peer_no(peer), why, g_sle_state_names[peer->state]);
+    g_sle_reconnect_stats.aborts++;
+    errcode_t ret = sle_disconnect_remote_device(&peer->addr);
+    if (ret != ERRCODE_SUCC) {
+        printf("[sle_client] disconnect failed:0x%x\r\n", ret);
+    }
+    sle_peer_release(peer);
+}
+
+// 记录连接建立到第一次写入的耗时，分别统计使用缓存句柄和完整发现两种路径。调用者持有发送锁
+static void sle_peer_first_write_locked(sle_client_peer_t *peer)
+{
+    if (peer->first_write_done) {
+        return;
+    }
+    peer->first_write_done = true;
+    peer->connect_to_write_us = (uint32_t)(uapi_systick_get_us() - peer->connect_us);
+
+    sle_client_reconnect_stats_t *st = &g_sle_reconnect_stats;
+    bool fast = (peer->handles != SLE_PEER_HANDLES_DISCOVERED);
+    if (fast) {
+        st->fast_count++;
+        st->fast_last_us = peer->connect_to_write_us;
+        st->fast_sum_us += peer->connect_to_write_us;
+    } else {
+        st->full_count++;
+        st->full_last_us = peer->connect_to_write_us;
+        st->full_sum_us += peer->connect_to_write_us;
+    }
+    printf("[sle_client] 63B#%u 连接到首次写入 %uus (%s)，平均: 缓存 %lluus x%u / 完整发现 %lluus x%u\r\n",
+           sle_peer_no(peer), peer->connect_to_write_us, fast ? "缓存句柄" : "完整发现",
+           (st->fast_count > 0) ? st->fast_sum_us / st->fast_count : 0, st->fast_count,
+           (st->full_count > 0) ? st->full_sum_us / st->full_count : 0, st->full_count);
+}
+
+// 把本次连接得到的句柄布局写入NV缓存。调用者持有发送锁
+static void sle_peer_cache_save_locked(const sle_client_peer_t *peer)
+{
+    sle_peer_cache_entry_t entry = {0};
+    memcpy_s(entry.addr, sizeof(entry.addr), peer->addr.addr, SLE_ADDR_LEN);
+    entry.wire = (uint8_t)peer->wire;
+    entry.service_start = peer->service_start;
+    entry.service_end = peer->service_end;
+    entry.write_handle = peer->write_id;
+    entry.mtu = peer->mtu;
+    sle_peer_cache_store(&entry);
+}
+
+// 按UUID查找一个服务或特征，只让对端返回目标结构，调用者持有发送锁
+static errcode_t sle_peer_find_uuid_locked(sle_client_peer_t *peer, uint8_t type, uint16_t start, uint16_t end,
+                                           const sle_uuid_t *uuid)
+{
+    ssapc_find_structure_param_t find_param = {0};
+    find_param.type = type;
+    find_param.start_hdl = start;
+    find_param.end_hdl = end;
+    find_param.uuid = *uuid;
+    peer->disc_rounds++;
+    errcode_t ret = ssapc_find_structure(0, peer->conn_id, &find_param);
+    if (ret != ERRCODE_SUCC) {
+        printf("[sle_client] 63B#%u find type=%u failed:0x%x\r\n", sle_peer_no(peer), type, ret);
+    }
+    return ret;
+}
+
+// 发起完整的服务发现: 只查找货物服务，找到后在其范围内只查找货物特征。调用者持有发送锁
+static void sle_peer_discover_locked(sle_client_peer_t *peer)
+{
+    peer->service_found = false;
+    peer->disc_rounds = 0;
+    peer->disc_us = uapi_systick_get_us();
+    if (sle_peer_find_uuid_locked(peer, SSAP_FIND_TYPE_PRIMARY_SERVICE, 1, 0xFFFF, &g_sle_service_uuid) !=
+        ERRCODE_SUCC) {
+        sle_peer_abort_locked(peer, "服务查找请求失败");
+    }
+}
+
+// 缓存的句柄布局已失效: 删除缓存，停止发送并回退到完整发现。调用者持有发送锁
+static void sle_peer_fallback_locked(sle_client_peer_t *peer, const char *why)
+{
+    printf("[sle_client] 63B#%u 缓存句柄失效(%s)，回退到完整服务发现\r\n", sle_peer_no(peer), why);
+    sle_peer_cache_invalidate(peer->addr.addr);
+    g_sle_reconnect_stats.fallbacks++;
+    // 发往旧句柄的帧不能作为增量基准，重新从关键帧开始
+    sle_cargo_tx_reset(&peer->cargo_tx);
+    peer->write_id = 0;
+    peer->handles = SLE_PEER_HANDLES_DISCOVERED;
+    sle_peer_set_state_locked(peer, SLE_CLIENT_PEER_DISCOVERING);
+    sle_peer_discover_locked(peer);
+}
+
+// 提交一帧到某个对端，调用者持有发送锁。写请求模式占用该对端的窗口槽位直到写确认，写命令模式没有确认，提交成功即完成
+static errcode_t sle_tx_submit_locked(sle_client_peer_t *peer, uint8_t kind, sle_client_write_mode_t mode,
+                                      const uint8_t *data, uint16_t len, uint8_t retries)
+{
+    if (mode == SLE_CLIENT_WRITE_REQ && peer->tx_count >= g_sle_tx_window) {
+        peer->tx_stats.busy++;
+        return SLE_CLIENT_ERRCODE_BUSY;
+    }
+    uint16_t max_len = (kind == SLE_CARGO_FRAME_FRAG) ? SLE_CARGO_FRAG_FRAME_MAX :
+                       (kind == SLE_CARGO_FRAME_BENCH) ? SLE_CARGO_BENCH_FRAME_MAX : SLE_CARGO_EVENTS_MAX_LEN;
+    if (len > max_len) {
+        return ERRCODE_INVALID_PARAM;
+    }
+
+    ssapc_write_param_t param = {0};
+    param.handle = peer->write_id;
+    param.type = SSAP_PROPERTY_TYPE_VALUE;
+    param.data_len = len;
+
+    if (mode == SLE_CLIENT_WRITE_CMD) {
+        param.data = (uint8_t *)data; // 注意：API会拷贝数据
+        errcode_t ret = ssapc_write_cmd(0, peer->conn_id, &param);
+        if (ret != ERRCODE_SUCC) {
+            // 协议栈缓冲区满，由调用者稍后重试
+            peer->tx_stats.busy++;
+            return SLE_CLIENT_ERRCODE_BUSY;
+        }
+        peer->tx_stats.cmd_issued++;
+        sle_peer_first_write_locked(peer);
+        return ERRCODE_SUCC;
+    }
+
+    // 先登记槽位再提交，写确认可能在 ssapc_write_req 返回前到达
+    sle_client_tx_slot_t *slot = &peer->tx_slots[(peer->tx_head + peer->tx_count) % SLE_CLIENT_TX_WINDOW_MAX];
+    slot->kind = kind;
+    slot->retries = retries;
+    slot->len = len;
+    slot->submit_us = uapi_systick_get_us();
+    if (kind == SLE_CARGO_FRAME_FRAG || kind == SLE_CARGO_FRAME_BENCH) {
+        // 分片失败时由分片层整条重发，压测帧不重发，槽位不保留内容
+        param.data = (uint8_t *)data;
+    } else {
+        if (slot->data != data) {
+            memcpy_s(slot->data, sizeof(slot->data), data, len);
+        }
+        param.data = slot->data;
+    }
+    peer->tx_count++;
+
+    errcode_t ret = ssapc_write_req(0, peer->conn_id, &param);
+    if (ret != ERRCODE_SUCC) {
+        peer->tx_count--;
+        peer->tx_stats.failed++;
+        return ret;
+    }
+    peer->tx_stats.req_issued++;
+    sle_cargo_telem_issued(&g_sle_telem);
+    peer->tx_stats.inflight = peer->tx_count;
+    sle_peer_first_write_locked(peer);
+    return ERRCODE_SUCC;
+}
+
+// 用发送窗口中保留槽位以外的空位发送大消息分片，调用者持有发送锁。
+// 调用点都在快照/增量帧和积压事件之后，小帧总是先提交
+static void sle_bulk_pump_locked(sle_client_peer_t *peer)
+{
+    if (peer->state != SLE_CLIENT_PEER_READY || peer->wire != SLE_CARGO_WIRE_BINARY) {
+        return;
+    }
+    uint8_t limit = (g_sle_tx_window > SLE_CLIENT_BULK_RESERVE) ? (g_sle_tx_window - SLE_CLIENT_BULK_RESERVE) : 1;
+    while (peer->tx_count < limit && sle_cargo_frag_tx_pending(&peer->bulk)) {
+        uint16_t len = sle_cargo_frag_tx_next(&peer->bulk, peer->mtu, g_sle_bulk_frame, sizeof(g_sle_bulk_frame));
+        if (len == 0) {
+            break;
+        }
+        if (sle_tx_submit_locked(peer, SLE_CARGO_FRAME_FRAG, SLE_CLIENT_WRITE_REQ, g_sle_bulk_frame, len, 0) !=
+            ERRCODE_SUCC) {
+            sle_cargo_frag_tx_cancel(&peer->bulk);
+            break;
+        }
+    }
+}
+
+// 压测目标的PHY切换完成(或等待超时)后开始本轮，结果和吞吐统计都对应开始时的PHY。调用者持有发送锁
+static void sle_bench_arm_locked(sle_client_peer_t *peer, uint32_t now)
+{
+    if (!g_sle_bench_armed) {
+        return;
+    }
+    bool timeout = (uint32_t)(now - g_sle_bench_arm_tick) >= SLE_CLIENT_BENCH_PHY_WAIT_MS;
+    if (!sle_cargo_phy_settled(&peer->phy) && !timeout) {
+        return;
+    }
+    g_sle_bench_armed = false;
+    sle_cargo_bench_tx_start(&g_sle_bench, &g_sle_bench_cfg, now);
+    g_sle_bench_epoch = peer->phy.epoch;
+    printf("[sle_client] 63B#%u 压测开始: run=%u len=%u (mtu=%u) rate=%u/s %ums %s phy=%s%s\r\n", sle_peer_no(peer),
+           g_sle_bench.run_id, g_sle_bench.cfg.frame_len, peer->mtu, g_sle_bench.cfg.rate_hz,
+           g_sle_bench.cfg.duration_ms, (g_sle_bench_mode == SLE_CLIENT_WRITE_CMD) ? "cmd" : "req",
+           sle_cargo_phy_name(peer->phy.current), timeout ? " (PHY切换未完成)" : "");
+    printf("[sle_client] bench 对端  | run |  frames |   kbps |  lost |  loss%%  | reord |  dup | jitter |     ms | phy\r\n");
+}
+
+// 按速率向压测目标提交压测帧，调用者持有发送锁。写请求模式与大消息分片一样只用保留槽位以外的空位，
+// 目标断开时本轮作废，63B空闲超时后给出已收到部分的结果
+static void sle_bench_pump_locked(uint32_t now)
+{
+    if (!g_sle_bench.active && !g_sle_bench_armed) {
+        return;
+    }
+    sle_client_peer_t *peer = sle_peer_find(g_sle_bench_conn);
+    if (peer == NULL || peer->state != SLE_CLIENT_PEER_READY) {
+        g_sle_bench.active = false;
+        g_sle_bench_armed = false;
+        printf("[sle_client] 压测目标已断开，停止压测 (已发 %u 帧)\r\n", g_sle_bench.seq);
+        return;
+    }
+    sle_bench_arm_locked(peer, now);
+    if (!g_sle_bench.active) {
+        return;
+    }
+
+    uint16_t len = (peer->mtu > SLE_CARGO_FRAG_MTU_OVERHEAD) ? (uint16_t)(peer->mtu - SLE_CARGO_FRAG_MTU_OVERHEAD) :
+                   SLE_CARGO_FRAG_MTU_MIN;
+    uint8_t limit = (g_sle_tx_window > SLE_CLIENT_BULK_RESERVE) ? (g_sle_tx_window - SLE_CLIENT_BULK_RESERVE) : 1;
+    uint32_t due = sle_cargo_bench_tx_due(&g_sle_bench, now);
+    for (; due > 0; due--) {
+        if (g_sle_bench_mode == SLE_CLIENT_WRITE_REQ && peer->tx_count >= limit) {
+            break;
+        }
+        uint16_t n = sle_cargo_bench_tx_next(&g_sle_bench, len, now, (uint32_t)uapi_systick_get_us(),
+                                             g_sle_bench_frame, sizeof(g_sle_bench_frame));
+        if (n == 0) {
+            break;
+        }
+        if (sle_tx_submit_locked(peer, SLE_CARGO_FRAME_BENCH, g_sle_bench_mode, g_sle_bench_frame, n, 0) !=
+            ERRCODE_SUCC) {
+            sle_cargo_bench_tx_cancel(&g_sle_bench);
+            break;
+        }
+    }
+
+    if (g_sle_bench.last) {
+        g_sle_bench.active = false;
+        printf("[sle_client] 63B#%u 压测发送完成: run=%u %u 帧 %ums\r\n", sle_peer_no(peer), g_sle_bench.run_id,
+               g_sle_bench.seq, now - g_sle_bench.start_tick);
+    }
+}
+
+// 记录一个候选服务器: 同一地址取最强的RSSI，窗口已满时替换最弱的候选。调用者持有发送锁
+static void sle_candidate_add_locked(const sle_addr_t *addr, int8_t rssi, sle_cargo_wire_t wire, uint8_t phy_caps)
+{
+    sle_client_candidate_t *slot = NULL;
+    for (uint8_t i = 0; i < g_sle_candidate_count; i++) {
+        if (memcmp(g_sle_candidates[i].addr.addr, addr->addr, SLE_ADDR_LEN) == 0) {
+            slot = &g_sle_candidates[i];
+            break;
+        }
+    }
+    if (slot != NULL) {
+        // 广播和扫描响应分开上报，只有广播数据带协议能力字段
+        if (rssi > slot->rssi) {
+            slot->rssi = rssi;
+        }
+        if (wire == SLE_CARGO_WIRE_BINARY) {
+            slot->wire = wire;
+        }
+        slot->phy_caps |= phy_caps;
+        return;
+    }
+
+    if (g_sle_candidate_count < SLE_CLIENT_CANDIDATE_MAX) {
+        slot = &g_sle_candidates[g_sle_candidate_count++];
+    } else {
+        slot = &g_sle_candidates[0];
+        for (uint8_t i = 1; i < SLE_CLIENT_CANDIDATE_MAX; i++) {
+            if (g_sle_candidates[i].rssi < slot->rssi) {
+                slot = &g_sle_candidates[i];
+            }
+        }
+        if (rssi <= slot->rssi) {
+            return;
+        }
+    }
+    slot->addr = *addr;
+    slot->rssi = rssi;
+    slot->wire = wire;
+    slot->phy_caps = phy_caps;
+    g_sle_scan_stats.candidates++;
+}
+
+// 找到一个要连接的服务器地址记录，没有时新建；表满时替换最久未连接的非固定记录。调用者持有发送锁
+static sle_client_server_t *sle_server_learn_locked(const uint8_t *addr, uint32_t now)
+{
+    sle_client_server_t *server = sle_server_find(addr);
+    if (server != NULL) {
+        return server;
+    }
+    if (g_sle_server_count < SLE_CLIENT_SERVER_MAX) {
+        server = &g_sle_servers[g_sle_server_count++];
+    } else {
+        for (uint8_t i = 0; i < SLE_CLIENT_SERVER_MAX; i++) {
+            sle_client_server_t *s = &g_sle_servers[i];
+            if (s->pinned || sle_peer_find_addr(s->addr) != NULL) {
+                continue;
+            }
+            if (server == NULL || (int32_t)(s->lost_tick - server->lost_tick) < 0) {
+                server = s;
+            }
+        }
+        if (server == NULL) {
+            return NULL;
+        }
+    }
+    memset_s(server, sizeof(*server), 0, sizeof(*server));
+    memcpy_s(server->addr, SLE_ADDR_LEN, addr, SLE_ADDR_LEN);
+    server->retry_tick = now;
+    server->lost_tick = g_sle_scan_tick; // 新发现的服务器从本轮扫描开始计时
+    return server;
+}
+
+// 星闪扫描结果回调: 按货物服务UUID或设备名称识别63B，候选窗口内只记录，由客户端任务选择信号最强的连接
 static void sle_seek_result_cb(sle_seek_result_info_t *seek_result_data)
 {
     if (seek_result_data == NULL) {
         printf("[sle_client] seek result data is NULL\r\n");
         return;
     }
-    
-    printf("[sle_client] found device addr: %02x:%02x:%02x:%02x:%02x:%02x, rssi: %d\r\n",
-           seek_result_data->addr.addr[0], seek_result_data->addr.addr[1], seek_result_data->addr.addr[2],
-           seek_result_data->addr.addr[3], seek_result_data->addr.addr[4], seek_result_data->addr.addr[5],
-           seek_result_data->rssi);
-    
-    printf("[sle_client] expected addr: %02x:%02x:%02x:%02x:%02x:%02x\r\n",
-           g_sle_expected_addr[0], g_sle_expected_addr[1], g_sle_expected_addr[2],
-           g_sle_expected_addr[3], g_sle_expected_addr[4], g_sle_expected_addr[5]);
-
-    // 只连接期望的服务器地址
-    if (memcmp((void *)seek_result_data->addr.addr, (void *)g_sle_expected_addr, SLE_ADDR_LEN) == 0) {
-        printf("[sle_client] ✓ FOUND TARGET CARGO_SERVER_63B! Connecting...\r\n");
-        
-        // 停止扫描
-        errcode_t ret = sle_stop_seek();
-        if (ret != ERRCODE_SUCC) {
-            printf("[sle_client] stop seek failed:0x%x\r\n", ret);
-        }
-        
-        // 保存远程设备地址
-        memcpy_s(&g_sle_remote_addr, sizeof(sle_addr_t), &seek_result_data->addr, sizeof(sle_addr_t));
-        
-        // 连接到目标设备
-        ret = sle_connect_remote_device(&seek_result_data->addr);
-        if (ret != ERRCODE_SUCC) {
-            printf("[sle_client] connect failed:0x%x, will retry scan\r\n", ret);
-            osDelay(1000);
-            sle_start_scan();
-        } else {
-            printf("[sle_client] connection request sent\r\n");
+
+    // 拥挤环境中同一设备的广播会反复上报，有效期内见过的直接丢弃，不打印也不匹配
+    sle_tx_lock();
+    uint32_t now = osKernelGetTickCount();
+    g_sle_scan_stats.seen++;
+    if (g_sle_scan_cache &&
+        sle_seen_cache_check(seek_result_data->addr.addr, seek_result_data->event_type, now)) {
+        g_sle_scan_stats.filtered++;
+        sle_tx_unlock();
+        return;
+    }
+
+    // 广播/扫描响应中带货物服务UUID或名称的设备，以及 sle_client_add_server 固定的地址
+    sle_client_server_t *server = sle_server_find(seek_result_data->addr.addr);
+    bool match = sle_cargo_adv_match_server(seek_result_data->data, seek_result_data->data_length) ||
+                 (server != NULL && server->pinned);
+    int8_t rssi = (int8_t)seek_result_data->rssi;
+    if (!match) {
+        sle_tx_unlock();
+        printf("[sle_client] found device %02x:%02x:%02x:%02x:%02x:%02x rssi=%d, not target\r\n",
+               seek_result_data->addr.addr[0], seek_result_data->addr.addr[1], seek_result_data->addr.addr[2],
+               seek_result_data->addr.addr[3], seek_result_data->addr.addr[4], seek_result_data->addr.addr[5], rssi);
+        return;
+    }
+    g_sle_scan_stats.matched++;
+
+    // 已连接、正在连接或仍在退避中的跳过
+    bool backoff = (server != NULL) && (int32_t)(now - server->retry_tick) < 0;
+    if (backoff) {
+        server->deferred = true;
+    }
+    if (g_sle_connecting || backoff || sle_peer_find_addr(seek_result_data->addr.addr) != NULL) {
+        sle_tx_unlock();
+        return;
+    }
+
+    // 服务器广播了协议能力字段则使用二进制帧，否则回退到旧版文本格式；字段中的PHY能力位用于批量传输时协商PHY
+    sle_candidate_add_locked(&seek_result_data->addr, rssi,
+                             sle_cargo_adv_find_proto(seek_result_data->data, seek_result_data->data_length),
+                             sle_cargo_adv_find_phy_caps(seek_result_data->data, seek_result_data->data_length));
+    bool open = !g_sle_window_open;
+    if (open) {
+        g_sle_window_open = true;
+        g_sle_window_end = now + SLE_CLIENT_CANDIDATE_WINDOW_MS;
+    }
+    sle_tx_unlock();
+
+    printf("[sle_client] candidate CARGO_SERVER_63B %02x:%02x rssi=%d\r\n", seek_result_data->addr.addr[4],
+           seek_result_data->addr.addr[5], rssi);
+    if (open) {
+        sle_client_post(SLE_CLIENT_EVT_KICK, 0, 0);
+    }
+}
+
+// 候选窗口结束: 连接信号最强的候选，其余候选在下一轮扫描中重新收集
+static void sle_client_connect_best(void)
+{
+    sle_tx_lock();
+    uint32_t now = osKernelGetTickCount();
+    sle_client_candidate_t best = {0};
+    bool found = false;
+    uint8_t count = g_sle_candidate_count;
+    for (uint8_t i = 0; i < g_sle_candidate_count; i++) {
+        const sle_client_candidate_t *c = &g_sle_candidates[i];
+        if (sle_peer_find_addr(c->addr.addr) != NULL || (found && c->rssi <= best.rssi)) {
+            continue;
+        }
+        best = *c;
+        found = true;
+    }
+    g_sle_candidate_count = 0;
+    g_sle_window_open = false;
+
+    sle_client_peer_t *peer = NULL;
+    sle_client_server_t *server = (found && !g_sle_connecting) ? sle_server_learn_locked(best.addr.addr, now) : NULL;
+    for (uint8_t i = 0; server != NULL && i < SLE_CLIENT_PEER_MAX; i++) {
+        if (g_sle_peers[i].state == SLE_CLIENT_PEER_IDLE) {
+            peer = &g_sle_peers[i];
+            break;
+        }
+    }
+    if (peer != NULL) {
+        sle_peer_reset_link(peer);
+        // 阶段时刻从该服务器上次断开(或开始寻找)算起
+        memset_s(peer->state_tick, sizeof(peer->state_tick), 0, sizeof(peer->state_tick));
+        peer->state_tick[SLE_CLIENT_PEER_IDLE] = server->lost_tick;
+        peer->reconnect_ms = 0;
+        peer->scan_tick = g_sle_scan_tick;
+        peer->scan_cache = g_sle_scan_cache;
+        peer->addr = best.addr;
+        peer->wire = best.wire;
+        peer->phy_caps = best.phy_caps;
+        sle_peer_set_state_locked(peer, SLE_CLIENT_PEER_CONNECTING);
+        g_sle_connecting = true;
+        g_sle_scan_stats.last_window_candidates = count;
+        g_sle_scan_stats.last_rssi = best.rssi;
+    }
+    sle_tx_unlock();
+    if (peer == NULL) {
+        return;
+    }
+
+    printf("[sle_client] ✓ CARGO_SERVER_63B %02x:%02x rssi=%d (strongest of %u), connecting as 63B#%u, wire format: %s\r\n",
+           best.addr.addr[4], best.addr.addr[5], best.rssi, count, sle_peer_no(peer),
+           (best.wire == SLE_CARGO_WIRE_BINARY) ? "binary" : "text");
+
+    // 停止扫描，连接建立后如仍有空闲表项由状态机重新扫描
+    errcode_t ret = sle_stop_seek();
+    if (ret != ERRCODE_SUCC) {
+        printf("[sle_client] stop seek failed:0x%x\r\n", ret);
+    }
+    sle_tx_lock();
+    g_sle_scanning = false;
+    sle_tx_unlock();
+
+    // 连接到目标设备
+    ret = sle_connect_remote_device(&best.addr);
+    if (ret != ERRCODE_SUCC) {
+        printf("[sle_client] connect failed:0x%x, will retry scan\r\n", ret);
+        sle_tx_lock();
+        if (peer->state == SLE_CLIENT_PEER_CONNECTING) {
+            sle_peer_release(peer);
         }
+        sle_tx_unlock();
     } else {
-        printf("[sle_client] not target server (addr mismatch), continue scanning...\r\n");
+        printf("[sle_client] connection request sent\r\n");
     }
 }
 
@@ -119,27 +926,90 @@ static void sle_connect_state_changed_cbk(uint16_t conn_id, const sle_addr_t *ad
            conn_id, conn_state, pair_state, disc_reason);
     printf("[sle_client] addr: %02x:%02x:%02x:%02x:%02x:%02x\r\n",
            addr->addr[0], addr->addr[1], addr->addr[2], addr->addr[3], addr->addr[4], addr->addr[5]);
-    
-    g_sle_client_conn_id = conn_id;
-    
+
+    sle_tx_lock();
+    if (conn_state == SLE_ACB_STATE_DISCONNECTED) {
+        // 主动放弃的连接稍后按未知连接忽略，断开原因仍然计入
+        sle_cargo_telem_disconnected(&g_sle_telem, (uint8_t)disc_reason);
+    }
+    sle_client_peer_t *peer = sle_peer_find(conn_id);
+    if (peer == NULL) {
+        // 连接建立或连接失败时表项还没有连接ID，按地址匹配
+        peer = sle_peer_find_addr(addr->addr);
+    }
+    if (peer == NULL || (peer->state == SLE_CLIENT_PEER_CONNECTING && g_sle_connecting)) {
+        g_sle_connecting = false;
+    }
+    if (peer == NULL) {
+        sle_tx_unlock();
+        if (conn_state == SLE_ACB_STATE_CONNECTED) {
+            // 超时放弃后才建立的链路，不再使用
+            printf("[sle_client] stray connection 0x%04x, disconnecting\r\n", conn_id);
+            sle_disconnect_remote_device(addr);
+        } else {
+            printf("[sle_client] state change for unknown peer ignored\r\n");
+        }
+        return;
+    }
+
+    uint8_t no = sle_peer_no(peer);
     if (conn_state == SLE_ACB_STATE_CONNECTED) {
-        printf("[sle_client] SLE connected successfully\r\n");
-        g_sle_client_conn_state = SLE_ACB_STATE_CONNECTED;
-        
-        // 如果还没有配对，启动配对
+        // 扫描开始到连接建立的耗时，按地址表开/关分开统计
+        uint32_t ttc = osKernelGetTickCount() - peer->scan_tick;
+        sle_client_scan_stats_t *sst = &g_sle_scan_stats;
+        if (peer->scan_cache) {
+            sst->ttc_on_count++;
+            sst->ttc_on_last_ms = ttc;
+            sst->ttc_on_sum_ms += ttc;
+        } else {
+            sst->ttc_off_count++;
+            sst->ttc_off_last_ms = ttc;
+            sst->ttc_off_sum_ms += ttc;
+        }
+        printf("[sle_client] 扫描到连接 %ums (地址表%s)\r\n", ttc, peer->scan_cache ? "开" : "关");
+        sle_cargo_telem_connected(&g_sle_telem);
+        peer->conn_id = conn_id;
+        sle_peer_reset_link(peer);
+        peer->connect_us = uapi_systick_get_us();
+        sle_cargo_conn_policy_init(&peer->conn_policy, g_sle_conn_idle_ms, osKernelGetTickCount());
+        sle_cargo_phy_init(&peer->phy, peer->phy_caps);
+        sle_cargo_phy_enable(&peer->phy, g_sle_phy_on);
+
+        // 连过的服务器: 直接使用NV中的写句柄，就绪后立即发送，配对/MTU交换和句柄校验在后台进行；
+        // MTU交换成功前大消息按最小长度分片，交换失败时回退到完整发现
+        sle_peer_cache_entry_t cache;
+        bool cached = sle_peer_cache_find(peer->addr.addr, &cache) && cache.write_handle != 0;
+        if (cached) {
+            peer->write_id = cache.write_handle;
+            peer->service_start = cache.service_start;
+            peer->service_end = cache.service_end;
+            peer->handles = SLE_PEER_HANDLES_CACHED;
+            sle_peer_set_state_locked(peer, SLE_CLIENT_PEER_READY);
+        } else {
+            sle_peer_set_state_locked(peer, (pair_state == SLE_PAIR_NONE) ?
+                                      SLE_CLIENT_PEER_PAIRING : SLE_CLIENT_PEER_EXCHANGING);
+        }
+        sle_addr_t remote = peer->addr;
+        sle_tx_unlock();
+        printf("[sle_client] 63B#%u SLE connected successfully%s\r\n", no, cached ? ", using cached handles" : "");
+
+        // 如果还没有配对，启动配对；已配对则直接进行MTU交换
         if (pair_state == SLE_PAIR_NONE) {
             printf("[sle_client] starting pairing...\r\n");
-            sle_pair_remote_device(&g_sle_remote_addr);
+            sle_pair_remote_device(&remote);
+        } else {
+            ssap_exchange_info_t info = {0};
+            info.mtu_size = SLE_MTU_SIZE_DEFAULT;
+            info.version = 1;
+            ssapc_exchange_info_req(0, conn_id, &info);
         }
     } else if (conn_state == SLE_ACB_STATE_DISCONNECTED) {
-        printf("[sle_client] SLE disconnected, reason:0x%02x\r\n", disc_reason);
-        g_sle_client_conn_state = SLE_ACB_STATE_NONE;
-        g_sle_client_write_id = 0; // 重置写句柄
-        
-        // 延迟后重新开始扫描
-        printf("[sle_client] will restart scanning in 2 seconds...\r\n");
-        osDelay(2000); // 延迟2秒后重新扫描
-        sle_start_scan();
+        sle_peer_release(peer);
+        sle_tx_unlock();
+        // 客户端任务按退避时间重新扫描，这里不阻塞协议栈回调
+        printf("[sle_client] 63B#%u SLE disconnected, reason:0x%02x, will rescan\r\n", no, disc_reason);
+    } else {
+        sle_tx_unlock();
     }
 }
 
@@ -149,8 +1019,16 @@ static void sle_pair_complete_cbk(uint16_t conn_id, const sle_addr_t *addr, errc
     printf("[sle_client] pair complete: conn_id=0x%02x, status=0x%x\r\n", conn_id, status);
     printf("[sle_client] pair addr: %02x:%02x:%02x:%02x:%02x:%02x\r\n",
            addr->addr[0], addr->addr[1], addr->addr[2], addr->addr[3], addr->addr[4], addr->addr[5]);
-    
+
     if (status == ERRCODE_SUCC) {
+        sle_tx_lock();
+        sle_client_peer_t *peer = sle_peer_find(conn_id);
+        if (peer != NULL) {
+            if (peer->state == SLE_CLIENT_PEER_PAIRING) {
+                sle_peer_set_state_locked(peer, SLE_CLIENT_PEER_EXCHANGING);
+            }
+        }
+        sle_tx_unlock();
         printf("[sle_client] pairing successful, starting MTU exchange...\r\n");
         // 发起MTU交换
         ssap_exchange_info_t info = {0};
@@ -159,218 +1037,962 @@ static void sle_pair_complete_cbk(uint16_t conn_id, const sle_addr_t *addr, errc
         ssapc_exchange_info_req(0, conn_id, &info); // 使用默认client_id 0
     } else {
         printf("[sle_client] pairing failed\r\n");
+        sle_tx_lock();
+        sle_client_peer_t *peer = sle_peer_find(conn_id);
+        if (peer != NULL && peer->state == SLE_CLIENT_PEER_PAIRING) {
+            sle_peer_abort_locked(peer, "配对失败");
+        }
+        sle_tx_unlock();
     }
 }
 
-// 解析来自服务器的货物数据
-static bool parse_server_cargo_data(const char *data, uint16_t len, uint32_t *jiangsu, uint32_t *zhejiang, uint32_t *shanghai, uint64_t *timestamp)
+// 打印63B导出的一块速率历史: 块头和最新的几个桶
+static void sle_client_print_history(uint8_t no, const uint8_t *data, uint16_t len)
 {
-    if (data == NULL || len == 0) {
-        return false;
+    sle_cargo_hist_chunk_t chunk;
+    sle_cargo_hist_bucket_t newest[SLE_CLIENT_HIST_PRINT_BUCKETS];
+    uint16_t n = sle_cargo_history_decode(data, len, &chunk, newest, SLE_CLIENT_HIST_PRINT_BUCKETS);
+    if (n == 0) {
+        printf("[sle_client] 63B#%u 速率历史块格式错误 len=%u\r\n", no, len);
+        return;
     }
-    
-    // 拷贝数据到本地缓冲区确保字符串结束
-    char buffer[256] = {0};
-    if (len >= sizeof(buffer)) {
-        len = sizeof(buffer) - 1;
+    printf("[sle_client] 63B#%u 速率历史 tier=%u 每桶%us 截至%us 共%u桶 %u字节, 最新:", no, chunk.tier,
+           chunk.period_s, chunk.newest_end_s, n, len);
+    for (uint16_t i = 0; i < n && i < SLE_CLIENT_HIST_PRINT_BUCKETS; i++) {
+        printf(" %u/%u/%u", newest[i].count[SLE_CARGO_REGION_JIANGSU], newest[i].count[SLE_CARGO_REGION_ZHEJIANG],
+               newest[i].count[SLE_CARGO_REGION_SHANGHAI]);
     }
-    memcpy_s(buffer, sizeof(buffer), data, len);
-    buffer[len] = '\0';
-    
-    printf("[sle_client] parsing server cargo data: %s\r\n", buffer);
-    
-    // 解析格式: "J:xxx,Z:xxx,S:xxx,T:timestamp"
-    uint32_t js = 0, zj = 0, sh = 0;
-    uint64_t ts = 0;
-    
-    char *token = strtok(buffer, ",");
-    int parsed_count = 0;
-    
-    while (token != NULL && parsed_count < 4) {
-        if (strncmp(token, "J:", 2) == 0) {
-            js = (uint32_t)atoi(token + 2);
-            parsed_count++;
-        } else if (strncmp(token, "Z:", 2) == 0) {
-            zj = (uint32_t)atoi(token + 2);
-            parsed_count++;
-        } else if (strncmp(token, "S:", 2) == 0) {
-            sh = (uint32_t)atoi(token + 2);
-            parsed_count++;
-        } else if (strncmp(token, "T:", 2) == 0) {
-            ts = (uint64_t)atoll(token + 2);
-            parsed_count++;
-        }
-        token = strtok(NULL, ",");
+    printf("\r\n");
+}
+
+// 重组63B通过notify发来的大消息，完整后在锁内处理并释放槽位
+static void sle_client_on_fragment(uint16_t conn_id, const sle_cargo_frag_t *frag)
+{
+    sle_cargo_frag_msg_t msg;
+    sle_tx_lock();
+    sle_client_peer_t *peer = sle_peer_find(conn_id);
+    uint32_t now = osKernelGetTickCount();
+    sle_cargo_frag_rx_result_t res = sle_cargo_frag_rx_push(&g_sle_frag_rx, conn_id, frag, now, &msg);
+    if (peer != NULL) {
+        // 63B在批量发送，下次检查时切到高速PHY
+        bool first = !peer->bulk_rx || (uint32_t)(now - peer->bulk_rx_tick) >= SLE_CLIENT_PHY_RX_BULK_MS;
+        peer->bulk_rx = true;
+        peer->bulk_rx_tick = now;
+        if (first) {
+            sle_client_post(SLE_CLIENT_EVT_KICK, 0, 0);
+        }
     }
-    
-    if (parsed_count >= 3) { // 至少要有J、Z、S三个数据
-        *jiangsu = js;
-        *zhejiang = zj;
-        *shanghai = sh;
-        *timestamp = ts;
-        printf("[sle_client] parsed server cargo: J=%u, Z=%u, S=%u, T=%llu\r\n", js, zj, sh, ts);
-        return true;
+    if (res == SLE_CARGO_FRAG_RX_COMPLETE) {
+        uint8_t no = (peer != NULL) ? sle_peer_no(peer) : 0;
+        if (peer != NULL) {
+            peer->bulk_rx_messages++;
+        }
+        if (msg.kind == SLE_CARGO_BULK_LOG) {
+            printf("[sle_client] 63B#%u 日志 %u 字节:\r\n%.*s\r\n", no, msg.len, (int)msg.len, (const char *)msg.data);
+        } else if (msg.kind == SLE_CARGO_BULK_RATE_HISTORY) {
+            sle_client_print_history(no, msg.data, msg.len);
+        } else {
+            printf("[sle_client] 63B#%u 收到大消息 kind=%u len=%u\r\n", no, msg.kind, msg.len);
+        }
+        sle_cargo_frag_rx_release(&g_sle_frag_rx, &msg);
+    } else if (res == SLE_CARGO_FRAG_RX_DROPPED) {
+        printf("[sle_client] conn 0x%04x 分片 msg=%u off=%u 无法重组，已丢弃\r\n", conn_id, frag->msg_id, frag->offset);
     }
-    
-    printf("[sle_client] parse failed, parsed_count=%d\r\n", parsed_count);
-    return false;
+    sle_tx_unlock();
+}
+
+// 63B回报的压测结果，按表格一行输出
+static void sle_client_on_bench_report(uint16_t conn_id, const sle_cargo_bench_report_t *report)
+{
+    sle_tx_lock();
+    sle_client_peer_t *peer = sle_peer_find(conn_id);
+    uint8_t no = (peer != NULL) ? sle_peer_no(peer) : 0;
+    uint8_t phy = (peer != NULL) ? peer->phy.current : SLE_CARGO_PHY_1M;
+    g_sle_bench_report = *report;
+    g_sle_bench_reported = true;
+    if (peer != NULL && (report->flags & SLE_CARGO_BENCH_LAST) != 0) {
+        // 63B测得的接收字节数和时长即该PHY上的有效吞吐
+        sle_cargo_phy_goodput(&peer->phy, g_sle_bench_epoch, report->bytes, report->elapsed_ms);
+    }
+    sle_tx_unlock();
+
+    uint32_t loss = sle_cargo_bench_loss_bp(report);
+    printf("[sle_client] bench 63B#%u | %3u | %7u | %6u | %5u | %3u.%02u | %5u | %4u | %6u | %6u | %s%s\r\n", no,
+           report->run_id, report->frames, sle_cargo_bench_bps(report) / 1000, report->lost, loss / 100, loss % 100,
+           report->reordered, report->dups, report->jitter_us, report->elapsed_ms, sle_cargo_phy_name(phy),
+           ((report->flags & SLE_CARGO_BENCH_LAST) != 0) ? " 最终" : "");
+}
+
+// 63B的对时请求: 带回t1，填上收到请求的时刻t2和发出回复前一刻的t3，用写命令立即回复，不占用发送窗口；
+// 回复因协议栈忙未发出时63B只是少一个样本
+static void sle_client_on_clock(uint16_t conn_id, uint16_t seq, const sle_cargo_clock_msg_t *ping, uint32_t t2)
+{
+    if ((ping->flags & SLE_CARGO_CLOCK_PONG) != 0) {
+        return;
+    }
+    sle_cargo_clock_msg_t pong = { SLE_CARGO_CLOCK_PONG, ping->t1, t2, 0 };
+    uint8_t frame[SLE_CARGO_CLOCK_LEN];
+    sle_tx_lock();
+    sle_client_peer_t *peer = sle_peer_find(conn_id);
+    if (peer != NULL && peer->state == SLE_CLIENT_PEER_READY) {
+        pong.t3 = osKernelGetTickCount();
+        uint16_t len = sle_cargo_encode_clock(frame, sizeof(frame), seq, &pong);
+        if (len > 0) {
+            (void)sle_tx_submit_locked(peer, SLE_CARGO_FRAME_CLOCK, SLE_CLIENT_WRITE_CMD, frame, len, 0);
+        }
+    }
+    sle_tx_unlock();
 }
 
 // 星闪数据接收回调
 static void sle_ssapc_data_received_cbk(uint8_t client_id, uint16_t conn_id, ssapc_handle_value_t *data,
                                         errcode_t status)
 {
+    uint32_t rx_tick = osKernelGetTickCount();
     unused(client_id);
-    unused(conn_id);
-    
+
     if (status != ERRCODE_SUCC) {
         printf("[sle_client] data received with error: 0x%x\r\n", status);
         return;
     }
-    
+
+    // 对时请求先处理，不打印，t2 尽量贴近实际到达时刻
+    if (data != NULL && sle_cargo_frame_type(data->data, data->data_len) == SLE_CARGO_FRAME_CLOCK) {
+        sle_cargo_frame_t frame;
+        if (sle_cargo_decode(data->data, data->data_len, &frame) == SLE_CARGO_OK) {
+            sle_client_on_clock(conn_id, frame.seq, &frame.clock, rx_tick);
+        }
+        return;
+    }
+
     if (data != NULL && data->data_len > 0) {
-        printf("[sle_client] received data len:%d\r\n", data->data_len);
-        
+#if SLE_CLIENT_RX_LOG
+        printf("[sle_client] received data len:%d from conn 0x%04x\r\n", data->data_len, conn_id);
+#endif
+
         // 解析接收到的货物数据
-        uint32_t jiangsu, zhejiang, shanghai;
-        uint64_t timestamp;
-        if (parse_server_cargo_data((const char *)data->data, data->data_len, 
-                                   &jiangsu, &zhejiang, &shanghai, &timestamp)) {
-            printf("[sle_client] received cargo data from 63B: J=%u, Z=%u, S=%u\r\n", 
-                   jiangsu, zhejiang, shanghai);
-            
+        sle_cargo_frame_t frame;
+        sle_cargo_err_t err = sle_cargo_decode(data->data, data->data_len, &frame);
+        if (err == SLE_CARGO_OK && frame.type == SLE_CARGO_FRAME_ACK) {
+            sle_tx_lock();
+            sle_client_peer_t *peer = sle_peer_find(conn_id);
+            if (peer != NULL) {
+                sle_client_handle_ack(peer, &frame.ack);
+            }
+            sle_tx_unlock();
+        } else if (err == SLE_CARGO_OK && frame.type == SLE_CARGO_FRAME_FRAG) {
+            sle_client_on_fragment(conn_id, &frame.frag);
+        } else if (err == SLE_CARGO_OK && frame.type == SLE_CARGO_FRAME_BENCH_REPORT) {
+            sle_client_on_bench_report(conn_id, &frame.bench_report);
+        } else if (err == SLE_CARGO_OK) {
+            printf("[sle_client] received cargo data from 63B: J=%u, Z=%u, S=%u, T=%u\r\n",
+                   frame.snapshot.jiangsu, frame.snapshot.zhejiang, frame.snapshot.shanghai, frame.snapshot.tick);
+
             // 这里可以添加处理逻辑，例如更新本地数据或同步到其他系统
             // 可以调用外部函数来更新WS63的本地货物数据
+        } else {
+            printf("[sle_client] parse server cargo data failed: %s\r\n", sle_cargo_err_str(err));
+        }
+    }
+}
+
+// 开始扫描
+static void sle_start_scan(void)
+{
+    sle_seek_param_t param = {0};
+    param.own_addr_type = 0;
+    param.filter_duplicates = SLE_CLIENT_SEEK_FILTER_DUPLICATES; // 控制器侧过滤重复广播，每轮扫描重新上报
+    param.seek_filter_policy = 0;
+    param.seek_phys = 1;
+    param.seek_type[0] = 1; // 主动扫描，设备名称在扫描响应中
+    param.seek_interval[0] = SLE_SEEK_INTERVAL_DEFAULT;
+    param.seek_window[0] = SLE_SEEK_WINDOW_DEFAULT;
+
+    errcode_t ret = sle_set_seek_param(&param);
+    if (ret != ERRCODE_SUCC) {
+        printf("[sle_client] set seek param failed:0x%x\r\n", ret);
+        return;
+    }
+
+    ret = sle_start_seek();
+    if (ret != ERRCODE_SUCC) {
+        printf("[sle_client] start seek failed:0x%x\r\n", ret);
+        return;
+    }
+    sle_tx_lock();
+    g_sle_scanning = true;
+    g_sle_scan_tick = osKernelGetTickCount();
+    for (uint8_t i = 0; i < g_sle_server_count; i++) {
+        g_sle_servers[i].deferred = false;
+    }
+    g_sle_scan_cache = g_sle_seen_cache_on;
+    g_sle_candidate_count = 0;
+    g_sle_window_open = false;
+    sle_seen_cache_reset();
+    sle_tx_unlock();
+
+    printf("[sle_client] start scan success, searching for CARGO_SERVER_63B / uuid 0x%04x...\r\n",
+           SLE_CARGO_ADV_SERVICE_UUID);
+}
+
+// 记录已发送的事件，调用者持有发送锁
+static void sle_event_history_add(sle_client_peer_t *peer, const sle_cargo_event_t *events, uint8_t count)
+{
+    for (uint8_t i = 0; i < count; i++) {
+        peer->event_history[(peer->event_history_head + peer->event_history_count) % SLE_CLIENT_EVENT_HISTORY] =
+            events[i];
+        if (peer->event_history_count < SLE_CLIENT_EVENT_HISTORY) {
+            peer->event_history_count++;
+        } else {
+            peer->event_history_head = (peer->event_history_head + 1) % SLE_CLIENT_EVENT_HISTORY;
+        }
+    }
+}
+
+// 从历史中取出编号 first 起连续的事件，返回条数；first 已不在历史中时返回0
+static uint8_t sle_event_history_collect(const sle_client_peer_t *peer, uint16_t first, sle_cargo_event_t *out,
+                                         uint8_t max)
+{
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < peer->event_history_count && n < max; i++) {
+        const sle_cargo_event_t *ev =
+            &peer->event_history[(peer->event_history_head + i) % SLE_CLIENT_EVENT_HISTORY];
+        if (ev->no == (uint16_t)(first + n)) {
+            out[n++] = *ev;
+        } else if (n > 0) {
+            break;
+        }
+    }
+    return n;
+}
+
+// 编码并提交一帧事件，调用者持有发送锁
+static errcode_t sle_send_events_locked(sle_client_peer_t *peer, const sle_cargo_event_t *events, uint8_t count)
+{
+    uint8_t msg[SLE_CARGO_EVENTS_MAX_LEN];
+    uint16_t msg_len = sle_cargo_encode_events(msg, sizeof(msg), peer->event_frame_seq, events, count);
+    if (msg_len == 0) {
+        return ERRCODE_FAIL;
+    }
+    errcode_t ret = sle_tx_submit_locked(peer, SLE_CARGO_FRAME_EVENTS, SLE_CLIENT_EVENT_WRITE_MODE, msg, msg_len, 0);
+    if (ret == ERRCODE_SUCC) {
+        peer->event_frame_seq++;
+    }
+    return ret;
+}
+
+// 按编号补发该对端积压的事件，调用者持有发送锁；积压已超出历史时改为下一帧发送关键帧
+static void sle_flush_backlog_locked(sle_client_peer_t *peer)
+{
+    while (peer->event_backlog) {
+        sle_cargo_event_t batch[SLE_CARGO_EVENT_BATCH_MAX];
+        uint16_t left = (uint16_t)(peer->backlog_end - peer->backlog_no);
+        uint8_t max = (left < SLE_CARGO_EVENT_BATCH_MAX) ? (uint8_t)left : SLE_CARGO_EVENT_BATCH_MAX;
+        uint8_t count = sle_event_history_collect(peer, peer->backlog_no, batch, max);
+        if (count == 0) {
+            peer->tx_stats.dropped++;
+            peer->event_backlog = false;
+            sle_cargo_tx_request_keyframe(&peer->cargo_tx);
+            printf("[sle_client] 63B#%u 积压事件已超出历史，改由关键帧补齐\r\n", sle_peer_no(peer));
+            break;
+        }
+        if (sle_send_events_locked(peer, batch, count) != ERRCODE_SUCC) {
+            break;
+        }
+        peer->backlog_no = (uint16_t)(peer->backlog_no + count);
+        peer->event_backlog = (peer->backlog_no != peer->backlog_end);
+    }
+}
+
+// 编码并提交一帧快照/增量帧，调用者持有发送锁
+static errcode_t sle_send_snapshot_locked(sle_client_peer_t *peer, const sle_cargo_snapshot_t *snap, uint8_t retries)
+{
+    // 窗口满时不编码，避免增量帧状态记录一个未发出的帧
+    if (peer->tx_count >= g_sle_tx_window) {
+        peer->tx_stats.busy++;
+        return SLE_CLIENT_ERRCODE_BUSY;
+    }
+
+    // 构建货物数据包: 二进制关键帧/增量帧，或旧版文本 "J:xxx,Z:xxx,S:xxx,T:timestamp"
+    uint8_t msg[SLE_CARGO_TEXT_MAX_LEN] = {0};
+    uint16_t msg_len = 0;
+    uint8_t kind = SLE_CARGO_FRAME_SNAPSHOT;
+    if (peer->wire == SLE_CARGO_WIRE_BINARY) {
+        msg_len = sle_cargo_tx_encode(&peer->cargo_tx, snap, msg, sizeof(msg));
+        if (msg_len == 0) {
+            // 计数没有变化且未到关键帧周期，本轮不占用空口
+            return ERRCODE_SUCC;
         }
+        kind = msg[2];
+    } else {
+        msg_len = sle_cargo_encode_text((char *)msg, sizeof(msg), snap);
+        if (msg_len == 0) {
+            printf("[sle_client] 编码货物数据失败\r\n");
+            return ERRCODE_FAIL;
+        }
+    }
+
+    errcode_t ret = sle_tx_submit_locked(peer, kind, SLE_CLIENT_WRITE_REQ, msg, msg_len, retries);
+    if (ret != ERRCODE_SUCC && peer->wire == SLE_CARGO_WIRE_BINARY) {
+        sle_cargo_tx_cancel(&peer->cargo_tx);
+    }
+    return ret;
+}
+
+// 发送货物数据到一个已就绪的对端
+static void sle_send_cargo_data_peer(sle_client_peer_t *peer, const sle_cargo_snapshot_t *snap)
+{
+    sle_tx_lock();
+    if (peer->state != SLE_CLIENT_PEER_READY) {
+        sle_tx_unlock();
+        return;
+    }
+    sle_flush_backlog_locked(peer);
+    uint8_t no = sle_peer_no(peer);
+    uint16_t seq = peer->cargo_tx.next_seq;
+    uint32_t issued = peer->tx_stats.req_issued;
+    errcode_t ret = sle_send_snapshot_locked(peer, snap, 0);
+    bool sent = (peer->tx_stats.req_issued != issued);
+    sle_bulk_pump_locked(peer);
+    uint8_t inflight = peer->tx_count;
+    bool binary = (peer->wire == SLE_CARGO_WIRE_BINARY);
+    sle_cargo_tx_t tx = peer->cargo_tx;
+    sle_tx_unlock();
+
+    if (ret == SLE_CLIENT_ERRCODE_BUSY) {
+        // 快照只反映当前计数，窗口满时不排队，下一周期的帧会带上最新值
+        printf("[sle_client] 63B#%u 发送窗口已满(%u/%u)，本轮快照顺延\r\n", no, inflight, g_sle_tx_window);
+    } else if (ret != ERRCODE_SUCC) {
+        printf("[sle_client] 63B#%u 发送失败，错误代码:0x%x\r\n", no, ret);
+    } else if (sent) {
+        printf("[sle_client] 63B#%u 发送请求已提交: seq=%u J=%u, Z=%u, S=%u, 在途=%u/%u\r\n",
+               no, seq, snap->jiangsu, snap->zhejiang, snap->shanghai, inflight, g_sle_tx_window);
+        if (binary) {
+            printf("[sle_client] 63B#%u 空口字节: %u/%u (关键帧=%u 增量帧=%u 跳过=%u)\r\n", no,
+                   tx.bytes_sent, tx.bytes_full, tx.key_frames, tx.delta_frames, tx.skipped);
+        }
+    }
+}
+
+// 发送货物数据到所有已就绪的服务器
+void sle_client_send_cargo_data(uint32_t jiangsu, uint32_t zhejiang, uint32_t shanghai)
+{
+    // 没有就绪的服务器或发件箱还在回放时存入发件箱，排在之前的事件之后
+    sle_cargo_snapshot_t snap = { jiangsu, zhejiang, shanghai, osKernelGetTickCount() };
+    sle_tx_lock();
+    sle_drain_outbox_locked(snap.tick);
+    bool queued = (sle_outbox_depth() > 0 || !sle_client_any_ready_locked());
+    if (queued) {
+        sle_outbox_put_snapshot(&snap, snap.tick);
+    }
+    uint16_t depth = sle_outbox_depth();
+    sle_tx_unlock();
+    if (queued) {
+        printf("[sle_client] 没有已完成服务发现的服务器，货物数据存入发件箱 (深度=%u/%u)\r\n", depth, SLE_OUTBOX_LEN);
+        return;
+    }
+
+    // 各对端各自编码，窗口满的对端只推迟自己
+    for (uint8_t i = 0; i < SLE_CLIENT_PEER_MAX; i++) {
+        sle_send_cargo_data_peer(&g_sle_peers[i], &snap);
+    }
+}
+
+// 提交一批分拣事件到所有已就绪的二进制服务器，调用者持有发送锁。返回目标数，targets 为0时事件未发出
+static uint8_t sle_send_events_all_locked(const sle_cargo_event_t *events, uint8_t count, uint8_t *sent_out)
+{
+    errcode_t result[SLE_CLIENT_PEER_MAX];
+    uint8_t targets = 0;
+    uint8_t sent = 0;
+    for (uint8_t i = 0; i < SLE_CLIENT_PEER_MAX; i++) {
+        sle_client_peer_t *peer = &g_sle_peers[i];
+        result[i] = ERRCODE_FAIL;
+        // 旧版服务器只认识文本快照，事件只能由定时快照带过去
+        if (peer->state != SLE_CLIENT_PEER_READY || peer->wire != SLE_CARGO_WIRE_BINARY) {
+            continue;
+        }
+        targets++;
+        // 先补发积压，保证对端按编号连续计入；仍有积压时新事件排在积压之后
+        sle_flush_backlog_locked(peer);
+        result[i] = peer->event_backlog ? SLE_CLIENT_ERRCODE_BUSY : sle_send_events_locked(peer, events, count);
+        if (result[i] == ERRCODE_SUCC) {
+            sent++;
+        }
+    }
+
+    // 至少一个对端收下了这批事件: 繁忙的对端记入积压，稍后补发，不拖慢其他对端
+    if (sent > 0) {
+        for (uint8_t i = 0; i < SLE_CLIENT_PEER_MAX; i++) {
+            sle_client_peer_t *peer = &g_sle_peers[i];
+            if (result[i] == SLE_CLIENT_ERRCODE_BUSY) {
+                if (!peer->event_backlog) {
+                    peer->event_backlog = true;
+                    peer->backlog_no = events[0].no;
+                }
+                peer->backlog_end = (uint16_t)(events[count - 1].no + 1);
+            } else if (result[i] != ERRCODE_SUCC) {
+                continue;
+            }
+            sle_event_history_add(peer, events, count);
+        }
+    }
+    *sent_out = sent;
+    return targets;
+}
+
+// 发件箱不为空且有已就绪的对端时按序回放，直到发送窗口或协议栈缓冲区已满，调用者持有发送锁。
+// 只有旧版文本服务器就绪时事件无法送达，直接丢弃，计数由快照带过去
+static void sle_drain_outbox_locked(uint32_t now)
+{
+    if (sle_outbox_depth() == 0) {
+        return;
+    }
+    if (!sle_client_any_ready_locked()) {
+        return;
+    }
+
+    sle_outbox_drain_begin(now);
+    while (sle_outbox_depth() > 0) {
+        sle_cargo_event_t batch[SLE_CARGO_EVENT_BATCH_MAX];
+        uint8_t count = sle_outbox_peek_events(batch, SLE_CARGO_EVENT_BATCH_MAX);
+        if (count > 0) {
+            uint8_t sent = 0;
+            uint8_t targets = sle_send_events_all_locked(batch, count, &sent);
+            if (targets > 0 && sent == 0) {
+                break;
+            }
+            sle_outbox_pop(count, targets > 0, now);
+            continue;
+        }
+
+        // 快照发给每个就绪的对端，全部繁忙时稍后再试；部分繁忙的对端由下一个快照补齐
+        sle_cargo_snapshot_t snap;
+        sle_outbox_peek_snapshot(&snap);
+        bool any = false;
+        for (uint8_t i = 0; i < SLE_CLIENT_PEER_MAX; i++) {
+            if (g_sle_peers[i].state == SLE_CLIENT_PEER_READY &&
+                sle_send_snapshot_locked(&g_sle_peers[i], &snap, 0) == ERRCODE_SUCC) {
+                any = true;
+            }
+        }
+        if (!any) {
+            break;
+        }
+        sle_outbox_pop(1, true, now);
+    }
+    for (uint8_t i = 0; i < SLE_CLIENT_PEER_MAX; i++) {
+        if (g_sle_peers[i].state == SLE_CLIENT_PEER_READY) {
+            sle_bulk_pump_locked(&g_sle_peers[i]);
+        }
+    }
+}
+
+// 发送一批分拣事件到所有已就绪的服务器；没有就绪的服务器或发件箱中还有未回放的内容时存入发件箱，保证顺序
+errcode_t sle_client_send_cargo_events(const sle_cargo_event_t *events, uint8_t count)
+{
+    if (events == NULL || count == 0 || count > SLE_CARGO_EVENT_BATCH_MAX) {
+        return ERRCODE_INVALID_PARAM;
+    }
+
+    uint8_t sent = 0;
+    uint8_t targets = 0;
+    bool queued = false;
+    sle_tx_lock();
+    uint32_t now = osKernelGetTickCount();
+    sle_drain_outbox_locked(now);
+    if (sle_outbox_depth() > 0 || !sle_client_any_ready_locked()) {
+        sle_outbox_put_events(events, count, now);
+        queued = true;
+    } else {
+        targets = sle_send_events_all_locked(events, count, &sent);
+        // 突发开始时立即请求分拣档位，不等客户端任务下一次检查
+        for (uint8_t i = 0; i < SLE_CLIENT_PEER_MAX; i++) {
+            if (g_sle_peers[i].state == SLE_CLIENT_PEER_READY) {
+                sle_cargo_conn_policy_events(&g_sle_peers[i].conn_policy, count, now);
+                sle_conn_policy_apply_locked(&g_sle_peers[i], now);
+            }
+        }
+    }
+    uint16_t depth = sle_outbox_depth();
+    sle_tx_unlock();
+
+    if (queued) {
+        printf("[sle_client] 分拣事件存入发件箱: no=%u..%u 深度=%u/%u\r\n", events[0].no, events[count - 1].no,
+               depth, SLE_OUTBOX_LEN);
+        return ERRCODE_SUCC;
+    }
+    if (targets == 0) {
+        return ERRCODE_FAIL;
+    }
+    if (sent == 0) {
+        return SLE_CLIENT_ERRCODE_BUSY;
+    }
+    printf("[sle_client] 分拣事件已提交: no=%u..%u count=%u 对端=%u/%u (%s)\r\n", events[0].no,
+           events[count - 1].no, count, sent, targets,
+           (SLE_CLIENT_EVENT_WRITE_MODE == SLE_CLIENT_WRITE_CMD) ? "cmd" : "req");
+    return ERRCODE_SUCC;
+}
+
+// 发送一条大消息到所有已就绪的二进制服务器
+errcode_t sle_client_send_bulk(uint8_t kind, const uint8_t *data, uint16_t len)
+{
+    if (data == NULL || len == 0 || len > SLE_CARGO_FRAG_MSG_MAX) {
+        return ERRCODE_INVALID_PARAM;
+    }
+
+    uint8_t targets = 0;
+    uint8_t started = 0;
+    sle_tx_lock();
+    uint32_t now = osKernelGetTickCount();
+    for (uint8_t i = 0; i < SLE_CLIENT_PEER_MAX; i++) {
+        sle_client_peer_t *peer = &g_sle_peers[i];
+        if (peer->state != SLE_CLIENT_PEER_READY || peer->wire != SLE_CARGO_WIRE_BINARY) {
+            continue;
+        }
+        targets++;
+        if (sle_cargo_frag_tx_start(&peer->bulk, kind, data, len, now)) {
+            started++;
+            peer->bulk_phy_epoch = peer->phy.epoch;
+            sle_bulk_pump_locked(peer);
+        }
+    }
+    sle_tx_unlock();
+
+    if (targets == 0) {
+        return ERRCODE_FAIL;
+    }
+    if (started == 0) {
+        return SLE_CLIENT_ERRCODE_BUSY;
+    }
+    printf("[sle_client] 大消息开始发送: kind=%u len=%u 对端=%u/%u\r\n", kind, len, started, targets);
+    // 客户端任务按需切换到高速PHY
+    sle_client_post(SLE_CLIENT_EVT_KICK, 0, 0);
+    return ERRCODE_SUCC;
+}
+
+// 请求所有已就绪的二进制服务器导出速率历史，结果以大消息异步返回
+errcode_t sle_client_request_history(uint8_t tier, uint16_t buckets)
+{
+    if (tier >= SLE_CARGO_HIST_TIERS) {
+        return ERRCODE_INVALID_PARAM;
+    }
+
+    sle_cargo_hist_req_t req = { tier, buckets };
+    uint8_t frame[SLE_CARGO_HIST_REQ_LEN];
+    uint8_t targets = 0;
+    uint8_t sent = 0;
+    sle_tx_lock();
+    for (uint8_t i = 0; i < SLE_CLIENT_PEER_MAX; i++) {
+        sle_client_peer_t *peer = &g_sle_peers[i];
+        if (peer->state != SLE_CLIENT_PEER_READY || peer->wire != SLE_CARGO_WIRE_BINARY) {
+            continue;
+        }
+        targets++;
+        // 写命令不占用发送窗口，也不进入写确认的重发逻辑；丢失时由使用者重新请求
+        uint16_t len = sle_cargo_encode_hist_req(frame, sizeof(frame), peer->hist_req_seq++, &req);
+        if (len > 0 && sle_tx_submit_locked(peer, SLE_CARGO_FRAME_HIST_REQ, SLE_CLIENT_WRITE_CMD, frame, len, 0) ==
+            ERRCODE_SUCC) {
+            sent++;
+        }
+    }
+    sle_tx_unlock();
+
+    if (targets == 0) {
+        return ERRCODE_FAIL;
+    }
+    if (sent == 0) {
+        return SLE_CLIENT_ERRCODE_BUSY;
+    }
+    printf("[sle_client] 请求速率历史: tier=%u buckets=%u 对端=%u/%u\r\n", tier, buckets, sent, targets);
+    return ERRCODE_SUCC;
+}
+
+// 开始一轮压测
+errcode_t sle_client_bench_start(uint16_t frame_len, uint16_t rate_hz, uint32_t duration_ms,
+                                 sle_client_write_mode_t mode)
+{
+    if (duration_ms == 0) {
+        return ERRCODE_INVALID_PARAM;
+    }
+
+    sle_tx_lock();
+    sle_client_peer_t *target = NULL;
+    for (uint8_t i = 0; i < SLE_CLIENT_PEER_MAX && target == NULL; i++) {
+        if (g_sle_peers[i].state == SLE_CLIENT_PEER_READY && g_sle_peers[i].wire == SLE_CARGO_WIRE_BINARY) {
+            target = &g_sle_peers[i];
+        }
+    }
+    if (target == NULL) {
+        sle_tx_unlock();
+        printf("[sle_client] 没有已就绪的二进制编码63B，无法压测\r\n");
+        return ERRCODE_FAIL;
+    }
+    // 在客户端任务中先按需切换PHY，切换完成后开始发送
+    g_sle_bench.active = false;
+    g_sle_bench_cfg.frame_len = frame_len;
+    g_sle_bench_cfg.rate_hz = rate_hz;
+    g_sle_bench_cfg.duration_ms = duration_ms;
+    g_sle_bench_armed = true;
+    g_sle_bench_arm_tick = osKernelGetTickCount();
+    g_sle_bench_conn = target->conn_id;
+    g_sle_bench_mode = mode;
+    uint8_t no = sle_peer_no(target);
+    uint8_t phy = g_sle_phy_on ? sle_cargo_phy_best(&target->phy) : SLE_CARGO_PHY_1M;
+    sle_tx_unlock();
+
+    printf("[sle_client] 63B#%u 压测已请求，PHY=%s\r\n", no, sle_cargo_phy_name(phy));
+    sle_client_post(SLE_CLIENT_EVT_KICK, 0, 0);
+    return ERRCODE_SUCC;
+}
+
+// 停止压测
+void sle_client_bench_stop(void)
+{
+    sle_tx_lock();
+    bool active = g_sle_bench.active || g_sle_bench_armed;
+    uint32_t sent = g_sle_bench.active ? g_sle_bench.seq : 0;
+    g_sle_bench.active = false;
+    g_sle_bench_armed = false;
+    sle_tx_unlock();
+    if (active) {
+        printf("[sle_client] 压测已停止 (已发 %u 帧)\r\n", sent);
+    }
+}
+
+// 获取63B最近一次回报的压测结果
+bool sle_client_get_bench_report(sle_cargo_bench_report_t *report)
+{
+    if (report == NULL) {
+        return false;
+    }
+    sle_tx_lock();
+    bool reported = g_sle_bench_reported;
+    *report = g_sle_bench_report;
+    sle_tx_unlock();
+    return reported;
+}
+
+// 添加要连接的服务器地址
+errcode_t sle_client_add_server(const uint8_t *addr)
+{
+    if (addr == NULL) {
+        return ERRCODE_INVALID_PARAM;
+    }
+    sle_tx_lock();
+    errcode_t ret = ERRCODE_SUCC;
+    uint32_t now = osKernelGetTickCount();
+    sle_client_server_t *server = sle_server_learn_locked(addr, now);
+    if (server != NULL) {
+        server->pinned = true;
+    } else {
+        ret = ERRCODE_FAIL;
+    }
+    sle_tx_unlock();
+    if (ret == ERRCODE_SUCC) {
+        sle_client_post(SLE_CLIENT_EVT_KICK, 0, 0);
+    }
+    return ret;
+}
+
+// 设置写请求窗口
+void sle_client_set_tx_window(uint8_t window)
+{
+    if (window == 0 || window > SLE_CLIENT_TX_WINDOW_MAX) {
+        printf("[sle_client] 无效的发送窗口: %u (1~%u)\r\n", window, SLE_CLIENT_TX_WINDOW_MAX);
+        return;
+    }
+    sle_tx_lock();
+    g_sle_tx_window = window;
+    sle_tx_unlock();
+}
+
+// 获取对端信息
+bool sle_client_get_peer_info(uint8_t peer, sle_client_peer_info_t *info)
+{
+    if (peer >= SLE_CLIENT_PEER_MAX || info == NULL) {
+        return false;
+    }
+    sle_tx_lock();
+    const sle_client_peer_t *p = &g_sle_peers[peer];
+    memcpy_s(info->addr, SLE_ADDR_LEN, p->addr.addr, SLE_ADDR_LEN);
+    info->conn_id = p->conn_id;
+    info->state = p->state;
+    info->wire = p->wire;
+    info->cached_handles = (p->handles != SLE_PEER_HANDLES_DISCOVERED);
+    info->connect_to_write_us = p->first_write_done ? p->connect_to_write_us : 0;
+    memcpy_s(info->state_tick, sizeof(info->state_tick), p->state_tick, sizeof(p->state_tick));
+    info->reconnect_ms = (p->state == SLE_CLIENT_PEER_READY) ? p->reconnect_ms : 0;
+    sle_tx_unlock();
+    return info->state != SLE_CLIENT_PEER_IDLE;
+}
+
+// 启用或关闭扫描地址表
+void sle_client_set_seen_cache(bool enable)
+{
+    sle_tx_lock();
+    g_sle_seen_cache_on = enable;
+    sle_tx_unlock();
+    printf("[sle_client] seen cache %s (next scan)\r\n", enable ? "on" : "off");
+}
+
+// 获取扫描统计
+void sle_client_get_scan_stats(sle_client_scan_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    sle_tx_lock();
+    *stats = g_sle_scan_stats;
+    stats->seen_cache = g_sle_seen_cache_on;
+    sle_tx_unlock();
+}
+
+// 获取快速重连统计
+void sle_client_get_reconnect_stats(sle_client_reconnect_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    sle_tx_lock();
+    *stats = g_sle_reconnect_stats;
+    sle_tx_unlock();
+}
+
+// 获取发件箱统计
+void sle_client_get_outbox_stats(sle_outbox_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    sle_tx_lock();
+    sle_outbox_get_stats(stats, osKernelGetTickCount());
+    sle_tx_unlock();
+}
+
+// 获取链路遥测
+void sle_client_get_telemetry(sle_cargo_telem_t *telem)
+{
+    if (telem == NULL) {
+        return;
+    }
+    sle_tx_lock();
+    *telem = g_sle_telem;
+    sle_tx_unlock();
+}
+
+// 获取发送统计
+bool sle_client_get_tx_stats(uint8_t peer, sle_client_tx_stats_t *stats)
+{
+    if (peer >= SLE_CLIENT_PEER_MAX || stats == NULL) {
+        return false;
+    }
+    sle_tx_lock();
+    const sle_client_peer_t *p = &g_sle_peers[peer];
+    *stats = p->tx_stats;
+    stats->inflight = p->tx_count;
+    stats->window = g_sle_tx_window;
+    stats->backlog = p->event_backlog ? (uint16_t)(p->backlog_end - p->backlog_no) : 0;
+    uint32_t done = p->tx_stats.confirmed + p->tx_stats.failed;
+    stats->lat_avg_us = (done > 0) ? (uint32_t)(p->tx_latency_sum_us / done) : 0;
+    bool used = (p->state != SLE_CLIENT_PEER_IDLE);
+    sle_tx_unlock();
+    return used;
+}
+
+// 获取63B确认帧统计
+bool sle_client_get_ack_stats(uint8_t peer, sle_client_ack_stats_t *stats)
+{
+    if (peer >= SLE_CLIENT_PEER_MAX || stats == NULL) {
+        return false;
+    }
+    sle_tx_lock();
+    const sle_client_peer_t *p = &g_sle_peers[peer];
+    *stats = p->ack_stats;
+    stats->rtt_avg_ms = (p->rtt_samples > 0) ? (uint32_t)(p->rtt_sum_ms / p->rtt_samples) : 0;
+    bool used = (p->state != SLE_CLIENT_PEER_IDLE);
+    sle_tx_unlock();
+    return used;
+}
+
+// 获取大消息收发统计
+bool sle_client_get_bulk_stats(uint8_t peer, sle_client_bulk_stats_t *stats)
+{
+    if (peer >= SLE_CLIENT_PEER_MAX || stats == NULL) {
+        return false;
     }
+    sle_tx_lock();
+    const sle_client_peer_t *p = &g_sle_peers[peer];
+    const sle_cargo_frag_tx_t *tx = &p->bulk;
+    const sle_cargo_frag_rx_t *rx = &g_sle_frag_rx;
+    stats->messages = tx->messages;
+    stats->bytes = tx->bytes;
+    stats->fragments = tx->fragments;
+    stats->restarts = tx->restarts;
+    stats->failed = tx->failed;
+    stats->last_ms = tx->last_ms;
+    stats->pending = tx->active ? (uint16_t)(tx->len - tx->offset) : 0;
+    stats->rx_messages = p->bulk_rx_messages;
+    stats->rx_dropped = rx->gaps + rx->timeouts + rx->abandoned + rx->no_slot + rx->too_long;
+    bool used = (p->state != SLE_CLIENT_PEER_IDLE);
+    sle_tx_unlock();
+    return used;
 }
 
-// 开始扫描
-static void sle_start_scan(void)
+// 获取连接参数策略
+bool sle_client_get_conn_policy(uint8_t peer, sle_cargo_conn_policy_t *policy)
 {
-    sle_seek_param_t param = {0};
-    param.own_addr_type = 0;
-    param.filter_duplicates = 0; // 不过滤重复设备，确保能扫描到目标
-    param.seek_filter_policy = 0;
-    param.seek_phys = 1;
-    param.seek_type[0] = 0; // 被动扫描
-    param.seek_interval[0] = SLE_SEEK_INTERVAL_DEFAULT;
-    param.seek_window[0] = SLE_SEEK_WINDOW_DEFAULT;
-    
-    errcode_t ret = sle_set_seek_param(&param);
-    if (ret != ERRCODE_SUCC) {
-        printf("[sle_client] set seek param failed:0x%x\r\n", ret);
-        return;
+    if (peer >= SLE_CLIENT_PEER_MAX || policy == NULL) {
+        return false;
     }
-    
-    ret = sle_start_seek();
-    if (ret != ERRCODE_SUCC) {
-        printf("[sle_client] start seek failed:0x%x\r\n", ret);
-        return;
+    sle_tx_lock();
+    const sle_client_peer_t *p = &g_sle_peers[peer];
+    *policy = p->conn_policy;
+    bool used = (p->state != SLE_CLIENT_PEER_IDLE);
+    sle_tx_unlock();
+    return used;
+}
+
+// 获取PHY协商状态
+bool sle_client_get_phy(uint8_t peer, sle_cargo_phy_link_t *phy)
+{
+    if (peer >= SLE_CLIENT_PEER_MAX || phy == NULL) {
+        return false;
     }
-    
-    printf("[sle_client] start scan success, searching for CARGO_SERVER_63B...\r\n");
+    sle_tx_lock();
+    const sle_client_peer_t *p = &g_sle_peers[peer];
+    *phy = p->phy;
+    bool used = (p->state != SLE_CLIENT_PEER_IDLE);
+    sle_tx_unlock();
+    return used;
 }
 
-// 发送货物数据到服务器
-void sle_client_send_cargo_data(uint32_t jiangsu, uint32_t zhejiang, uint32_t shanghai)
+// 允许或禁止切换到高速PHY
+void sle_client_set_phy_policy(bool enable)
 {
-    if (g_sle_client_conn_state != SLE_ACB_STATE_CONNECTED) {
-        printf("[sle_client] not connected, cannot send cargo data\r\n");
-        return;
+    sle_tx_lock();
+    g_sle_phy_on = enable;
+    for (uint8_t i = 0; i < SLE_CLIENT_PEER_MAX; i++) {
+        sle_cargo_phy_enable(&g_sle_peers[i].phy, enable);
     }
+    sle_tx_unlock();
+    printf("[sle_client] 高速PHY%s\r\n", enable ? "已允许" : "已禁止，批量传输使用1M");
+    sle_client_post(SLE_CLIENT_EVT_KICK, 0, 0);
+}
 
-    // 检查写句柄是否已设置
-    if (g_sle_client_write_id == 0) {
-        printf("[sle_client] 错误：写句柄未设置，服务发现可能未完成\r\n");
-        return;
+// 设置空闲时长
+void sle_client_set_conn_idle_ms(uint32_t idle_ms)
+{
+    sle_tx_lock();
+    g_sle_conn_idle_ms = idle_ms;
+    for (uint8_t i = 0; i < SLE_CLIENT_PEER_MAX; i++) {
+        g_sle_peers[i].conn_policy.idle_ms = idle_ms;
     }
+    sle_tx_unlock();
+    // 唤醒客户端任务按新的空闲时长重新计算等待
+    sle_client_post(SLE_CLIENT_EVT_KICK, 0, 0);
+}
+
+// 处理63B的确认帧: 统计往返时延，对端缺事件时只重发缺失的事件，缺基准时补发关键帧。调用者持有发送锁
+static void sle_client_handle_ack(sle_client_peer_t *peer, const sle_cargo_ack_t *ack)
+{
+    uint32_t now = osKernelGetTickCount();
+    uint8_t resent = 0;
+    bool key_resent = false;
 
-    // 构建货物数据包格式: "J:xxx,Z:xxx,S:xxx,T:timestamp"
-    char msg[128] = {0};
-    uint64_t timestamp = (uint64_t)osKernelGetTickCount();
-    snprintf(msg, sizeof(msg), "J:%u,Z:%u,S:%u,T:%llu", 
-             jiangsu, zhejiang, shanghai, timestamp);
+    peer->ack_stats.acks++;
+    peer->ack_stats.last_seq = ack->last_seq;
+    peer->ack_stats.total = ack->total;
+    peer->ack_stats.flags = ack->flags;
+    peer->ack_stats.display_lag_ms = ack->display_lag_ms;
+    peer->ack_stats.last_ack_tick = now;
+    if (ack->flags & SLE_CARGO_ACK_RTT_VALID) {
+        uint32_t rtt = now - ack->echo_tick;
+        peer->ack_stats.rtt_last_ms = rtt;
+        if (peer->rtt_samples == 0 || rtt < peer->ack_stats.rtt_min_ms) {
+            peer->ack_stats.rtt_min_ms = rtt;
+        }
+        if (rtt > peer->ack_stats.rtt_max_ms) {
+            peer->ack_stats.rtt_max_ms = rtt;
+        }
+        peer->rtt_sum_ms += rtt;
+        peer->rtt_samples++;
+    }
 
-    // 添加详细调试信息
-    printf("[sle_client] 准备发送数据：\r\n");
-    printf("  连接ID: 0x%04x\r\n", g_sle_client_conn_id);
-    printf("  写句柄: 0x%04x\r\n", g_sle_client_write_id);
-    printf("  数据长度: %d\r\n", (int)strlen(msg));
-    printf("  数据内容: %s\r\n", msg);
+    // 同一缺口在修复前每次写入都会回报，至少间隔两个往返时延再重发
+    uint32_t guard = (peer->rtt_samples > 0) ? (uint32_t)(2 * peer->rtt_sum_ms / peer->rtt_samples) : 0;
+    if (guard < SLE_CLIENT_RESEND_GUARD_MS) {
+        guard = SLE_CLIENT_RESEND_GUARD_MS;
+    }
+    bool need_resend = (ack->flags & (SLE_CARGO_ACK_EVENT_GAP | SLE_CARGO_ACK_NEED_KEYFRAME)) != 0;
+    bool guarded = peer->resend_armed && peer->resend_total == ack->total && (now - peer->resend_tick) < guard;
+    if (need_resend && !guarded) {
+        peer->resend_armed = true;
+        peer->resend_total = ack->total;
+        peer->resend_tick = now;
 
-    // 使用全局发送参数，句柄由特征发现回调设置
-    g_sle_send_param.handle = g_sle_client_write_id;
-    g_sle_send_param.type = SSAP_PROPERTY_TYPE_VALUE;
-    g_sle_send_param.data_len = (uint16_t)strlen(msg);
-    g_sle_send_param.data = (uint8_t *)msg; // 注意：API会拷贝数据
+        sle_cargo_event_t batch[SLE_CARGO_EVENT_BATCH_MAX];
+        uint8_t count = 0;
+        if ((ack->flags & SLE_CARGO_ACK_NEED_KEYFRAME) == 0) {
+            count = sle_event_history_collect(peer, (uint16_t)(ack->total + 1), batch, SLE_CARGO_EVENT_BATCH_MAX);
+        }
+        if (count > 0 && sle_send_events_locked(peer, batch, count) == ERRCODE_SUCC) {
+            peer->ack_stats.event_resends += count;
+            resent = count;
+        } else {
+            // 缺失的事件已不在历史中或对端没有基准: 以当前计数补发关键帧
+            sle_cargo_snapshot_t snap = {0};
+            get_current_cargo_counts(&snap.jiangsu, &snap.zhejiang, &snap.shanghai);
+            snap.tick = now;
+            sle_cargo_tx_request_keyframe(&peer->cargo_tx);
+            if (sle_send_snapshot_locked(peer, &snap, 0) == ERRCODE_SUCC) {
+                peer->ack_stats.key_resends++;
+                key_resent = true;
+            }
+        }
+    }
 
-    errcode_t ret = ssapc_write_req(0, g_sle_client_conn_id, &g_sle_send_param);
-    if (ret != ERRCODE_SUCC) {
-        printf("[sle_client] 发送失败，错误代码:0x%x\r\n", ret);
-    } else {
-        printf("[sle_client] 发送请求已提交: %s\r\n", msg);
+#if SLE_CLIENT_RX_LOG
+    printf("[sle_client] 63B#%u ack: seq=%u total=%u flags=0x%02x display=%s lag=%ums rtt=%ums\r\n",
+           sle_peer_no(peer), ack->last_seq, ack->total, ack->flags,
+           (ack->flags & SLE_CARGO_ACK_DISPLAY_CURRENT) ? "current" : "pending",
+           ack->display_lag_ms, peer->ack_stats.rtt_last_ms);
+#endif
+    if (resent > 0) {
+        printf("[sle_client] 63B#%u 重发事件 no=%u 起 %u 条\r\n", sle_peer_no(peer), (uint16_t)(ack->total + 1), resent);
+    } else if (key_resent) {
+        printf("[sle_client] 63B#%u 对端缺少基准，已补发关键帧\r\n", sle_peer_no(peer));
     }
 }
 
-// 服务发现完成回调
+// 服务查找回调: 查找已按UUID过滤，仍按完整UUID确认一次，兼容不支持过滤的协议栈
 static void sle_ssapc_find_structure_cbk(uint8_t client_id, uint16_t conn_id,
                                           ssapc_find_service_result_t *service, errcode_t status)
 {
-    printf("[sle_client] find structure cbk: status=%d\r\n", status);
-    
+    unused(client_id);
+
     if (status != ERRCODE_SUCC || service == NULL) {
-        printf("[sle_client] service discovery failed\r\n");
+        printf("[sle_client] service discovery failed: conn_id=0x%04x status=%d\r\n", conn_id, status);
         return;
     }
-    
-    printf("[sle_client] found service: start_hdl=0x%04x, end_hdl=0x%04x, uuid_len=%d\r\n",
-           service->start_hdl, service->end_hdl, service->uuid.len);
-    
-    // 检查是否是我们期望的服务UUID  
-    printf("[sle_client] 检查服务UUID，长度=%d\r\n", service->uuid.len);
-    
-    // 支持16字节完整UUID和2字节短UUID
-    uint16_t service_uuid = 0;
-    bool uuid_match = false;
-    
-    if (service->uuid.len == 2) {
-        // 2字节短UUID
-        service_uuid = (service->uuid.uuid[15] << 8) | service->uuid.uuid[14];
-        printf("[sle_client] 短UUID: 0x%04x\r\n", service_uuid);
-        uuid_match = (service_uuid == SLE_UUID_SERVER_SERVICE);
-    } else if (service->uuid.len == 16) {
-        // 16字节完整UUID，检查最后2字节
-        service_uuid = (service->uuid.uuid[15] << 8) | service->uuid.uuid[14];
-        printf("[sle_client] 完整UUID最后2字节: 0x%04x\r\n", service_uuid);
-        uuid_match = (service_uuid == SLE_UUID_SERVER_SERVICE);
-    } else {
-        printf("[sle_client] UUID长度不支持: %d\r\n", service->uuid.len);
+    if (!sle_uuid_equal(&service->uuid, &g_sle_service_uuid)) {
+        printf("[sle_client] 跳过非货物服务 0x%04x..0x%04x\r\n", service->start_hdl, service->end_hdl);
+        return;
     }
-    
-    if (uuid_match) {
-        printf("[sle_client] ✅ 找到货物服务，开始发现特征...\r\n");
-        g_sle_client_server_id = service->start_hdl;
-        
-        // 发现特征
-        ssapc_find_structure_param_t find_param = {0};
-        find_param.type = SSAP_FIND_TYPE_PROPERTY;
-        find_param.start_hdl = service->start_hdl;
-        find_param.end_hdl = service->end_hdl;
-        
-        printf("[sle_client] 发起特征发现: start_hdl=0x%04x, end_hdl=0x%04x\r\n", 
-               find_param.start_hdl, find_param.end_hdl);
-        
-        errcode_t ret = ssapc_find_structure(client_id, conn_id, &find_param);
-        if (ret != ERRCODE_SUCC) {
-            printf("[sle_client] ❌ 特征发现请求失败:0x%x\r\n", ret);
-        } else {
-            printf("[sle_client] ✅ 特征发现请求已发送\r\n");
+
+    sle_tx_lock();
+    sle_client_peer_t *peer = sle_peer_find(conn_id);
+    if (peer != NULL && peer->state == SLE_CLIENT_PEER_DISCOVERING && !peer->service_found) {
+        peer->service_found = true;
+        peer->service_start = service->start_hdl;
+        peer->service_end = service->end_hdl;
+        printf("[sle_client] 63B#%u 找到货物服务 0x%04x..0x%04x，查找货物特征\r\n", sle_peer_no(peer),
+               service->start_hdl, service->end_hdl);
+        if (sle_peer_find_uuid_locked(peer, SSAP_FIND_TYPE_PROPERTY, service->start_hdl, service->end_hdl,
+                                      &g_sle_property_uuid) != ERRCODE_SUCC) {
+            sle_peer_abort_locked(peer, "特征查找请求失败");
         }
-    } else {
-        printf("[sle_client] 不是目标服务 (UUID=0x%04x, 期望=0x%04x)\r\n", 
-               service_uuid, SLE_UUID_SERVER_SERVICE);
     }
+    sle_tx_unlock();
 }
 
 // 设置连接参数 - 参考官方教程
@@ -379,12 +2001,12 @@ static errcode_t sle_client_connect_param_init(void)
     sle_default_connect_param_t param = {0};
     param.enable_filter_policy = 0;
     param.gt_negotiate = 0;
-    param.initiate_phys = 1;
-    param.max_interval = SLE_CONN_INTV_MAX_DEFAULT;  // 按官方demo标准
-    param.min_interval = SLE_CONN_INTV_MIN_DEFAULT;  // 按官方demo标准
+    param.initiate_phys = 1;      // 以1M建立连接，批量传输时再按双方能力切换PHY
+    param.max_interval = SLE_CARGO_CONN_DEFAULT_INTERVAL;  // 与63B广播参数一致，之后由连接参数策略调整
+    param.min_interval = SLE_CARGO_CONN_DEFAULT_INTERVAL;
     param.scan_interval = 400;     // 扫描间隔
     param.scan_window = 20;        // 扫描窗口
-    param.timeout = 0x1F4;         // 超时时间
+    param.timeout = SLE_CARGO_CONN_TIMEOUT; // 超时时间
     
     errcode_t ret = sle_default_connection_param_set(&param);
     if (ret != ERRCODE_SUCC) {
@@ -412,12 +2034,88 @@ static errcode_t sle_client_seek_cbk_register(void)
     return ERRCODE_SUCC;
 }
 
+// RSSI读取结果
+static void sle_read_rssi_cbk(uint16_t conn_id, int8_t rssi, errcode_t status)
+{
+    if (status != ERRCODE_SUCC) {
+        return;
+    }
+    sle_tx_lock();
+    if (sle_peer_find(conn_id) != NULL) {
+        sle_cargo_telem_rssi(&g_sle_telem, rssi);
+    }
+    sle_tx_unlock();
+}
+
+// 连接参数更新结果，本端请求的和对端发起的都在这里归类到档位
+static void sle_connect_param_update_cbk(uint16_t conn_id, errcode_t status,
+                                         const sle_connection_param_update_evt_t *param)
+{
+    sle_tx_lock();
+    sle_client_peer_t *peer = sle_peer_find(conn_id);
+    if (peer == NULL) {
+        sle_tx_unlock();
+        return;
+    }
+    uint8_t no = sle_peer_no(peer);
+    uint32_t now = osKernelGetTickCount();
+    bool ok = (status == ERRCODE_SUCC && param != NULL);
+    uint8_t before = peer->conn_policy.current;
+    bool changed = sle_cargo_conn_policy_updated(&peer->conn_policy, ok, ok ? param->interval : 0,
+                                                 ok ? param->latency : 0, now);
+    sle_cargo_conn_policy_t policy = peer->conn_policy;
+    sle_tx_unlock();
+
+    if (!ok) {
+        printf("[sle_client] 63B#%u 连接参数更新失败:0x%x\r\n", no, status);
+        return;
+    }
+    printf("[sle_client] 63B#%u 连接参数: interval=%uus latency=%u timeout=%ums -> %s (请求到生效 %ums)\r\n", no,
+           param->interval * 125, param->latency, param->supervision * 10,
+           sle_cargo_conn_profile_name(policy.current), policy.apply_last_ms);
+    // 一轮分拣结束回到空闲档位时打印各档位写时延的对比
+    if (changed && before == SLE_CARGO_CONN_ACTIVE) {
+        static char line[320];
+        sle_cargo_conn_policy_format(&policy, line, sizeof(line));
+        printf("[sle_client] 63B#%u 分拣突发结束，写时延: %s\r\n", no, line);
+    }
+}
+
+// PHY切换结果，本端请求的和对端发起的都在这里记录；失败时下次检查按次快的PHY重新请求
+static void sle_set_phy_cbk(uint16_t conn_id, errcode_t status, const sle_set_phy_t *param)
+{
+    sle_tx_lock();
+    sle_client_peer_t *peer = sle_peer_find(conn_id);
+    if (peer == NULL) {
+        sle_tx_unlock();
+        return;
+    }
+    uint8_t no = sle_peer_no(peer);
+    bool ok = (status == ERRCODE_SUCC && param != NULL);
+    sle_cargo_phy_updated(&peer->phy, ok, ok ? param->tx_phy : 0, osKernelGetTickCount());
+    sle_cargo_phy_link_t phy = peer->phy;
+    sle_tx_unlock();
+
+    if (!ok) {
+        printf("[sle_client] 63B#%u PHY切换失败:0x%x，保持 %s，可用 %s\r\n", no, status,
+               sle_cargo_phy_name(phy.current), sle_cargo_phy_name(sle_cargo_phy_best(&phy)));
+    } else {
+        printf("[sle_client] 63B#%u PHY: tx=%s rx=%s (请求到生效 %ums)\r\n", no, sle_cargo_phy_name(param->tx_phy),
+               sle_cargo_phy_name(param->rx_phy), phy.apply_last_ms);
+    }
+    // 等待切换的压测或回退后的重新请求在客户端任务中继续
+    sle_client_post(SLE_CLIENT_EVT_KICK, 0, 0);
+}
+
 // 注册连接回调
 static errcode_t sle_client_connect_cbk_register(void)
 {
     sle_connection_callbacks_t conn_cbks = {0};
     conn_cbks.connect_state_changed_cb = sle_connect_state_changed_cbk;
     conn_cbks.pair_complete_cb = sle_pair_complete_cbk;
+    conn_cbks.read_rssi_cb = sle_read_rssi_cbk;
+    conn_cbks.connect_param_update_cb = sle_connect_param_update_cbk;
+    conn_cbks.set_phy_cb = sle_set_phy_cbk;
     
     errcode_t ret = sle_connection_register_callbacks(&conn_cbks);
     if (ret != ERRCODE_SUCC) {
@@ -436,6 +2134,7 @@ static errcode_t sle_client_ssapc_cbk_register(void)
     ssapc_cbks.exchange_info_cb = sle_client_exchange_info_cbk;
     ssapc_cbks.find_structure_cb = sle_ssapc_find_structure_cbk;
     ssapc_cbks.ssapc_find_property_cbk = sle_client_find_property_cbk;
+    ssapc_cbks.find_structure_cmp_cb = sle_client_find_structure_cmp_cbk;
     ssapc_cbks.write_cfm_cb = sle_client_write_cfm_cbk;
     ssapc_cbks.notification_cb = sle_ssapc_data_received_cbk;
     ssapc_cbks.indication_cb = sle_ssapc_data_received_cbk;
@@ -473,7 +2172,37 @@ static errcode_t sle_client_set_local_addr(void)
 errcode_t sle_client_init(void)
 {
     printf("[sle_client] init start\r\n");
+
+    // 发送锁，写确认回调中会重发失败的帧
+    osMutexAttr_t mutex_attr = {0};
+    mutex_attr.name = "sle_tx";
+    mutex_attr.attr_bits = osMutexRecursive | osMutexPrioInherit;
+    g_sle_tx_mutex = osMutexNew(&mutex_attr);
+    if (g_sle_tx_mutex == NULL) {
+        printf("[sle_client] create tx mutex fail\r\n");
+        return ERRCODE_FAIL;
+    }
     
+    // 连接状态机事件队列，协议栈回调向客户端任务投递
+    g_sle_evt_queue = osMessageQueueNew(SLE_CLIENT_EVT_QUEUE_LEN, sizeof(sle_client_evt_t), NULL);
+    if (g_sle_evt_queue == NULL) {
+        printf("[sle_client] create event queue fail\r\n");
+        return ERRCODE_FAIL;
+    }
+    g_sle_rand_state = (uint32_t)uapi_systick_get_us();
+
+    // 读取NV中缓存的服务器句柄布局，重连时跳过配对和服务发现
+    sle_peer_cache_load();
+    sle_cargo_frag_rx_reset(&g_sle_frag_rx);
+    // 发件箱，启用NV时恢复复位前未送达的内容，分拣计数从保存时继续，63B看到的计数不会倒退；
+    // 此时串口任务尚未创建，可以直接写入计数
+    sle_cargo_snapshot_t counts;
+    if (sle_outbox_init(osKernelGetTickCount(), &counts)) {
+        set_current_cargo_counts(counts.jiangsu, counts.zhejiang, counts.shanghai);
+    }
+    sle_cargo_telem_init(&g_sle_telem, osKernelGetTickCount());
+    sle_cargo_telem_set_link(&g_sle_telem, SLE_CARGO_LINK_SEARCHING, osKernelGetTickCount());
+
     // 1. 注册扫描回调
     errcode_t ret = sle_client_seek_cbk_register();
     if (ret != ERRCODE_SUCC) {
@@ -516,24 +2245,330 @@ errcode_t sle_client_init(void)
     return ERRCODE_SUCC;
 }
 
-// 星闪客户端任务
+// 状态机周期检查: 处理各阶段超时、候选窗口和扫描超时，有空闲表项且退避结束时开始扫描。返回距下一个截止时刻的等待时长
+static uint32_t sle_client_sm_poll(void)
+{
+    uint32_t wait = SLE_TASK_DELAY_MS;
+    bool scan = false;
+    bool pick = false;
+
+    sle_tx_lock();
+    uint32_t now = osKernelGetTickCount();
+    for (uint8_t i = 0; i < SLE_CLIENT_PEER_MAX; i++) {
+        sle_client_peer_t *peer = &g_sle_peers[i];
+        if (peer->state == SLE_CLIENT_PEER_IDLE || !peer->deadline_armed) {
+            continue;
+        }
+        int32_t left = (int32_t)(peer->deadline - now);
+        if (left <= 0) {
+            g_sle_reconnect_stats.state_timeouts++;
+            sle_peer_abort_locked(peer, "阶段超时");
+        } else if ((uint32_t)left < wait) {
+            wait = (uint32_t)left;
+        }
+    }
+
+    if (g_sle_window_open) {
+        int32_t left = (int32_t)(g_sle_window_end - now);
+        if (left <= 0) {
+            pick = true;
+        } else if ((uint32_t)left < wait) {
+            wait = (uint32_t)left;
+        }
+    } else if (g_sle_scanning) {
+        int32_t left = (int32_t)(g_sle_scan_tick + SLE_CLIENT_SCAN_TIMEOUT_MS - now);
+        if (left <= 0) {
+            // 本轮没有找到可连接的服务器: 停止扫描，仍未连接的服务器和寻找新服务器各记一次失败
+            printf("[sle_client] scan timeout, backing off\r\n");
+            sle_stop_seek();
+            g_sle_scanning = false;
+            g_sle_reconnect_stats.scan_timeouts++;
+            for (uint8_t i = 0; i < g_sle_server_count; i++) {
+                if (sle_peer_find_addr(g_sle_servers[i].addr) == NULL) {
+                    sle_server_schedule_locked(&g_sle_servers[i], true, now);
+                }
+            }
+            sle_server_schedule_locked(&g_sle_discover, true, now);
+        } else if ((uint32_t)left < wait) {
+            wait = (uint32_t)left;
+        }
+    }
+
+    // 扫描中被跳过的服务器退避结束: 控制器已过滤掉它之后的广播，重启扫描让它重新上报
+    bool restart = false;
+    bool slots = sle_peer_count() < SLE_CLIENT_PEER_MAX;
+    if (!g_sle_connecting && !pick && slots) {
+        if (!g_sle_scanning) {
+            int32_t left = (int32_t)(g_sle_discover.retry_tick - now);
+            if (left <= 0) {
+                scan = true;
+            } else if ((uint32_t)left < wait) {
+                wait = (uint32_t)left;
+            }
+        }
+        for (uint8_t i = 0; i < g_sle_server_count; i++) {
+            if (sle_peer_find_addr(g_sle_servers[i].addr) != NULL ||
+                (g_sle_scanning && !g_sle_servers[i].deferred)) {
+                continue;
+            }
+            int32_t left = (int32_t)(g_sle_servers[i].retry_tick - now);
+            if (left <= 0) {
+                scan = true;
+                restart = g_sle_scanning;
+            } else if ((uint32_t)left < wait) {
+                wait = (uint32_t)left;
+            }
+        }
+    }
+    uint8_t peers = sle_peer_count();
+    if (scan && restart) {
+        sle_stop_seek();
+        g_sle_scanning = false;
+    }
+    sle_tx_unlock();
+
+    if (pick) {
+        sle_client_connect_best();
+        return 0;
+    }
+    if (scan) {
+        printf("[sle_client] %u/%u peers connected, scanning\r\n", peers, SLE_CLIENT_PEER_MAX);
+        sle_start_scan();
+    }
+    return wait;
+}
+
+// 处理回调投递的事件
+static void sle_client_sm_event(const sle_client_evt_t *evt)
+{
+    if (evt->type != SLE_CLIENT_EVT_READY || evt->peer >= SLE_CLIENT_PEER_MAX) {
+        return;
+    }
+
+    // 立即向新就绪的服务器发送一次当前货物数据，确保63B能看到初始状态
+    sle_client_peer_t *peer = &g_sle_peers[evt->peer];
+    sle_tx_lock();
+    bool ready = (peer->state == SLE_CLIENT_PEER_READY && peer->conn_id == evt->conn_id);
+    // 发件箱中有断开期间的内容时先按序回放，队尾的快照就是最新计数，不再单独发送初始数据
+    uint16_t depth = ready ? sle_outbox_depth() : 0;
+    if (depth > 0) {
+        sle_drain_outbox_locked(osKernelGetTickCount());
+    }
+    sle_tx_unlock();
+    if (!ready) {
+        return;
+    }
+    if (depth > 0) {
+        printf("[sle_client] 63B#%u 就绪，开始回放发件箱 %u 条\r\n", evt->peer + 1, depth);
+        return;
+    }
+    sle_cargo_snapshot_t snap = {0};
+    get_current_cargo_counts(&snap.jiangsu, &snap.zhejiang, &snap.shanghai);
+    snap.tick = osKernelGetTickCount();
+    sle_send_cargo_data_peer(peer, &snap);
+    printf("[sle_client] 63B#%u 发送初始货物数据: J=%u, Z=%u, S=%u\r\n", evt->peer + 1, snap.jiangsu, snap.zhejiang,
+           snap.shanghai);
+
+    if (g_sle_bench_auto &&
+        sle_client_bench_start(SLE_CLIENT_BENCH_LEN, SLE_CLIENT_BENCH_RATE, SLE_CLIENT_BENCH_DURATION_MS,
+                               SLE_CLIENT_BENCH_MODE) == ERRCODE_SUCC) {
+        g_sle_bench_auto = false;
+    }
+}
+
+// 定期读取已就绪连接的RSSI，结果在 sle_read_rssi_cbk 中计入遥测；返回到下次读取的等待时长与wait中较小者
+static uint32_t sle_client_rssi_poll(uint32_t wait)
+{
+    if (SLE_CLIENT_RSSI_INTERVAL_MS == 0) {
+        return wait;
+    }
+    uint16_t conn_ids[SLE_CLIENT_PEER_MAX];
+    uint8_t count = 0;
+    uint32_t now = osKernelGetTickCount();
+    sle_tx_lock();
+    int32_t left = (int32_t)(g_sle_rssi_tick - now);
+    if (left <= 0) {
+        g_sle_rssi_tick = now + SLE_CLIENT_RSSI_INTERVAL_MS;
+        left = SLE_CLIENT_RSSI_INTERVAL_MS;
+        for (uint8_t i = 0; i < SLE_CLIENT_PEER_MAX; i++) {
+            if (g_sle_peers[i].state == SLE_CLIENT_PEER_READY) {
+                conn_ids[count++] = g_sle_peers[i].conn_id;
+            }
+        }
+    }
+    sle_tx_unlock();
+
+    for (uint8_t i = 0; i < count; i++) {
+        sle_read_remote_device_rssi(conn_ids[i]);
+    }
+    return ((uint32_t)left < wait) ? (uint32_t)left : wait;
+}
+
+// 连接参数策略需要切换档位时发出更新请求，限速由策略负责。调用者持有发送锁
+static void sle_conn_policy_apply_locked(sle_client_peer_t *peer, uint32_t now)
+{
+    uint8_t profile = 0;
+    if (SLE_CLIENT_CONN_POLICY == 0 || peer->state != SLE_CLIENT_PEER_READY ||
+        !sle_cargo_conn_policy_poll(&peer->conn_policy, now, &profile)) {
+        return;
+    }
+    sle_cargo_conn_param_t cp;
+    sle_cargo_conn_profile_param(profile, &cp);
+    sle_connection_param_update_t param = {
+        .conn_id = peer->conn_id,
+        .interval_min = cp.interval_min,
+        .interval_max = cp.interval_max,
+        .max_latency = cp.latency,
+        .supervision_timeout = cp.timeout,
+    };
+    errcode_t ret = sle_update_connect_param(&param);
+    if (ret != ERRCODE_SUCC) {
+        printf("[sle_client] 63B#%u 请求连接参数 %s 失败:0x%x\r\n", sle_peer_no(peer),
+               sle_cargo_conn_profile_name(profile), ret);
+        sle_cargo_conn_policy_updated(&peer->conn_policy, false, 0, 0, now);
+        return;
+    }
+    printf("[sle_client] 63B#%u 请求连接参数 %s: interval=%u~%uus latency=%u\r\n", sle_peer_no(peer),
+           sle_cargo_conn_profile_name(profile), cp.interval_min * 125, cp.interval_max * 125, cp.latency);
+}
+
+// 连接参数策略: 空闲超时、限速到期后切换档位；返回到下次检查的等待时长与wait中较小者
+static uint32_t sle_client_conn_policy_poll(uint32_t wait)
+{
+    if (SLE_CLIENT_CONN_POLICY == 0) {
+        return wait;
+    }
+    sle_tx_lock();
+    uint32_t now = osKernelGetTickCount();
+    for (uint8_t i = 0; i < SLE_CLIENT_PEER_MAX; i++) {
+        sle_client_peer_t *peer = &g_sle_peers[i];
+        if (peer->state != SLE_CLIENT_PEER_READY) {
+            continue;
+        }
+        sle_conn_policy_apply_locked(peer, now);
+        uint32_t left = sle_cargo_conn_policy_wait(&peer->conn_policy, now);
+        if (left < wait) {
+            wait = left;
+        }
+    }
+    sle_tx_unlock();
+    return wait;
+}
+
+// PHY对应的协议栈参数: 高速PHY使用无线帧类型2和较稀疏的导频以减少开销，1M恢复建立连接时的设置
+static void sle_client_phy_param(uint8_t phy, sle_set_phy_t *param)
+{
+    bool fast = (phy != SLE_CARGO_PHY_1M);
+    param->tx_format = fast ? SLE_RADIO_FRAME_2 : SLE_RADIO_FRAME_1;
+    param->rx_format = param->tx_format;
+    param->tx_phy = phy;
+    param->rx_phy = phy;
+    param->tx_pilot_density = fast ? SLE_PHY_PILOT_DENSITY_16_TO_1 : SLE_PHY_PILOT_DENSITY_4_TO_1;
+    param->rx_pilot_density = param->tx_pilot_density;
+    param->g_feedback = 0;
+    param->t_feedback = 0;
+}
+
+// 有批量传输时切到可用的最快PHY，空闲后回到1M。调用者持有发送锁
+static void sle_phy_apply_locked(sle_client_peer_t *peer, uint32_t now)
+{
+    bool bench = (g_sle_bench_armed || g_sle_bench.active) && g_sle_bench_conn == peer->conn_id;
+    bool rx = peer->bulk_rx && (uint32_t)(now - peer->bulk_rx_tick) < SLE_CLIENT_PHY_RX_BULK_MS;
+    uint8_t phy = SLE_CARGO_PHY_1M;
+    if (peer->state != SLE_CLIENT_PEER_READY || !sle_cargo_phy_poll(&peer->phy, bench || rx || peer->bulk.active, now, &phy)) {
+        return;
+    }
+    sle_set_phy_t param = {0};
+    sle_client_phy_param(phy, &param);
+    errcode_t ret = sle_set_phy_param(peer->conn_id, &param);
+    if (ret != ERRCODE_SUCC) {
+        printf("[sle_client] 63B#%u 请求PHY %s 失败:0x%x\r\n", sle_peer_no(peer), sle_cargo_phy_name(phy), ret);
+        sle_cargo_phy_updated(&peer->phy, false, 0, now);
+        return;
+    }
+    printf("[sle_client] 63B#%u 请求PHY %s (对端能力 %02x)\r\n", sle_peer_no(peer), sle_cargo_phy_name(phy),
+           peer->phy.peer_caps);
+}
+
+// PHY协商: 批量传输开始、结束保持到期、请求超时后切换；返回到下次检查的等待时长与wait中较小者
+static uint32_t sle_client_phy_poll(uint32_t wait)
+{
+    sle_tx_lock();
+    uint32_t now = osKernelGetTickCount();
+    for (uint8_t i = 0; i < SLE_CLIENT_PEER_MAX; i++) {
+        sle_client_peer_t *peer = &g_sle_peers[i];
+        if (peer->state != SLE_CLIENT_PEER_READY) {
+            continue;
+        }
+        sle_phy_apply_locked(peer, now);
+        uint32_t left = sle_cargo_phy_wait(&peer->phy, now);
+        if (peer->bulk_rx && (uint32_t)(now - peer->bulk_rx_tick) < SLE_CLIENT_PHY_RX_BULK_MS) {
+            // 63B的批量发送结束后按时重新检查
+            uint32_t rx_left = SLE_CLIENT_PHY_RX_BULK_MS - (now - peer->bulk_rx_tick);
+            left = (rx_left < left) ? rx_left : left;
+        }
+        if (left < wait) {
+            wait = left;
+        }
+    }
+    sle_tx_unlock();
+    return wait;
+}
+
+// 发件箱回放: 发送窗口或协议栈缓冲区满时按较短的间隔重试，并按间隔保存到NV；返回等待时长与wait中较小者
+static uint32_t sle_client_outbox_poll(uint32_t wait)
+{
+    sle_tx_lock();
+    uint32_t now = osKernelGetTickCount();
+    sle_drain_outbox_locked(now);
+    sle_cargo_snapshot_t counts = { 0 };
+    get_current_cargo_counts(&counts.jiangsu, &counts.zhejiang, &counts.shanghai);
+    sle_outbox_flush(now, &counts);
+    bool pending = (sle_outbox_depth() > 0 && sle_client_any_ready_locked());
+    sle_tx_unlock();
+    return (pending && SLE_CLIENT_OUTBOX_RETRY_MS < wait) ? SLE_CLIENT_OUTBOX_RETRY_MS : wait;
+}
+
+// 压测运行时按速率补发压测帧；返回到下一帧应发时刻的等待时长与wait中较小者
+static uint32_t sle_client_bench_poll(uint32_t wait)
+{
+    sle_tx_lock();
+    uint32_t now = osKernelGetTickCount();
+    sle_bench_pump_locked(now);
+    uint32_t left = sle_cargo_bench_tx_wait(&g_sle_bench, now);
+    if (g_sle_bench_armed) {
+        // 等待PHY切换，最迟到上限时开始
+        uint32_t waited = now - g_sle_bench_arm_tick;
+        uint32_t arm_left = (waited < SLE_CLIENT_BENCH_PHY_WAIT_MS) ? (SLE_CLIENT_BENCH_PHY_WAIT_MS - waited) : 0;
+        left = (arm_left < left) ? arm_left : left;
+    }
+    sle_tx_unlock();
+    return (left < wait) ? left : wait;
+}
+
+// 星闪客户端任务: 连接状态机在此推进，协议栈回调只投递事件，等待时长取最近的截止时刻
 static void sle_client_sample_task(void)
 {
     printf("[sle_client] sample task started\r\n");
-    
+
     // 延迟一下确保初始化完成
     osDelay(1000);
-    
-    // 启动扫描
-    sle_start_scan();
-    
+
+    sle_tx_lock();
+    uint32_t now = osKernelGetTickCount();
+    for (uint8_t i = 0; i < g_sle_server_count; i++) {
+        g_sle_servers[i].lost_tick = now;
+        g_sle_servers[i].retry_tick = now;
+    }
+    g_sle_discover.retry_tick = now;
+    sle_tx_unlock();
+
     while (true) {
-        // 保持任务存活，其他动作在回调中驱动
-        osDelay(SLE_TASK_DELAY_MS);
-        
-        // 如果连接断开，定期重新扫描
-        if (g_sle_client_conn_state != SLE_ACB_STATE_CONNECTED) {
-            printf("[sle_client] not connected, check scan status\r\n");
+        uint32_t wait = sle_client_conn_policy_poll(sle_client_bench_poll(
+            sle_client_phy_poll(sle_client_outbox_poll(sle_client_rssi_poll(sle_client_sm_poll())))));
+        sle_client_evt_t evt;
+        if (osMessageQueueGet(g_sle_evt_queue, &evt, NULL, wait) == osOK) {
+            sle_client_sm_event(&evt);
         }
     }
 }
@@ -541,121 +2576,307 @@ static void sle_client_sample_task(void)
 // MTU交换完成回调后，发起服务发现
 static void sle_client_exchange_info_cbk(uint8_t client_id, uint16_t conn_id, ssap_exchange_info_t *param, errcode_t status)
 {
-    printf("[sle_client] exchange info: mtu=%u ver=%u status=%d\r\n", param->mtu_size, param->version, status);
-    
-    if (status == ERRCODE_SUCC) {
+    if (param == NULL) {
+        printf("[sle_client] exchange info: conn_id=0x%04x without result, status=%d\r\n", conn_id, status);
+        status = ERRCODE_FAIL;
+    } else {
+        printf("[sle_client] exchange info: conn_id=0x%04x mtu=%u ver=%u status=%d\r\n", conn_id, param->mtu_size,
+               param->version, status);
+    }
+
+    sle_tx_lock();
+    sle_client_peer_t *peer = sle_peer_find(conn_id);
+    bool validate = false;
+    ssapc_find_structure_param_t find_param = {0};
+    if (peer != NULL && status == ERRCODE_SUCC) {
+        peer->mtu = param->mtu_size;
+    }
+    if (peer != NULL && peer->handles == SLE_PEER_HANDLES_CACHED && status == ERRCODE_SUCC) {
+        // 使用缓存句柄的连接: 只在缓存的服务句柄范围内查找一次特征，确认布局没有变化
+        validate = true;
+        peer->prop_found = false;
+        peer->disc_rounds = 0;
+        peer->disc_us = uapi_systick_get_us();
+        find_param.type = SSAP_FIND_TYPE_PROPERTY;
+        find_param.start_hdl = peer->service_start;
+        find_param.end_hdl = peer->service_end;
+        find_param.uuid = g_sle_property_uuid;
+    } else if (peer != NULL && peer->handles == SLE_PEER_HANDLES_CACHED) {
+        // 交换失败时缓存的句柄无从校验，按失效处理
+        sle_peer_fallback_locked(peer, "MTU交换失败");
+    } else if (peer != NULL && status == ERRCODE_SUCC) {
         printf("[sle_client] MTU exchange successful, starting service discovery...\r\n");
-        // 首先发现服务
-        ssapc_find_structure_param_t find_param = {0};
-        find_param.type = SSAP_FIND_TYPE_PRIMARY_SERVICE;
-        find_param.start_hdl = 1;
-        find_param.end_hdl = 0xFFFF;
+        sle_peer_set_state_locked(peer, SLE_CLIENT_PEER_DISCOVERING);
+        sle_peer_discover_locked(peer);
+    } else if (peer != NULL && peer->state == SLE_CLIENT_PEER_EXCHANGING) {
+        sle_peer_abort_locked(peer, "MTU交换失败");
+    }
+    sle_tx_unlock();
+
+    if (validate) {
+        printf("[sle_client] validating cached handles in 0x%04x..0x%04x\r\n", find_param.start_hdl,
+               find_param.end_hdl);
         ssapc_find_structure(client_id, conn_id, &find_param);
-    } else {
+    } else if (status != ERRCODE_SUCC) {
         printf("[sle_client] MTU exchange failed\r\n");
     }
 }
 
-// 发现特征回调：记录可写特征的句柄
+// 记录一次完整发现的耗时和查找请求数，调用者持有发送锁
+static void sle_peer_discover_done_locked(sle_client_peer_t *peer)
+{
+    uint32_t elapsed_us = (uint32_t)(uapi_systick_get_us() - peer->disc_us);
+    sle_client_reconnect_stats_t *st = &g_sle_reconnect_stats;
+    st->discover_count++;
+    st->discover_last_us = elapsed_us;
+    st->discover_sum_us += elapsed_us;
+    st->discover_rounds_last = peer->disc_rounds;
+    printf("[sle_client] 63B#%u discovery: rounds=%u %lu us (avg %lu us over %lu)\r\n", sle_peer_no(peer),
+           peer->disc_rounds, (unsigned long)elapsed_us, (unsigned long)(st->discover_sum_us / st->discover_count),
+           (unsigned long)st->discover_count);
+}
+
+// 发现特征回调：记录可写特征的句柄，拿到写句柄后忽略后续结果
 static void sle_client_find_property_cbk(uint8_t client_id, uint16_t conn_id, ssapc_find_property_result_t *property, errcode_t status)
 {
     unused(client_id);
-    unused(conn_id);
-    
-    printf("[sle_client] ===== 特征发现回调 =====\r\n");
-    printf("[sle_client] 客户端ID=%d, 连接ID=0x%04x, 状态=0x%02x\r\n", client_id, conn_id, status);
-    
-    if (status != ERRCODE_SUCC) {
-        printf("[sle_client] ❌ 特征发现失败，状态=0x%02x\r\n", status);
+
+    if (status != ERRCODE_SUCC || property == NULL) {
+        printf("[sle_client] ❌ 特征发现失败: conn_id=0x%04x status=0x%02x\r\n", conn_id, status);
         return;
     }
-    
-    if (property == NULL) {
-        printf("[sle_client] ❌ 特征指针为空\r\n");
+    if (!sle_uuid_equal(&property->uuid, &g_sle_property_uuid)) {
+        printf("[sle_client] 跳过非货物特征 0x%04x\r\n", property->handle);
         return;
     }
-    
-    printf("[sle_client] 发现特征: 句柄=0x%04x, 操作指示=0x%02x\r\n",
-           property->handle, property->operate_indication);
-    
-    // 检查是否是我们期望的特征UUID
-    printf("[sle_client] 检查特征UUID，长度=%d\r\n", property->uuid.len);
-    
-    // 支持16字节完整UUID和2字节短UUID
-    uint16_t property_uuid = 0;
-    bool uuid_match = false;
-    
-    if (property->uuid.len == 2) {
-        // 2字节短UUID
-        property_uuid = (property->uuid.uuid[15] << 8) | property->uuid.uuid[14];
-        printf("[sle_client] 短UUID: 0x%04x\r\n", property_uuid);
-        uuid_match = (property_uuid == SLE_UUID_SERVER_NTF_REPORT);
-    } else if (property->uuid.len == 16) {
-        // 16字节完整UUID，检查最后2字节
-        property_uuid = (property->uuid.uuid[15] << 8) | property->uuid.uuid[14];
-        printf("[sle_client] 完整UUID最后2字节: 0x%04x\r\n", property_uuid);
-        uuid_match = (property_uuid == SLE_UUID_SERVER_NTF_REPORT);
-    } else {
-        printf("[sle_client] UUID长度不支持: %d\r\n", property->uuid.len);
+    // 检查是否支持写操作
+    if ((property->operate_indication & SSAP_OPERATE_INDICATION_BIT_WRITE) == 0) {
+        printf("[sle_client] ❌ 货物特征不支持写操作 (0x%02x)\r\n", property->operate_indication);
+        return;
     }
-    
-    printf("[sle_client] 特征UUID: 0x%04x (期望: 0x%04x) 匹配=%s\r\n", 
-           property_uuid, SLE_UUID_SERVER_NTF_REPORT, uuid_match ? "是" : "否");
-    
-    if (uuid_match) {
-        printf("[sle_client] ✅ 找到目标货物特征！\r\n");
-        // 检查是否支持写操作
-        if (property->operate_indication & SSAP_OPERATE_INDICATION_BIT_WRITE) {
-            g_sle_client_write_id = property->handle;
-            printf("[sle_client] ✅ 特征支持写操作，句柄=0x%04x\r\n", g_sle_client_write_id);
-            printf("[sle_client] ✅ SLE服务发现完成，准备发送数据\r\n");
-            
-            // 立即发送一次当前货物数据，确保63B能看到初始状态
-            extern void get_current_cargo_counts(uint32_t *js, uint32_t *zj, uint32_t *sh);
-            uint32_t js, zj, sh;
-            get_current_cargo_counts(&js, &zj, &sh);
-            
-            // 延迟一下确保连接稳定，然后发送初始数据
-            osDelay(100);
-            sle_client_send_cargo_data(js, zj, sh);
-            printf("[sle_client] 发送初始货物数据: J=%u, Z=%u, S=%u\r\n", js, zj, sh);
-        } else {
-            printf("[sle_client] ❌ 货物特征不支持写操作 (0x%02x)\r\n", property->operate_indication);
+
+    // 写句柄按连接保存，各服务器的句柄可能不同
+    sle_tx_lock();
+    sle_client_peer_t *peer = sle_peer_find(conn_id);
+    bool validating = (peer != NULL && peer->handles == SLE_PEER_HANDLES_CACHED);
+    bool discovered = (peer != NULL && !validating && peer->state == SLE_CLIENT_PEER_DISCOVERING);
+    if (validating) {
+        // 校验缓存: 特征仍在服务范围内，句柄有变化时改用新句柄
+        peer->prop_found = true;
+        if (peer->write_id != property->handle) {
+            printf("[sle_client] 63B#%u 写句柄 0x%04x -> 0x%04x\r\n", sle_peer_no(peer), peer->write_id,
+                   property->handle);
+            sle_cargo_tx_reset(&peer->cargo_tx);
+            peer->write_id = property->handle;
+        }
+        peer->handles = SLE_PEER_HANDLES_VERIFIED;
+        sle_peer_cache_save_locked(peer);
+        printf("[sle_client] ✅ 63B#%u 缓存句柄校验通过，%lu us\r\n", sle_peer_no(peer),
+               (unsigned long)(uapi_systick_get_us() - peer->disc_us));
+    } else if (discovered) {
+        peer->write_id = property->handle;
+        sle_peer_discover_done_locked(peer);
+        sle_peer_cache_save_locked(peer);
+        printf("[sle_client] ✅ 63B#%u 货物特征句柄=0x%04x，SLE服务发现完成\r\n", sle_peer_no(peer), property->handle);
+        // 初始数据由客户端任务在收到就绪事件后发送，回调中不等待
+        sle_peer_set_state_locked(peer, SLE_CLIENT_PEER_READY);
+    } else if (peer == NULL) {
+        printf("[sle_client] ❌ 连接0x%04x不在对端表中\r\n", conn_id);
+    }
+    sle_tx_unlock();
+}
+
+// 查找完成回调: 校验缓存时没有找到货物特征说明服务器布局已变化；
+// 完整发现中服务或特征查找结束仍未找到目标时立即放弃，不必等阶段超时
+static void sle_client_find_structure_cmp_cbk(uint8_t client_id, uint16_t conn_id,
+                                              ssapc_find_structure_result_t *structure_result, errcode_t status)
+{
+    unused(client_id);
+
+    sle_tx_lock();
+    sle_client_peer_t *peer = sle_peer_find(conn_id);
+    if (peer != NULL && peer->handles == SLE_PEER_HANDLES_CACHED && !peer->prop_found) {
+        sle_peer_fallback_locked(peer, (status == ERRCODE_SUCC) ? "特征不在缓存的服务范围内" : "校验查找失败");
+    } else if (peer != NULL && peer->state == SLE_CLIENT_PEER_DISCOVERING && structure_result != NULL) {
+        if (structure_result->type == SSAP_FIND_TYPE_PRIMARY_SERVICE && !peer->service_found) {
+            sle_peer_abort_locked(peer, "未找到货物服务");
+        } else if (structure_result->type == SSAP_FIND_TYPE_PROPERTY && peer->service_found) {
+            sle_peer_abort_locked(peer, "未找到可写的货物特征");
         }
-    } else {
-        printf("[sle_client] 不是目标特征，继续搜索...\r\n");
     }
+    sle_tx_unlock();
 }
 
 // 写确认回调
 static void sle_client_write_cfm_cbk(uint8_t client_id, uint16_t conn_id, ssapc_write_result_t *write_result, errcode_t status)
 {
     unused(client_id);
-    unused(conn_id);
-    
-    printf("[sle_client] 写操作确认回调：\r\n");
-    printf("  客户端ID: %d\r\n", client_id);
-    printf("  连接ID: 0x%04x\r\n", conn_id);
-    printf("  状态码: 0x%02x (%s)\r\n", status, (status == ERRCODE_SUCC) ? "成功" : "失败");
-    
-    if (write_result != NULL) {
-        printf("  句柄: 0x%04x\r\n", write_result->handle);
-        printf("  类型: 0x%02x\r\n", write_result->type);
+
+    // 只加一次锁；压测中该连接的逐帧日志会拖慢发送并淹没结果，只统计不打印
+    sle_tx_lock();
+    bool quiet = g_sle_bench.active && g_sle_bench_conn == conn_id;
+#if SLE_CLIENT_TX_LOG
+    if (!quiet) {
+        printf("[sle_client] write cfm conn=0x%04x handle=0x%04x status=0x%02x\r\n", conn_id,
+               (write_result != NULL) ? write_result->handle : 0, status);
+    }
+#else
+    unused(write_result);
+#endif
+    sle_client_peer_t *peer = sle_peer_find(conn_id);
+    if (peer == NULL || peer->tx_count == 0) {
+        // 窗口已在断开时清空
+        sle_tx_unlock();
+        printf("[sle_client] 收到未登记的写确认，忽略\r\n");
+        return;
+    }
+
+    // 同一连接的写确认按提交顺序返回，释放该对端最早的槽位
+    sle_client_tx_slot_t *slot = &peer->tx_slots[peer->tx_head];
+    peer->tx_head = (peer->tx_head + 1) % SLE_CLIENT_TX_WINDOW_MAX;
+    peer->tx_count--;
+    sle_client_tx_stats_t *st = &peer->tx_stats;
+    uint32_t latency = (uint32_t)(uapi_systick_get_us() - slot->submit_us);
+    st->lat_last_us = latency;
+    if (st->lat_min_us == 0 || latency < st->lat_min_us) {
+        st->lat_min_us = latency;
+    }
+    if (latency > st->lat_max_us) {
+        st->lat_max_us = latency;
+    }
+    peer->tx_latency_sum_us += latency;
+    sle_cargo_telem_confirmed(&g_sle_telem, status == ERRCODE_SUCC, latency);
+    if (slot->kind != SLE_CARGO_FRAME_FRAG && slot->kind != SLE_CARGO_FRAME_BENCH) {
+        sle_cargo_conn_policy_latency(&peer->conn_policy, latency);
+    }
+    if (status == ERRCODE_SUCC) {
+        st->confirmed++;
     } else {
-        printf("  写结果为空\r\n");
+        st->failed++;
     }
-    
-    if (status != ERRCODE_SUCC) {
-        printf("[sle_client] ❌ 货物数据发送失败！\r\n");
+
+    // 写入未校验的缓存句柄失败: 不再重试，回退到完整发现，发现完成后重新发送初始数据
+    if (status != ERRCODE_SUCC && peer->handles == SLE_PEER_HANDLES_CACHED) {
+        st->dropped++;
+        st->inflight = peer->tx_count;
+        sle_peer_fallback_locked(peer, "写入失败");
+        sle_tx_unlock();
+        return;
+    }
+
+    errcode_t ret = ERRCODE_SUCC;
+    uint8_t retries = slot->retries;
+    sle_cargo_frag_tx_result_t bulk = SLE_CARGO_FRAG_TX_NONE;
+    if (slot->kind == SLE_CARGO_FRAME_FRAG) {
+        // 分片不单独重试: 对端按序重组，失败后由分片层换新编号整条重发
+        bulk = sle_cargo_frag_tx_on_confirm(&peer->bulk, status == ERRCODE_SUCC, osKernelGetTickCount());
+        if (status != ERRCODE_SUCC && bulk != SLE_CARGO_FRAG_TX_RESTART) {
+            ret = ERRCODE_FAIL;
+        }
+        if (bulk == SLE_CARGO_FRAG_TX_DONE) {
+            sle_cargo_phy_goodput(&peer->phy, peer->bulk_phy_epoch, peer->bulk.len, peer->bulk.last_ms);
+        }
+    } else if (slot->kind == SLE_CARGO_FRAME_BENCH) {
+        // 压测帧不重试，丢失由63B按序号统计
+        if (status != ERRCODE_SUCC) {
+            ret = ERRCODE_FAIL;
+        }
+    } else if (slot->kind == SLE_CARGO_FRAME_EVENTS) {
+        // 事件帧在对端按编号去重，失败后原样重发；其后已有帧在途时重发会排到它们后面，
+        // 对端收到的编号乱序，改为丢弃，由对端回报的事件缺口从历史中按序补发
+        if (status != ERRCODE_SUCC) {
+            ret = (retries < SLE_CLIENT_TX_RETRY_MAX && peer->tx_count == 0) ?
+                  sle_tx_submit_locked(peer, slot->kind, SLE_CLIENT_WRITE_REQ, slot->data, slot->len, retries + 1) :
+                  ERRCODE_FAIL;
+        }
     } else {
-        printf("[sle_client] ✅ 货物数据发送成功！\r\n");
+        // 写确认即对端已收到该帧，作为后续增量帧的基准；失败则以当前计数重发一个关键帧，旧帧内容已过时
+        if (peer->wire == SLE_CARGO_WIRE_BINARY) {
+            sle_cargo_tx_on_confirm(&peer->cargo_tx, status == ERRCODE_SUCC);
+        }
+        if (status != ERRCODE_SUCC) {
+            ret = ERRCODE_FAIL;
+            if (retries < SLE_CLIENT_TX_RETRY_MAX) {
+                sle_cargo_snapshot_t snap = {0};
+                get_current_cargo_counts(&snap.jiangsu, &snap.zhejiang, &snap.shanghai);
+                snap.tick = osKernelGetTickCount();
+                ret = sle_send_snapshot_locked(peer, &snap, retries + 1);
+            }
+        }
+    }
+    if (status != ERRCODE_SUCC) {
+        if (ret == ERRCODE_SUCC) {
+            st->retried++;
+        } else {
+            // 重试次数用尽或窗口已满: 明确计为丢弃，计数由下一个周期快照补齐
+            st->dropped++;
+        }
+    }
+    // 腾出了槽位，先补发该对端积压的事件和发件箱，剩余的窗口继续发大消息分片
+    sle_flush_backlog_locked(peer);
+    sle_drain_outbox_locked(osKernelGetTickCount());
+    sle_bulk_pump_locked(peer);
+    if (g_sle_bench_mode == SLE_CLIENT_WRITE_REQ) {
+        sle_bench_pump_locked(osKernelGetTickCount());
+    }
+    st->inflight = peer->tx_count;
+    sle_client_tx_stats_t stats = *st;
+    uint8_t no = sle_peer_no(peer);
+    sle_cargo_frag_tx_t *btx = &peer->bulk;
+    uint16_t bulk_len = btx->len;
+    uint32_t bulk_ms = btx->last_ms;
+    uint32_t bulk_frags = btx->frag_seq;
+    uint8_t phy = peer->phy.current;
+    sle_tx_unlock();
+
+    if (bulk == SLE_CARGO_FRAG_TX_DONE) {
+        printf("[sle_client] 63B#%u 大消息发送完成: %u 字节 %u 分片 %ums (%u B/s, PHY %s)\r\n", no, bulk_len,
+               bulk_frags, bulk_ms, (bulk_ms > 0) ? (uint32_t)((uint64_t)bulk_len * 1000 / bulk_ms) : 0,
+               sle_cargo_phy_name(phy));
+    } else if (bulk == SLE_CARGO_FRAG_TX_RESTART) {
+        printf("[sle_client] 63B#%u 大消息分片写入失败，整条重发\r\n", no);
+    } else if (bulk == SLE_CARGO_FRAG_TX_FAILED) {
+        printf("[sle_client] 63B#%u 大消息重发次数用尽，已丢弃\r\n", no);
     }
+
+    if (status != ERRCODE_SUCC && !quiet) {
+        printf("[sle_client] 63B#%u 写失败 %s (重试=%u 丢弃=%u)\r\n", no, (ret == ERRCODE_SUCC) ? "已重发" : "已丢弃",
+               stats.retried, stats.dropped);
+    }
+#if SLE_CLIENT_TX_LOG
+    if (!quiet) {
+        printf("[sle_client] 63B#%u 写时延 %uus (min=%u max=%u) 在途=%u/%u\r\n", no, latency, stats.lat_min_us,
+               stats.lat_max_us, stats.inflight, g_sle_tx_window);
+    }
+#endif
 }
 
 // 获取连接状态
 bool sle_client_is_connected(void)
 {
-    return (g_sle_client_conn_state == SLE_ACB_STATE_CONNECTED);
+    bool connected = false;
+    sle_tx_lock();
+    for (uint8_t i = 0; i < SLE_CLIENT_PEER_MAX; i++) {
+        if (g_sle_peers[i].state > SLE_CLIENT_PEER_CONNECTING) {
+            connected = true;
+        }
+    }
+    sle_tx_unlock();
+    return connected;
+}
+
+// 获取已就绪的对端数
+uint8_t sle_client_ready_count(void)
+{
+    uint8_t count = 0;
+    sle_tx_lock();
+    for (uint8_t i = 0; i < SLE_CLIENT_PEER_MAX; i++) {
+        if (g_sle_peers[i].state == SLE_CLIENT_PEER_READY) {
+            count++;
+        }
+    }
+    sle_tx_unlock();
+    return count;
 }
 
 // 创建星闪客户端任务
@@ -675,7 +2896,7 @@ errcode_t sle_client_task_init(void)
         printf("[sle_client] Failed to create task!\r\n");
         return ERRCODE_FAIL;
     }
-    
+
     printf("[sle_client] task created successfully\r\n");
     return ERRCODE_SUCC;
 }
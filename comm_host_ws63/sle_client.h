@@ -27,12 +27,231 @@
 #include "sle_device_discovery.h"
 #include "sle_connection_manager.h"
 #include "sle_ssap_client.h"
+#include "sle_cargo_proto.h"
+#include "sle_cargo_frag.h"
+#include "sle_cargo_telemetry.h"
+#include "sle_cargo_bench.h"
+#include "sle_cargo_connparam.h"
+#include "sle_cargo_phy.h"
+#include "sle_outbox.h"
 
 // 星闪相关定义
 #define SLE_NAME_MAX_LEN    31
 #define SLE_SEEK_INTERVAL_DEFAULT 0x60
 #define SLE_SEEK_WINDOW_DEFAULT   0x30
 
+// 扫描去重: 控制器侧过滤重复广播(协议栈支持时)，回调中再用地址表丢弃有效期内重复出现的设备
+#ifndef SLE_CLIENT_SEEK_FILTER_DUPLICATES
+#define SLE_CLIENT_SEEK_FILTER_DUPLICATES   1
+#endif
+#ifndef SLE_CLIENT_SEEN_CACHE
+#define SLE_CLIENT_SEEN_CACHE               1
+#endif
+
+// 扫描统计
+typedef struct {
+    uint32_t seen;                  // 扫描回调收到的广播
+    uint32_t filtered;              // 被地址表丢弃的重复广播
+    uint32_t matched;               // 匹配到货物服务UUID/名称或固定地址的广播
+    uint32_t candidates;            // 进入候选窗口的服务器
+    uint8_t last_window_candidates; // 最近一次选择时窗口内的候选数
+    int8_t last_rssi;               // 最近一次选中的候选的RSSI
+    bool seen_cache;                // 当前是否启用地址表
+    // 扫描开始到连接建立的耗时，按地址表开/关分开统计
+    uint32_t ttc_on_count;
+    uint32_t ttc_on_last_ms;
+    uint64_t ttc_on_sum_ms;
+    uint32_t ttc_off_count;
+    uint32_t ttc_off_last_ms;
+    uint64_t ttc_off_sum_ms;
+} sle_client_scan_stats_t;
+
+// 服务器选择: 按广播中的货物服务UUID或设备名称识别63B，第一个候选出现后收集一段时间，连接信号最强的
+#ifndef SLE_CLIENT_CANDIDATE_WINDOW_MS
+#define SLE_CLIENT_CANDIDATE_WINDOW_MS      300
+#endif
+#define SLE_CLIENT_CANDIDATE_MAX            8
+// 记录退避状态的服务器地址数 (发现的和 sle_client_add_server 固定的)
+#define SLE_CLIENT_SERVER_MAX               8
+
+// 同时连接的63B显示/汇总板数量，每块板有独立的服务发现状态、写句柄和发送窗口
+#ifndef SLE_CLIENT_PEER_MAX
+#define SLE_CLIENT_PEER_MAX         4
+#endif
+
+// 对端连接阶段
+typedef enum {
+    SLE_CLIENT_PEER_IDLE = 0,       // 空闲表项
+    SLE_CLIENT_PEER_CONNECTING,     // 已发起连接
+    SLE_CLIENT_PEER_PAIRING,        // 已连接，等待配对完成
+    SLE_CLIENT_PEER_EXCHANGING,     // MTU交换中
+    SLE_CLIENT_PEER_DISCOVERING,    // 服务/特征发现中
+    SLE_CLIENT_PEER_READY,          // 已获得写句柄，可以发送
+    SLE_CLIENT_PEER_STATE_MAX,
+} sle_client_peer_state_t;
+
+// 连接状态机: 各阶段超时，超时后断开并按退避时间重新扫描
+#define SLE_CLIENT_SCAN_TIMEOUT_MS      10000
+#define SLE_CLIENT_CONNECT_TIMEOUT_MS   5000
+#define SLE_CLIENT_PAIR_TIMEOUT_MS      5000
+#define SLE_CLIENT_EXCHANGE_TIMEOUT_MS  3000
+#define SLE_CLIENT_DISCOVER_TIMEOUT_MS  5000
+
+// 重试退避: 连续失败时从基准时长开始倍增到上限，叠加±25%随机抖动；就绪保持足够久后失败计数清零
+#define SLE_CLIENT_BACKOFF_BASE_MS      500
+#define SLE_CLIENT_BACKOFF_MAX_MS       30000
+#define SLE_CLIENT_BACKOFF_RESET_MS     10000
+
+// 对端信息
+typedef struct {
+    uint8_t addr[SLE_ADDR_LEN];
+    uint16_t conn_id;
+    sle_client_peer_state_t state;
+    sle_cargo_wire_t wire;          // 连接时根据服务器广播确定的编码格式
+    bool cached_handles;            // 本次连接使用了NV中缓存的句柄布局
+    uint32_t connect_to_write_us;   // 连接建立到第一次写入的耗时，尚未写入时为0
+    uint32_t state_tick[SLE_CLIENT_PEER_STATE_MAX]; // 本次连接进入各阶段的时刻(ms)，未经过的阶段为0，
+                                                    // IDLE 为该服务器上次断开或开始寻找的时刻
+    uint32_t reconnect_ms;          // 上次断开(或开始寻找)到就绪的耗时，尚未就绪时为0
+} sle_client_peer_info_t;
+
+// 快速重连统计: 连接建立到第一次写入的耗时，按使用缓存句柄和完整服务发现分开
+typedef struct {
+    uint32_t fast_count;
+    uint32_t fast_last_us;
+    uint64_t fast_sum_us;
+    uint32_t full_count;
+    uint32_t full_last_us;
+    uint64_t full_sum_us;
+    uint32_t fallbacks;             // 缓存失效后回退到完整发现的次数
+    // 连接状态机: 断开(或开始寻找)到就绪的耗时
+    uint32_t ready_count;
+    uint32_t ready_last_ms;
+    uint64_t ready_sum_ms;
+    uint32_t scan_timeouts;         // 扫描超时未找到可连接的服务器
+    uint32_t state_timeouts;        // 连接/配对/MTU交换/服务发现阶段超时
+    uint32_t aborts;                // 因超时或失败主动放弃的连接
+    // 完整服务发现: MTU交换完成到拿到写句柄的耗时和查找请求数
+    uint32_t discover_count;
+    uint32_t discover_last_us;
+    uint64_t discover_sum_us;
+    uint8_t discover_rounds_last;
+} sle_client_reconnect_stats_t;
+
+// 发送引擎: 写请求在途窗口(可运行时调整)、失败重试次数
+#ifndef SLE_CLIENT_TX_WINDOW
+#define SLE_CLIENT_TX_WINDOW        4
+#endif
+#define SLE_CLIENT_TX_WINDOW_MAX    8
+#define SLE_CLIENT_TX_RETRY_MAX     2
+// 逐个写确认打印句柄、状态和时延，写确认在协议栈回调中处理，默认关闭；失败和大消息的结果始终打印
+#ifndef SLE_CLIENT_TX_LOG
+#define SLE_CLIENT_TX_LOG           0
+#endif
+// 逐个notify打印长度、逐个确认帧打印内容，同样在协议栈回调中且确认帧持发送锁处理，默认关闭；重发和补发关键帧始终打印
+#ifndef SLE_CLIENT_RX_LOG
+#define SLE_CLIENT_RX_LOG           0
+#endif
+
+// 发送窗口已满或协议栈缓冲区已满，稍后重试
+#define SLE_CLIENT_ERRCODE_BUSY     0x8000A001
+
+// 写入方式
+typedef enum {
+    SLE_CLIENT_WRITE_REQ = 0,   // 写请求: 对端确认，占用窗口槽位，用于快照/增量帧
+    SLE_CLIENT_WRITE_CMD = 1,   // 写命令: 无确认，用于高频事件流
+} sle_client_write_mode_t;
+
+// 分拣事件使用的写入方式
+#ifndef SLE_CLIENT_EVENT_WRITE_MODE
+#define SLE_CLIENT_EVENT_WRITE_MODE SLE_CLIENT_WRITE_CMD
+#endif
+
+// 发送统计
+typedef struct {
+    uint32_t req_issued;    // 已提交的写请求
+    uint32_t cmd_issued;    // 已提交的写命令
+    uint32_t confirmed;     // 写确认成功
+    uint32_t failed;        // 写确认失败或提交失败
+    uint32_t retried;       // 失败后重发的次数
+    uint32_t busy;          // 因窗口或协议栈缓冲区已满被推迟的次数
+    uint32_t dropped;       // 重试用尽或断开时仍未确认而放弃的帧
+    uint8_t inflight;       // 当前在途写请求数
+    uint8_t window;         // 当前窗口大小
+    uint16_t backlog;       // 因该对端繁忙尚未发出的事件数，其他对端不受影响
+    uint32_t lat_last_us;   // 写请求提交到写确认的时延
+    uint32_t lat_min_us;
+    uint32_t lat_max_us;
+    uint32_t lat_avg_us;
+} sle_client_tx_stats_t;
+
+// 大消息分片: 分片只占用发送窗口中保留槽位以外的空位，快照/增量帧总能立即提交
+#define SLE_CLIENT_BULK_RESERVE     1
+
+// 大消息统计，见 sle_cargo_frag
+typedef struct {
+    uint32_t messages;      // 发送完成(所有分片均已确认)的消息数
+    uint32_t bytes;
+    uint32_t fragments;     // 已提交的分片数
+    uint32_t restarts;      // 分片失败后整条重发的次数
+    uint32_t failed;        // 重发用尽或断开时未完成的消息
+    uint32_t last_ms;       // 最近一条消息从开始到全部确认的耗时
+    uint16_t pending;       // 当前消息尚未发出的字节数
+    uint32_t rx_messages;   // 从该63B收到并重组完成的消息数
+    uint32_t rx_dropped;    // 所有63B的分片因缺失、超时或无空闲槽位而丢弃的消息数
+} sle_client_bulk_stats_t;
+
+// 链路遥测: 已就绪的连接每隔一段时间读取一次RSSI，0表示不读取
+#define SLE_CLIENT_RSSI_INTERVAL_MS 5000
+
+// 连接参数随分拣流量切换: 货物流动时请求短间隔且从机不跳过连接事件，空闲一段时间后请求长间隔；0表示保持建立连接时的参数
+#ifndef SLE_CLIENT_CONN_POLICY
+#define SLE_CLIENT_CONN_POLICY      1
+#endif
+
+// 批量传输(大消息、压测、63B发来的分片)期间切换到双方都支持的最快PHY，失败时逐级回退，结束后回到1M；
+// 0表示默认始终使用1M，可由 sle_client_set_phy_policy 在运行时切换以对比吞吐
+#ifndef SLE_CLIENT_PHY_POLICY
+#define SLE_CLIENT_PHY_POLICY       1
+#endif
+// 最近一次收到63B分片后这么久内视为63B仍在批量发送
+#define SLE_CLIENT_PHY_RX_BULK_MS   1000
+
+// 发件箱回放时发送窗口或协议栈缓冲区已满，等待这么久后重试 (约一个连接间隔)
+#define SLE_CLIENT_OUTBOX_RETRY_MS  13
+
+// 吞吐/时延压测: 向一个63B连续发送带序号和时间戳的压测帧，63B统计后回报结果。
+// 编译时置1则第一个对端就绪后自动按默认参数运行一轮，也可由 sle_client_bench_start 随时启动
+#ifndef SLE_CLIENT_BENCH
+#define SLE_CLIENT_BENCH            0
+#endif
+#define SLE_CLIENT_BENCH_LEN        244     // 默认帧长度，超过协商MTU时按MTU截断
+#define SLE_CLIENT_BENCH_RATE       0       // 默认每秒帧数，0表示不限速
+#define SLE_CLIENT_BENCH_DURATION_MS 10000
+#define SLE_CLIENT_BENCH_MODE       SLE_CLIENT_WRITE_CMD
+// 压测先等PHY切换完成再开始发送，使结果对应单一PHY；超过该时长仍未完成则在当前PHY上开始
+#define SLE_CLIENT_BENCH_PHY_WAIT_MS 4000
+
+// 选择性重发: 保留最近发送的事件，两次重发之间至少间隔的时间
+#define SLE_CLIENT_EVENT_HISTORY    32
+#define SLE_CLIENT_RESEND_GUARD_MS  50
+
+// 63B确认帧统计
+typedef struct {
+    uint32_t acks;              // 收到的确认帧数
+    uint32_t rtt_last_ms;       // 快照/增量帧发送到收到确认的往返时延
+    uint32_t rtt_min_ms;
+    uint32_t rtt_max_ms;
+    uint32_t rtt_avg_ms;
+    uint16_t last_seq;          // 63B最近应用的帧序号
+    uint32_t total;             // 63B已计入的累计总数
+    uint8_t flags;              // 最近一次确认的 SLE_CARGO_ACK_* 标志
+    uint16_t display_lag_ms;    // 63B显示延迟，见 sle_cargo_ack_t
+    uint32_t last_ack_tick;     // 最近一次收到确认的本地时刻
+    uint32_t event_resends;     // 重发的事件数
+    uint32_t key_resends;       // 因对端缺少基准而补发的关键帧数
+} sle_client_ack_stats_t;
+
 // 星闪连接参数
 typedef struct {
     uint16_t conn_id;
@@ -81,19 +300,185 @@ errcode_t sle_client_init(void);
 errcode_t sle_client_task_init(void);
 
 /**
- * @brief  发送货物数据到星闪服务器
+ * @brief  发送货物数据到所有已就绪的星闪服务器
+ * @note   每个对端独立编码关键帧/增量帧，某个对端窗口已满只推迟该对端；
+ *         没有已就绪的服务器或发件箱还在回放时存入发件箱，与队尾的快照合并
  * @param  jiangsu: 江苏货物数量
  * @param  zhejiang: 浙江货物数量
  * @param  shanghai: 上海货物数量
  */
 void sle_client_send_cargo_data(uint32_t jiangsu, uint32_t zhejiang, uint32_t shanghai);
 
+/**
+ * @brief  发送一批分拣事件到所有已就绪的星闪服务器 (每个对端一次写入)
+ * @note   至少一个对端已接收时返回成功，繁忙的对端把这批事件记入积压，腾出窗口后按编号补发
+ * @param  events: 事件数组
+ * @param  count: 事件数，1 ~ SLE_CARGO_EVENT_BATCH_MAX
+ * @retval 错误码，没有已就绪的服务器或发件箱还在回放时存入发件箱并返回成功；
+ *         所有对端的发送窗口或协议栈缓冲区都已满时返回 SLE_CLIENT_ERRCODE_BUSY，
+ *         只有旧版文本服务器就绪时返回 ERRCODE_FAIL
+ */
+errcode_t sle_client_send_cargo_events(const sle_cargo_event_t *events, uint8_t count);
+
+/**
+ * @brief  发送一条大消息到所有已就绪的二进制服务器，按各连接协商的MTU分片
+ * @note   内容拷贝到每个对端的发送缓冲区后立即返回；分片用写请求发出并持续填满发送窗口，
+ *         但不占用保留给快照/增量帧的槽位，分拣事件走写命令不受影响
+ * @param  kind: 内容类型，sle_cargo_bulk_kind_t
+ * @param  data: 消息内容
+ * @param  len: 消息长度，1 ~ SLE_CARGO_FRAG_MSG_MAX
+ * @retval 错误码，所有对端都还有未发完的消息时返回 SLE_CLIENT_ERRCODE_BUSY，
+ *         没有已就绪的二进制对端时返回 ERRCODE_FAIL
+ */
+errcode_t sle_client_send_bulk(uint8_t kind, const uint8_t *data, uint16_t len);
+
+/**
+ * @brief  固定一个要连接的服务器地址，扫描到后即使广播中没有货物服务UUID/名称也作为候选
+ * @note   带货物服务UUID或名称 CARGO_SERVER_63B 的63B会被自动发现，不需要调用
+ * @param  addr: 服务器地址，长度 SLE_ADDR_LEN
+ * @retval 错误码，地址表中都是固定或已连接的地址时返回 ERRCODE_FAIL
+ */
+errcode_t sle_client_add_server(const uint8_t *addr);
+
+/**
+ * @brief  设置写请求在途窗口大小，对所有对端生效
+ * @param  window: 1 ~ SLE_CLIENT_TX_WINDOW_MAX
+ */
+void sle_client_set_tx_window(uint8_t window);
+
+/**
+ * @brief  获取对端信息
+ * @param  peer: 对端表项序号，0 ~ SLE_CLIENT_PEER_MAX-1
+ * @param  info: 输出的对端信息
+ * @retval 表项是否在用
+ */
+bool sle_client_get_peer_info(uint8_t peer, sle_client_peer_info_t *info);
+
+/**
+ * @brief  启用或关闭扫描地址表，用于对比拥挤环境下的连接耗时，下一轮扫描生效
+ * @param  enable: 是否启用
+ */
+void sle_client_set_seen_cache(bool enable);
+
+/**
+ * @brief  获取扫描统计
+ * @param  stats: 输出的统计信息
+ */
+void sle_client_get_scan_stats(sle_client_scan_stats_t *stats);
+
+/**
+ * @brief  获取快速重连和连接状态机统计
+ * @param  stats: 输出的统计信息
+ */
+void sle_client_get_reconnect_stats(sle_client_reconnect_stats_t *stats);
+
+/**
+ * @brief  获取发件箱统计: 深度、合并/丢弃/回放条数、断开时长和回放耗时
+ * @param  stats: 输出的统计
+ */
+void sle_client_get_outbox_stats(sle_outbox_stats_t *stats);
+
+/**
+ * @brief  获取链路遥测: RSSI、写请求到写确认的时延直方图、写请求计数、按原因的断开次数、已连接/寻找中时长
+ * @param  telem: 输出的遥测，所有对端合计
+ */
+void sle_client_get_telemetry(sle_cargo_telem_t *telem);
+
+/**
+ * @brief  开始一轮压测，目标为第一个已就绪的二进制编码63B；已有压测在运行时先结束它
+ * @param  frame_len: 帧长度，SLE_CARGO_BENCH_HDR_LEN ~ SLE_CARGO_BENCH_FRAME_MAX
+ * @param  rate_hz: 每秒帧数，0表示不限速
+ * @param  duration_ms: 持续时长
+ * @param  mode: 写命令(无确认，测链路上限)或写请求(占用发送窗口中保留槽位以外的空位)
+ * @retval 错误码，没有可用的对端时返回 ERRCODE_FAIL
+ */
+errcode_t sle_client_bench_start(uint16_t frame_len, uint16_t rate_hz, uint32_t duration_ms,
+                                 sle_client_write_mode_t mode);
+
+/**
+ * @brief  停止正在运行的压测，63B在空闲超时后给出最终结果
+ */
+void sle_client_bench_stop(void);
+
+/**
+ * @brief  请求所有已就绪的二进制服务器导出分拣速率历史，63B分块以大消息回复，收到后打印块头和最新的几个桶
+ * @param  tier: 级别，SLE_CARGO_HIST_FINE (10秒一桶，1小时) 或 SLE_CARGO_HIST_COARSE (1分钟一桶，1天)
+ * @param  buckets: 最多导出的桶数，0为全部
+ * @retval 错误码，没有已就绪的二进制对端时返回 ERRCODE_FAIL，协议栈缓冲区都满时返回 SLE_CLIENT_ERRCODE_BUSY
+ */
+errcode_t sle_client_request_history(uint8_t tier, uint16_t buckets);
+
+/**
+ * @brief  获取63B最近一次回报的压测结果
+ * @param  report: 输出的结果
+ * @retval 是否收到过结果
+ */
+bool sle_client_get_bench_report(sle_cargo_bench_report_t *report);
+
+/**
+ * @brief  获取某个对端的发送统计
+ * @param  peer: 对端表项序号，0 ~ SLE_CLIENT_PEER_MAX-1
+ * @param  stats: 输出的统计信息
+ * @retval 表项是否在用
+ */
+bool sle_client_get_tx_stats(uint8_t peer, sle_client_tx_stats_t *stats);
+
+/**
+ * @brief  获取某个对端的63B确认帧统计 (往返时延、显示是否最新、重发次数)
+ * @param  peer: 对端表项序号，0 ~ SLE_CLIENT_PEER_MAX-1
+ * @param  stats: 输出的统计信息
+ * @retval 表项是否在用
+ */
+bool sle_client_get_ack_stats(uint8_t peer, sle_client_ack_stats_t *stats);
+
+/**
+ * @brief  获取某个对端的大消息收发统计
+ * @param  peer: 对端表项序号，0 ~ SLE_CLIENT_PEER_MAX-1
+ * @param  stats: 输出的统计信息
+ * @retval 表项是否在用
+ */
+bool sle_client_get_bulk_stats(uint8_t peer, sle_client_bulk_stats_t *stats);
+
+/**
+ * @brief  获取某个对端的连接参数策略: 当前档位、请求计数和各档位的写时延
+ * @param  peer: 对端表项序号，0 ~ SLE_CLIENT_PEER_MAX-1
+ * @param  policy: 输出的策略状态
+ * @retval 表项是否在用
+ */
+bool sle_client_get_conn_policy(uint8_t peer, sle_cargo_conn_policy_t *policy);
+
+/**
+ * @brief  获取某个对端的PHY协商状态: 当前PHY、双方能力、回退计数和各PHY上批量传输的有效吞吐
+ * @param  peer: 对端表项序号，0 ~ SLE_CLIENT_PEER_MAX-1
+ * @param  phy: 输出的协商状态
+ * @retval 表项是否在用
+ */
+bool sle_client_get_phy(uint8_t peer, sle_cargo_phy_link_t *phy);
+
+/**
+ * @brief  允许或禁止批量传输时切换到高速PHY，对已建立的连接立即生效；禁止时回到1M，用于测量对比基准
+ * @param  enable: 是否允许
+ */
+void sle_client_set_phy_policy(bool enable);
+
+/**
+ * @brief  设置最后一件货物之后多久切换到空闲连接参数，对已建立的连接立即生效
+ * @param  idle_ms: 空闲时长，默认 SLE_CARGO_CONN_IDLE_MS
+ */
+void sle_client_set_conn_idle_ms(uint32_t idle_ms);
+
 /**
  * @brief  获取星闪连接状态
- * @retval 连接状态
+ * @retval 至少一个对端已连接时返回true
  */
 bool sle_client_is_connected(void);
 
+/**
+ * @brief  获取已就绪 (可发送) 的对端数量
+ * @retval 对端数量
+ */
+uint8_t sle_client_ready_count(void);
+
 /**
  * @brief  获取当前货物分拣信息 (外部函数)
  * @param  js: 江苏货物数量
@@ -102,4 +487,12 @@ bool sle_client_is_connected(void);
  */
 extern void get_current_cargo_counts(uint32_t *js, uint32_t *zj, uint32_t *sh);
 
+/**
+ * @brief  设置当前货物分拣信息，用于复位后从发件箱保存的计数继续 (外部函数)
+ * @param  js: 江苏货物数量
+ * @param  zj: 浙江货物数量
+ * @param  sh: 上海货物数量
+ */
+extern void set_current_cargo_counts(uint32_t js, uint32_t zj, uint32_t sh);
+
 #endif /* SLE_CLIENT_H */
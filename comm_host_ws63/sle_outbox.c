@@ -0,0 +1,261 @@
+/*
+ * Copyright (c) 2024 HiSilicon Technologies CO., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "sle_outbox.h"
+#include <stdio.h>
+#include <string.h>
+#include "errcode.h"
+#include "nv.h"
+
+#define SLE_OUTBOX_MAGIC    0xC5
+#define SLE_OUTBOX_VERSION  2
+
+static sle_outbox_entry_t g_outbox[SLE_OUTBOX_LEN];
+static uint16_t g_outbox_head = 0;
+static uint16_t g_outbox_count = 0;
+static sle_outbox_stats_t g_outbox_stats;
+static uint32_t g_outbox_first_tick = 0;    // 本次断开第一条存入的时刻
+static bool g_outbox_draining = false;
+static uint32_t g_outbox_drain_tick = 0;
+static uint16_t g_outbox_drain_entries = 0;
+static bool g_outbox_dirty = false;
+static uint32_t g_outbox_save_tick = 0;
+
+#if SLE_OUTBOX_FLASH
+// NV中的存储格式: 头部(含保存时的分拣计数) + 按顺序排列的条目，格式变化时升级版本号；
+// 旧版本的记录没有计数，恢复后会与从0开始的新计数矛盾，直接丢弃
+typedef struct {
+    uint8_t magic;
+    uint8_t version;
+    uint16_t count;
+    sle_cargo_snapshot_t counts;
+    sle_outbox_entry_t entries[SLE_OUTBOX_LEN];
+} sle_outbox_nv_t;
+
+static sle_outbox_nv_t g_outbox_nv;
+
+static void sle_outbox_save(const sle_cargo_snapshot_t *counts)
+{
+    g_outbox_nv.magic = SLE_OUTBOX_MAGIC;
+    g_outbox_nv.version = SLE_OUTBOX_VERSION;
+    g_outbox_nv.count = g_outbox_count;
+    g_outbox_nv.counts = *counts;
+    for (uint16_t i = 0; i < g_outbox_count; i++) {
+        g_outbox_nv.entries[i] = g_outbox[(g_outbox_head + i) % SLE_OUTBOX_LEN];
+    }
+    // 只写入有效部分
+    uint16_t len = (uint16_t)(sizeof(g_outbox_nv) - sizeof(g_outbox_nv.entries) +
+                              g_outbox_count * sizeof(sle_outbox_entry_t));
+    errcode_t ret = uapi_nv_write(SLE_OUTBOX_NV_KEY, (const uint8_t *)&g_outbox_nv, len);
+    if (ret != ERRCODE_SUCC) {
+        printf("[sle_outbox] nv write failed:0x%x\r\n", ret);
+        return;
+    }
+    g_outbox_stats.flash_saves++;
+}
+
+static bool sle_outbox_restore(sle_cargo_snapshot_t *counts)
+{
+    uint16_t len = 0;
+    errcode_t ret = uapi_nv_read(SLE_OUTBOX_NV_KEY, sizeof(g_outbox_nv), &len, (uint8_t *)&g_outbox_nv);
+    uint16_t head_len = (uint16_t)(sizeof(g_outbox_nv) - sizeof(g_outbox_nv.entries));
+    if (ret != ERRCODE_SUCC || len < head_len || g_outbox_nv.magic != SLE_OUTBOX_MAGIC ||
+        g_outbox_nv.version != SLE_OUTBOX_VERSION || g_outbox_nv.count > SLE_OUTBOX_LEN ||
+        len != head_len + g_outbox_nv.count * sizeof(sle_outbox_entry_t) || g_outbox_nv.count == 0) {
+        return false;
+    }
+    memcpy(g_outbox, g_outbox_nv.entries, g_outbox_nv.count * sizeof(sle_outbox_entry_t));
+    g_outbox_count = g_outbox_nv.count;
+    g_outbox_stats.restored = g_outbox_count;
+    *counts = g_outbox_nv.counts;
+    printf("[sle_outbox] restored %u entries from nv, counts %u/%u/%u\r\n", g_outbox_count,
+           counts->jiangsu, counts->zhejiang, counts->shanghai);
+    return true;
+}
+#endif
+
+bool sle_outbox_init(uint32_t now, sle_cargo_snapshot_t *counts)
+{
+    bool restored = false;
+    memset(g_outbox, 0, sizeof(g_outbox));
+    memset(&g_outbox_stats, 0, sizeof(g_outbox_stats));
+    g_outbox_head = 0;
+    g_outbox_count = 0;
+    g_outbox_draining = false;
+    g_outbox_dirty = false;
+    g_outbox_save_tick = now;
+    g_outbox_first_tick = now;
+#if SLE_OUTBOX_FLASH
+    if (counts != NULL) {
+        restored = sle_outbox_restore(counts);
+    }
+#else
+    (void)counts;
+#endif
+    g_outbox_stats.depth_max = g_outbox_count;
+    return restored;
+}
+
+uint16_t sle_outbox_depth(void)
+{
+    return g_outbox_count;
+}
+
+// 在队尾追加一个条目，队列满时先丢弃队首
+static sle_outbox_entry_t *sle_outbox_append(uint32_t now)
+{
+    if (g_outbox_count == 0) {
+        g_outbox_first_tick = now;
+    }
+    if (g_outbox_count == SLE_OUTBOX_LEN) {
+        g_outbox_head = (g_outbox_head + 1) % SLE_OUTBOX_LEN;
+        g_outbox_count--;
+        g_outbox_stats.dropped++;
+    }
+    sle_outbox_entry_t *entry = &g_outbox[(g_outbox_head + g_outbox_count) % SLE_OUTBOX_LEN];
+    g_outbox_count++;
+    if (g_outbox_count > g_outbox_stats.depth_max) {
+        g_outbox_stats.depth_max = g_outbox_count;
+    }
+    g_outbox_stats.queued++;
+    g_outbox_dirty = true;
+    return entry;
+}
+
+void sle_outbox_put_events(const sle_cargo_event_t *events, uint8_t count, uint32_t now)
+{
+    if (events == NULL) {
+        return;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        sle_outbox_entry_t *entry = sle_outbox_append(now);
+        entry->kind = SLE_OUTBOX_EVENT;
+        entry->u.event = events[i];
+    }
+}
+
+void sle_outbox_put_snapshot(const sle_cargo_snapshot_t *snap, uint32_t now)
+{
+    if (snap == NULL) {
+        return;
+    }
+    if (g_outbox_count > 0) {
+        sle_outbox_entry_t *tail = &g_outbox[(g_outbox_head + g_outbox_count - 1) % SLE_OUTBOX_LEN];
+        if (tail->kind == SLE_OUTBOX_SNAPSHOT) {
+            // 两条快照之间没有事件，旧快照已无意义
+            tail->u.snapshot = *snap;
+            g_outbox_stats.queued++;
+            g_outbox_stats.merged++;
+            g_outbox_dirty = true;
+            return;
+        }
+    }
+    sle_outbox_entry_t *entry = sle_outbox_append(now);
+    entry->kind = SLE_OUTBOX_SNAPSHOT;
+    entry->u.snapshot = *snap;
+}
+
+uint8_t sle_outbox_peek_events(sle_cargo_event_t *out, uint8_t max)
+{
+    if (out == NULL) {
+        return 0;
+    }
+    uint8_t n = 0;
+    while (n < max && n < g_outbox_count) {
+        const sle_outbox_entry_t *entry = &g_outbox[(g_outbox_head + n) % SLE_OUTBOX_LEN];
+        if (entry->kind != SLE_OUTBOX_EVENT) {
+            break;
+        }
+        out[n++] = entry->u.event;
+    }
+    return n;
+}
+
+bool sle_outbox_peek_snapshot(sle_cargo_snapshot_t *snap)
+{
+    if (snap == NULL || g_outbox_count == 0 || g_outbox[g_outbox_head].kind != SLE_OUTBOX_SNAPSHOT) {
+        return false;
+    }
+    *snap = g_outbox[g_outbox_head].u.snapshot;
+    return true;
+}
+
+void sle_outbox_drain_begin(uint32_t now)
+{
+    if (g_outbox_count == 0 || g_outbox_draining) {
+        return;
+    }
+    g_outbox_draining = true;
+    g_outbox_drain_tick = now;
+    g_outbox_drain_entries = 0;
+    g_outbox_stats.outage_last_ms = now - g_outbox_first_tick;
+    if (g_outbox_stats.outage_last_ms > g_outbox_stats.outage_max_ms) {
+        g_outbox_stats.outage_max_ms = g_outbox_stats.outage_last_ms;
+    }
+}
+
+void sle_outbox_pop(uint16_t count, bool replayed, uint32_t now)
+{
+    if (count > g_outbox_count) {
+        count = g_outbox_count;
+    }
+    g_outbox_head = (g_outbox_head + count) % SLE_OUTBOX_LEN;
+    g_outbox_count -= count;
+    g_outbox_dirty = true;
+    if (replayed) {
+        g_outbox_stats.replayed += count;
+        g_outbox_drain_entries += count;
+    } else {
+        g_outbox_stats.dropped += count;
+    }
+    if (g_outbox_count == 0 && g_outbox_draining) {
+        g_outbox_draining = false;
+        g_outbox_stats.outages++;
+        g_outbox_stats.drain_last_ms = now - g_outbox_drain_tick;
+        g_outbox_stats.drain_last_entries = g_outbox_drain_entries;
+        if (g_outbox_stats.drain_last_ms > g_outbox_stats.drain_max_ms) {
+            g_outbox_stats.drain_max_ms = g_outbox_stats.drain_last_ms;
+        }
+    }
+}
+
+void sle_outbox_flush(uint32_t now, const sle_cargo_snapshot_t *counts)
+{
+#if SLE_OUTBOX_FLASH
+    // 清空后立即写入，避免复位后重放已送达的内容
+    if (counts == NULL || !g_outbox_dirty ||
+        (g_outbox_count > 0 && (uint32_t)(now - g_outbox_save_tick) < SLE_OUTBOX_FLASH_SAVE_MS)) {
+        return;
+    }
+    sle_outbox_save(counts);
+    g_outbox_save_tick = now;
+    g_outbox_dirty = false;
+#else
+    (void)now;
+    (void)counts;
+    g_outbox_dirty = false;
+#endif
+}
+
+void sle_outbox_get_stats(sle_outbox_stats_t *stats, uint32_t now)
+{
+    if (stats == NULL) {
+        return;
+    }
+    *stats = g_outbox_stats;
+    stats->depth = g_outbox_count;
+    stats->capacity = SLE_OUTBOX_LEN;
+    stats->outage_ms = (g_outbox_count > 0 && !g_outbox_draining) ? (now - g_outbox_first_tick) : 0;
+}
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2024 HiSilicon Technologies CO., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SLE_OUTBOX_H
+#define SLE_OUTBOX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sle_cargo_proto.h"
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+#endif /* __cplusplus */
+
+// 发件箱: 星闪断开期间的分拣事件和计数快照按产生顺序存入定长环形队列，重连后按序全速回放。
+// 相邻的快照合并为一条；队列满时丢弃最旧的条目，其计数已包含在之后的快照中，63B由快照补齐
+#ifndef SLE_OUTBOX_LEN
+#define SLE_OUTBOX_LEN              128
+#endif
+
+// 置1时同时保存到NV，断开期间复位也不丢失；写入间隔限制Flash擦写次数。
+// 分拣计数与条目一起保存，复位后从保存时的计数继续，回放的旧事件和之后的新计数前后一致
+#ifndef SLE_OUTBOX_FLASH
+#define SLE_OUTBOX_FLASH            0
+#endif
+#define SLE_OUTBOX_FLASH_SAVE_MS    5000
+
+// 应用自定义NV项，需与工程的NV配置一致
+#ifndef SLE_OUTBOX_NV_KEY
+#define SLE_OUTBOX_NV_KEY           0x2F11
+#endif
+
+// 条目类型
+typedef enum {
+    SLE_OUTBOX_EVENT = 0,
+    SLE_OUTBOX_SNAPSHOT,
+} sle_outbox_kind_t;
+
+typedef struct {
+    uint8_t kind;                   // sle_outbox_kind_t
+    uint8_t reserved[3];
+    union {
+        sle_cargo_event_t event;
+        sle_cargo_snapshot_t snapshot;
+    } u;
+} sle_outbox_entry_t;
+
+// 发件箱统计，用于按最长断开时长确定队列大小
+typedef struct {
+    uint16_t depth;                 // 当前条目数
+    uint16_t depth_max;             // 历史最大条目数
+    uint16_t capacity;
+    uint32_t queued;                // 存入的条目数 (合并前)
+    uint32_t merged;                // 合并到前一条快照的次数
+    uint32_t dropped;               // 队列满或无法回放而丢弃的条目
+    uint32_t replayed;              // 已回放的条目
+    uint32_t outages;               // 完成回放的断开次数
+    uint32_t outage_ms;             // 当前断开已持续的时长，队列为空时为0
+    uint32_t outage_last_ms;        // 上次断开: 第一条存入到开始回放
+    uint32_t outage_max_ms;
+    uint32_t drain_last_ms;         // 上次回放: 开始到队列清空
+    uint32_t drain_max_ms;
+    uint16_t drain_last_entries;    // 上次回放的条目数
+    uint32_t flash_saves;
+    uint16_t restored;              // 启动时从NV恢复的条目数
+} sle_outbox_stats_t;
+
+/**
+ * @brief  清空发件箱，启用NV时恢复上次保存的内容
+ * @param  now: 当前时刻(ms)
+ * @param  counts: 恢复了条目时输出保存时的分拣计数，调用者须以此作为当前计数
+ * @retval 是否从NV恢复了条目
+ * @note   发件箱本身不加锁，调用者负责互斥
+ */
+bool sle_outbox_init(uint32_t now, sle_cargo_snapshot_t *counts);
+
+/**
+ * @brief  发件箱中的条目数
+ * @retval 条目数
+ */
+uint16_t sle_outbox_depth(void);
+
+/**
+ * @brief  存入一批分拣事件，队列满时丢弃最旧的条目
+ * @param  events: 事件
+ * @param  count: 事件数
+ * @param  now: 当前时刻(ms)
+ */
+void sle_outbox_put_events(const sle_cargo_event_t *events, uint8_t count, uint32_t now);
+
+/**
+ * @brief  存入一个计数快照，队尾已是快照时用新值覆盖
+ * @param  snap: 快照
+ * @param  now: 当前时刻(ms)
+ */
+void sle_outbox_put_snapshot(const sle_cargo_snapshot_t *snap, uint32_t now);
+
+/**
+ * @brief  取出队首连续的事件，不移出
+ * @param  out: 输出的事件
+ * @param  max: 最多取出的条数
+ * @retval 条数，队首是快照或队列为空时返回0
+ */
+uint8_t sle_outbox_peek_events(sle_cargo_event_t *out, uint8_t max);
+
+/**
+ * @brief  取出队首的快照，不移出
+ * @param  snap: 输出的快照
+ * @retval 队首是否为快照
+ */
+bool sle_outbox_peek_snapshot(sle_cargo_snapshot_t *snap);
+
+/**
+ * @brief  开始回放，记录断开时长；已在回放中时不做任何事
+ * @param  now: 当前时刻(ms)
+ */
+void sle_outbox_drain_begin(uint32_t now);
+
+/**
+ * @brief  移出队首的条目，队列清空时记录回放耗时
+ * @param  count: 条目数
+ * @param  replayed: 已发出计为回放，否则计为丢弃
+ * @param  now: 当前时刻(ms)
+ */
+void sle_outbox_pop(uint16_t count, bool replayed, uint32_t now);
+
+/**
+ * @brief  内容有变化且距上次保存满 SLE_OUTBOX_FLASH_SAVE_MS 时写入NV，未启用NV时不做任何事
+ * @param  now: 当前时刻(ms)
+ * @param  counts: 当前的分拣计数，与条目一起保存
+ */
+void sle_outbox_flush(uint32_t now, const sle_cargo_snapshot_t *counts);
+
+/**
+ * @brief  获取统计
+ * @param  stats: 输出的统计
+ * @param  now: 当前时刻(ms)
+ */
+void sle_outbox_get_stats(sle_outbox_stats_t *stats, uint32_t now);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* __cplusplus */
+
+#endif /* SLE_OUTBOX_H */
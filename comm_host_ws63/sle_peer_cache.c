@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2024 HiSilicon Technologies CO., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "sle_peer_cache.h"
+#include <stdio.h>
+#include <string.h>
+#include "errcode.h"
+#include "nv.h"
+
+#define SLE_PEER_CACHE_MAGIC    0xC5
+#define SLE_PEER_CACHE_VERSION  1
+
+// NV中的存储格式: 头部 + 定长记录表，记录格式变化时升级版本号
+typedef struct {
+    uint8_t magic;
+    uint8_t version;
+    uint8_t count;
+    uint8_t reserved;
+    sle_peer_cache_entry_t entries[SLE_PEER_CACHE_MAX];
+} sle_peer_cache_nv_t;
+
+static sle_peer_cache_nv_t g_peer_cache;
+static uint16_t g_peer_cache_stamp = 0;
+
+static int sle_peer_cache_index(const uint8_t *addr)
+{
+    for (uint8_t i = 0; i < g_peer_cache.count; i++) {
+        if (memcmp(g_peer_cache.entries[i].addr, addr, SLE_PEER_CACHE_ADDR_LEN) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void sle_peer_cache_save(void)
+{
+    errcode_t ret = uapi_nv_write(SLE_PEER_CACHE_NV_KEY, (const uint8_t *)&g_peer_cache, sizeof(g_peer_cache));
+    if (ret != ERRCODE_SUCC) {
+        printf("[sle_peer_cache] nv write failed:0x%x\r\n", ret);
+    }
+}
+
+void sle_peer_cache_load(void)
+{
+    uint16_t len = 0;
+    errcode_t ret = uapi_nv_read(SLE_PEER_CACHE_NV_KEY, sizeof(g_peer_cache), &len, (uint8_t *)&g_peer_cache);
+    if (ret != ERRCODE_SUCC || len != sizeof(g_peer_cache) || g_peer_cache.magic != SLE_PEER_CACHE_MAGIC ||
+        g_peer_cache.version != SLE_PEER_CACHE_VERSION || g_peer_cache.count > SLE_PEER_CACHE_MAX) {
+        memset(&g_peer_cache, 0, sizeof(g_peer_cache));
+        g_peer_cache.magic = SLE_PEER_CACHE_MAGIC;
+        g_peer_cache.version = SLE_PEER_CACHE_VERSION;
+        printf("[sle_peer_cache] no valid cache in nv\r\n");
+        return;
+    }
+
+    g_peer_cache_stamp = 0;
+    for (uint8_t i = 0; i < g_peer_cache.count; i++) {
+        if ((int16_t)(g_peer_cache.entries[i].stamp - g_peer_cache_stamp) > 0) {
+            g_peer_cache_stamp = g_peer_cache.entries[i].stamp;
+        }
+    }
+    printf("[sle_peer_cache] loaded %u servers from nv\r\n", g_peer_cache.count);
+}
+
+bool sle_peer_cache_find(const uint8_t *addr, sle_peer_cache_entry_t *entry)
+{
+    if (addr == NULL || entry == NULL) {
+        return false;
+    }
+    int idx = sle_peer_cache_index(addr);
+    if (idx < 0) {
+        return false;
+    }
+    *entry = g_peer_cache.entries[idx];
+    return true;
+}
+
+void sle_peer_cache_store(const sle_peer_cache_entry_t *entry)
+{
+    if (entry == NULL) {
+        return;
+    }
+
+    int idx = sle_peer_cache_index(entry->addr);
+    if (idx >= 0) {
+        // 布局没变时只更新使用顺序: 已是最近使用的记录不写NV，反复重连同一块63B不会擦写flash；
+        // 顺序变化时写入，复位后仍按实际的使用顺序替换记录
+        sle_peer_cache_entry_t cur = g_peer_cache.entries[idx];
+        cur.stamp = entry->stamp;
+        cur.reserved = entry->reserved;
+        if (memcmp(&cur, entry, sizeof(cur)) == 0) {
+            if (g_peer_cache.entries[idx].stamp != g_peer_cache_stamp) {
+                g_peer_cache.entries[idx].stamp = ++g_peer_cache_stamp;
+                sle_peer_cache_save();
+            }
+            return;
+        }
+    } else if (g_peer_cache.count < SLE_PEER_CACHE_MAX) {
+        idx = g_peer_cache.count++;
+    } else {
+        // 表满: 替换最久未用的记录
+        idx = 0;
+        for (uint8_t i = 1; i < SLE_PEER_CACHE_MAX; i++) {
+            if ((int16_t)(g_peer_cache.entries[i].stamp - g_peer_cache.entries[idx].stamp) < 0) {
+                idx = i;
+            }
+        }
+    }
+
+    g_peer_cache.entries[idx] = *entry;
+    g_peer_cache.entries[idx].stamp = ++g_peer_cache_stamp;
+    sle_peer_cache_save();
+}
+
+void sle_peer_cache_invalidate(const uint8_t *addr)
+{
+    if (addr == NULL) {
+        return;
+    }
+    int idx = sle_peer_cache_index(addr);
+    if (idx < 0) {
+        return;
+    }
+    g_peer_cache.count--;
+    g_peer_cache.entries[idx] = g_peer_cache.entries[g_peer_cache.count];
+    memset(&g_peer_cache.entries[g_peer_cache.count], 0, sizeof(sle_peer_cache_entry_t));
+    sle_peer_cache_save();
+}
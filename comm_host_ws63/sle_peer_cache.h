@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2024 HiSilicon Technologies CO., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SLE_PEER_CACHE_H
+#define SLE_PEER_CACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+#endif /* __cplusplus */
+
+// 保存在NV中的服务器数量，超出时替换最久未用的记录
+#define SLE_PEER_CACHE_MAX          8
+#define SLE_PEER_CACHE_ADDR_LEN     6
+
+// 应用自定义NV项，需与工程的NV配置一致
+#ifndef SLE_PEER_CACHE_NV_KEY
+#define SLE_PEER_CACHE_NV_KEY       0x2F10
+#endif
+
+// 一个服务器的句柄布局，按地址索引。配对与否只看协议栈连接时报告的配对状态，绑定信息由协议栈自己保存，
+// 这里不缓存: 协议栈报告未配对时它已没有密钥，缓存说已绑定也必须重新配对
+typedef struct {
+    uint8_t addr[SLE_PEER_CACHE_ADDR_LEN];
+    uint8_t wire;               // sle_cargo_wire_t
+    uint8_t reserved;           // 旧版本的绑定标志，已不使用，保持记录布局不变
+    uint16_t service_start;     // 货物服务句柄范围，重连后只在此范围内校验
+    uint16_t service_end;
+    uint16_t write_handle;      // 货物特征的写句柄
+    uint16_t mtu;               // 上次协商的MTU
+    uint16_t stamp;             // 最近使用序号
+} sle_peer_cache_entry_t;
+
+/**
+ * @brief  从NV读取缓存，内容无效时清空
+ * @note   缓存本身不加锁，调用者负责与协议栈回调之间的互斥
+ */
+void sle_peer_cache_load(void);
+
+/**
+ * @brief  按地址查找缓存
+ * @param  addr: 服务器地址
+ * @param  entry: 输出的缓存记录
+ * @retval 是否找到
+ */
+bool sle_peer_cache_find(const uint8_t *addr, sle_peer_cache_entry_t *entry);
+
+/**
+ * @brief  保存一条记录并标记为最近使用，内容或使用顺序有变化时写入NV
+ * @param  entry: 缓存记录，stamp 由缓存维护
+ */
+void sle_peer_cache_store(const sle_peer_cache_entry_t *entry);
+
+/**
+ * @brief  删除一条记录 (服务器句柄布局已变化时调用)
+ * @param  addr: 服务器地址
+ */
+void sle_peer_cache_invalidate(const uint8_t *addr);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* __cplusplus */
+
+#endif /* SLE_PEER_CACHE_H */
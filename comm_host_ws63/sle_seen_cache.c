@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2024 HiSilicon Technologies CO., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "sle_seen_cache.h"
+#include <string.h>
+
+typedef struct {
+    uint8_t addr[SLE_SEEN_CACHE_ADDR_LEN];
+    uint8_t kind;
+    bool used;
+    uint32_t tick;                  // 记录(或过期后重新记录)的时刻
+} sle_seen_entry_t;
+
+static sle_seen_entry_t g_seen_cache[SLE_SEEN_CACHE_SIZE];
+
+// FNV-1a，地址末几个字节常常相同，逐字节混合后再取低位
+static uint32_t sle_seen_hash(const uint8_t *addr, uint8_t kind)
+{
+    uint32_t h = 2166136261U;
+    for (uint8_t i = 0; i < SLE_SEEN_CACHE_ADDR_LEN; i++) {
+        h = (h ^ addr[i]) * 16777619U;
+    }
+    return (h ^ kind) * 16777619U;
+}
+
+void sle_seen_cache_reset(void)
+{
+    memset(g_seen_cache, 0, sizeof(g_seen_cache));
+}
+
+bool sle_seen_cache_check(const uint8_t *addr, uint8_t kind, uint32_t now)
+{
+    if (addr == NULL) {
+        return false;
+    }
+
+    uint32_t base = sle_seen_hash(addr, kind);
+    sle_seen_entry_t *victim = NULL;
+    for (uint8_t i = 0; i < SLE_SEEN_CACHE_PROBE; i++) {
+        sle_seen_entry_t *e = &g_seen_cache[(base + i) & (SLE_SEEN_CACHE_SIZE - 1)];
+        if (!e->used) {
+            if (victim == NULL || victim->used) {
+                victim = e;
+            }
+            continue;
+        }
+        if (e->kind == kind && memcmp(e->addr, addr, SLE_SEEN_CACHE_ADDR_LEN) == 0) {
+            if (now - e->tick < SLE_SEEN_CACHE_TTL_MS) {
+                return true;
+            }
+            e->tick = now;
+            return false;
+        }
+        if (victim == NULL || (victim->used && (int32_t)(e->tick - victim->tick) < 0)) {
+            victim = e;
+        }
+    }
+
+    memcpy(victim->addr, addr, SLE_SEEN_CACHE_ADDR_LEN);
+    victim->kind = kind;
+    victim->used = true;
+    victim->tick = now;
+    return false;
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2024 HiSilicon Technologies CO., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SLE_SEEN_CACHE_H
+#define SLE_SEEN_CACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+#endif /* __cplusplus */
+
+// 最近扫描到的设备地址表: 定长哈希表，按地址散列后在相邻几个槽位中查找，满时替换最旧的记录
+#define SLE_SEEN_CACHE_SIZE         32      // 必须是2的幂
+#define SLE_SEEN_CACHE_PROBE        4
+#define SLE_SEEN_CACHE_ADDR_LEN     6
+
+// 同一地址同一类上报(广播/扫描响应)在此时长内重复出现时被丢弃，过期后重新交给扫描回调判断
+#ifndef SLE_SEEN_CACHE_TTL_MS
+#define SLE_SEEN_CACHE_TTL_MS       1000
+#endif
+
+/**
+ * @brief  清空地址表，每轮扫描开始时调用
+ * @note   地址表本身不加锁，调用者负责与扫描回调之间的互斥
+ */
+void sle_seen_cache_reset(void);
+
+/**
+ * @brief  查询并记录一个地址
+ * @param  addr: 设备地址
+ * @param  kind: 上报类型 (扫描结果的 event_type)，主动扫描时广播和扫描响应分开记录
+ * @param  now: 当前时刻(ms)
+ * @retval true: 有效期内已经见过，应丢弃；false: 首次出现或已过期，已记录
+ */
+bool sle_seen_cache_check(const uint8_t *addr, uint8_t kind, uint32_t now);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* __cplusplus */
+
+#endif /* SLE_SEEN_CACHE_H */
@@ -32,6 +32,8 @@
 #include "oled_ssd1306_ws63.h"
 #include "wifi_sta_connect_ws63.h"
 #include "udp_server_ws63.h"
+#include "sle_client.h"
+#include "sle_cargo_history.h"
 
 // 全局变量：保存UDP socket和客户端地址
 static int g_sockfd = -1;
@@ -254,6 +256,187 @@ void UdpServerDemo(void *arg)
                     printf("[UDP]send cargo status: %s\r\n", cargo_response);
                 }
 
+            } else if (strstr(recvData, "_sle_stats") != NULL) {
+                printf("SLE telemetry request received\r\n");
+                recvDataFlag = -1;
+
+                // 星闪链路遥测: RSSI、写时延分位与直方图、写请求计数、断开原因、已连接/寻找中时长
+                static char stats_response[SLE_CARGO_TELEM_LINE_LEN + 128];
+                sle_cargo_telem_t telem;
+                sle_client_get_telemetry(&telem);
+                int head = snprintf(stats_response, sizeof(stats_response), "SLE_STATS:");
+                head += sle_cargo_telem_format(&telem, osKernelGetTickCount(), stats_response + head,
+                                               (uint16_t)(sizeof(stats_response) - head));
+                // 发件箱深度与断开/回放耗时，用于按最长断开时长确定发件箱大小
+                sle_outbox_stats_t ob;
+                sle_client_get_outbox_stats(&ob);
+                snprintf(stats_response + head, sizeof(stats_response) - head,
+                         " outbox=%u/%u max=%u drop=%u merge=%u outage_max=%u drain_last=%u drain_max=%u",
+                         ob.depth, ob.capacity, ob.depth_max, ob.dropped, ob.merged, ob.outage_max_ms,
+                         ob.drain_last_ms, ob.drain_max_ms);
+
+                ssize_t sentLen = sendto(sServer, stats_response, strlen(stats_response), 0,
+                                         (struct sockaddr *)&remoteAddr, addrLen);
+                if (sentLen > 0) {
+                    printf("[UDP]send sle stats: %s\r\n", stats_response);
+                }
+
+            } else if (strstr(recvData, "_sle_scan") != NULL) {
+                printf("SLE scan request received:%s\r\n", recvData);
+                recvDataFlag = -1;
+
+                // _sle_scan[:0|1]，带参数时从下一轮扫描起关闭/启用地址表；返回广播计数和地址表开/关时扫描到连接的耗时，
+                // 在设备密集的现场交替开关并断开重连若干次，即可对比两种设置下的连接耗时
+                const char *args = strstr(recvData, "_sle_scan:");
+                unsigned int enable = 0;
+                if (args != NULL && sscanf(args + strlen("_sle_scan:"), "%u", &enable) == 1) {
+                    sle_client_set_seen_cache(enable != 0);
+                }
+                sle_client_scan_stats_t sc;
+                sle_client_get_scan_stats(&sc);
+                static char scan_response[256];
+                snprintf(scan_response, sizeof(scan_response),
+                         "SLE_SCAN:cache=%u seen=%u filtered=%u matched=%u ttc_on=%u/%u/%u ttc_off=%u/%u/%u",
+                         sc.seen_cache ? 1 : 0, sc.seen, sc.filtered, sc.matched, sc.ttc_on_count,
+                         (sc.ttc_on_count > 0) ? (uint32_t)(sc.ttc_on_sum_ms / sc.ttc_on_count) : 0,
+                         sc.ttc_on_last_ms, sc.ttc_off_count,
+                         (sc.ttc_off_count > 0) ? (uint32_t)(sc.ttc_off_sum_ms / sc.ttc_off_count) : 0,
+                         sc.ttc_off_last_ms);
+                ssize_t sentLen = sendto(sServer, scan_response, strlen(scan_response), 0,
+                                         (struct sockaddr *)&remoteAddr, addrLen);
+                if (sentLen > 0) {
+                    printf("[UDP]send sle scan: %s\r\n", scan_response);
+                }
+
+            } else if (strstr(recvData, "_sle_conn") != NULL) {
+                printf("SLE conn policy request received:%s\r\n", recvData);
+                recvDataFlag = -1;
+
+                // _sle_conn[:空闲毫秒数]，带参数时设置切换到空闲连接参数的时长；返回各63B的档位和各档位写时延
+                const char *args = strstr(recvData, "_sle_conn:");
+                unsigned int idle_ms = 0;
+                if (args != NULL && sscanf(args + strlen("_sle_conn:"), "%u", &idle_ms) == 1 && idle_ms > 0) {
+                    sle_client_set_conn_idle_ms(idle_ms);
+                }
+                static char conn_response[SLE_CLIENT_PEER_MAX * 320 + 16];
+                int len = snprintf(conn_response, sizeof(conn_response), "SLE_CONN:");
+                for (uint8_t i = 0; i < SLE_CLIENT_PEER_MAX && len < (int)sizeof(conn_response); i++) {
+                    sle_cargo_conn_policy_t policy;
+                    if (!sle_client_get_conn_policy(i, &policy)) {
+                        continue;
+                    }
+                    len += snprintf(conn_response + len, sizeof(conn_response) - len, "#%u ", i + 1);
+                    if (len < (int)sizeof(conn_response)) {
+                        len += sle_cargo_conn_policy_format(&policy, conn_response + len,
+                                                            (uint16_t)(sizeof(conn_response) - len));
+                    }
+                    if (len < (int)sizeof(conn_response) - 1) {
+                        conn_response[len++] = ';';
+                        conn_response[len] = '\0';
+                    }
+                }
+                ssize_t sentLen = sendto(sServer, conn_response, strlen(conn_response), 0,
+                                         (struct sockaddr *)&remoteAddr, addrLen);
+                if (sentLen > 0) {
+                    printf("[UDP]send sle conn: %s\r\n", conn_response);
+                }
+
+            } else if (strstr(recvData, "_sle_phy") != NULL) {
+                printf("SLE phy request received:%s\r\n", recvData);
+                recvDataFlag = -1;
+
+                // _sle_phy[:0|1]，带参数时禁止/允许切换到高速PHY；返回各63B当前的PHY、双方能力、回退计数和各PHY上的有效吞吐
+                const char *args = strstr(recvData, "_sle_phy:");
+                unsigned int enable = 0;
+                if (args != NULL && sscanf(args + strlen("_sle_phy:"), "%u", &enable) == 1) {
+                    sle_client_set_phy_policy(enable != 0);
+                }
+                static char phy_response[SLE_CLIENT_PEER_MAX * 256 + 16];
+                int len = snprintf(phy_response, sizeof(phy_response), "SLE_PHY:");
+                for (uint8_t i = 0; i < SLE_CLIENT_PEER_MAX && len < (int)sizeof(phy_response); i++) {
+                    sle_cargo_phy_link_t phy;
+                    if (!sle_client_get_phy(i, &phy)) {
+                        continue;
+                    }
+                    len += snprintf(phy_response + len, sizeof(phy_response) - len, "#%u ", i + 1);
+                    if (len < (int)sizeof(phy_response)) {
+                        len += sle_cargo_phy_format(&phy, phy_response + len, (uint16_t)(sizeof(phy_response) - len));
+                    }
+                    if (len < (int)sizeof(phy_response) - 1) {
+                        phy_response[len++] = ';';
+                        phy_response[len] = '\0';
+                    }
+                }
+                ssize_t sentLen = sendto(sServer, phy_response, strlen(phy_response), 0,
+                                         (struct sockaddr *)&remoteAddr, addrLen);
+                if (sentLen > 0) {
+                    printf("[UDP]send sle phy: %s\r\n", phy_response);
+                }
+
+            } else if (strstr(recvData, "_sle_hist") != NULL) {
+                printf("SLE history request received:%s\r\n", recvData);
+                recvDataFlag = -1;
+
+                // _sle_hist[:级别[,桶数]]，级别0为10秒一桶的1小时、1为1分钟一桶的1天；63B分块回复，结果打印在串口
+                unsigned int tier = SLE_CARGO_HIST_FINE;
+                unsigned int buckets = 0;
+                const char *args = strstr(recvData, "_sle_hist:");
+                if (args != NULL) {
+                    sscanf(args + strlen("_sle_hist:"), "%u,%u", &tier, &buckets);
+                }
+                errcode_t ret = sle_client_request_history((uint8_t)tier, (uint16_t)buckets);
+                const char *reply = (ret == ERRCODE_SUCC) ? "SLE_HIST:REQUESTED" :
+                                    (ret == SLE_CLIENT_ERRCODE_BUSY) ? "SLE_HIST:BUSY" : "SLE_HIST:FAIL";
+                sendto(sServer, reply, strlen(reply), 0, (struct sockaddr *)&remoteAddr, addrLen);
+
+            } else if (strstr(recvData, "_sle_bench_stop") != NULL) {
+                printf("SLE bench stop request received\r\n");
+                recvDataFlag = -1;
+                sle_client_bench_stop();
+                sendto(sServer, "SLE_BENCH:STOP", strlen("SLE_BENCH:STOP"), 0, (struct sockaddr *)&remoteAddr, addrLen);
+
+            } else if (strstr(recvData, "_sle_bench_result") != NULL) {
+                printf("SLE bench result request received\r\n");
+                recvDataFlag = -1;
+
+                // 63B最近一次回报的压测结果
+                static char bench_response[192];
+                sle_cargo_bench_report_t report;
+                if (sle_client_get_bench_report(&report)) {
+                    uint32_t loss = sle_cargo_bench_loss_bp(&report);
+                    snprintf(bench_response, sizeof(bench_response),
+                             "SLE_BENCH:run=%u len=%u frames=%u kbps=%u lost=%u loss=%u.%02u%% reord=%u dup=%u "
+                             "jitter=%u ms=%u%s", report.run_id, report.frame_len, report.frames,
+                             sle_cargo_bench_bps(&report) / 1000, report.lost, loss / 100, loss % 100,
+                             report.reordered, report.dups, report.jitter_us, report.elapsed_ms,
+                             ((report.flags & SLE_CARGO_BENCH_LAST) != 0) ? " final" : "");
+                } else {
+                    snprintf(bench_response, sizeof(bench_response), "SLE_BENCH:NONE");
+                }
+                ssize_t sentLen = sendto(sServer, bench_response, strlen(bench_response), 0,
+                                         (struct sockaddr *)&remoteAddr, addrLen);
+                if (sentLen > 0) {
+                    printf("[UDP]send sle bench: %s\r\n", bench_response);
+                }
+
+            } else if (strstr(recvData, "_sle_bench") != NULL) {
+                printf("SLE bench request received:%s\r\n", recvData);
+                recvDataFlag = -1;
+
+                // _sle_bench[:长度,每秒帧数,秒数[,req]]，省略参数时使用默认值，每秒帧数为0表示不限速
+                unsigned int len = SLE_CLIENT_BENCH_LEN;
+                unsigned int rate = SLE_CLIENT_BENCH_RATE;
+                unsigned int secs = SLE_CLIENT_BENCH_DURATION_MS / 1000;
+                const char *args = strstr(recvData, "_sle_bench:");
+                if (args != NULL) {
+                    sscanf(args + strlen("_sle_bench:"), "%u,%u,%u", &len, &rate, &secs);
+                }
+                sle_client_write_mode_t mode = (strstr(recvData, ",req") != NULL) ? SLE_CLIENT_WRITE_REQ :
+                                               SLE_CLIENT_BENCH_MODE;
+                errcode_t ret = sle_client_bench_start((uint16_t)len, (uint16_t)rate, secs * 1000, mode);
+                const char *reply = (ret == ERRCODE_SUCC) ? "SLE_BENCH:START" : "SLE_BENCH:FAIL";
+                sendto(sServer, reply, strlen(reply), 0, (struct sockaddr *)&remoteAddr, addrLen);
+
             } else if (strstr(recvData, "UnoladPage") != NULL) {
                 printf("The applet exits the current interface\r\n");
 
@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 2024 HiSilicon Technologies CO., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "sle_cargo_bench.h"
+#include <string.h>
+
+void sle_cargo_bench_tx_start(sle_cargo_bench_tx_t *tx, const sle_cargo_bench_cfg_t *cfg, uint32_t now)
+{
+    if (tx == NULL || cfg == NULL) {
+        return;
+    }
+    tx->cfg = *cfg;
+    if (tx->cfg.frame_len < SLE_CARGO_BENCH_HDR_LEN) {
+        tx->cfg.frame_len = SLE_CARGO_BENCH_HDR_LEN;
+    } else if (tx->cfg.frame_len > SLE_CARGO_BENCH_FRAME_MAX) {
+        tx->cfg.frame_len = SLE_CARGO_BENCH_FRAME_MAX;
+    }
+    tx->active = true;
+    tx->run_id++;
+    tx->seq = 0;
+    tx->start_tick = now;
+    tx->last = false;
+}
+
+uint32_t sle_cargo_bench_tx_due(const sle_cargo_bench_tx_t *tx, uint32_t now)
+{
+    if (tx == NULL || !tx->active || tx->last) {
+        return 0;
+    }
+    uint32_t elapsed = now - tx->start_tick;
+    if (elapsed >= tx->cfg.duration_ms) {
+        // 只剩最后一帧
+        return 1;
+    }
+    if (tx->cfg.rate_hz == 0) {
+        return SLE_CARGO_BENCH_BURST_MAX;
+    }
+    // 开始以来应发的帧数，落后太多时一次最多补一批，避免长时间占用发送锁
+    uint32_t target = (uint32_t)((uint64_t)elapsed * tx->cfg.rate_hz / 1000) + 1;
+    if (target <= tx->seq) {
+        return 0;
+    }
+    uint32_t due = target - tx->seq;
+    return (due < SLE_CARGO_BENCH_BURST_MAX) ? due : SLE_CARGO_BENCH_BURST_MAX;
+}
+
+uint32_t sle_cargo_bench_tx_wait(const sle_cargo_bench_tx_t *tx, uint32_t now)
+{
+    if (tx == NULL || !tx->active || tx->last) {
+        return UINT32_MAX;
+    }
+    uint32_t elapsed = now - tx->start_tick;
+    if (elapsed >= tx->cfg.duration_ms) {
+        return 0;
+    }
+    uint32_t left = tx->cfg.duration_ms - elapsed;
+    if (tx->cfg.rate_hz == 0) {
+        return 1;
+    }
+    // 第 seq 帧的应发时刻
+    uint32_t next = (uint32_t)((uint64_t)tx->seq * 1000 / tx->cfg.rate_hz);
+    uint32_t wait = (next > elapsed) ? (next - elapsed) : 0;
+    return (wait < left) ? wait : left;
+}
+
+uint16_t sle_cargo_bench_tx_next(sle_cargo_bench_tx_t *tx, uint16_t len, uint32_t now, uint32_t now_us,
+                                 uint8_t *buf, uint16_t cap)
+{
+    if (tx == NULL || !tx->active || tx->last || buf == NULL) {
+        return 0;
+    }
+    sle_cargo_bench_t bench = {
+        .run_id = tx->run_id,
+        .flags = 0,
+        .seq = tx->seq,
+        .tx_us = now_us,
+        .len = (tx->cfg.frame_len < len) ? tx->cfg.frame_len : len,
+    };
+    if ((uint32_t)(now - tx->start_tick) >= tx->cfg.duration_ms) {
+        bench.flags = SLE_CARGO_BENCH_LAST;
+    }
+    uint16_t out = sle_cargo_encode_bench(buf, cap, &bench);
+    if (out == 0) {
+        return 0;
+    }
+    tx->seq++;
+    tx->last = (bench.flags & SLE_CARGO_BENCH_LAST) != 0;
+    return out;
+}
+
+void sle_cargo_bench_tx_cancel(sle_cargo_bench_tx_t *tx)
+{
+    if (tx == NULL || tx->seq == 0) {
+        return;
+    }
+    tx->seq--;
+    tx->last = false;
+}
+
+// 开始新的一轮
+static void bench_rx_begin(sle_cargo_bench_rx_t *rx, uint16_t link, const sle_cargo_bench_t *bench, uint32_t now)
+{
+    memset(rx, 0, sizeof(*rx));
+    rx->active = true;
+    rx->run_id = bench->run_id;
+    rx->link = link;
+    rx->first_tick = now;
+    rx->report_tick = now;
+    rx->max_seq = bench->seq;
+}
+
+bool sle_cargo_bench_rx_push(sle_cargo_bench_rx_t *rx, uint16_t link, const sle_cargo_bench_t *bench, uint32_t now,
+                             uint32_t now_us)
+{
+    if (rx == NULL || bench == NULL) {
+        return false;
+    }
+    if (rx->active && rx->finished && rx->run_id == bench->run_id && rx->link == link) {
+        // 已结束的轮次迟到的帧只计为重复，不再计入字节数和时长，也不再触发报告
+        rx->frames++;
+        rx->dups++;
+        return false;
+    }
+    bool fresh = false;
+    if (!rx->active || rx->run_id != bench->run_id || rx->link != link) {
+        bench_rx_begin(rx, link, bench, now);
+        fresh = true;
+    }
+
+    rx->frames++;
+    rx->bytes += bench->len;
+    rx->frame_len = bench->len;
+    rx->last_tick = now;
+
+    // 序号窗口: 更大的序号右移窗口，更小的序号按位判断重复或乱序到达
+    if (fresh) {
+        rx->window = 1;
+    } else if (bench->seq > rx->max_seq) {
+        uint32_t shift = bench->seq - rx->max_seq;
+        rx->window = (shift >= SLE_CARGO_BENCH_WINDOW) ? 1 : ((rx->window << shift) | 1);
+        rx->max_seq = bench->seq;
+    } else {
+        uint32_t off = rx->max_seq - bench->seq;
+        if (off < SLE_CARGO_BENCH_WINDOW && (rx->window & (1UL << off)) != 0) {
+            rx->dups++;
+        } else {
+            // 超出窗口的旧序号无法区分重复，按乱序计
+            rx->reordered++;
+            if (off < SLE_CARGO_BENCH_WINDOW) {
+                rx->window |= 1UL << off;
+            }
+        }
+    }
+
+    // 到达间隔抖动: J += (|D| - J) / 16，D 为相邻两帧传输时间之差，两端时钟偏差相互抵消
+    int32_t transit = (int32_t)(now_us - bench->tx_us);
+    if (!fresh) {
+        int32_t d = transit - rx->transit_us;
+        uint32_t abs_d = (uint32_t)((d < 0) ? -d : d);
+        rx->jitter_q += abs_d - ((rx->jitter_q + 8) >> 4);
+    }
+    rx->transit_us = transit;
+
+    if ((bench->flags & SLE_CARGO_BENCH_LAST) != 0) {
+        rx->finished = true;
+        return true;
+    }
+    return (uint32_t)(now - rx->report_tick) >= SLE_CARGO_BENCH_REPORT_MS;
+}
+
+bool sle_cargo_bench_rx_expire(sle_cargo_bench_rx_t *rx, uint32_t now)
+{
+    if (rx == NULL || !rx->active || rx->finished || (uint32_t)(now - rx->last_tick) < SLE_CARGO_BENCH_IDLE_MS) {
+        return false;
+    }
+    rx->finished = true;
+    return true;
+}
+
+void sle_cargo_bench_rx_report(sle_cargo_bench_rx_t *rx, uint32_t now, sle_cargo_bench_report_t *report)
+{
+    if (rx == NULL || report == NULL) {
+        return;
+    }
+    memset(report, 0, sizeof(*report));
+    if (!rx->active) {
+        return;
+    }
+    // 应收帧数为最大序号+1，收到的不重复帧数少于它的部分计为丢失
+    uint32_t unique = rx->frames - rx->dups;
+    uint32_t expected = rx->max_seq + 1;
+    report->run_id = rx->run_id;
+    report->flags = rx->finished ? SLE_CARGO_BENCH_LAST : 0;
+    report->frames = rx->frames;
+    report->bytes = rx->bytes;
+    report->lost = (expected > unique) ? (expected - unique) : 0;
+    report->reordered = rx->reordered;
+    report->dups = rx->dups;
+    report->elapsed_ms = rx->last_tick - rx->first_tick;
+    report->jitter_us = rx->jitter_q >> 4;
+    report->frame_len = rx->frame_len;
+    rx->report_tick = now;
+}
+
+uint32_t sle_cargo_bench_bps(const sle_cargo_bench_report_t *report)
+{
+    if (report == NULL || report->elapsed_ms == 0) {
+        return 0;
+    }
+    return (uint32_t)((uint64_t)report->bytes * 8 * 1000 / report->elapsed_ms);
+}
+
+uint32_t sle_cargo_bench_loss_bp(const sle_cargo_bench_report_t *report)
+{
+    if (report == NULL) {
+        return 0;
+    }
+    uint32_t expected = report->frames - report->dups + report->lost;
+    if (expected == 0) {
+        return 0;
+    }
+    return (uint32_t)((uint64_t)report->lost * 10000 / expected);
+}
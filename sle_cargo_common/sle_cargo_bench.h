@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2024 HiSilicon Technologies CO., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SLE_CARGO_BENCH_H
+#define SLE_CARGO_BENCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sle_cargo_proto.h"
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+#endif /* __cplusplus */
+
+// 压测帧的最大长度，与双方请求的MTU一致；实际长度还受协商后的MTU限制
+#define SLE_CARGO_BENCH_FRAME_MAX       512
+// 不限速时每次最多连续提交的帧数，提交失败(缓冲区满)时提前停止
+#define SLE_CARGO_BENCH_BURST_MAX       16
+// 接收端: 运行中每隔多久回报一次，多久没有收到新帧视为本轮结束
+#define SLE_CARGO_BENCH_REPORT_MS       1000
+#define SLE_CARGO_BENCH_IDLE_MS         2000
+// 接收端判断重复/乱序的序号窗口 (位图宽度)
+#define SLE_CARGO_BENCH_WINDOW          32
+
+// 一轮压测的参数
+typedef struct {
+    uint16_t frame_len;                 // 每帧长度，SLE_CARGO_BENCH_HDR_LEN ~ SLE_CARGO_BENCH_FRAME_MAX
+    uint16_t rate_hz;                   // 每秒帧数，0表示不限速(填满发送窗口或协议栈缓冲区)
+    uint32_t duration_ms;               // 持续时长
+} sle_cargo_bench_cfg_t;
+
+// 发送端
+typedef struct {
+    bool active;
+    uint8_t run_id;
+    sle_cargo_bench_cfg_t cfg;
+    uint32_t seq;                       // 下一帧的序号，即已发出的帧数
+    uint32_t start_tick;
+    bool last;                          // 最后一帧已生成
+} sle_cargo_bench_tx_t;
+
+// 接收端
+typedef struct {
+    bool active;
+    uint8_t run_id;
+    uint16_t link;                      // 压测帧来源的链路
+    uint16_t frame_len;
+    uint32_t frames;
+    uint32_t bytes;
+    uint32_t dups;
+    uint32_t reordered;
+    uint32_t max_seq;                   // 收到的最大序号
+    uint32_t window;                    // 位i表示序号 max_seq-i 已收到
+    uint32_t first_tick;
+    uint32_t last_tick;
+    uint32_t report_tick;               // 上次回报的时刻
+    int32_t transit_us;                 // 上一帧的 接收时刻 - 发送时刻
+    uint32_t jitter_q;                  // 抖动 x 16
+    bool finished;                      // 收到最后一帧或空闲超时，结果保持到下一轮开始
+} sle_cargo_bench_rx_t;
+
+/**
+ * @brief  开始一轮压测，轮次编号加1
+ * @param  tx: 发送端状态
+ * @param  cfg: 压测参数，帧长度超出范围时截断
+ * @param  now: 当前时刻(ms)
+ */
+void sle_cargo_bench_tx_start(sle_cargo_bench_tx_t *tx, const sle_cargo_bench_cfg_t *cfg, uint32_t now);
+
+/**
+ * @brief  当前应当发出的帧数: 限速时按开始以来的应发帧数补齐，不限速时为 SLE_CARGO_BENCH_BURST_MAX
+ * @param  tx: 发送端状态
+ * @param  now: 当前时刻(ms)
+ * @retval 应发帧数，压测未运行或已发完时为0
+ */
+uint32_t sle_cargo_bench_tx_due(const sle_cargo_bench_tx_t *tx, uint32_t now);
+
+/**
+ * @brief  到下一帧应发时刻的等待时长
+ * @param  tx: 发送端状态
+ * @param  now: 当前时刻(ms)
+ * @retval 等待时长(ms)，压测未运行时为 UINT32_MAX
+ */
+uint32_t sle_cargo_bench_tx_wait(const sle_cargo_bench_tx_t *tx, uint32_t now);
+
+/**
+ * @brief  生成下一帧，持续时长已到时生成带 SLE_CARGO_BENCH_LAST 的最后一帧
+ * @param  tx: 发送端状态
+ * @param  len: 帧长度上限 (由MTU决定)，不小于 SLE_CARGO_BENCH_HDR_LEN
+ * @param  now: 当前时刻(ms)
+ * @param  now_us: 当前时刻(us)，写入帧中供接收端计算抖动
+ * @param  buf: 输出缓冲区
+ * @param  cap: 缓冲区容量
+ * @retval 帧长度，没有要发的帧时返回0
+ */
+uint16_t sle_cargo_bench_tx_next(sle_cargo_bench_tx_t *tx, uint16_t len, uint32_t now, uint32_t now_us,
+                                 uint8_t *buf, uint16_t cap);
+
+/**
+ * @brief  撤销最近一次 sle_cargo_bench_tx_next 生成的帧 (提交失败时调用)
+ * @param  tx: 发送端状态
+ */
+void sle_cargo_bench_tx_cancel(sle_cargo_bench_tx_t *tx);
+
+/**
+ * @brief  记录收到的一个压测帧，新的轮次编号重新开始统计
+ * @param  rx: 接收端状态
+ * @param  link: 来源链路
+ * @param  bench: 解码得到的压测帧
+ * @param  now: 当前时刻(ms)
+ * @param  now_us: 当前时刻(us)
+ * @retval 是否应当回报: 距上次回报满 SLE_CARGO_BENCH_REPORT_MS 或收到最后一帧
+ */
+bool sle_cargo_bench_rx_push(sle_cargo_bench_rx_t *rx, uint16_t link, const sle_cargo_bench_t *bench, uint32_t now,
+                             uint32_t now_us);
+
+/**
+ * @brief  空闲超时检查: 运行中超过 SLE_CARGO_BENCH_IDLE_MS 没有收到新帧时结束本轮
+ * @param  rx: 接收端状态
+ * @param  now: 当前时刻(ms)
+ * @retval 本次是否结束了一轮，结束时应当发送最终报告
+ */
+bool sle_cargo_bench_rx_expire(sle_cargo_bench_rx_t *rx, uint32_t now);
+
+/**
+ * @brief  生成当前结果
+ * @param  rx: 接收端状态
+ * @param  now: 当前时刻(ms)，记为本次回报时刻
+ * @param  report: 输出的结果，本轮已结束时带 SLE_CARGO_BENCH_LAST
+ */
+void sle_cargo_bench_rx_report(sle_cargo_bench_rx_t *rx, uint32_t now, sle_cargo_bench_report_t *report);
+
+/**
+ * @brief  由结果计算吞吐量
+ * @param  report: 压测结果
+ * @retval 每秒比特数，时长为0时返回0
+ */
+uint32_t sle_cargo_bench_bps(const sle_cargo_bench_report_t *report);
+
+/**
+ * @brief  由结果计算丢失率
+ * @param  report: 压测结果
+ * @retval 丢失率，单位0.01%
+ */
+uint32_t sle_cargo_bench_loss_bp(const sle_cargo_bench_report_t *report);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* __cplusplus */
+
+#endif /* SLE_CARGO_BENCH_H */
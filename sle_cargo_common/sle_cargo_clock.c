@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) 2024 HiSilicon Technologies CO., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "sle_cargo_clock.h"
+#include <stdio.h>
+#include <string.h>
+
+#define CLOCK_US_PER_MS     1000
+#define CLOCK_PPB_SCALE     1000000     // ppb x ms / 1e6 = us
+#define CLOCK_DRIFT_MAX_PPB 1000000     // 1000ppm，超出即为拟合异常
+
+// us 四舍五入到 ms
+static int32_t clock_round_ms(int64_t us)
+{
+    return (int32_t)((us >= 0) ? (us + CLOCK_US_PER_MS / 2) / CLOCK_US_PER_MS :
+                     -((-us + CLOCK_US_PER_MS / 2) / CLOCK_US_PER_MS));
+}
+
+// 本地时刻 t 的偏差估计 (相对 base，us)
+static int64_t clock_offset_at(const sle_cargo_clock_t *c, uint32_t t)
+{
+    return (int64_t)c->offset_us + (int64_t)c->drift_ppb * (int32_t)(t - c->ref_ms) / CLOCK_PPB_SCALE;
+}
+
+// 参与拟合的样本往返不超过最短往返的2倍加2ms，当前区间刚开始时可能只有一个慢回复，不能让它拉偏拟合
+static bool clock_rtt_good(const sle_cargo_clock_sample_t *s, uint16_t best_rtt)
+{
+    return s->rtt_ms <= (uint32_t)best_rtt * 2 + 2;
+}
+
+// 用 ring 中各区间的样本和当前区间的样本重新估计偏差和频差
+static void clock_estimate(sle_cargo_clock_t *c)
+{
+    const sle_cargo_clock_sample_t *all[SLE_CARGO_CLOCK_SAMPLES + 1];
+    uint8_t total = 0;
+    for (uint8_t i = 0; i < c->count; i++) {
+        all[total++] = &c->ring[(c->head + SLE_CARGO_CLOCK_SAMPLES - c->count + i) % SLE_CARGO_CLOCK_SAMPLES];
+    }
+    all[total++] = &c->pending;
+    const sle_cargo_clock_sample_t *best = all[0];
+    for (uint8_t i = 1; i < total; i++) {
+        best = (all[i]->rtt_ms < best->rtt_ms) ? all[i] : best;
+    }
+    const sle_cargo_clock_sample_t *points[SLE_CARGO_CLOCK_SAMPLES + 1];
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < total; i++) {
+        if (clock_rtt_good(all[i], best->rtt_ms)) {
+            points[n++] = all[i];
+        }
+    }
+
+    // 以最新样本为参考时刻，x 为相对它的毫秒数
+    c->ref_ms = c->pending.local_ms;
+    int64_t sx = 0;
+    int64_t sy = 0;
+    int32_t x_min = 0;
+    for (uint8_t i = 0; i < n; i++) {
+        int32_t x = (int32_t)(points[i]->local_ms - c->ref_ms);
+        sx += x;
+        sy += points[i]->offset_us;
+        x_min = (x < x_min) ? x : x_min;
+    }
+    if (n < 3 || -x_min < SLE_CARGO_CLOCK_DRIFT_SPAN_MS) {
+        // 跨度太短时斜率主要是量化噪声: 不估计频差，取往返最短的样本
+        c->drift_ppb = 0;
+        c->offset_us = best->offset_us;
+        return;
+    }
+
+    int32_t mx = (int32_t)(sx / n);
+    int32_t my = (int32_t)(sy / n);
+    int64_t cov = 0;
+    int64_t var = 0;
+    for (uint8_t i = 0; i < n; i++) {
+        int64_t dx = (int32_t)(points[i]->local_ms - c->ref_ms) - mx;
+        int64_t dy = points[i]->offset_us - my;
+        cov += dx * dy;
+        var += dx * dx;
+    }
+    int64_t drift = (var > 0) ? cov * CLOCK_PPB_SCALE / var : 0;
+    if (drift > CLOCK_DRIFT_MAX_PPB || drift < -CLOCK_DRIFT_MAX_PPB) {
+        drift = 0;
+    }
+    c->drift_ppb = (int32_t)drift;
+    c->offset_us = (int32_t)(my - drift * mx / CLOCK_PPB_SCALE);
+}
+
+static void clock_restart(sle_cargo_clock_t *c)
+{
+    uint32_t rejected = c->rejected;
+    uint32_t steps = c->steps;
+    memset(c, 0, sizeof(*c));
+    c->rejected = rejected;
+    c->steps = steps;
+}
+
+void sle_cargo_clock_init(sle_cargo_clock_t *c)
+{
+    if (c != NULL) {
+        memset(c, 0, sizeof(*c));
+    }
+}
+
+bool sle_cargo_clock_sample(sle_cargo_clock_t *c, uint32_t t1, uint32_t t2, uint32_t t3, uint32_t t4)
+{
+    if (c == NULL) {
+        return false;
+    }
+    int32_t total = (int32_t)(t4 - t1);
+    int32_t turn = (int32_t)(t3 - t2);
+    // 毫秒计数的量化可使往返算出-1
+    int32_t rtt = total - turn;
+    if (total < 0 || turn < 0 || rtt < -1 || rtt > SLE_CARGO_CLOCK_RTT_MAX_MS) {
+        c->rejected++;
+        return false;
+    }
+
+    // 偏差 = (t2-t1) - rtt/2
+    uint32_t d1 = t2 - t1;
+    if (!c->has_base) {
+        c->base_ms = d1;
+        c->has_base = true;
+    }
+    sle_cargo_clock_sample_t s;
+    s.local_ms = t1 + (uint32_t)total / 2;
+    s.offset_us = (int32_t)(d1 - c->base_ms) * CLOCK_US_PER_MS - rtt * (CLOCK_US_PER_MS / 2);
+    s.rtt_ms = (uint16_t)((rtt > 0) ? rtt : 0);
+
+    // 往返正常却远离预测: 对端重启或计数器被重设，丢弃旧估计
+    if (sle_cargo_clock_synced(c) && clock_rtt_good(&s, c->rtt_min_ms)) {
+        int64_t err = (int64_t)s.offset_us - clock_offset_at(c, s.local_ms);
+        if (err > SLE_CARGO_CLOCK_STEP_US || err < -SLE_CARGO_CLOCK_STEP_US) {
+            c->steps++;
+            clock_restart(c);
+            return sle_cargo_clock_sample(c, t1, t2, t3, t4);
+        }
+    }
+
+    if (!c->has_pending) {
+        c->pending = s;
+        c->pending_start = s.local_ms;
+        c->has_pending = true;
+    } else if ((int32_t)(s.local_ms - c->pending_start) >= SLE_CARGO_CLOCK_INTERVAL_MS) {
+        c->ring[c->head] = c->pending;
+        c->head = (uint8_t)((c->head + 1) % SLE_CARGO_CLOCK_SAMPLES);
+        c->count = (c->count < SLE_CARGO_CLOCK_SAMPLES) ? (uint8_t)(c->count + 1) : c->count;
+        c->pending = s;
+        c->pending_start = s.local_ms;
+    } else if (s.rtt_ms <= c->pending.rtt_ms) {
+        c->pending = s;
+    }
+    clock_estimate(c);
+
+    c->samples++;
+    c->rtt_last_ms = s.rtt_ms;
+    if (c->samples == 1 || s.rtt_ms < c->rtt_min_ms) {
+        c->rtt_min_ms = s.rtt_ms;
+    }
+    return true;
+}
+
+bool sle_cargo_clock_synced(const sle_cargo_clock_t *c)
+{
+    return c != NULL && c->samples >= SLE_CARGO_CLOCK_MIN_SAMPLES;
+}
+
+bool sle_cargo_clock_to_local(const sle_cargo_clock_t *c, uint32_t remote_ms, uint32_t *local_ms)
+{
+    if (!sle_cargo_clock_synced(c) || local_ms == NULL) {
+        return false;
+    }
+    // 先按参考时刻的偏差粗略换算，再按该时刻计入频差
+    uint32_t approx = remote_ms - c->base_ms - (uint32_t)clock_round_ms(c->offset_us);
+    *local_ms = remote_ms - c->base_ms - (uint32_t)clock_round_ms(clock_offset_at(c, approx));
+    return true;
+}
+
+uint32_t sle_cargo_clock_offset_ms(const sle_cargo_clock_t *c, uint32_t now)
+{
+    if (c == NULL || !c->has_base) {
+        return 0;
+    }
+    return c->base_ms + (uint32_t)clock_round_ms(clock_offset_at(c, now));
+}
+
+void sle_cargo_clock_lat_add(sle_cargo_clock_lat_t *lat, uint32_t origin, uint32_t now)
+{
+    if (lat == NULL) {
+        return;
+    }
+    int32_t ms = (int32_t)(now - origin);
+    if (ms < 0) {
+        lat->early++;
+        ms = 0;
+    }
+    uint32_t us = (uint32_t)ms * CLOCK_US_PER_MS;
+    lat->hist[sle_cargo_telem_lat_bucket(us)]++;
+    lat->count++;
+    lat->last_us = us;
+    if (us > lat->max_us) {
+        lat->max_us = us;
+    }
+}
+
+uint32_t sle_cargo_clock_lat_percentile(const sle_cargo_clock_lat_t *lat, uint8_t pct)
+{
+    if (lat == NULL) {
+        return 0;
+    }
+    return sle_cargo_telem_hist_percentile(lat->hist, lat->count, lat->max_us, pct);
+}
+
+uint16_t sle_cargo_clock_format(const sle_cargo_clock_t *c, uint32_t now, char *buf, uint16_t cap)
+{
+    if (c == NULL || buf == NULL || cap == 0) {
+        return 0;
+    }
+    int32_t ppb = c->drift_ppb;
+    uint32_t abs_ppb = (ppb < 0) ? (uint32_t)(-(int64_t)ppb) : (uint32_t)ppb;
+    int n = snprintf(buf, cap, "%s off=%dms drift=%s%u.%02uppm rtt=%u/%ums n=%u rej=%u steps=%u",
+                     sle_cargo_clock_synced(c) ? "synced" : "syncing", (int32_t)sle_cargo_clock_offset_ms(c, now),
+                     (ppb < 0) ? "-" : "", abs_ppb / 1000, (abs_ppb % 1000) / 10, c->rtt_last_ms, c->rtt_min_ms,
+                     c->samples, c->rejected, c->steps);
+    if (n < 0) {
+        buf[0] = '\0';
+        return 0;
+    }
+    return (uint16_t)((n < cap) ? n : (cap - 1));
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2024 HiSilicon Technologies CO., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SLE_CARGO_CLOCK_H
+#define SLE_CARGO_CLOCK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sle_cargo_telemetry.h"
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+#endif /* __cplusplus */
+
+// 两块板时钟的对时: 本地发出 t1，对端收到 t2、回复 t3，本地收到 t4，四个时刻都是各自的 osKernelGetTickCount。
+// 偏差 = ((t2-t1) + (t3-t4)) / 2，往返 = (t4-t1) - (t3-t2)；往返越短，偏差的误差上限 (往返的一半) 越小。
+// 每个区间只保留往返最短的一个样本，再对最近若干区间的样本做最小二乘拟合，斜率即两块板晶振的频差
+#ifndef SLE_CARGO_CLOCK_SAMPLES
+#define SLE_CARGO_CLOCK_SAMPLES         16      // 参与拟合的区间数
+#endif
+#ifndef SLE_CARGO_CLOCK_INTERVAL_MS
+#define SLE_CARGO_CLOCK_INTERVAL_MS     30000   // 每个区间的长度，16个区间覆盖最近8分钟
+#endif
+#define SLE_CARGO_CLOCK_MIN_SAMPLES     4       // 收到这么多有效样本后才视为已同步
+#define SLE_CARGO_CLOCK_RTT_MAX_MS      500     // 往返超过此值的样本丢弃
+#define SLE_CARGO_CLOCK_DRIFT_SPAN_MS   60000   // 拟合的样本跨度不足时不估计频差，频差按0
+#define SLE_CARGO_CLOCK_STEP_US         50000   // 往返正常的样本偏离预测超过此值时视为对端时钟跳变，重新估计
+
+// 单向时延直方图的档位与链路遥测相同 (按微秒的2的幂分档)
+#define SLE_CARGO_CLOCK_LAT_BUCKETS     SLE_CARGO_TELEM_LAT_BUCKETS
+
+// sle_cargo_clock_format 输出一行所需的缓冲区长度
+#define SLE_CARGO_CLOCK_LINE_LEN        128
+
+// 一个对时样本，偏差相对 base 保存，便于对任意两个不相关的计数器做有符号运算
+typedef struct {
+    uint32_t local_ms;                      // 样本时刻: t1 与 t4 的中点 (本地时钟)
+    int32_t offset_us;                      // 对端时钟减本地时钟，再减去 base
+    uint16_t rtt_ms;
+} sle_cargo_clock_sample_t;
+
+// 对一块对端板的时钟估计
+typedef struct {
+    bool has_base;
+    uint32_t base_ms;                       // 第一个样本的偏差 (ms)，之后的偏差都相对它保存
+    sle_cargo_clock_sample_t ring[SLE_CARGO_CLOCK_SAMPLES];
+    uint8_t head;
+    uint8_t count;
+    sle_cargo_clock_sample_t pending;       // 当前区间内往返最短的样本，区间结束后进入 ring
+    bool has_pending;
+    uint32_t pending_start;                 // 当前区间的开始时刻
+    // 估计结果: ref_ms 时刻的偏差，以及频差 (对端比本地每秒多走的纳秒数 / 1000，即 ppb)
+    uint32_t ref_ms;
+    int32_t offset_us;
+    int32_t drift_ppb;
+    // 统计
+    uint32_t samples;                       // 有效样本数
+    uint32_t rejected;                      // 往返过长或时刻不合理而丢弃的样本
+    uint32_t steps;                         // 检测到对端时钟跳变的次数
+    uint16_t rtt_last_ms;
+    uint16_t rtt_min_ms;
+} sle_cargo_clock_t;
+
+// 单向时延直方图
+typedef struct {
+    uint32_t hist[SLE_CARGO_CLOCK_LAT_BUCKETS];
+    uint32_t count;
+    uint32_t last_us;
+    uint32_t max_us;
+    uint32_t early;                         // 换算后早于源头时刻的样本，说明时钟估计误差大于时延，计为0
+} sle_cargo_clock_lat_t;
+
+/**
+ * @brief  清空时钟估计
+ * @param  c: 时钟估计
+ */
+void sle_cargo_clock_init(sle_cargo_clock_t *c);
+
+/**
+ * @brief  计入一次对时
+ * @param  c: 时钟估计
+ * @param  t1: 本地发出请求的时刻
+ * @param  t2: 对端收到请求的时刻 (对端时钟)
+ * @param  t3: 对端发出回复的时刻 (对端时钟)
+ * @param  t4: 本地收到回复的时刻
+ * @retval 样本是否有效
+ */
+bool sle_cargo_clock_sample(sle_cargo_clock_t *c, uint32_t t1, uint32_t t2, uint32_t t3, uint32_t t4);
+
+/**
+ * @brief  是否已有足够的样本可以换算对端时刻
+ * @param  c: 时钟估计
+ * @retval 是否已同步
+ */
+bool sle_cargo_clock_synced(const sle_cargo_clock_t *c);
+
+/**
+ * @brief  把对端时钟的时刻换算到本地时钟，计入频差
+ * @param  c: 时钟估计
+ * @param  remote_ms: 对端时刻
+ * @param  local_ms: 输出的本地时刻
+ * @retval 是否已同步，未同步时不输出
+ */
+bool sle_cargo_clock_to_local(const sle_cargo_clock_t *c, uint32_t remote_ms, uint32_t *local_ms);
+
+/**
+ * @brief  当前偏差估计 (对端时钟减本地时钟)
+ * @param  c: 时钟估计
+ * @param  now: 本地当前时刻
+ * @retval 偏差(ms)，按32位计数器取模
+ */
+uint32_t sle_cargo_clock_offset_ms(const sle_cargo_clock_t *c, uint32_t now);
+
+/**
+ * @brief  计入一个单向时延
+ * @param  lat: 直方图
+ * @param  origin: 源头时刻换算到本地时钟后的值
+ * @param  now: 到达时刻
+ */
+void sle_cargo_clock_lat_add(sle_cargo_clock_lat_t *lat, uint32_t origin, uint32_t now);
+
+/**
+ * @brief  单向时延的分位数，取所在档位的上界，不超过最大值
+ * @param  lat: 直方图
+ * @param  pct: 百分位 (1~100)
+ * @retval 时延(us)，没有样本时返回0
+ */
+uint32_t sle_cargo_clock_lat_percentile(const sle_cargo_clock_lat_t *lat, uint8_t pct);
+
+/**
+ * @brief  把时钟估计格式化为一行: 偏差、频差、往返和样本数
+ * @param  c: 时钟估计
+ * @param  now: 本地当前时刻
+ * @param  buf: 输出缓冲区，建议 SLE_CARGO_CLOCK_LINE_LEN
+ * @param  cap: 缓冲区容量
+ * @retval 写入的长度
+ */
+uint16_t sle_cargo_clock_format(const sle_cargo_clock_t *c, uint32_t now, char *buf, uint16_t cap);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* __cplusplus */
+
+#endif /* SLE_CARGO_CLOCK_H */
@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2024 HiSilicon Technologies CO., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "sle_cargo_connparam.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *g_conn_profile_names[SLE_CARGO_CONN_PROFILE_MAX] = { "default", "active", "idle" };
+
+void sle_cargo_conn_profile_param(uint8_t profile, sle_cargo_conn_param_t *param)
+{
+    if (param == NULL) {
+        return;
+    }
+    param->timeout = SLE_CARGO_CONN_TIMEOUT;
+    switch (profile) {
+        case SLE_CARGO_CONN_ACTIVE:
+            param->interval_min = SLE_CARGO_CONN_ACTIVE_INTERVAL_MIN;
+            param->interval_max = SLE_CARGO_CONN_ACTIVE_INTERVAL_MAX;
+            param->latency = 0;
+            break;
+        case SLE_CARGO_CONN_IDLE:
+            param->interval_min = SLE_CARGO_CONN_IDLE_INTERVAL;
+            param->interval_max = SLE_CARGO_CONN_IDLE_INTERVAL;
+            param->latency = SLE_CARGO_CONN_IDLE_LATENCY;
+            break;
+        default:
+            param->interval_min = SLE_CARGO_CONN_DEFAULT_INTERVAL;
+            param->interval_max = SLE_CARGO_CONN_DEFAULT_INTERVAL;
+            param->latency = SLE_CARGO_CONN_DEFAULT_LATENCY;
+            break;
+    }
+}
+
+const char *sle_cargo_conn_profile_name(uint8_t profile)
+{
+    return (profile < SLE_CARGO_CONN_PROFILE_MAX) ? g_conn_profile_names[profile] : "?";
+}
+
+uint8_t sle_cargo_conn_classify(uint16_t interval, uint16_t latency)
+{
+    if (interval <= SLE_CARGO_CONN_ACTIVE_INTERVAL_MAX && latency == 0) {
+        return SLE_CARGO_CONN_ACTIVE;
+    }
+    if (interval >= SLE_CARGO_CONN_IDLE_INTERVAL && latency <= SLE_CARGO_CONN_IDLE_LATENCY) {
+        return SLE_CARGO_CONN_IDLE;
+    }
+    return SLE_CARGO_CONN_DEFAULT;
+}
+
+void sle_cargo_conn_policy_init(sle_cargo_conn_policy_t *p, uint32_t idle_ms, uint32_t now)
+{
+    if (p == NULL) {
+        return;
+    }
+    memset(p, 0, sizeof(*p));
+    p->current = SLE_CARGO_CONN_DEFAULT;
+    p->idle_ms = idle_ms;
+    p->last_event_tick = now;
+    p->window_tick = now;
+}
+
+void sle_cargo_conn_policy_events(sle_cargo_conn_policy_t *p, uint16_t count, uint32_t now)
+{
+    if (p == NULL || count == 0) {
+        return;
+    }
+    uint32_t since = now - p->window_tick;
+    if (since >= 1000) {
+        // 中间隔了不止一个窗口时上一个窗口没有事件
+        p->rate = (since < 2000) ? p->window_events : 0;
+        p->window_tick = now;
+        p->window_events = 0;
+    }
+    p->window_events += count;
+    if (!p->flowing || (uint32_t)(now - p->last_event_tick) >= SLE_CARGO_CONN_BURST_GAP_MS) {
+        p->burst_first = true;
+    }
+    if (p->window_events >= SLE_CARGO_CONN_ACTIVE_EVENTS) {
+        p->flowing = true;
+    }
+    p->last_event_tick = now;
+}
+
+// 期望的档位: 货物流动中为分拣档位，最后一件货物之后满 idle_ms 为空闲档位，其余时间保持不变
+static uint8_t conn_policy_target(sle_cargo_conn_policy_t *p, uint32_t now)
+{
+    bool quiet = (uint32_t)(now - p->last_event_tick) >= p->idle_ms;
+    if (p->flowing && quiet) {
+        p->flowing = false;
+    }
+    if (p->flowing) {
+        return SLE_CARGO_CONN_ACTIVE;
+    }
+    return quiet ? SLE_CARGO_CONN_IDLE : p->current;
+}
+
+bool sle_cargo_conn_policy_poll(sle_cargo_conn_policy_t *p, uint32_t now, uint8_t *profile)
+{
+    if (p == NULL || profile == NULL) {
+        return false;
+    }
+    if (p->pending) {
+        if ((uint32_t)(now - p->request_tick) < SLE_CARGO_CONN_UPDATE_TIMEOUT_MS) {
+            return false;
+        }
+        // 没有等到结果，按失败处理，下次检查时重新请求
+        p->pending = false;
+        p->failures++;
+    }
+    uint8_t target = conn_policy_target(p, now);
+    if (target == p->current) {
+        p->throttled = false;
+        return false;
+    }
+    if (p->requested_once && (uint32_t)(now - p->request_tick) < SLE_CARGO_CONN_UPDATE_GAP_MS) {
+        if (!p->throttled) {
+            p->throttled = true;
+            p->throttles++;
+        }
+        return false;
+    }
+    p->pending = true;
+    p->requested = target;
+    p->request_tick = now;
+    p->requested_once = true;
+    p->throttled = false;
+    p->requests++;
+    *profile = target;
+    return true;
+}
+
+bool sle_cargo_conn_policy_updated(sle_cargo_conn_policy_t *p, bool ok, uint16_t interval, uint16_t latency,
+                                   uint32_t now)
+{
+    if (p == NULL) {
+        return false;
+    }
+    bool ours = p->pending;
+    p->pending = false;
+    if (!ok) {
+        p->failures++;
+        return false;
+    }
+    if (ours) {
+        p->apply_last_ms = now - p->request_tick;
+    }
+    uint8_t profile = sle_cargo_conn_classify(interval, latency);
+    p->switches++;
+    if (profile == p->current) {
+        return false;
+    }
+    p->current = profile;
+    return true;
+}
+
+uint32_t sle_cargo_conn_policy_wait(const sle_cargo_conn_policy_t *p, uint32_t now)
+{
+    if (p == NULL) {
+        return UINT32_MAX;
+    }
+    if (p->pending) {
+        uint32_t waited = now - p->request_tick;
+        return (waited < SLE_CARGO_CONN_UPDATE_TIMEOUT_MS) ? (SLE_CARGO_CONN_UPDATE_TIMEOUT_MS - waited) : 0;
+    }
+    if (p->throttled) {
+        uint32_t waited = now - p->request_tick;
+        return (waited < SLE_CARGO_CONN_UPDATE_GAP_MS) ? (SLE_CARGO_CONN_UPDATE_GAP_MS - waited) : 0;
+    }
+    if (p->current == SLE_CARGO_CONN_IDLE && !p->flowing) {
+        return UINT32_MAX;
+    }
+    uint32_t quiet = now - p->last_event_tick;
+    return (quiet < p->idle_ms) ? (p->idle_ms - quiet) : 0;
+}
+
+void sle_cargo_conn_policy_latency(sle_cargo_conn_policy_t *p, uint32_t latency_us)
+{
+    if (p == NULL || p->current >= SLE_CARGO_CONN_PROFILE_MAX) {
+        return;
+    }
+    sle_cargo_conn_lat_t *lat = &p->lat[p->current];
+    lat->writes++;
+    lat->sum_us += latency_us;
+    if (latency_us > lat->max_us) {
+        lat->max_us = latency_us;
+    }
+    if (p->burst_first) {
+        // 突发的第一件货物在切换生效前发出，反映的是突发开始时所处档位的唤醒时延
+        p->burst_first = false;
+        lat->first_writes++;
+        lat->first_sum_us += latency_us;
+        if (latency_us > lat->first_max_us) {
+            lat->first_max_us = latency_us;
+        }
+    }
+}
+
+static uint32_t conn_lat_avg(const sle_cargo_conn_lat_t *lat)
+{
+    return (lat->writes > 0) ? (uint32_t)(lat->sum_us / lat->writes) : 0;
+}
+
+uint16_t sle_cargo_conn_policy_format(const sle_cargo_conn_policy_t *p, char *buf, uint16_t cap)
+{
+    if (p == NULL || buf == NULL || cap == 0) {
+        return 0;
+    }
+    int n = snprintf(buf, cap, "%s%s rate=%u/s req=%u thr=%u fail=%u apply=%ums", sle_cargo_conn_profile_name(p->current),
+                     p->pending ? "*" : "", p->rate, p->requests, p->throttles, p->failures, p->apply_last_ms);
+    for (uint8_t i = 0; i < SLE_CARGO_CONN_PROFILE_MAX && n > 0 && n < cap; i++) {
+        const sle_cargo_conn_lat_t *lat = &p->lat[i];
+        uint32_t first = (lat->first_writes > 0) ? (uint32_t)(lat->first_sum_us / lat->first_writes) : 0;
+        n += snprintf(buf + n, cap - n, " | %s n=%u avg=%uus max=%uus first=%uus", sle_cargo_conn_profile_name(i),
+                      lat->writes, conn_lat_avg(lat), lat->max_us, first);
+    }
+    // 分拣档位相对建立连接时参数 (没有样本时相对空闲档位) 的平均写时延降低比例
+    const sle_cargo_conn_lat_t *base = &p->lat[SLE_CARGO_CONN_DEFAULT];
+    if (base->writes == 0) {
+        base = &p->lat[SLE_CARGO_CONN_IDLE];
+    }
+    uint32_t base_avg = conn_lat_avg(base);
+    uint32_t active_avg = conn_lat_avg(&p->lat[SLE_CARGO_CONN_ACTIVE]);
+    if (n > 0 && n < cap && base_avg > 0 && active_avg > 0) {
+        int32_t gain = (int32_t)(((int64_t)base_avg - active_avg) * 100 / base_avg);
+        n += snprintf(buf + n, cap - n, " | gain=%d%%", (int)gain);
+    }
+    if (n < 0) {
+        buf[0] = '\0';
+        return 0;
+    }
+    return (uint16_t)((n < cap) ? n : (cap - 1));
+}
@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2024 HiSilicon Technologies CO., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SLE_CARGO_CONNPARAM_H
+#define SLE_CARGO_CONNPARAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+#endif /* __cplusplus */
+
+// 连接参数: 间隔单位0.125ms，监督超时单位10ms
+// 建立连接时的参数，两块板一致 (官方demo: 12.5ms，从机可跳过最多0x1F3个连接事件)
+#define SLE_CARGO_CONN_DEFAULT_INTERVAL     0x64
+#define SLE_CARGO_CONN_DEFAULT_LATENCY      0x1F3
+#define SLE_CARGO_CONN_TIMEOUT              0x1F4
+// 分拣中: 7.5~10ms，从机不跳过连接事件，突发的第一件货物也不必等从机醒来
+#define SLE_CARGO_CONN_ACTIVE_INTERVAL_MIN  0x3C
+#define SLE_CARGO_CONN_ACTIVE_INTERVAL_MAX  0x50
+// 空闲: 100ms，仍不跳过连接事件，最坏等待一个间隔
+#define SLE_CARGO_CONN_IDLE_INTERVAL        0x320
+#define SLE_CARGO_CONN_IDLE_LATENCY         0
+
+// 1秒内的分拣事件达到该数量时切换到分拣档位
+#define SLE_CARGO_CONN_ACTIVE_EVENTS        1
+// 最后一件货物之后多久切换到空闲档位，可运行时调整
+#ifndef SLE_CARGO_CONN_IDLE_MS
+#define SLE_CARGO_CONN_IDLE_MS              10000
+#endif
+// 两次参数更新请求的最小间隔，以及等待更新结果的超时
+#define SLE_CARGO_CONN_UPDATE_GAP_MS        2000
+#define SLE_CARGO_CONN_UPDATE_TIMEOUT_MS    3000
+// 距上一件货物超过该时长的事件视为新一轮突发的开始
+#define SLE_CARGO_CONN_BURST_GAP_MS         1000
+
+// 连接参数档位
+typedef enum {
+    SLE_CARGO_CONN_DEFAULT = 0,             // 建立连接时的参数
+    SLE_CARGO_CONN_ACTIVE,
+    SLE_CARGO_CONN_IDLE,
+    SLE_CARGO_CONN_PROFILE_MAX,
+} sle_cargo_conn_profile_t;
+
+typedef struct {
+    uint16_t interval_min;
+    uint16_t interval_max;
+    uint16_t latency;                       // 从机可跳过的连接事件数
+    uint16_t timeout;
+} sle_cargo_conn_param_t;
+
+// 某个档位生效期间的写时延
+typedef struct {
+    uint32_t writes;
+    uint64_t sum_us;
+    uint32_t max_us;
+    uint32_t first_writes;                  // 其中作为突发第一件货物的写入
+    uint64_t first_sum_us;
+    uint32_t first_max_us;
+} sle_cargo_conn_lat_t;
+
+// 一条连接的参数策略: 按分拣事件的速率选择档位，请求限速，统计各档位的写时延
+typedef struct {
+    uint8_t current;                        // 已生效的档位
+    uint8_t requested;                      // 在途请求的档位
+    bool pending;
+    bool flowing;                           // 货物在流动中
+    bool throttled;                         // 本次切换已因限速推迟过
+    bool burst_first;                       // 下一次写时延是突发的第一件货物
+    bool requested_once;
+    uint32_t idle_ms;
+    uint32_t request_tick;
+    uint32_t last_event_tick;
+    uint32_t window_tick;                   // 当前1秒窗口的开始时刻
+    uint16_t window_events;
+    uint16_t rate;                          // 上一个1秒窗口的事件数
+    // 统计
+    uint32_t requests;
+    uint32_t throttles;                     // 因限速推迟的切换
+    uint32_t failures;                      // 请求失败、被拒绝或超时
+    uint32_t switches;                      // 生效的参数更新次数 (含对端发起的)
+    uint32_t apply_last_ms;                 // 最近一次请求到生效的耗时
+    sle_cargo_conn_lat_t lat[SLE_CARGO_CONN_PROFILE_MAX];
+} sle_cargo_conn_policy_t;
+
+/**
+ * @brief  档位对应的连接参数
+ * @param  profile: 档位 (sle_cargo_conn_profile_t)
+ * @param  param: 输出的参数
+ */
+void sle_cargo_conn_profile_param(uint8_t profile, sle_cargo_conn_param_t *param);
+
+/**
+ * @brief  档位名称
+ * @param  profile: 档位
+ * @retval 名称
+ */
+const char *sle_cargo_conn_profile_name(uint8_t profile);
+
+/**
+ * @brief  按实际生效的参数判断档位，对端或协议栈调整后的参数也能归类
+ * @param  interval: 连接间隔
+ * @param  latency: 从机可跳过的连接事件数
+ * @retval 档位
+ */
+uint8_t sle_cargo_conn_classify(uint16_t interval, uint16_t latency);
+
+/**
+ * @brief  连接建立后开始，当前档位为 SLE_CARGO_CONN_DEFAULT，统计清零
+ * @param  p: 策略状态
+ * @param  idle_ms: 最后一件货物之后多久切换到空闲档位
+ * @param  now: 当前时刻(ms)
+ */
+void sle_cargo_conn_policy_init(sle_cargo_conn_policy_t *p, uint32_t idle_ms, uint32_t now);
+
+/**
+ * @brief  记录发出的分拣事件
+ * @param  p: 策略状态
+ * @param  count: 事件数
+ * @param  now: 当前时刻(ms)
+ */
+void sle_cargo_conn_policy_events(sle_cargo_conn_policy_t *p, uint16_t count, uint32_t now);
+
+/**
+ * @brief  检查是否需要切换档位，限速和在途请求都满足时记为已请求
+ * @param  p: 策略状态
+ * @param  now: 当前时刻(ms)
+ * @param  profile: 需要请求时输出目标档位
+ * @retval 是否应当发出参数更新请求
+ */
+bool sle_cargo_conn_policy_poll(sle_cargo_conn_policy_t *p, uint32_t now, uint8_t *profile);
+
+/**
+ * @brief  参数更新结果，请求提交失败时也以 ok=false 调用
+ * @param  p: 策略状态
+ * @param  ok: 是否成功
+ * @param  interval: 生效的连接间隔
+ * @param  latency: 生效的从机延迟
+ * @param  now: 当前时刻(ms)
+ * @retval 生效的档位是否变化
+ */
+bool sle_cargo_conn_policy_updated(sle_cargo_conn_policy_t *p, bool ok, uint16_t interval, uint16_t latency,
+                                   uint32_t now);
+
+/**
+ * @brief  到下一次需要检查的等待时长 (空闲超时、限速到期或请求超时)
+ * @param  p: 策略状态
+ * @param  now: 当前时刻(ms)
+ * @retval 等待时长(ms)，没有待切换的档位时为 UINT32_MAX
+ */
+uint32_t sle_cargo_conn_policy_wait(const sle_cargo_conn_policy_t *p, uint32_t now);
+
+/**
+ * @brief  记录一次分拣数据写请求 (快照/增量帧，写命令没有确认) 的时延，计入当前档位
+ * @param  p: 策略状态
+ * @param  latency_us: 提交到写确认的时延
+ */
+void sle_cargo_conn_policy_latency(sle_cargo_conn_policy_t *p, uint32_t latency_us);
+
+/**
+ * @brief  格式化为一行文本: 当前档位、请求计数和各档位的写时延，用于日志和远程查询
+ * @param  p: 策略状态
+ * @param  buf: 输出缓冲区
+ * @param  cap: 缓冲区容量
+ * @retval 写入的长度(不含结尾的'\0')
+ */
+uint16_t sle_cargo_conn_policy_format(const sle_cargo_conn_policy_t *p, char *buf, uint16_t cap);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* __cplusplus */
+
+#endif /* SLE_CARGO_CONNPARAM_H */
@@ -0,0 +1,294 @@
+/*
+ * Copyright (c) 2024 HiSilicon Technologies CO., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "sle_cargo_frag.h"
+#include <string.h>
+
+void sle_cargo_frag_tx_reset(sle_cargo_frag_tx_t *tx)
+{
+    if (tx == NULL) {
+        return;
+    }
+    // 断开时协议栈不会再回写确认，在途计数一并清零
+    if (tx->active) {
+        tx->failed++;
+    }
+    tx->active = false;
+    tx->inflight = 0;
+    tx->stale = 0;
+}
+
+bool sle_cargo_frag_tx_start(sle_cargo_frag_tx_t *tx, uint8_t kind, const uint8_t *data, uint16_t len, uint32_t now)
+{
+    if (tx == NULL || data == NULL || len == 0 || len > SLE_CARGO_FRAG_MSG_MAX || tx->active) {
+        return false;
+    }
+
+    memcpy(tx->data, data, len);
+    tx->active = true;
+    tx->kind = kind;
+    tx->msg_id++;
+    tx->len = len;
+    tx->offset = 0;
+    tx->frag_seq = 0;
+    tx->last_len = 0;
+    tx->inflight = 0;
+    tx->retries = 0;
+    tx->start_tick = now;
+    return true;
+}
+
+bool sle_cargo_frag_tx_pending(const sle_cargo_frag_tx_t *tx)
+{
+    return tx != NULL && tx->active && tx->offset < tx->len;
+}
+
+uint16_t sle_cargo_frag_tx_next(sle_cargo_frag_tx_t *tx, uint16_t mtu, uint8_t *buf, uint16_t cap)
+{
+    if (!sle_cargo_frag_tx_pending(tx) || buf == NULL) {
+        return 0;
+    }
+
+    // 分片帧长度取 MTU 可用负载、帧上限和缓冲区容量中最小的一个
+    uint16_t frame_max = ((mtu != 0) ? mtu : SLE_CARGO_FRAG_MTU_MIN) - SLE_CARGO_FRAG_MTU_OVERHEAD;
+    if (frame_max > SLE_CARGO_FRAG_FRAME_MAX) {
+        frame_max = SLE_CARGO_FRAG_FRAME_MAX;
+    }
+    if (frame_max > cap) {
+        frame_max = cap;
+    }
+    if (frame_max <= SLE_CARGO_FRAG_HDR_LEN) {
+        return 0;
+    }
+
+    uint16_t left = (uint16_t)(tx->len - tx->offset);
+    uint16_t chunk = (uint16_t)(frame_max - SLE_CARGO_FRAG_HDR_LEN);
+    sle_cargo_frag_t frag = {
+        .msg_id = tx->msg_id,
+        .total_len = tx->len,
+        .offset = tx->offset,
+        .kind = tx->kind,
+        .data_len = (left < chunk) ? left : chunk,
+        .data = &tx->data[tx->offset],
+    };
+    uint16_t len = sle_cargo_encode_frag(buf, cap, tx->frag_seq, &frag);
+    if (len == 0) {
+        return 0;
+    }
+
+    tx->offset += frag.data_len;
+    tx->last_len = frag.data_len;
+    tx->frag_seq++;
+    tx->inflight++;
+    tx->fragments++;
+    return len;
+}
+
+void sle_cargo_frag_tx_cancel(sle_cargo_frag_tx_t *tx)
+{
+    if (tx == NULL || tx->last_len == 0 || tx->inflight == 0) {
+        return;
+    }
+    tx->offset -= tx->last_len;
+    tx->last_len = 0;
+    tx->frag_seq--;
+    tx->inflight--;
+    tx->fragments--;
+}
+
+sle_cargo_frag_tx_result_t sle_cargo_frag_tx_on_confirm(sle_cargo_frag_tx_t *tx, bool success, uint32_t now)
+{
+    if (tx == NULL) {
+        return SLE_CARGO_FRAG_TX_NONE;
+    }
+    // 确认按提交顺序返回: 先消耗上一轮发出的分片的确认
+    if (tx->stale > 0) {
+        tx->stale--;
+        return SLE_CARGO_FRAG_TX_NONE;
+    }
+    if (!tx->active || tx->inflight == 0) {
+        return SLE_CARGO_FRAG_TX_NONE;
+    }
+    tx->inflight--;
+    tx->last_len = 0;
+
+    if (!success) {
+        // 接收端只按序重组，缺一个分片整条消息作废；换新编号让对端立即释放旧槽位
+        tx->stale = tx->inflight;
+        tx->inflight = 0;
+        if (tx->retries >= SLE_CARGO_FRAG_TX_RETRY_MAX) {
+            tx->active = false;
+            tx->failed++;
+            return SLE_CARGO_FRAG_TX_FAILED;
+        }
+        tx->retries++;
+        tx->restarts++;
+        tx->msg_id++;
+        tx->offset = 0;
+        tx->frag_seq = 0;
+        return SLE_CARGO_FRAG_TX_RESTART;
+    }
+
+    if (tx->offset < tx->len || tx->inflight > 0) {
+        return SLE_CARGO_FRAG_TX_NONE;
+    }
+    tx->active = false;
+    tx->messages++;
+    tx->bytes += tx->len;
+    tx->last_ms = now - tx->start_tick;
+    return SLE_CARGO_FRAG_TX_DONE;
+}
+
+void sle_cargo_frag_rx_reset(sle_cargo_frag_rx_t *rx)
+{
+    if (rx == NULL) {
+        return;
+    }
+    memset(rx, 0, sizeof(*rx));
+}
+
+static sle_cargo_frag_slot_t *rx_find_link(sle_cargo_frag_rx_t *rx, uint16_t link)
+{
+    for (uint8_t i = 0; i < SLE_CARGO_FRAG_RX_SLOTS; i++) {
+        if (rx->slots[i].used && rx->slots[i].link == link) {
+            return &rx->slots[i];
+        }
+    }
+    return NULL;
+}
+
+static sle_cargo_frag_slot_t *rx_alloc(sle_cargo_frag_rx_t *rx)
+{
+    for (uint8_t i = 0; i < SLE_CARGO_FRAG_RX_SLOTS; i++) {
+        if (!rx->slots[i].used) {
+            return &rx->slots[i];
+        }
+    }
+    return NULL;
+}
+
+sle_cargo_frag_rx_result_t sle_cargo_frag_rx_push(sle_cargo_frag_rx_t *rx, uint16_t link, const sle_cargo_frag_t *frag,
+                                                  uint32_t now, sle_cargo_frag_msg_t *msg)
+{
+    if (rx == NULL || frag == NULL || msg == NULL || frag->data == NULL) {
+        return SLE_CARGO_FRAG_RX_DROPPED;
+    }
+    sle_cargo_frag_rx_expire(rx, now);
+    rx->fragments++;
+
+    sle_cargo_frag_slot_t *slot = rx_find_link(rx, link);
+    if (slot != NULL && slot->msg_id != frag->msg_id) {
+        // 同一链路上出现新编号: 发送端已放弃旧消息，未处理完的完整消息仍保留给调用者
+        if (slot->complete) {
+            rx->no_slot++;
+            return SLE_CARGO_FRAG_RX_DROPPED;
+        }
+        rx->abandoned++;
+        slot->used = false;
+        slot = NULL;
+    }
+
+    if (slot == NULL) {
+        if (frag->total_len > SLE_CARGO_FRAG_MSG_MAX) {
+            rx->too_long++;
+            return SLE_CARGO_FRAG_RX_DROPPED;
+        }
+        if (frag->offset != 0) {
+            // 没有收到首个分片，无法按序重组
+            rx->gaps++;
+            return SLE_CARGO_FRAG_RX_DROPPED;
+        }
+        slot = rx_alloc(rx);
+        if (slot == NULL) {
+            rx->no_slot++;
+            return SLE_CARGO_FRAG_RX_DROPPED;
+        }
+        slot->used = true;
+        slot->complete = false;
+        slot->link = link;
+        slot->msg_id = frag->msg_id;
+        slot->kind = frag->kind;
+        slot->len = frag->total_len;
+        slot->received = 0;
+    }
+
+    if (slot->complete || frag->offset + frag->data_len <= slot->received) {
+        rx->dups++;
+        return SLE_CARGO_FRAG_RX_DUP;
+    }
+    if (frag->offset != slot->received || frag->total_len != slot->len) {
+        rx->gaps++;
+        slot->used = false;
+        return SLE_CARGO_FRAG_RX_DROPPED;
+    }
+
+    memcpy(&slot->data[slot->received], frag->data, frag->data_len);
+    slot->received += frag->data_len;
+    slot->tick = now;
+    if (slot->received < slot->len) {
+        return SLE_CARGO_FRAG_RX_PARTIAL;
+    }
+
+    slot->complete = true;
+    rx->messages++;
+    msg->link = link;
+    msg->msg_id = slot->msg_id;
+    msg->kind = slot->kind;
+    msg->len = slot->len;
+    msg->data = slot->data;
+    msg->slot = (uint8_t)(slot - rx->slots);
+    return SLE_CARGO_FRAG_RX_COMPLETE;
+}
+
+void sle_cargo_frag_rx_release(sle_cargo_frag_rx_t *rx, const sle_cargo_frag_msg_t *msg)
+{
+    if (rx == NULL || msg == NULL || msg->slot >= SLE_CARGO_FRAG_RX_SLOTS) {
+        return;
+    }
+    sle_cargo_frag_slot_t *slot = &rx->slots[msg->slot];
+    if (slot->used && slot->link == msg->link && slot->msg_id == msg->msg_id) {
+        slot->used = false;
+    }
+}
+
+uint8_t sle_cargo_frag_rx_expire(sle_cargo_frag_rx_t *rx, uint32_t now)
+{
+    if (rx == NULL) {
+        return 0;
+    }
+    uint8_t expired = 0;
+    for (uint8_t i = 0; i < SLE_CARGO_FRAG_RX_SLOTS; i++) {
+        sle_cargo_frag_slot_t *slot = &rx->slots[i];
+        // 完整消息等待调用者释放，不计超时
+        if (slot->used && !slot->complete && (uint32_t)(now - slot->tick) >= SLE_CARGO_FRAG_RX_TIMEOUT_MS) {
+            slot->used = false;
+            rx->timeouts++;
+            expired++;
+        }
+    }
+    return expired;
+}
+
+void sle_cargo_frag_rx_drop_link(sle_cargo_frag_rx_t *rx, uint16_t link)
+{
+    if (rx == NULL) {
+        return;
+    }
+    for (uint8_t i = 0; i < SLE_CARGO_FRAG_RX_SLOTS; i++) {
+        if (rx->slots[i].used && rx->slots[i].link == link) {
+            rx->slots[i].used = false;
+        }
+    }
+}
@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2024 HiSilicon Technologies CO., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SLE_CARGO_FRAG_H
+#define SLE_CARGO_FRAG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sle_cargo_proto.h"
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+#endif /* __cplusplus */
+
+// 单条消息的最大长度，发送端和接收端的缓冲区都按此预分配
+#ifndef SLE_CARGO_FRAG_MSG_MAX
+#define SLE_CARGO_FRAG_MSG_MAX          1024
+#endif
+
+// 一个分片帧的最大长度，与双方请求的MTU一致；实际分片大小取协商后的MTU
+#define SLE_CARGO_FRAG_FRAME_MAX        512
+// 协商结果未知时使用的MTU
+#define SLE_CARGO_FRAG_MTU_MIN          64
+// 一次写入/通知中协议栈占用的字节，分片帧长度 = MTU - 开销
+#define SLE_CARGO_FRAG_MTU_OVERHEAD     4
+
+// 接收端重组槽位数，以及未完成消息的超时
+#define SLE_CARGO_FRAG_RX_SLOTS         4
+#define SLE_CARGO_FRAG_RX_TIMEOUT_MS    3000
+
+// 发送端: 某个分片写入失败后整条消息换新编号重发的次数
+#define SLE_CARGO_FRAG_TX_RETRY_MAX     2
+
+// 消息内容类型
+typedef enum {
+    SLE_CARGO_BULK_RAW = 0,
+    SLE_CARGO_BULK_SORT_HISTORY = 1,    // sle_cargo_event_t 记录序列，每条 SLE_CARGO_EVENT_LEN 字节
+    SLE_CARGO_BULK_LOG = 2,             // 日志文本
+    SLE_CARGO_BULK_CONFIG = 3,          // 配置数据块
+    SLE_CARGO_BULK_RATE_HISTORY = 4,    // 分拣速率历史的一个导出块，见 sle_cargo_history_export
+} sle_cargo_bulk_kind_t;
+
+// 发送端处理写确认的结果
+typedef enum {
+    SLE_CARGO_FRAG_TX_NONE = 0,         // 消息仍在发送
+    SLE_CARGO_FRAG_TX_DONE,             // 所有分片都已确认
+    SLE_CARGO_FRAG_TX_RESTART,          // 分片失败，整条消息换新编号从头重发
+    SLE_CARGO_FRAG_TX_FAILED,           // 重发次数用尽，消息已丢弃
+} sle_cargo_frag_tx_result_t;
+
+// 发送端: 每条链路同一时刻发送一条消息，内容拷贝到内部缓冲区
+typedef struct {
+    bool active;
+    uint8_t kind;
+    uint16_t msg_id;
+    uint16_t len;
+    uint16_t offset;                    // 下一个要发出的分片的偏移
+    uint16_t frag_seq;                  // 下一个分片的序号
+    uint16_t last_len;                  // 最近一次生成的分片数据长度，撤销时使用
+    uint8_t inflight;                   // 已发出未确认的分片数
+    uint8_t stale;                      // 重发前已发出的分片，其确认不再计入
+    uint8_t retries;
+    uint32_t start_tick;
+    uint8_t data[SLE_CARGO_FRAG_MSG_MAX];
+    // 统计
+    uint32_t messages;                  // 发送完成的消息数
+    uint32_t fragments;
+    uint32_t bytes;                     // 发送完成的消息字节数
+    uint32_t restarts;
+    uint32_t failed;
+    uint32_t last_ms;                   // 最近一条消息从开始到全部确认的耗时
+} sle_cargo_frag_tx_t;
+
+// 重组完成的消息，数据留在重组槽位中，处理完后用 sle_cargo_frag_rx_release 释放
+typedef struct {
+    uint16_t link;
+    uint16_t msg_id;
+    uint8_t kind;
+    uint16_t len;
+    const uint8_t *data;
+    uint8_t slot;
+} sle_cargo_frag_msg_t;
+
+// 一个重组槽位
+typedef struct {
+    bool used;
+    bool complete;
+    uint16_t link;
+    uint16_t msg_id;
+    uint8_t kind;
+    uint16_t len;
+    uint16_t received;                  // 按序收到的字节数
+    uint32_t tick;                      // 最近收到分片的时刻
+    uint8_t data[SLE_CARGO_FRAG_MSG_MAX];
+} sle_cargo_frag_slot_t;
+
+// 接收端处理结果
+typedef enum {
+    SLE_CARGO_FRAG_RX_PARTIAL = 0,      // 已写入重组槽位，消息尚未完整
+    SLE_CARGO_FRAG_RX_COMPLETE,         // 消息已完整
+    SLE_CARGO_FRAG_RX_DUP,              // 重复的分片，已忽略
+    SLE_CARGO_FRAG_RX_DROPPED,          // 无法重组(缺分片、无空闲槽位或消息过长)，已丢弃
+} sle_cargo_frag_rx_result_t;
+
+// 接收端: 定长重组池，不使用堆；每条链路同一时刻最多重组一条消息
+typedef struct {
+    sle_cargo_frag_slot_t slots[SLE_CARGO_FRAG_RX_SLOTS];
+    // 统计
+    uint32_t messages;
+    uint32_t fragments;
+    uint32_t dups;
+    uint32_t gaps;                      // 分片不连续，消息丢弃
+    uint32_t timeouts;                  // 超时未收齐，消息丢弃
+    uint32_t abandoned;                 // 发送端改发新消息，未完成的旧消息丢弃
+    uint32_t no_slot;
+    uint32_t too_long;
+} sle_cargo_frag_rx_t;
+
+/**
+ * @brief  丢弃正在发送的消息并计为失败 (断开连接时调用)，消息编号和其余统计保留
+ * @param  tx: 发送端状态
+ */
+void sle_cargo_frag_tx_reset(sle_cargo_frag_tx_t *tx);
+
+/**
+ * @brief  开始发送一条消息，内容拷贝到发送端缓冲区
+ * @param  tx: 发送端状态
+ * @param  kind: 消息内容类型
+ * @param  data: 消息内容
+ * @param  len: 消息长度，1 ~ SLE_CARGO_FRAG_MSG_MAX
+ * @param  now: 当前时刻(ms)
+ * @retval 是否开始发送，上一条消息未完成或参数非法时返回false
+ */
+bool sle_cargo_frag_tx_start(sle_cargo_frag_tx_t *tx, uint8_t kind, const uint8_t *data, uint16_t len, uint32_t now);
+
+/**
+ * @brief  是否还有未发出的分片
+ * @param  tx: 发送端状态
+ * @retval true=还有分片要发
+ */
+bool sle_cargo_frag_tx_pending(const sle_cargo_frag_tx_t *tx);
+
+/**
+ * @brief  生成下一个分片帧，分片大小由协商后的MTU决定
+ * @param  tx: 发送端状态
+ * @param  mtu: 协商后的MTU，0表示未知
+ * @param  buf: 输出缓冲区
+ * @param  cap: 缓冲区容量
+ * @retval 帧长度，没有要发的分片时返回0
+ */
+uint16_t sle_cargo_frag_tx_next(sle_cargo_frag_tx_t *tx, uint16_t mtu, uint8_t *buf, uint16_t cap);
+
+/**
+ * @brief  撤销最近一次 sle_cargo_frag_tx_next 生成的分片 (提交失败时调用)
+ * @param  tx: 发送端状态
+ */
+void sle_cargo_frag_tx_cancel(sle_cargo_frag_tx_t *tx);
+
+/**
+ * @brief  处理最早一个在途分片的确认；通知等没有确认的通道在提交成功后以 success=true 调用
+ * @param  tx: 发送端状态
+ * @param  success: 对端是否收到
+ * @param  now: 当前时刻(ms)
+ * @retval 处理结果
+ */
+sle_cargo_frag_tx_result_t sle_cargo_frag_tx_on_confirm(sle_cargo_frag_tx_t *tx, bool success, uint32_t now);
+
+/**
+ * @brief  清空重组池
+ * @param  rx: 接收端状态
+ */
+void sle_cargo_frag_rx_reset(sle_cargo_frag_rx_t *rx);
+
+/**
+ * @brief  把一个分片写入重组池，顺带丢弃超时的消息
+ * @param  rx: 接收端状态
+ * @param  link: 链路标识(连接ID)
+ * @param  frag: 解码得到的分片
+ * @param  now: 当前时刻(ms)
+ * @param  msg: 消息完整时输出，须调用 sle_cargo_frag_rx_release 释放
+ * @retval 处理结果
+ */
+sle_cargo_frag_rx_result_t sle_cargo_frag_rx_push(sle_cargo_frag_rx_t *rx, uint16_t link, const sle_cargo_frag_t *frag,
+                                                  uint32_t now, sle_cargo_frag_msg_t *msg);
+
+/**
+ * @brief  释放已处理完的消息所占的槽位
+ * @param  rx: 接收端状态
+ * @param  msg: sle_cargo_frag_rx_push 输出的消息
+ */
+void sle_cargo_frag_rx_release(sle_cargo_frag_rx_t *rx, const sle_cargo_frag_msg_t *msg);
+
+/**
+ * @brief  丢弃超时未收齐的消息
+ * @param  rx: 接收端状态
+ * @param  now: 当前时刻(ms)
+ * @retval 本次丢弃的消息数
+ */
+uint8_t sle_cargo_frag_rx_expire(sle_cargo_frag_rx_t *rx, uint32_t now);
+
+/**
+ * @brief  丢弃某条链路上未完成的消息 (断开连接时调用)
+ * @param  rx: 接收端状态
+ * @param  link: 链路标识
+ */
+void sle_cargo_frag_rx_drop_link(sle_cargo_frag_rx_t *rx, uint16_t link);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* __cplusplus */
+
+#endif /* SLE_CARGO_FRAG_H */
@@ -0,0 +1,319 @@
+/*
+ * Copyright (c) 2024 HiSilicon Technologies CO., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "sle_cargo_history.h"
+#include <string.h>
+
+#define HIST_MS_PER_S   1000
+#define HIST_S_PER_MIN  60
+
+static void hist_tier_init(sle_cargo_hist_tier_t *t, sle_cargo_hist_bucket_t *buckets, uint16_t len,
+                           uint16_t period_s, uint32_t now)
+{
+    t->buckets = buckets;
+    t->len = len;
+    t->period_s = period_s;
+    t->head = 0;
+    t->filled = 0;
+    t->start_ms = now;
+    memset(buckets, 0, sizeof(*buckets) * len);
+}
+
+static void hist_tier_advance(sle_cargo_hist_tier_t *t, uint32_t now)
+{
+    uint32_t period_ms = (uint32_t)t->period_s * HIST_MS_PER_S;
+    int32_t elapsed = (int32_t)(now - t->start_ms);
+    if (elapsed < (int32_t)period_ms) {
+        return;
+    }
+    uint32_t steps = (uint32_t)elapsed / period_ms;
+    t->start_ms += steps * period_ms;
+    // 跨过整个环时所有桶都要清零，多出的步数只影响已完成桶数
+    uint32_t clear = (steps < t->len) ? steps : t->len;
+    for (uint32_t i = 0; i < clear; i++) {
+        t->head = (uint16_t)((t->head + 1) % t->len);
+        memset(&t->buckets[t->head], 0, sizeof(t->buckets[t->head]));
+    }
+    uint32_t filled = t->filled + steps;
+    uint32_t max_filled = (uint32_t)t->len - 1;
+    t->filled = (uint16_t)((filled < max_filled) ? filled : max_filled);
+}
+
+static const sle_cargo_hist_bucket_t *hist_tier_at(const sle_cargo_hist_tier_t *t, uint16_t age)
+{
+    return &t->buckets[(t->head + t->len - age) % t->len];
+}
+
+void sle_cargo_history_init(sle_cargo_history_t *h, uint32_t now)
+{
+    if (h == NULL) {
+        return;
+    }
+    hist_tier_init(&h->tier[SLE_CARGO_HIST_FINE], h->fine, SLE_CARGO_HIST_FINE_BUCKETS + 1,
+                   SLE_CARGO_HIST_FINE_PERIOD_S, now);
+    hist_tier_init(&h->tier[SLE_CARGO_HIST_COARSE], h->coarse, SLE_CARGO_HIST_COARSE_BUCKETS + 1,
+                   SLE_CARGO_HIST_COARSE_PERIOD_S, now);
+    h->saturated = 0;
+}
+
+void sle_cargo_history_advance(sle_cargo_history_t *h, uint32_t now)
+{
+    if (h == NULL) {
+        return;
+    }
+    for (uint8_t i = 0; i < SLE_CARGO_HIST_TIERS; i++) {
+        hist_tier_advance(&h->tier[i], now);
+    }
+}
+
+void sle_cargo_history_add(sle_cargo_history_t *h, const uint32_t delta[SLE_CARGO_REGION_MAX], uint32_t now)
+{
+    if (h == NULL || delta == NULL) {
+        return;
+    }
+    sle_cargo_history_advance(h, now);
+    for (uint8_t i = 0; i < SLE_CARGO_HIST_TIERS; i++) {
+        sle_cargo_hist_tier_t *t = &h->tier[i];
+        sle_cargo_hist_bucket_t *b = &t->buckets[t->head];
+        for (uint8_t r = 0; r < SLE_CARGO_REGION_MAX; r++) {
+            uint32_t sum = (uint32_t)b->count[r] + delta[r];
+            if (sum > UINT16_MAX) {
+                sum = UINT16_MAX;
+                h->saturated++;
+            }
+            b->count[r] = (uint16_t)sum;
+        }
+    }
+}
+
+bool sle_cargo_history_bucket(const sle_cargo_history_t *h, uint8_t tier, uint16_t age, sle_cargo_hist_bucket_t *bucket)
+{
+    if (h == NULL || tier >= SLE_CARGO_HIST_TIERS || bucket == NULL || age > h->tier[tier].filled) {
+        return false;
+    }
+    *bucket = *hist_tier_at(&h->tier[tier], age);
+    return true;
+}
+
+uint16_t sle_cargo_history_rate(const sle_cargo_history_t *h, uint8_t tier, uint16_t buckets,
+                                uint32_t per_min[SLE_CARGO_REGION_MAX])
+{
+    if (per_min != NULL) {
+        memset(per_min, 0, sizeof(uint32_t) * SLE_CARGO_REGION_MAX);
+    }
+    if (h == NULL || tier >= SLE_CARGO_HIST_TIERS || per_min == NULL) {
+        return 0;
+    }
+    const sle_cargo_hist_tier_t *t = &h->tier[tier];
+    uint16_t n = (buckets < t->filled) ? buckets : t->filled;
+    if (n == 0) {
+        return 0;
+    }
+    for (uint16_t age = 1; age <= n; age++) {
+        const sle_cargo_hist_bucket_t *b = hist_tier_at(t, age);
+        for (uint8_t r = 0; r < SLE_CARGO_REGION_MAX; r++) {
+            per_min[r] += b->count[r];
+        }
+    }
+    uint32_t span_s = (uint32_t)n * t->period_s;
+    for (uint8_t r = 0; r < SLE_CARGO_REGION_MAX; r++) {
+        per_min[r] = (uint32_t)(((uint64_t)per_min[r] * HIST_S_PER_MIN + span_s / 2) / span_s);
+    }
+    return n;
+}
+
+void sle_cargo_history_series(const sle_cargo_history_t *h, uint8_t tier, uint16_t points, uint16_t per_point,
+                              uint32_t *out)
+{
+    if (out == NULL) {
+        return;
+    }
+    memset(out, 0, sizeof(uint32_t) * points);
+    if (h == NULL || tier >= SLE_CARGO_HIST_TIERS || per_point == 0) {
+        return;
+    }
+    const sle_cargo_hist_tier_t *t = &h->tier[tier];
+    for (uint16_t k = 0; k < points; k++) {
+        uint32_t sum = 0;
+        for (uint16_t j = 1; j <= per_point; j++) {
+            uint32_t age = (uint32_t)k * per_point + j;
+            if (age > t->filled) {
+                break;
+            }
+            const sle_cargo_hist_bucket_t *b = hist_tier_at(t, (uint16_t)age);
+            for (uint8_t r = 0; r < SLE_CARGO_REGION_MAX; r++) {
+                sum += b->count[r];
+            }
+        }
+        out[points - 1 - k] = sum;
+    }
+}
+
+static uint16_t hist_put_varint(uint8_t *buf, int32_t value)
+{
+    uint32_t zz = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+    uint16_t n = 0;
+    while (zz >= 0x80) {
+        buf[n++] = (uint8_t)(zz | 0x80);
+        zz >>= 7;
+    }
+    buf[n++] = (uint8_t)zz;
+    return n;
+}
+
+static bool hist_get_varint(const uint8_t *buf, uint16_t len, uint16_t *pos, int32_t *value)
+{
+    uint32_t zz = 0;
+    for (uint8_t shift = 0; shift < 21; shift += 7) {
+        if (*pos >= len) {
+            return false;
+        }
+        uint8_t byte = buf[(*pos)++];
+        zz |= (uint32_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            *value = (int32_t)(zz >> 1) ^ -(int32_t)(zz & 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool hist_same(const sle_cargo_hist_bucket_t *a, const sle_cargo_hist_bucket_t *b)
+{
+    return memcmp(a->count, b->count, sizeof(a->count)) == 0;
+}
+
+uint16_t sle_cargo_history_age_at(const sle_cargo_history_t *h, uint8_t tier, uint32_t end_ms)
+{
+    if (h == NULL || tier >= SLE_CARGO_HIST_TIERS) {
+        return 0;
+    }
+    const sle_cargo_hist_tier_t *t = &h->tier[tier];
+    uint32_t period_ms = (uint32_t)t->period_s * HIST_MS_PER_S;
+    int32_t behind = (int32_t)(t->start_ms - end_ms);
+    if (behind < 0) {
+        return 0;
+    }
+    uint32_t age = (uint32_t)behind / period_ms + 1;
+    return (age <= t->filled) ? (uint16_t)age : 0;
+}
+
+uint16_t sle_cargo_history_export(const sle_cargo_history_t *h, uint8_t tier, uint16_t from_age, uint16_t max,
+                                  uint8_t *buf, uint16_t cap, uint16_t *next_age)
+{
+    if (next_age != NULL) {
+        *next_age = 0;
+    }
+    if (h == NULL || tier >= SLE_CARGO_HIST_TIERS || buf == NULL || next_age == NULL || from_age == 0 ||
+        cap < SLE_CARGO_HIST_CHUNK_HDR_LEN + SLE_CARGO_HIST_RECORD_MAX) {
+        return 0;
+    }
+    const sle_cargo_hist_tier_t *t = &h->tier[tier];
+    if (from_age > t->filled) {
+        return 0;
+    }
+
+    // 第 age 个桶在当前桶开始前 (age-1) 个周期结束
+    uint32_t newest_end_ms = t->start_ms - (uint32_t)(from_age - 1) * t->period_s * HIST_MS_PER_S;
+    uint32_t newest_end_s = newest_end_ms / HIST_MS_PER_S;
+    buf[0] = tier;
+    buf[1] = (uint8_t)(t->period_s & 0xFF);
+    buf[2] = (uint8_t)(t->period_s >> 8);
+    buf[3] = (uint8_t)(newest_end_s & 0xFF);
+    buf[4] = (uint8_t)((newest_end_s >> 8) & 0xFF);
+    buf[5] = (uint8_t)((newest_end_s >> 16) & 0xFF);
+    buf[6] = (uint8_t)(newest_end_s >> 24);
+
+    uint32_t last = (max > 0) ? (uint32_t)from_age + max - 1 : t->filled;
+    if (last > t->filled) {
+        last = t->filled;
+    }
+    sle_cargo_hist_bucket_t prev = { 0 };
+    uint16_t pos = SLE_CARGO_HIST_CHUNK_HDR_LEN;
+    uint16_t count = 0;
+    uint16_t age = from_age;
+    while (age <= last && cap - pos >= SLE_CARGO_HIST_RECORD_MAX) {
+        const sle_cargo_hist_bucket_t *b = hist_tier_at(t, age);
+        uint16_t flag_pos = pos++;
+        uint8_t mask = 0;
+        for (uint8_t r = 0; r < SLE_CARGO_REGION_MAX; r++) {
+            int32_t diff = (int32_t)b->count[r] - (int32_t)prev.count[r];
+            if (diff != 0) {
+                mask |= (uint8_t)(1U << r);
+                pos += hist_put_varint(&buf[pos], diff);
+            }
+        }
+        uint8_t run = 0;
+        age++;
+        while (run < SLE_CARGO_HIST_RUN_MAX && age <= last && hist_same(hist_tier_at(t, age), b)) {
+            run++;
+            age++;
+        }
+        buf[flag_pos] = (uint8_t)((run << 3) | mask);
+        count += (uint16_t)(run + 1);
+        prev = *b;
+    }
+    buf[7] = (uint8_t)(count & 0xFF);
+    buf[8] = (uint8_t)(count >> 8);
+    *next_age = (age <= last) ? age : 0;
+    return pos;
+}
+
+uint16_t sle_cargo_history_decode(const uint8_t *buf, uint16_t len, sle_cargo_hist_chunk_t *chunk,
+                                  sle_cargo_hist_bucket_t *out, uint16_t max)
+{
+    if (buf == NULL || chunk == NULL || len < SLE_CARGO_HIST_CHUNK_HDR_LEN) {
+        return 0;
+    }
+    chunk->tier = buf[0];
+    chunk->period_s = (uint16_t)(buf[1] | (buf[2] << 8));
+    chunk->newest_end_s = (uint32_t)buf[3] | ((uint32_t)buf[4] << 8) | ((uint32_t)buf[5] << 16) |
+                          ((uint32_t)buf[6] << 24);
+    chunk->count = (uint16_t)(buf[7] | (buf[8] << 8));
+    if (chunk->tier >= SLE_CARGO_HIST_TIERS || chunk->period_s == 0) {
+        return 0;
+    }
+
+    int32_t prev[SLE_CARGO_REGION_MAX] = { 0 };
+    uint16_t pos = SLE_CARGO_HIST_CHUNK_HDR_LEN;
+    uint16_t n = 0;
+    while (pos < len) {
+        uint8_t flag = buf[pos++];
+        uint8_t mask = flag & 0x07;
+        uint8_t run = flag >> 3;
+        if ((uint32_t)n + run + 1 > chunk->count) {
+            return 0;
+        }
+        for (uint8_t r = 0; r < SLE_CARGO_REGION_MAX; r++) {
+            int32_t diff = 0;
+            if ((mask & (1U << r)) != 0 && !hist_get_varint(buf, len, &pos, &diff)) {
+                return 0;
+            }
+            prev[r] += diff;
+            if (prev[r] < 0 || prev[r] > UINT16_MAX) {
+                return 0;
+            }
+        }
+        for (uint8_t i = 0; i <= run; i++) {
+            if (out != NULL && n < max) {
+                for (uint8_t r = 0; r < SLE_CARGO_REGION_MAX; r++) {
+                    out[n].count[r] = (uint16_t)prev[r];
+                }
+            }
+            n++;
+        }
+    }
+    return (n == chunk->count) ? n : 0;
+}
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2024 HiSilicon Technologies CO., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SLE_CARGO_HISTORY_H
+#define SLE_CARGO_HISTORY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sle_cargo_proto.h"
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+#endif /* __cplusplus */
+
+// 分拣速率历史: 两级固定长度的环，每个桶记录该时段内各地区新增的件数
+// 细粒度: 10秒一桶，保留1小时；粗粒度: 1分钟一桶，保留1天
+typedef enum {
+    SLE_CARGO_HIST_FINE = 0,
+    SLE_CARGO_HIST_COARSE,
+    SLE_CARGO_HIST_TIERS,
+} sle_cargo_hist_tier_id_t;
+
+#define SLE_CARGO_HIST_FINE_PERIOD_S    10
+#define SLE_CARGO_HIST_FINE_BUCKETS     360
+#define SLE_CARGO_HIST_COARSE_PERIOD_S  60
+#define SLE_CARGO_HIST_COARSE_BUCKETS   1440
+
+// 导出块: tier(1) + period_s(2) + newest_end_s(4) + count(2)，之后为从新到旧的桶记录。
+// 每条记录先是一个字节: 低3位标记相对前一个桶(块内第一个桶相对0)有变化的地区，高5位为之后完全相同的桶数；
+// 随后按地区顺序给出有变化地区的差值，zigzag 后按 LEB128 变长编码。速率平稳或停线时一个字节可覆盖32个桶
+#define SLE_CARGO_HIST_CHUNK_HDR_LEN    9
+#define SLE_CARGO_HIST_RUN_MAX          31
+// 一条记录的最大长度: 标记字节 + 每个地区最多3字节
+#define SLE_CARGO_HIST_RECORD_MAX       (1 + SLE_CARGO_REGION_MAX * 3)
+
+// 一个桶: 各地区在该时段内新增的件数，超出 uint16_t 时饱和
+typedef struct {
+    uint16_t count[SLE_CARGO_REGION_MAX];
+} sle_cargo_hist_bucket_t;
+
+// 一级环，head 为当前正在累计的桶
+typedef struct {
+    sle_cargo_hist_bucket_t *buckets;
+    uint16_t len;                           // 环长度，比保留的完整桶数多1
+    uint16_t period_s;
+    uint16_t head;
+    uint16_t filled;                        // 已完成的桶数，不超过 len-1
+    uint32_t start_ms;                      // 当前桶的开始时刻
+} sle_cargo_hist_tier_t;
+
+typedef struct {
+    sle_cargo_hist_tier_t tier[SLE_CARGO_HIST_TIERS];
+    sle_cargo_hist_bucket_t fine[SLE_CARGO_HIST_FINE_BUCKETS + 1];
+    sle_cargo_hist_bucket_t coarse[SLE_CARGO_HIST_COARSE_BUCKETS + 1];
+    uint32_t saturated;                     // 因饱和少计的桶
+} sle_cargo_history_t;
+
+// 解码后的导出块头
+typedef struct {
+    uint8_t tier;
+    uint16_t period_s;
+    uint32_t newest_end_s;                  // 块内最新一个桶的结束时刻 (导出方开机后的秒数)
+    uint16_t count;
+} sle_cargo_hist_chunk_t;
+
+/**
+ * @brief  清空历史，当前桶从 now 开始
+ * @param  h: 历史
+ * @param  now: 当前时刻(ms)
+ */
+void sle_cargo_history_init(sle_cargo_history_t *h, uint32_t now);
+
+/**
+ * @brief  推进到 now 所在的桶，跨过的桶清零；没有新货物时也应周期调用，使空闲时段记为0
+ * @note   每次调用清零的桶数为跨过的桶数，不超过环长度，分摊到每个桶为O(1)
+ * @param  h: 历史
+ * @param  now: 当前时刻(ms)
+ */
+void sle_cargo_history_advance(sle_cargo_history_t *h, uint32_t now);
+
+/**
+ * @brief  把各地区新增的件数计入 now 所在的桶，O(1)，不分配内存
+ * @param  h: 历史
+ * @param  delta: 各地区新增的件数
+ * @param  now: 当前时刻(ms)
+ */
+void sle_cargo_history_add(sle_cargo_history_t *h, const uint32_t delta[SLE_CARGO_REGION_MAX], uint32_t now);
+
+/**
+ * @brief  读取一个桶
+ * @param  h: 历史
+ * @param  tier: 级别 (sle_cargo_hist_tier_id_t)
+ * @param  age: 0为当前未完成的桶，1为最近完成的桶，依次更早
+ * @param  bucket: 输出
+ * @retval 该桶是否存在
+ */
+bool sle_cargo_history_bucket(const sle_cargo_history_t *h, uint8_t tier, uint16_t age, sle_cargo_hist_bucket_t *bucket);
+
+/**
+ * @brief  最近 buckets 个已完成的桶内各地区的平均速率
+ * @param  h: 历史
+ * @param  tier: 级别
+ * @param  buckets: 桶数，不足时按已有的桶计算
+ * @param  per_min: 输出各地区每分钟件数
+ * @retval 实际参与计算的桶数，为0时速率无效
+ */
+uint16_t sle_cargo_history_rate(const sle_cargo_history_t *h, uint8_t tier, uint16_t buckets,
+                                uint32_t per_min[SLE_CARGO_REGION_MAX]);
+
+/**
+ * @brief  把最近 points * per_point 个已完成的桶按每 per_point 个合并，得到各段三个地区的合计，用于趋势图
+ * @param  h: 历史
+ * @param  tier: 级别
+ * @param  points: 段数，out[0]为最早的一段
+ * @param  per_point: 每段的桶数
+ * @param  out: 输出各段合计，没有数据的段为0
+ */
+void sle_cargo_history_series(const sle_cargo_history_t *h, uint8_t tier, uint16_t points, uint16_t per_point,
+                              uint32_t *out);
+
+/**
+ * @brief  结束时刻为 end_ms 的已完成桶当前的 age。分块导出期间历史仍在推进，导出方记下下一块的结束时刻，
+ *         每块导出前据此重新定位
+ * @param  h: 历史
+ * @param  tier: 级别
+ * @param  end_ms: 桶的结束时刻(ms)
+ * @retval age，该桶已被覆盖或尚未完成时返回0
+ */
+uint16_t sle_cargo_history_age_at(const sle_cargo_history_t *h, uint8_t tier, uint32_t end_ms);
+
+/**
+ * @brief  导出一块: 从 age 为 from_age 的桶开始向更早的桶编码，直到写满缓冲区、达到 max 个或没有更多的桶
+ * @note   导出前应先调用 sle_cargo_history_advance，使空闲时段已计为0
+ * @param  h: 历史
+ * @param  tier: 级别
+ * @param  from_age: 第一个导出的桶，1为最近完成的桶
+ * @param  max: 本块最多导出的桶数，0为不限
+ * @param  buf: 输出缓冲区
+ * @param  cap: 缓冲区容量，至少 SLE_CARGO_HIST_CHUNK_HDR_LEN + SLE_CARGO_HIST_RECORD_MAX
+ * @param  next_age: 输出下一块的 from_age，全部导出完时为0
+ * @retval 块长度，没有可导出的桶或参数非法时返回0
+ */
+uint16_t sle_cargo_history_export(const sle_cargo_history_t *h, uint8_t tier, uint16_t from_age, uint16_t max,
+                                  uint8_t *buf, uint16_t cap, uint16_t *next_age);
+
+/**
+ * @brief  解码一个导出块
+ * @param  buf: 块数据
+ * @param  len: 块长度
+ * @param  chunk: 输出块头
+ * @param  out: 输出的桶，从新到旧，可为NULL (只校验和计数)
+ * @param  max: out 的容量，超出的桶只计数不输出
+ * @retval 块内的桶数，格式错误或与块头不符时返回0
+ */
+uint16_t sle_cargo_history_decode(const uint8_t *buf, uint16_t len, sle_cargo_hist_chunk_t *chunk,
+                                  sle_cargo_hist_bucket_t *out, uint16_t max);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* __cplusplus */
+
+#endif /* SLE_CARGO_HISTORY_H */
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2024 HiSilicon Technologies CO., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "sle_cargo_latch.h"
+#include <string.h>
+
+void sle_cargo_latch_init(sle_cargo_latch_t *l, void *copy0, void *copy1, uint16_t size, const void *initial)
+{
+    if (l == NULL || copy0 == NULL || copy1 == NULL || initial == NULL) {
+        return;
+    }
+    memset(l, 0, sizeof(*l));
+    l->copy[0] = (uint8_t *)copy0;
+    l->copy[1] = (uint8_t *)copy1;
+    l->size = size;
+    memcpy(l->copy[0], initial, size);
+    memcpy(l->copy[1], initial, size);
+}
+
+void sle_cargo_latch_publish(sle_cargo_latch_t *l, const void *data)
+{
+    if (l == NULL || data == NULL || l->size == 0) {
+        return;
+    }
+    uint32_t seq = __atomic_load_n(&l->seq, __ATOMIC_RELAXED);
+    // 奇数: 读者改用副本1，此时可以写副本0
+    __atomic_store_n(&l->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    memcpy(l->copy[0], data, l->size);
+    // 偶数: 读者回到已更新的副本0，再写副本1
+    __atomic_store_n(&l->seq, seq + 2, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    memcpy(l->copy[1], data, l->size);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+bool sle_cargo_latch_read(sle_cargo_latch_t *l, void *out, uint32_t *gen)
+{
+    if (l == NULL || out == NULL || l->size == 0) {
+        return false;
+    }
+    l->reads++;
+    for (uint8_t i = 0; i < SLE_CARGO_LATCH_READ_TRIES; i++) {
+        uint32_t seq = __atomic_load_n(&l->seq, __ATOMIC_ACQUIRE);
+        memcpy(out, l->copy[seq & 1], l->size);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&l->seq, __ATOMIC_RELAXED) == seq) {
+            if (gen != NULL) {
+                *gen = seq >> 1;
+            }
+            return true;
+        }
+        l->retries++;
+    }
+    l->fails++;
+    return false;
+}
+
+uint32_t sle_cargo_latch_generation(const sle_cargo_latch_t *l)
+{
+    return (l != NULL) ? (__atomic_load_n(&l->seq, __ATOMIC_ACQUIRE) >> 1) : 0;
+}
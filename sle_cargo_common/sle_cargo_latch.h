@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2024 HiSilicon Technologies CO., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SLE_CARGO_LATCH_H
+#define SLE_CARGO_LATCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+#endif /* __cplusplus */
+
+// 读者重读的次数上限，只有写者在一次拷贝期间连续发布多次才会用尽
+#define SLE_CARGO_LATCH_READ_TRIES  8
+
+// 双缓冲序号锁: 写者依次更新两份副本，每更新一份前序号加1，读者按序号的奇偶拷贝当前没有在写的那一份，
+// 拷贝前后序号不同则重读。读者不加锁，不会阻塞写者，也不必等写者写完；多个写者之间须由调用者互斥
+typedef struct {
+    uint32_t seq;                           // 发布一次加2，发布中途为奇数
+    uint8_t *copy[2];
+    uint16_t size;
+    // 统计，读者之间不互斥，仅用于观察
+    uint32_t reads;
+    uint32_t retries;                       // 拷贝期间写者发布了新状态而重读
+    uint32_t fails;                         // 重读次数用尽
+} sle_cargo_latch_t;
+
+/**
+ * @brief  初始化，两份副本都写入初始状态，代数为0
+ * @param  l: 序号锁
+ * @param  copy0: 副本缓冲区，容量 size
+ * @param  copy1: 副本缓冲区，容量 size
+ * @param  size: 状态大小
+ * @param  initial: 初始状态
+ */
+void sle_cargo_latch_init(sle_cargo_latch_t *l, void *copy0, void *copy1, uint16_t size, const void *initial);
+
+/**
+ * @brief  发布新状态，代数加1
+ * @param  l: 序号锁
+ * @param  data: 新状态，大小为初始化时的 size
+ */
+void sle_cargo_latch_publish(sle_cargo_latch_t *l, const void *data);
+
+/**
+ * @brief  读取一份完整的状态，不阻塞
+ * @param  l: 序号锁
+ * @param  out: 输出缓冲区，容量至少 size
+ * @param  gen: 输出读到的状态的代数，可为NULL
+ * @retval 是否读到一致的状态，重读次数用尽时返回false
+ */
+bool sle_cargo_latch_read(sle_cargo_latch_t *l, void *out, uint32_t *gen);
+
+/**
+ * @brief  当前代数，读者据此判断状态是否变化，不变时可跳过读取
+ * @param  l: 序号锁
+ * @retval 已完成的发布次数
+ */
+uint32_t sle_cargo_latch_generation(const sle_cargo_latch_t *l);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* __cplusplus */
+
+#endif /* SLE_CARGO_LATCH_H */
@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2024 HiSilicon Technologies CO., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "sle_cargo_phy.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *g_phy_names[SLE_CARGO_PHY_MAX] = { "1M", "2M", "4M" };
+
+const char *sle_cargo_phy_name(uint8_t phy)
+{
+    return (phy < SLE_CARGO_PHY_MAX) ? g_phy_names[phy] : "?";
+}
+
+void sle_cargo_phy_init(sle_cargo_phy_link_t *p, uint8_t peer_caps)
+{
+    if (p == NULL) {
+        return;
+    }
+    memset(p, 0, sizeof(*p));
+    p->peer_caps = peer_caps | SLE_CARGO_PHY_CAP_1M;
+    p->current = SLE_CARGO_PHY_1M;
+}
+
+uint8_t sle_cargo_phy_best(const sle_cargo_phy_link_t *p)
+{
+    if (p == NULL) {
+        return SLE_CARGO_PHY_1M;
+    }
+    uint8_t usable = (uint8_t)(SLE_CARGO_PHY_CAPS & p->peer_caps & ~p->rejected);
+    for (uint8_t phy = SLE_CARGO_PHY_MAX - 1; phy > SLE_CARGO_PHY_1M; phy--) {
+        if ((usable & (1U << phy)) != 0) {
+            return phy;
+        }
+    }
+    return SLE_CARGO_PHY_1M;
+}
+
+void sle_cargo_phy_enable(sle_cargo_phy_link_t *p, bool enable)
+{
+    if (p != NULL) {
+        p->disabled = !enable;
+    }
+}
+
+// 放弃某个高速PHY，之后按次快的PHY重新请求；1M不会被放弃
+static void phy_reject(sle_cargo_phy_link_t *p, uint8_t phy)
+{
+    if (phy == SLE_CARGO_PHY_1M || phy >= SLE_CARGO_PHY_MAX || (p->rejected & (1U << phy)) != 0) {
+        return;
+    }
+    p->rejected |= (uint8_t)(1U << phy);
+    p->fallbacks++;
+}
+
+// 期望的PHY: 有批量传输或刚结束不久时为可用的最快PHY，否则为1M
+static uint8_t phy_target(const sle_cargo_phy_link_t *p, uint32_t now)
+{
+    if (p->disabled) {
+        return SLE_CARGO_PHY_1M;
+    }
+    bool hold = p->bulk || (p->bulk_seen && (uint32_t)(now - p->bulk_tick) < SLE_CARGO_PHY_HOLD_MS);
+    return hold ? sle_cargo_phy_best(p) : SLE_CARGO_PHY_1M;
+}
+
+bool sle_cargo_phy_poll(sle_cargo_phy_link_t *p, bool bulk, uint32_t now, uint8_t *phy)
+{
+    if (p == NULL || phy == NULL) {
+        return false;
+    }
+    p->bulk = bulk;
+    if (bulk) {
+        p->bulk_seen = true;
+        p->bulk_tick = now;
+    }
+    if (p->pending) {
+        if ((uint32_t)(now - p->request_tick) < SLE_CARGO_PHY_UPDATE_TIMEOUT_MS) {
+            return false;
+        }
+        // 没有等到结果，按失败处理，下次检查时按次快的PHY重新请求
+        p->pending = false;
+        p->failures++;
+        phy_reject(p, p->requested);
+    }
+    uint8_t target = phy_target(p, now);
+    if (target == p->current) {
+        return false;
+    }
+    if (p->requested_once && (uint32_t)(now - p->request_tick) < SLE_CARGO_PHY_RETRY_MS) {
+        return false;
+    }
+    p->pending = true;
+    p->requested = target;
+    p->request_tick = now;
+    p->requested_once = true;
+    p->requests++;
+    *phy = target;
+    return true;
+}
+
+bool sle_cargo_phy_updated(sle_cargo_phy_link_t *p, bool ok, uint8_t phy, uint32_t now)
+{
+    if (p == NULL) {
+        return false;
+    }
+    bool ours = p->pending;
+    p->pending = false;
+    if (!ok || phy >= SLE_CARGO_PHY_MAX) {
+        p->failures++;
+        if (ours) {
+            phy_reject(p, p->requested);
+        }
+        return false;
+    }
+    if (ours) {
+        p->apply_last_ms = now - p->request_tick;
+        // 控制器只接受了较慢的PHY: 更快的那些不再请求
+        for (uint8_t i = phy + 1; i <= p->requested && i < SLE_CARGO_PHY_MAX; i++) {
+            phy_reject(p, i);
+        }
+    }
+    if (phy == p->current) {
+        return false;
+    }
+    p->current = phy;
+    p->epoch++;
+    p->switches++;
+    return true;
+}
+
+bool sle_cargo_phy_settled(const sle_cargo_phy_link_t *p)
+{
+    if (p == NULL) {
+        return true;
+    }
+    return !p->pending && p->current == (p->disabled ? SLE_CARGO_PHY_1M : sle_cargo_phy_best(p));
+}
+
+uint32_t sle_cargo_phy_wait(const sle_cargo_phy_link_t *p, uint32_t now)
+{
+    if (p == NULL) {
+        return UINT32_MAX;
+    }
+    if (p->pending) {
+        uint32_t waited = now - p->request_tick;
+        return (waited < SLE_CARGO_PHY_UPDATE_TIMEOUT_MS) ? (SLE_CARGO_PHY_UPDATE_TIMEOUT_MS - waited) : 0;
+    }
+    if (phy_target(p, now) != p->current) {
+        uint32_t waited = now - p->request_tick;
+        return (!p->requested_once || waited >= SLE_CARGO_PHY_RETRY_MS) ? 0 : (SLE_CARGO_PHY_RETRY_MS - waited);
+    }
+    if (p->current != SLE_CARGO_PHY_1M && !p->bulk) {
+        uint32_t quiet = now - p->bulk_tick;
+        return (quiet < SLE_CARGO_PHY_HOLD_MS) ? (SLE_CARGO_PHY_HOLD_MS - quiet) : 0;
+    }
+    return UINT32_MAX;
+}
+
+void sle_cargo_phy_goodput(sle_cargo_phy_link_t *p, uint32_t epoch, uint32_t bytes, uint32_t ms)
+{
+    if (p == NULL || p->current >= SLE_CARGO_PHY_MAX || ms == 0) {
+        return;
+    }
+    if (epoch != p->epoch) {
+        p->mixed++;
+        return;
+    }
+    sle_cargo_phy_goodput_t *g = &p->goodput[p->current];
+    g->runs++;
+    g->bytes += bytes;
+    g->ms += ms;
+    g->last_bps = (uint32_t)((uint64_t)bytes * 1000 / ms);
+}
+
+static uint32_t phy_goodput_avg(const sle_cargo_phy_goodput_t *g)
+{
+    return (g->ms > 0) ? (uint32_t)(g->bytes * 1000 / g->ms) : 0;
+}
+
+uint16_t sle_cargo_phy_format(const sle_cargo_phy_link_t *p, char *buf, uint16_t cap)
+{
+    if (p == NULL || buf == NULL || cap == 0) {
+        return 0;
+    }
+    int n = snprintf(buf, cap, "%s%s%s best=%s caps=%02x/%02x req=%u fail=%u fallback=%u mixed=%u apply=%ums",
+                     sle_cargo_phy_name(p->current), p->pending ? "*" : "", p->disabled ? " off" : "",
+                     sle_cargo_phy_name(sle_cargo_phy_best(p)),
+                     SLE_CARGO_PHY_CAPS, p->peer_caps, p->requests, p->failures, p->fallbacks, p->mixed,
+                     p->apply_last_ms);
+    for (uint8_t i = 0; i < SLE_CARGO_PHY_MAX && n > 0 && n < cap; i++) {
+        const sle_cargo_phy_goodput_t *g = &p->goodput[i];
+        if (g->runs == 0) {
+            continue;
+        }
+        n += snprintf(buf + n, cap - n, " | %s n=%u avg=%uB/s last=%uB/s", sle_cargo_phy_name(i), g->runs,
+                      phy_goodput_avg(g), g->last_bps);
+    }
+    // 最快的有样本的高速PHY相对1M的有效吞吐倍数
+    uint32_t base = phy_goodput_avg(&p->goodput[SLE_CARGO_PHY_1M]);
+    for (uint8_t i = SLE_CARGO_PHY_MAX - 1; i > SLE_CARGO_PHY_1M && n > 0 && n < cap && base > 0; i--) {
+        uint32_t fast = phy_goodput_avg(&p->goodput[i]);
+        if (fast > 0) {
+            uint32_t x100 = (uint32_t)((uint64_t)fast * 100 / base);
+            n += snprintf(buf + n, cap - n, " | gain=%u.%02ux", x100 / 100, x100 % 100);
+            break;
+        }
+    }
+    if (n < 0) {
+        buf[0] = '\0';
+        return 0;
+    }
+    return (uint16_t)((n < cap) ? n : (cap - 1));
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2024 HiSilicon Technologies CO., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SLE_CARGO_PHY_H
+#define SLE_CARGO_PHY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sle_cargo_proto.h"
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+#endif /* __cplusplus */
+
+// PHY编号，与协议栈 sle_phy_tx_rx_t 的取值一致
+typedef enum {
+    SLE_CARGO_PHY_1M = 0,
+    SLE_CARGO_PHY_2M,
+    SLE_CARGO_PHY_4M,
+    SLE_CARGO_PHY_MAX,
+} sle_cargo_phy_t;
+
+// 等待切换结果的超时，超时按失败处理
+#define SLE_CARGO_PHY_UPDATE_TIMEOUT_MS     3000
+// 两次切换请求的最小间隔
+#define SLE_CARGO_PHY_RETRY_MS              2000
+// 批量传输结束后保持高速PHY的时长，连续的多段传输不反复切换；之后回到灵敏度更高的1M
+#ifndef SLE_CARGO_PHY_HOLD_MS
+#define SLE_CARGO_PHY_HOLD_MS               5000
+#endif
+
+// 某个PHY上完成的批量传输
+typedef struct {
+    uint32_t runs;
+    uint64_t bytes;
+    uint64_t ms;
+    uint32_t last_bps;                      // 最近一次的有效吞吐(字节/秒)
+} sle_cargo_phy_goodput_t;
+
+// 一条连接的PHY协商: 有批量传输时切到双方都支持的最快PHY，被拒绝或超时则逐级回退，空闲后回到1M
+typedef struct {
+    uint8_t peer_caps;                      // 对端广播的PHY能力位
+    uint8_t rejected;                       // 本次连接中失败过的PHY，不再请求
+    uint8_t current;                        // 已生效的PHY
+    uint8_t requested;                      // 在途请求的PHY
+    bool pending;
+    bool requested_once;
+    bool disabled;                          // 只使用1M，用于测量对比基准
+    bool bulk;                              // 最近一次检查时有批量传输
+    bool bulk_seen;                         // 本次连接中有过批量传输
+    uint32_t bulk_tick;                     // 最近一次有批量传输的时刻
+    uint32_t request_tick;
+    uint32_t epoch;                         // PHY每变化一次加1，跨越切换的传输不计入吞吐统计
+    // 统计
+    uint32_t requests;
+    uint32_t failures;                      // 请求失败、被拒绝或超时
+    uint32_t fallbacks;                     // 因失败或控制器降级而放弃的PHY
+    uint32_t switches;                      // 生效的PHY变化 (含对端发起的)
+    uint32_t mixed;                         // 传输期间PHY发生变化，未计入吞吐统计
+    uint32_t apply_last_ms;                 // 最近一次请求到生效的耗时
+    sle_cargo_phy_goodput_t goodput[SLE_CARGO_PHY_MAX];
+} sle_cargo_phy_link_t;
+
+/**
+ * @brief  PHY名称
+ * @param  phy: PHY编号
+ * @retval 名称
+ */
+const char *sle_cargo_phy_name(uint8_t phy);
+
+/**
+ * @brief  连接建立后开始，当前为1M，统计清零
+ * @param  p: 协商状态
+ * @param  peer_caps: 对端广播的PHY能力位 (sle_cargo_adv_find_phy_caps)
+ */
+void sle_cargo_phy_init(sle_cargo_phy_link_t *p, uint8_t peer_caps);
+
+/**
+ * @brief  批量传输应使用的PHY: 本端、对端都支持且本次连接中未失败过的最快PHY
+ * @param  p: 协商状态
+ * @retval PHY编号，没有可用的高速PHY时为 SLE_CARGO_PHY_1M
+ */
+uint8_t sle_cargo_phy_best(const sle_cargo_phy_link_t *p);
+
+/**
+ * @brief  允许或禁止切换到高速PHY，禁止后在下次检查时回到1M
+ * @param  p: 协商状态
+ * @param  enable: 是否允许
+ */
+void sle_cargo_phy_enable(sle_cargo_phy_link_t *p, bool enable);
+
+/**
+ * @brief  检查是否需要切换PHY，在途请求超时时按失败回退
+ * @param  p: 协商状态
+ * @param  bulk: 当前是否有批量传输 (大消息、压测等)
+ * @param  now: 当前时刻(ms)
+ * @param  phy: 需要请求时输出目标PHY
+ * @retval 是否应当发出切换请求
+ */
+bool sle_cargo_phy_poll(sle_cargo_phy_link_t *p, bool bulk, uint32_t now, uint8_t *phy);
+
+/**
+ * @brief  切换结果，请求提交失败时也以 ok=false 调用
+ * @param  p: 协商状态
+ * @param  ok: 是否成功
+ * @param  phy: 生效的PHY (发送方向)
+ * @param  now: 当前时刻(ms)
+ * @retval 生效的PHY是否变化
+ */
+bool sle_cargo_phy_updated(sle_cargo_phy_link_t *p, bool ok, uint8_t phy, uint32_t now);
+
+/**
+ * @brief  批量传输是否可以开始: 没有在途请求，且已在可用的最快PHY上 (禁止切换时为1M)
+ * @param  p: 协商状态
+ * @retval 是否已就绪
+ */
+bool sle_cargo_phy_settled(const sle_cargo_phy_link_t *p);
+
+/**
+ * @brief  到下一次需要检查的等待时长 (请求超时、重试间隔或保持时长到期)
+ * @param  p: 协商状态
+ * @param  now: 当前时刻(ms)
+ * @retval 等待时长(ms)，不需要再检查时为 UINT32_MAX
+ */
+uint32_t sle_cargo_phy_wait(const sle_cargo_phy_link_t *p, uint32_t now);
+
+/**
+ * @brief  记录一次完成的批量传输，计入当前PHY；传输开始后PHY变化过则只计数不计入吞吐
+ * @param  p: 协商状态
+ * @param  epoch: 传输开始时的 p->epoch
+ * @param  bytes: 传输的有效字节数
+ * @param  ms: 耗时
+ */
+void sle_cargo_phy_goodput(sle_cargo_phy_link_t *p, uint32_t epoch, uint32_t bytes, uint32_t ms);
+
+/**
+ * @brief  格式化为一行文本: 当前PHY、协商计数和各PHY的有效吞吐，用于日志和远程查询
+ * @param  p: 协商状态
+ * @param  buf: 输出缓冲区
+ * @param  cap: 缓冲区容量
+ * @retval 写入的长度(不含结尾的'\0')
+ */
+uint16_t sle_cargo_phy_format(const sle_cargo_phy_link_t *p, char *buf, uint16_t cap);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* __cplusplus */
+
+#endif /* SLE_CARGO_PHY_H */
@@ -0,0 +1,684 @@
+/*
+ * Copyright (c) 2024 HiSilicon Technologies CO., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "sle_cargo_proto.h"
+#include <stdio.h>
+#include <string.h>
+
+// 小端读写辅助函数，不依赖CPU字节序和对齐
+static void put_le16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_le32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint16_t get_le16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | ((uint16_t)p[1] << 8));
+}
+
+static uint32_t get_le32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// 计算掩码中置位字段的个数
+static uint8_t mask_count(uint8_t mask)
+{
+    return (uint8_t)(((mask >> 0) & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1));
+}
+
+static void put_header(uint8_t *buf, uint8_t type, uint16_t seq)
+{
+    buf[0] = SLE_CARGO_MAGIC;
+    buf[1] = SLE_CARGO_VERSION;
+    buf[2] = type;
+    put_le16(&buf[3], seq);
+}
+
+uint16_t sle_cargo_encode_snapshot(uint8_t *buf, uint16_t cap, uint16_t seq, const sle_cargo_snapshot_t *snap)
+{
+    if (buf == NULL || snap == NULL || cap < SLE_CARGO_SNAPSHOT_LEN) {
+        return 0;
+    }
+
+    put_header(buf, SLE_CARGO_FRAME_SNAPSHOT, seq);
+    put_le32(&buf[SLE_CARGO_HDR_LEN], snap->jiangsu);
+    put_le32(&buf[SLE_CARGO_HDR_LEN + 4], snap->zhejiang);
+    put_le32(&buf[SLE_CARGO_HDR_LEN + 8], snap->shanghai);
+    put_le32(&buf[SLE_CARGO_HDR_LEN + 12], snap->tick);
+    return SLE_CARGO_SNAPSHOT_LEN;
+}
+
+// 二进制帧: 帧头已由调用者确认 magic，这里检查版本、类型和长度
+static sle_cargo_err_t decode_binary(const uint8_t *buf, uint16_t len, sle_cargo_frame_t *frame)
+{
+    if (len < SLE_CARGO_HDR_LEN) {
+        return SLE_CARGO_ERR_TRUNCATED;
+    }
+    if (buf[1] != SLE_CARGO_VERSION) {
+        return SLE_CARGO_ERR_VERSION;
+    }
+
+    frame->wire = SLE_CARGO_WIRE_BINARY;
+    frame->type = buf[2];
+    frame->seq = get_le16(&buf[3]);
+    frame->base_seq = frame->seq;
+    frame->mask = SLE_CARGO_FIELD_ALL;
+    frame->event_count = 0;
+    frame->events = NULL;
+
+    switch (frame->type) {
+        case SLE_CARGO_FRAME_SNAPSHOT:
+            // 长度只做下限检查，尾部多出的字段留给后续扩展
+            if (len < SLE_CARGO_SNAPSHOT_LEN) {
+                return SLE_CARGO_ERR_TRUNCATED;
+            }
+            frame->snapshot.jiangsu = get_le32(&buf[SLE_CARGO_HDR_LEN]);
+            frame->snapshot.zhejiang = get_le32(&buf[SLE_CARGO_HDR_LEN + 4]);
+            frame->snapshot.shanghai = get_le32(&buf[SLE_CARGO_HDR_LEN + 8]);
+            frame->snapshot.tick = get_le32(&buf[SLE_CARGO_HDR_LEN + 12]);
+            return SLE_CARGO_OK;
+        case SLE_CARGO_FRAME_DELTA: {
+            if (len < SLE_CARGO_DELTA_MIN_LEN) {
+                return SLE_CARGO_ERR_TRUNCATED;
+            }
+            uint16_t idx = SLE_CARGO_HDR_LEN;
+            frame->base_seq = get_le16(&buf[idx]);
+            idx += 2;
+            frame->mask = buf[idx++];
+            if ((frame->mask & ~SLE_CARGO_FIELD_ALL) != 0) {
+                return SLE_CARGO_ERR_MASK;
+            }
+            if (len < SLE_CARGO_DELTA_MIN_LEN + 4 * mask_count(frame->mask)) {
+                return SLE_CARGO_ERR_TRUNCATED;
+            }
+            memset(&frame->snapshot, 0, sizeof(frame->snapshot));
+            if (frame->mask & SLE_CARGO_FIELD_JIANGSU) {
+                frame->snapshot.jiangsu = get_le32(&buf[idx]);
+                idx += 4;
+            }
+            if (frame->mask & SLE_CARGO_FIELD_ZHEJIANG) {
+                frame->snapshot.zhejiang = get_le32(&buf[idx]);
+                idx += 4;
+            }
+            if (frame->mask & SLE_CARGO_FIELD_SHANGHAI) {
+                frame->snapshot.shanghai = get_le32(&buf[idx]);
+                idx += 4;
+            }
+            frame->snapshot.tick = get_le32(&buf[idx]);
+            return SLE_CARGO_OK;
+        }
+        case SLE_CARGO_FRAME_EVENTS: {
+            if (len < SLE_CARGO_HDR_LEN + 1) {
+                return SLE_CARGO_ERR_TRUNCATED;
+            }
+            uint8_t count = buf[SLE_CARGO_HDR_LEN];
+            if (count == 0 || count > SLE_CARGO_EVENT_BATCH_MAX) {
+                return SLE_CARGO_ERR_EVENT;
+            }
+            if (len < SLE_CARGO_HDR_LEN + 1 + count * SLE_CARGO_EVENT_LEN) {
+                return SLE_CARGO_ERR_TRUNCATED;
+            }
+            // 记录留在输入缓冲区中按需读取，这里只校验地区
+            const uint8_t *rec = &buf[SLE_CARGO_HDR_LEN + 1];
+            for (uint8_t i = 0; i < count; i++, rec += SLE_CARGO_EVENT_LEN) {
+                if ((rec[3] & ~SLE_CARGO_EVENT_NO_ID) >= SLE_CARGO_REGION_MAX) {
+                    return SLE_CARGO_ERR_EVENT;
+                }
+            }
+            memset(&frame->snapshot, 0, sizeof(frame->snapshot));
+            frame->mask = 0;
+            frame->event_count = count;
+            frame->events = &buf[SLE_CARGO_HDR_LEN + 1];
+            return SLE_CARGO_OK;
+        }
+        case SLE_CARGO_FRAME_ACK: {
+            if (len < SLE_CARGO_ACK_LEN) {
+                return SLE_CARGO_ERR_TRUNCATED;
+            }
+            const uint8_t *p = &buf[SLE_CARGO_HDR_LEN];
+            memset(&frame->snapshot, 0, sizeof(frame->snapshot));
+            frame->mask = 0;
+            frame->ack.last_seq = get_le16(p);
+            frame->ack.total = get_le32(&p[2]);
+            frame->ack.flags = p[6];
+            frame->ack.display_lag_ms = get_le16(&p[7]);
+            frame->ack.echo_tick = get_le32(&p[9]);
+            return SLE_CARGO_OK;
+        }
+        case SLE_CARGO_FRAME_FRAG: {
+            if (len < SLE_CARGO_FRAG_HDR_LEN) {
+                return SLE_CARGO_ERR_TRUNCATED;
+            }
+            const uint8_t *p = &buf[SLE_CARGO_HDR_LEN];
+            memset(&frame->snapshot, 0, sizeof(frame->snapshot));
+            frame->mask = 0;
+            frame->frag.msg_id = get_le16(p);
+            frame->frag.total_len = get_le16(&p[2]);
+            frame->frag.offset = get_le16(&p[4]);
+            frame->frag.kind = p[6];
+            frame->frag.data_len = (uint16_t)(len - SLE_CARGO_FRAG_HDR_LEN);
+            frame->frag.data = &buf[SLE_CARGO_FRAG_HDR_LEN];
+            if (frame->frag.data_len == 0 ||
+                (uint32_t)frame->frag.offset + frame->frag.data_len > frame->frag.total_len) {
+                return SLE_CARGO_ERR_FRAG;
+            }
+            return SLE_CARGO_OK;
+        }
+        case SLE_CARGO_FRAME_BENCH: {
+            if (len < SLE_CARGO_BENCH_HDR_LEN) {
+                return SLE_CARGO_ERR_TRUNCATED;
+            }
+            const uint8_t *p = &buf[SLE_CARGO_HDR_LEN];
+            memset(&frame->snapshot, 0, sizeof(frame->snapshot));
+            frame->mask = 0;
+            frame->bench.run_id = p[0];
+            frame->bench.flags = p[1];
+            frame->bench.seq = get_le32(&p[2]);
+            frame->bench.tx_us = get_le32(&p[6]);
+            frame->bench.len = len;
+            return SLE_CARGO_OK;
+        }
+        case SLE_CARGO_FRAME_BENCH_REPORT: {
+            if (len < SLE_CARGO_BENCH_REPORT_LEN) {
+                return SLE_CARGO_ERR_TRUNCATED;
+            }
+            const uint8_t *p = &buf[SLE_CARGO_HDR_LEN];
+            sle_cargo_bench_report_t *r = &frame->bench_report;
+            memset(&frame->snapshot, 0, sizeof(frame->snapshot));
+            frame->mask = 0;
+            r->run_id = p[0];
+            r->flags = p[1];
+            r->frames = get_le32(&p[2]);
+            r->bytes = get_le32(&p[6]);
+            r->lost = get_le32(&p[10]);
+            r->reordered = get_le32(&p[14]);
+            r->dups = get_le32(&p[18]);
+            r->elapsed_ms = get_le32(&p[22]);
+            r->jitter_us = get_le32(&p[26]);
+            r->frame_len = get_le16(&p[30]);
+            return SLE_CARGO_OK;
+        }
+        case SLE_CARGO_FRAME_HIST_REQ: {
+            if (len < SLE_CARGO_HIST_REQ_LEN) {
+                return SLE_CARGO_ERR_TRUNCATED;
+            }
+            const uint8_t *p = &buf[SLE_CARGO_HDR_LEN];
+            memset(&frame->snapshot, 0, sizeof(frame->snapshot));
+            frame->mask = 0;
+            frame->hist_req.tier = p[0];
+            frame->hist_req.buckets = get_le16(&p[1]);
+            return SLE_CARGO_OK;
+        }
+        case SLE_CARGO_FRAME_CLOCK: {
+            if (len < SLE_CARGO_CLOCK_LEN) {
+                return SLE_CARGO_ERR_TRUNCATED;
+            }
+            const uint8_t *p = &buf[SLE_CARGO_HDR_LEN];
+            memset(&frame->snapshot, 0, sizeof(frame->snapshot));
+            frame->mask = 0;
+            frame->clock.flags = p[0];
+            frame->clock.t1 = get_le32(&p[1]);
+            frame->clock.t2 = get_le32(&p[5]);
+            frame->clock.t3 = get_le32(&p[9]);
+            return SLE_CARGO_OK;
+        }
+        default:
+            return SLE_CARGO_ERR_TYPE;
+    }
+}
+
+// 文本帧 "J:xxx,Z:xxx,S:xxx,T:timestamp": 字段顺序不限，T可省略，单遍扫描并逐位累加数值
+static sle_cargo_err_t decode_text(const uint8_t *buf, uint16_t len, sle_cargo_frame_t *frame)
+{
+    uint32_t values[4] = {0};  // J, Z, S, T
+    uint8_t seen = 0;
+    uint16_t i = 0;
+
+    // 允许发送端把字符串结束符一起发出
+    while (len > 0 && buf[len - 1] == '\0') {
+        len--;
+    }
+    if (len == 0) {
+        return SLE_CARGO_ERR_EMPTY;
+    }
+
+    while (i < len) {
+        uint8_t field;
+        if (i + 2 > len) {
+            return SLE_CARGO_ERR_TRUNCATED;
+        }
+        switch (buf[i]) {
+            case 'J': field = 0; break;
+            case 'Z': field = 1; break;
+            case 'S': field = 2; break;
+            case 'T': field = 3; break;
+            default: return SLE_CARGO_ERR_KEY;
+        }
+        if (buf[i + 1] != ':') {
+            return SLE_CARGO_ERR_KEY;
+        }
+        if (seen & (1U << field)) {
+            return SLE_CARGO_ERR_DUP_KEY;
+        }
+        i += 2;
+
+        uint32_t value = 0;
+        uint16_t digits = 0;
+        while (i < len && buf[i] != ',') {
+            uint8_t c = buf[i];
+            if (c < '0' || c > '9') {
+                return SLE_CARGO_ERR_NUMBER;
+            }
+            if (value > (UINT32_MAX - (uint32_t)(c - '0')) / 10) {
+                return SLE_CARGO_ERR_OVERFLOW;
+            }
+            value = value * 10 + (uint32_t)(c - '0');
+            digits++;
+            i++;
+        }
+        if (digits == 0) {
+            return SLE_CARGO_ERR_NUMBER;
+        }
+        values[field] = value;
+        seen |= (uint8_t)(1U << field);
+
+        // 跳过分隔符，分隔符后必须还有字段
+        if (i < len && ++i == len) {
+            return SLE_CARGO_ERR_TRUNCATED;
+        }
+    }
+
+    if ((seen & 0x07) != 0x07) {
+        return SLE_CARGO_ERR_MISSING;
+    }
+
+    frame->wire = SLE_CARGO_WIRE_TEXT;
+    frame->type = SLE_CARGO_FRAME_SNAPSHOT;
+    frame->seq = 0;
+    frame->base_seq = 0;
+    frame->mask = SLE_CARGO_FIELD_ALL;
+    frame->event_count = 0;
+    frame->events = NULL;
+    frame->snapshot.jiangsu = values[0];
+    frame->snapshot.zhejiang = values[1];
+    frame->snapshot.shanghai = values[2];
+    frame->snapshot.tick = values[3];
+    return SLE_CARGO_OK;
+}
+
+sle_cargo_err_t sle_cargo_decode(const uint8_t *buf, uint16_t len, sle_cargo_frame_t *frame)
+{
+    if (buf == NULL || frame == NULL) {
+        return SLE_CARGO_ERR_PARAM;
+    }
+    if (len == 0) {
+        return SLE_CARGO_ERR_EMPTY;
+    }
+
+    if (buf[0] == SLE_CARGO_MAGIC) {
+        return decode_binary(buf, len, frame);
+    }
+    return decode_text(buf, len, frame);
+}
+
+const char *sle_cargo_err_str(sle_cargo_err_t err)
+{
+    static const char * const err_str[] = {
+        "ok",
+        "null parameter",
+        "empty payload",
+        "truncated frame",
+        "unsupported version",
+        "unknown frame type",
+        "bad field name",
+        "duplicate field",
+        "bad number",
+        "number overflow",
+        "missing J/Z/S field",
+        "bad field mask",
+        "bad event record",
+        "bad fragment range",
+    };
+
+    if ((uint32_t)err >= sizeof(err_str) / sizeof(err_str[0])) {
+        return "unknown error";
+    }
+    return err_str[err];
+}
+
+uint16_t sle_cargo_encode_delta(uint8_t *buf, uint16_t cap, uint16_t seq, uint16_t base_seq, uint8_t mask,
+                                const sle_cargo_snapshot_t *snap)
+{
+    if (buf == NULL || snap == NULL || (mask & ~SLE_CARGO_FIELD_ALL) != 0 || cap < SLE_CARGO_DELTA_MAX_LEN) {
+        return 0;
+    }
+
+    uint16_t idx = SLE_CARGO_HDR_LEN;
+    put_header(buf, SLE_CARGO_FRAME_DELTA, seq);
+    put_le16(&buf[idx], base_seq);
+    idx += 2;
+    buf[idx++] = mask;
+    if (mask & SLE_CARGO_FIELD_JIANGSU) {
+        put_le32(&buf[idx], snap->jiangsu);
+        idx += 4;
+    }
+    if (mask & SLE_CARGO_FIELD_ZHEJIANG) {
+        put_le32(&buf[idx], snap->zhejiang);
+        idx += 4;
+    }
+    if (mask & SLE_CARGO_FIELD_SHANGHAI) {
+        put_le32(&buf[idx], snap->shanghai);
+        idx += 4;
+    }
+    put_le32(&buf[idx], snap->tick);
+    idx += 4;
+    return idx;
+}
+
+uint16_t sle_cargo_encode_events(uint8_t *buf, uint16_t cap, uint16_t seq, const sle_cargo_event_t *events,
+                                 uint8_t count)
+{
+    if (buf == NULL || events == NULL || count == 0 || count > SLE_CARGO_EVENT_BATCH_MAX ||
+        cap < SLE_CARGO_HDR_LEN + 1 + count * SLE_CARGO_EVENT_LEN) {
+        return 0;
+    }
+
+    uint16_t idx = SLE_CARGO_HDR_LEN;
+    put_header(buf, SLE_CARGO_FRAME_EVENTS, seq);
+    buf[idx++] = count;
+    for (uint8_t i = 0; i < count; i++) {
+        put_le16(&buf[idx], events[i].no);
+        buf[idx + 2] = events[i].item_id;
+        buf[idx + 3] = events[i].region;
+        put_le32(&buf[idx + 4], events[i].tick);
+        idx += SLE_CARGO_EVENT_LEN;
+    }
+    return idx;
+}
+
+uint16_t sle_cargo_encode_ack(uint8_t *buf, uint16_t cap, uint16_t seq, const sle_cargo_ack_t *ack)
+{
+    if (buf == NULL || ack == NULL || cap < SLE_CARGO_ACK_LEN) {
+        return 0;
+    }
+
+    uint8_t *p = &buf[SLE_CARGO_HDR_LEN];
+    put_header(buf, SLE_CARGO_FRAME_ACK, seq);
+    put_le16(p, ack->last_seq);
+    put_le32(&p[2], ack->total);
+    p[6] = ack->flags;
+    put_le16(&p[7], ack->display_lag_ms);
+    put_le32(&p[9], ack->echo_tick);
+    return SLE_CARGO_ACK_LEN;
+}
+
+uint16_t sle_cargo_encode_frag(uint8_t *buf, uint16_t cap, uint16_t seq, const sle_cargo_frag_t *frag)
+{
+    if (buf == NULL || frag == NULL || frag->data == NULL || frag->data_len == 0 ||
+        (uint32_t)frag->offset + frag->data_len > frag->total_len ||
+        cap < SLE_CARGO_FRAG_HDR_LEN + frag->data_len) {
+        return 0;
+    }
+
+    uint8_t *p = &buf[SLE_CARGO_HDR_LEN];
+    put_header(buf, SLE_CARGO_FRAME_FRAG, seq);
+    put_le16(p, frag->msg_id);
+    put_le16(&p[2], frag->total_len);
+    put_le16(&p[4], frag->offset);
+    p[6] = frag->kind;
+    memcpy(&buf[SLE_CARGO_FRAG_HDR_LEN], frag->data, frag->data_len);
+    return (uint16_t)(SLE_CARGO_FRAG_HDR_LEN + frag->data_len);
+}
+
+bool sle_cargo_event_get(const sle_cargo_frame_t *frame, uint8_t idx, sle_cargo_event_t *event)
+{
+    if (frame == NULL || event == NULL || frame->events == NULL || idx >= frame->event_count) {
+        return false;
+    }
+
+    const uint8_t *rec = &frame->events[idx * SLE_CARGO_EVENT_LEN];
+    event->no = get_le16(rec);
+    event->item_id = rec[2];
+    event->region = rec[3];
+    event->tick = get_le32(&rec[4]);
+    return true;
+}
+
+bool sle_cargo_is_binary(const uint8_t *buf, uint16_t len)
+{
+    return (buf != NULL && len >= SLE_CARGO_HDR_LEN && buf[0] == SLE_CARGO_MAGIC);
+}
+
+uint8_t sle_cargo_frame_type(const uint8_t *buf, uint16_t len)
+{
+    if (!sle_cargo_is_binary(buf, len) || buf[1] != SLE_CARGO_VERSION) {
+        return 0;
+    }
+    return buf[2];
+}
+
+uint16_t sle_cargo_encode_bench(uint8_t *buf, uint16_t cap, const sle_cargo_bench_t *bench)
+{
+    if (buf == NULL || bench == NULL || bench->len < SLE_CARGO_BENCH_HDR_LEN || cap < bench->len) {
+        return 0;
+    }
+
+    uint8_t *p = &buf[SLE_CARGO_HDR_LEN];
+    put_header(buf, SLE_CARGO_FRAME_BENCH, (uint16_t)bench->seq);
+    p[0] = bench->run_id;
+    p[1] = bench->flags;
+    put_le32(&p[2], bench->seq);
+    put_le32(&p[6], bench->tx_us);
+    // 填充内容不参与统计，用递增图样便于抓包时辨认
+    for (uint16_t i = SLE_CARGO_BENCH_HDR_LEN; i < bench->len; i++) {
+        buf[i] = (uint8_t)i;
+    }
+    return bench->len;
+}
+
+uint16_t sle_cargo_encode_bench_report(uint8_t *buf, uint16_t cap, uint16_t seq,
+                                       const sle_cargo_bench_report_t *report)
+{
+    if (buf == NULL || report == NULL || cap < SLE_CARGO_BENCH_REPORT_LEN) {
+        return 0;
+    }
+
+    uint8_t *p = &buf[SLE_CARGO_HDR_LEN];
+    put_header(buf, SLE_CARGO_FRAME_BENCH_REPORT, seq);
+    p[0] = report->run_id;
+    p[1] = report->flags;
+    put_le32(&p[2], report->frames);
+    put_le32(&p[6], report->bytes);
+    put_le32(&p[10], report->lost);
+    put_le32(&p[14], report->reordered);
+    put_le32(&p[18], report->dups);
+    put_le32(&p[22], report->elapsed_ms);
+    put_le32(&p[26], report->jitter_us);
+    put_le16(&p[30], report->frame_len);
+    return SLE_CARGO_BENCH_REPORT_LEN;
+}
+
+uint16_t sle_cargo_encode_hist_req(uint8_t *buf, uint16_t cap, uint16_t seq, const sle_cargo_hist_req_t *req)
+{
+    if (buf == NULL || req == NULL || cap < SLE_CARGO_HIST_REQ_LEN) {
+        return 0;
+    }
+
+    uint8_t *p = &buf[SLE_CARGO_HDR_LEN];
+    put_header(buf, SLE_CARGO_FRAME_HIST_REQ, seq);
+    p[0] = req->tier;
+    put_le16(&p[1], req->buckets);
+    return SLE_CARGO_HIST_REQ_LEN;
+}
+
+uint16_t sle_cargo_encode_clock(uint8_t *buf, uint16_t cap, uint16_t seq, const sle_cargo_clock_msg_t *msg)
+{
+    if (buf == NULL || msg == NULL || cap < SLE_CARGO_CLOCK_LEN) {
+        return 0;
+    }
+
+    uint8_t *p = &buf[SLE_CARGO_HDR_LEN];
+    put_header(buf, SLE_CARGO_FRAME_CLOCK, seq);
+    p[0] = msg->flags;
+    put_le32(&p[1], msg->t1);
+    put_le32(&p[5], msg->t2);
+    put_le32(&p[9], msg->t3);
+    return SLE_CARGO_CLOCK_LEN;
+}
+
+uint16_t sle_cargo_encode_text(char *buf, uint16_t cap, const sle_cargo_snapshot_t *snap)
+{
+    if (buf == NULL || snap == NULL || cap == 0) {
+        return 0;
+    }
+
+    int len = snprintf(buf, cap, "J:%u,Z:%u,S:%u,T:%llu",
+                       snap->jiangsu, snap->zhejiang, snap->shanghai, (unsigned long long)snap->tick);
+    if (len <= 0 || len >= (int)cap) {
+        return 0;
+    }
+    return (uint16_t)len;
+}
+
+uint16_t sle_cargo_adv_put_proto(uint8_t *buf, uint16_t cap)
+{
+    if (buf == NULL || cap < SLE_CARGO_ADV_PROTO_PHY_LEN) {
+        return 0;
+    }
+
+    // 与其他广播字段一致: length(含type) + type + value；旧版客户端只检查前两个字节
+    buf[0] = SLE_CARGO_ADV_PROTO_PHY_LEN - 1;
+    buf[1] = SLE_CARGO_ADV_TYPE_PROTO;
+    buf[2] = SLE_CARGO_MAGIC;
+    buf[3] = SLE_CARGO_VERSION;
+    buf[4] = SLE_CARGO_PHY_CAPS | SLE_CARGO_PHY_CAP_1M;
+    return SLE_CARGO_ADV_PROTO_PHY_LEN;
+}
+
+// 查找协议能力字段，返回字段内容(type之后)及其长度
+static const uint8_t *adv_find_proto_field(const uint8_t *data, uint16_t len, uint8_t *field_len)
+{
+    if (data == NULL) {
+        return NULL;
+    }
+
+    uint16_t idx = 0;
+    while (idx + 1 < len) {
+        uint8_t flen = data[idx];
+        if (flen == 0 || idx + 1 + flen > len) {
+            break;
+        }
+        const uint8_t *field = &data[idx + 1];
+        if (field[0] == SLE_CARGO_ADV_TYPE_PROTO && flen >= SLE_CARGO_ADV_PROTO_LEN - 1 &&
+            field[1] == SLE_CARGO_MAGIC && field[2] >= SLE_CARGO_VERSION) {
+            *field_len = flen;
+            return field;
+        }
+        idx += 1 + flen;
+    }
+    return NULL;
+}
+
+sle_cargo_wire_t sle_cargo_adv_find_proto(const uint8_t *data, uint16_t len)
+{
+    uint8_t field_len = 0;
+    return (adv_find_proto_field(data, len, &field_len) != NULL) ? SLE_CARGO_WIRE_BINARY : SLE_CARGO_WIRE_TEXT;
+}
+
+uint8_t sle_cargo_adv_find_phy_caps(const uint8_t *data, uint16_t len)
+{
+    uint8_t field_len = 0;
+    const uint8_t *field = adv_find_proto_field(data, len, &field_len);
+    if (field == NULL || field_len < SLE_CARGO_ADV_PROTO_PHY_LEN - 1) {
+        return SLE_CARGO_PHY_CAP_1M;
+    }
+    return field[3] | SLE_CARGO_PHY_CAP_1M;
+}
+
+uint16_t sle_cargo_adv_put_service(uint8_t *buf, uint16_t cap)
+{
+    if (buf == NULL || cap < SLE_CARGO_ADV_SERVICE_LEN) {
+        return 0;
+    }
+
+    buf[0] = SLE_CARGO_ADV_SERVICE_LEN - 1;
+    buf[1] = SLE_CARGO_ADV_TYPE_UUID16_LIST;
+    buf[2] = (uint8_t)(SLE_CARGO_ADV_SERVICE_UUID & 0xFF);
+    buf[3] = (uint8_t)(SLE_CARGO_ADV_SERVICE_UUID >> 8);
+    return SLE_CARGO_ADV_SERVICE_LEN;
+}
+
+uint16_t sle_cargo_adv_put_name(uint8_t *buf, uint16_t cap)
+{
+    uint16_t name_len = (uint16_t)(sizeof(SLE_CARGO_ADV_SERVER_NAME) - 1);
+    if (buf == NULL || cap < name_len + 2) {
+        return 0;
+    }
+
+    buf[0] = (uint8_t)(name_len + 1); // 长度包含type字节
+    buf[1] = SLE_CARGO_ADV_TYPE_LOCAL_NAME;
+    memcpy(&buf[2], SLE_CARGO_ADV_SERVER_NAME, name_len);
+    return name_len + 2;
+}
+
+// 名称字段: 与完整名称一致，或是不短于 SLE_CARGO_ADV_NAME_MIN_LEN 的前缀(旧固件/缩写名称)
+static bool sle_cargo_adv_name_match(const uint8_t *name, uint8_t len)
+{
+    uint8_t full = (uint8_t)(sizeof(SLE_CARGO_ADV_SERVER_NAME) - 1);
+    return len >= SLE_CARGO_ADV_NAME_MIN_LEN && len <= full && memcmp(name, SLE_CARGO_ADV_SERVER_NAME, len) == 0;
+}
+
+bool sle_cargo_adv_match_server(const uint8_t *data, uint16_t len)
+{
+    if (data == NULL) {
+        return false;
+    }
+
+    uint16_t idx = 0;
+    while (idx + 1 < len) {
+        uint8_t field_len = data[idx];
+        if (field_len == 0) {
+            break;
+        }
+        // 长度越界时按剩余字节解析，旧版63B的名称字段长度少1，最后一个字符落在字段之外
+        uint16_t avail = (uint16_t)(len - idx - 1);
+        const uint8_t *field = &data[idx + 1];
+        uint8_t value_len = (uint8_t)(((field_len < avail) ? field_len : avail) - 1);
+        const uint8_t *value = &field[1];
+        if (field[0] == SLE_CARGO_ADV_TYPE_UUID16_LIST) {
+            for (uint8_t i = 0; i + 1 < value_len; i += 2) {
+                if ((value[i] | (value[i + 1] << 8)) == SLE_CARGO_ADV_SERVICE_UUID) {
+                    return true;
+                }
+            }
+        } else if (field[0] == SLE_CARGO_ADV_TYPE_LOCAL_NAME || field[0] == SLE_CARGO_ADV_TYPE_SHORT_NAME) {
+            if (sle_cargo_adv_name_match(value, value_len)) {
+                return true;
+            }
+        }
+        idx += 1 + field_len;
+    }
+    return false;
+}
@@ -0,0 +1,465 @@
+/*
+ * Copyright (c) 2024 HiSilicon Technologies CO., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SLE_CARGO_PROTO_H
+#define SLE_CARGO_PROTO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+#endif /* __cplusplus */
+
+// 二进制帧头: magic(1) + version(1) + type(1) + seq(2)，多字节字段均为小端
+#define SLE_CARGO_MAGIC             0xC5
+#define SLE_CARGO_VERSION           1
+#define SLE_CARGO_HDR_LEN           5
+
+// 快照帧(关键帧): 帧头 + J(4) + Z(4) + S(4) + tick(4)
+#define SLE_CARGO_SNAPSHOT_LEN      (SLE_CARGO_HDR_LEN + 16)
+
+// 增量帧: 帧头 + base_seq(2) + mask(1) + 变化字段的绝对值(每个4) + tick(4)
+#define SLE_CARGO_DELTA_MIN_LEN     (SLE_CARGO_HDR_LEN + 7)
+#define SLE_CARGO_DELTA_MAX_LEN     (SLE_CARGO_DELTA_MIN_LEN + 12)
+
+// 增量帧字段掩码
+#define SLE_CARGO_FIELD_JIANGSU     0x01
+#define SLE_CARGO_FIELD_ZHEJIANG    0x02
+#define SLE_CARGO_FIELD_SHANGHAI    0x04
+#define SLE_CARGO_FIELD_ALL         0x07
+
+// 事件帧: 帧头 + count(1) + count个事件记录，记录为 no(2) + item_id(1) + region(1) + tick(4)
+#define SLE_CARGO_EVENT_LEN         8
+#define SLE_CARGO_EVENT_BATCH_MAX   16
+#define SLE_CARGO_EVENTS_MAX_LEN    (SLE_CARGO_HDR_LEN + 1 + SLE_CARGO_EVENT_BATCH_MAX * SLE_CARGO_EVENT_LEN)
+
+// 事件记录 region 字段的标志位: 该件货物没有条码编号 (例如 "SORT:x" 指令)
+#define SLE_CARGO_EVENT_NO_ID       0x80
+
+// 确认帧(63B->WS63): 帧头 + last_seq(2) + total(4) + flags(1) + display_lag_ms(2) + echo_tick(4)
+#define SLE_CARGO_ACK_LEN           (SLE_CARGO_HDR_LEN + 13)
+
+// 确认帧标志位
+#define SLE_CARGO_ACK_SYNCED            0x01    // 已由关键帧建立基准
+#define SLE_CARGO_ACK_NEED_KEYFRAME     0x02    // 缺少增量帧的基准，需要关键帧
+#define SLE_CARGO_ACK_EVENT_GAP         0x04    // 事件编号不连续，需要重发 total 之后的事件
+#define SLE_CARGO_ACK_DISPLAY_CURRENT   0x08    // 显示屏已显示最新状态
+#define SLE_CARGO_ACK_RTT_VALID         0x10    // 由刚应用的快照/增量帧触发，echo_tick 为该帧的发送时刻
+
+// display_lag_ms 未知
+#define SLE_CARGO_ACK_LAG_UNKNOWN       0xFFFF
+
+// 分片帧: 帧头 + msg_id(2) + total_len(2) + offset(2) + kind(1) + 数据，帧头序号为分片在消息中的序号
+#define SLE_CARGO_FRAG_HDR_LEN      (SLE_CARGO_HDR_LEN + 7)
+
+// 压测帧(WS63->63B): 帧头 + run_id(1) + flags(1) + seq(4) + tx_us(4) + 填充，帧头序号为 seq 的低16位
+#define SLE_CARGO_BENCH_HDR_LEN     (SLE_CARGO_HDR_LEN + 10)
+// 压测报告帧(63B->WS63): 帧头 + run_id(1) + flags(1) + frames(4) + bytes(4) + lost(4) + reordered(4) + dups(4)
+//                         + elapsed_ms(4) + jitter_us(4) + frame_len(2)
+#define SLE_CARGO_BENCH_REPORT_LEN  (SLE_CARGO_HDR_LEN + 32)
+// 压测帧/报告帧标志位: 本轮最后一帧 / 本轮最终报告
+#define SLE_CARGO_BENCH_LAST        0x01
+
+// 速率历史请求帧(WS63->63B): 帧头 + tier(1) + buckets(2)，63B以 SLE_CARGO_BULK_RATE_HISTORY 大消息回复
+#define SLE_CARGO_HIST_REQ_LEN      (SLE_CARGO_HDR_LEN + 3)
+
+// 对时帧(双向): 帧头 + flags(1) + t1(4) + t2(4) + t3(4)。63B以notify发出请求只填t1，
+// WS63原样带回t1并填上收到请求的时刻t2和发出回复的时刻t3，标志置 SLE_CARGO_CLOCK_PONG，见 sle_cargo_clock
+#define SLE_CARGO_CLOCK_LEN         (SLE_CARGO_HDR_LEN + 13)
+// 对时帧标志位: 回复
+#define SLE_CARGO_CLOCK_PONG        0x01
+
+// 旧版文本帧 "J:xxx,Z:xxx,S:xxx,T:timestamp" 的最大长度
+#define SLE_CARGO_TEXT_MAX_LEN      64
+
+// 广播数据中的协议能力字段: len + type + magic + version [+ phy_caps]
+#define SLE_CARGO_ADV_TYPE_PROTO    0xFF
+#define SLE_CARGO_ADV_PROTO_LEN     4
+// 带PHY能力位的字段长度；旧版固件的字段没有该字节，视为只支持1M
+#define SLE_CARGO_ADV_PROTO_PHY_LEN 5
+
+// PHY能力位，位序与协议栈的PHY编号 (1M=0, 2M=1, 4M=2) 一致
+#define SLE_CARGO_PHY_CAP_1M        0x01
+#define SLE_CARGO_PHY_CAP_2M        0x02
+#define SLE_CARGO_PHY_CAP_4M        0x04
+// 本板支持的PHY，写入广播并参与协商；置为 SLE_CARGO_PHY_CAP_1M 则始终使用1M
+#ifndef SLE_CARGO_PHY_CAPS
+#define SLE_CARGO_PHY_CAPS          (SLE_CARGO_PHY_CAP_1M | SLE_CARGO_PHY_CAP_2M | SLE_CARGO_PHY_CAP_4M)
+#endif
+
+// 货物服务器的身份字段: 广播数据中的16位服务UUID列表，扫描响应中的设备名称
+#define SLE_CARGO_ADV_TYPE_UUID16_LIST  0x05    // 完整的16位服务UUID列表
+#define SLE_CARGO_ADV_TYPE_SHORT_NAME   0x0A
+#define SLE_CARGO_ADV_TYPE_LOCAL_NAME   0x0B
+#define SLE_CARGO_ADV_SERVICE_UUID      0xABCD
+#define SLE_CARGO_ADV_SERVICE_LEN       4
+#define SLE_CARGO_ADV_SERVER_NAME       "CARGO_SERVER_63B"
+// 旧版63B固件把名称字段长度少算了1字节，对端只能解析出前15个字符
+#define SLE_CARGO_ADV_NAME_MIN_LEN      15
+
+// 板上编解码计时开关，默认关闭；编解码正确性由主机测试 sle_cargo_common/test 校验
+#ifndef SLE_CARGO_PROTO_BENCH
+#define SLE_CARGO_PROTO_BENCH       0
+#endif
+
+// 帧类型
+typedef enum {
+    SLE_CARGO_FRAME_SNAPSHOT = 0x01,  // 三个地区的累计计数(关键帧)
+    SLE_CARGO_FRAME_DELTA = 0x02,     // 相对已确认状态发生变化的计数
+    SLE_CARGO_FRAME_EVENTS = 0x03,    // 逐件分拣事件，一次写入可携带多条
+    SLE_CARGO_FRAME_ACK = 0x04,       // 63B通过notify回报的接收状态
+    SLE_CARGO_FRAME_FRAG = 0x05,      // 大消息的一个分片，由 sle_cargo_frag 拆分和重组
+    SLE_CARGO_FRAME_BENCH = 0x06,     // 链路压测帧，见 sle_cargo_bench
+    SLE_CARGO_FRAME_BENCH_REPORT = 0x07, // 63B通过notify回报的压测结果
+    SLE_CARGO_FRAME_HIST_REQ = 0x08,  // 请求63B导出分拣速率历史，见 sle_cargo_history
+    SLE_CARGO_FRAME_CLOCK = 0x09,     // 两块板之间的对时请求/回复，见 sle_cargo_clock
+} sle_cargo_frame_type_t;
+
+// 分拣去向地区，与 WS63 的 sort_type 一致
+typedef enum {
+    SLE_CARGO_REGION_JIANGSU = 0,
+    SLE_CARGO_REGION_ZHEJIANG = 1,
+    SLE_CARGO_REGION_SHANGHAI = 2,
+    SLE_CARGO_REGION_MAX,
+} sle_cargo_region_t;
+
+// 链路上使用的编码格式，连接时根据对端广播确定
+typedef enum {
+    SLE_CARGO_WIRE_TEXT = 0,    // 旧版文本格式，兼容老固件
+    SLE_CARGO_WIRE_BINARY = 1,  // 定长小端二进制帧
+} sle_cargo_wire_t;
+
+// 解码结果
+typedef enum {
+    SLE_CARGO_OK = 0,
+    SLE_CARGO_ERR_PARAM,      // 参数为空
+    SLE_CARGO_ERR_EMPTY,      // 数据长度为0
+    SLE_CARGO_ERR_TRUNCATED,  // 数据不完整
+    SLE_CARGO_ERR_VERSION,    // 二进制帧版本不支持
+    SLE_CARGO_ERR_TYPE,       // 二进制帧类型未知
+    SLE_CARGO_ERR_KEY,        // 文本字段名非法
+    SLE_CARGO_ERR_DUP_KEY,    // 文本字段重复
+    SLE_CARGO_ERR_NUMBER,     // 数值为空或含非数字字符
+    SLE_CARGO_ERR_OVERFLOW,   // 数值超出32位范围
+    SLE_CARGO_ERR_MISSING,    // 缺少J/Z/S字段
+    SLE_CARGO_ERR_MASK,       // 增量帧字段掩码非法
+    SLE_CARGO_ERR_EVENT,      // 事件帧条数或地区非法
+    SLE_CARGO_ERR_FRAG,       // 分片偏移或长度超出消息长度
+} sle_cargo_err_t;
+
+// 货物计数快照
+typedef struct {
+    uint32_t jiangsu;   // 江苏货物数量
+    uint32_t zhejiang;  // 浙江货物数量
+    uint32_t shanghai;  // 上海货物数量
+    uint32_t tick;      // 发送端 osKernelGetTickCount
+} sle_cargo_snapshot_t;
+
+// 单件分拣事件
+typedef struct {
+    uint16_t no;        // 事件编号 = 该件计入后发送端三地累计总数(低16位)，接收端据此去重
+    uint8_t item_id;    // 货物编号 (sort_info 中的 id)
+    uint8_t region;     // sle_cargo_region_t，可带 SLE_CARGO_EVENT_NO_ID 标志
+    uint32_t tick;      // 发送端收到该事件时的 osKernelGetTickCount
+} sle_cargo_event_t;
+
+// 接收状态确认
+typedef struct {
+    uint16_t last_seq;          // 最近应用的快照/增量帧序号
+    uint32_t total;             // 已计入的三地累计总数，事件按此去重
+    uint8_t flags;              // SLE_CARGO_ACK_*
+    uint16_t display_lag_ms;    // 显示最新时为状态更新到上屏的耗时，否则为最新状态等待上屏的时长
+    uint32_t echo_tick;         // 最近应用的帧/事件携带的发送端 tick，发送端据此计算往返时延
+} sle_cargo_ack_t;
+
+// 大消息的一个分片
+typedef struct {
+    uint16_t msg_id;            // 消息编号，同一链路上每条新消息加1
+    uint16_t total_len;         // 整条消息的长度
+    uint16_t offset;            // 本分片数据在消息中的偏移
+    uint8_t kind;               // 消息内容类型，sle_cargo_bulk_kind_t
+    uint16_t data_len;
+    const uint8_t *data;        // 解码时指向输入缓冲区
+} sle_cargo_frag_t;
+
+// 压测帧
+typedef struct {
+    uint8_t run_id;             // 压测轮次，新一轮重新统计
+    uint8_t flags;              // SLE_CARGO_BENCH_LAST
+    uint32_t seq;               // 本轮内从0开始的帧序号
+    uint32_t tx_us;             // 发送时刻 (发送端微秒计时的低32位)
+    uint16_t len;               // 整帧长度，含填充
+} sle_cargo_bench_t;
+
+// 压测结果
+typedef struct {
+    uint8_t run_id;
+    uint8_t flags;              // SLE_CARGO_BENCH_LAST 表示本轮已结束
+    uint32_t frames;            // 收到的帧数，含重复
+    uint32_t bytes;             // 收到的字节数
+    uint32_t lost;              // 按最大序号推算仍未收到的帧数
+    uint32_t reordered;         // 晚于更大序号到达的帧数
+    uint32_t dups;              // 重复的帧数
+    uint32_t elapsed_ms;        // 首帧到最近一帧的时长
+    uint32_t jitter_us;         // 到达间隔抖动 (RFC 3550 估计)
+    uint16_t frame_len;         // 最近一帧的长度
+} sle_cargo_bench_report_t;
+
+// 速率历史请求
+typedef struct {
+    uint8_t tier;               // sle_cargo_hist_tier_id_t
+    uint16_t buckets;           // 最多导出的桶数，0为全部
+} sle_cargo_hist_req_t;
+
+// 对时帧内容，各时刻为发出方/回复方各自的 osKernelGetTickCount
+typedef struct {
+    uint8_t flags;              // SLE_CARGO_CLOCK_PONG 表示回复
+    uint32_t t1;                // 请求方发出请求的时刻
+    uint32_t t2;                // 回复方收到请求的时刻
+    uint32_t t3;                // 回复方发出回复的时刻
+} sle_cargo_clock_msg_t;
+
+// 解码后的货物帧
+typedef struct {
+    sle_cargo_wire_t wire;          // 收到的编码格式
+    uint8_t type;                   // sle_cargo_frame_type_t，文本帧固定为快照
+    uint16_t seq;                   // 帧序号，文本帧无序号时为0
+    uint16_t base_seq;              // 增量帧所基于的已确认帧序号，快照帧等于seq
+    uint8_t mask;                   // 携带的字段，快照帧为 SLE_CARGO_FIELD_ALL
+    sle_cargo_snapshot_t snapshot;  // 快照内容，增量帧中未携带的字段为0
+    uint8_t event_count;            // 事件帧携带的事件数，其他帧为0
+    const uint8_t *events;          // 指向输入缓冲区中的事件记录，用 sle_cargo_event_get 读取
+    sle_cargo_ack_t ack;            // 确认帧内容
+    sle_cargo_frag_t frag;          // 分片帧内容
+    sle_cargo_bench_t bench;        // 压测帧内容
+    sle_cargo_bench_report_t bench_report; // 压测报告帧内容
+    sle_cargo_hist_req_t hist_req;  // 速率历史请求帧内容
+    sle_cargo_clock_msg_t clock;    // 对时帧内容
+} sle_cargo_frame_t;
+
+/**
+ * @brief  编码二进制快照帧
+ * @param  buf: 输出缓冲区
+ * @param  cap: 缓冲区容量
+ * @param  seq: 帧序号
+ * @param  snap: 快照内容
+ * @retval 帧长度，缓冲区不足时返回0
+ */
+uint16_t sle_cargo_encode_snapshot(uint8_t *buf, uint16_t cap, uint16_t seq, const sle_cargo_snapshot_t *snap);
+
+/**
+ * @brief  编码二进制增量帧，只携带 mask 中字段的绝对值
+ * @param  buf: 输出缓冲区
+ * @param  cap: 缓冲区容量
+ * @param  seq: 帧序号
+ * @param  base_seq: 增量所基于的已确认帧序号
+ * @param  mask: 携带的字段 (SLE_CARGO_FIELD_*)
+ * @param  snap: 当前计数
+ * @retval 帧长度，参数非法或缓冲区不足时返回0
+ */
+uint16_t sle_cargo_encode_delta(uint8_t *buf, uint16_t cap, uint16_t seq, uint16_t base_seq, uint8_t mask,
+                                const sle_cargo_snapshot_t *snap);
+
+/**
+ * @brief  编码二进制事件帧
+ * @param  buf: 输出缓冲区，容量至少 SLE_CARGO_HDR_LEN + 1 + count * SLE_CARGO_EVENT_LEN
+ * @param  cap: 缓冲区容量
+ * @param  seq: 帧序号
+ * @param  events: 事件数组
+ * @param  count: 事件数，1 ~ SLE_CARGO_EVENT_BATCH_MAX
+ * @retval 帧长度，参数非法或缓冲区不足时返回0
+ */
+uint16_t sle_cargo_encode_events(uint8_t *buf, uint16_t cap, uint16_t seq, const sle_cargo_event_t *events,
+                                 uint8_t count);
+
+/**
+ * @brief  编码二进制确认帧
+ * @param  buf: 输出缓冲区
+ * @param  cap: 缓冲区容量
+ * @param  seq: 帧序号
+ * @param  ack: 确认内容
+ * @retval 帧长度，缓冲区不足时返回0
+ */
+uint16_t sle_cargo_encode_ack(uint8_t *buf, uint16_t cap, uint16_t seq, const sle_cargo_ack_t *ack);
+
+/**
+ * @brief  编码一个分片帧
+ * @param  buf: 输出缓冲区，容量至少 SLE_CARGO_FRAG_HDR_LEN + frag->data_len
+ * @param  cap: 缓冲区容量
+ * @param  seq: 分片在消息中的序号
+ * @param  frag: 分片内容
+ * @retval 帧长度，参数非法或缓冲区不足时返回0
+ */
+uint16_t sle_cargo_encode_frag(uint8_t *buf, uint16_t cap, uint16_t seq, const sle_cargo_frag_t *frag);
+
+/**
+ * @brief  编码一个压测帧，帧头之后的部分用固定图样填充到 len
+ * @param  buf: 输出缓冲区
+ * @param  cap: 缓冲区容量
+ * @param  bench: 压测帧内容，len 不小于 SLE_CARGO_BENCH_HDR_LEN
+ * @retval 帧长度，参数非法或缓冲区不足时返回0
+ */
+uint16_t sle_cargo_encode_bench(uint8_t *buf, uint16_t cap, const sle_cargo_bench_t *bench);
+
+/**
+ * @brief  编码压测报告帧
+ * @param  buf: 输出缓冲区
+ * @param  cap: 缓冲区容量
+ * @param  seq: 帧序号
+ * @param  report: 压测结果
+ * @retval 帧长度，缓冲区不足时返回0
+ */
+uint16_t sle_cargo_encode_bench_report(uint8_t *buf, uint16_t cap, uint16_t seq,
+                                       const sle_cargo_bench_report_t *report);
+
+/**
+ * @brief  编码速率历史请求帧
+ * @param  buf: 输出缓冲区
+ * @param  cap: 缓冲区容量
+ * @param  seq: 帧序号
+ * @param  req: 请求内容
+ * @retval 帧长度，缓冲区不足时返回0
+ */
+uint16_t sle_cargo_encode_hist_req(uint8_t *buf, uint16_t cap, uint16_t seq, const sle_cargo_hist_req_t *req);
+
+/**
+ * @brief  编码对时帧
+ * @param  buf: 输出缓冲区
+ * @param  cap: 缓冲区容量
+ * @param  seq: 帧序号
+ * @param  msg: 对时内容
+ * @retval 帧长度，缓冲区不足时返回0
+ */
+uint16_t sle_cargo_encode_clock(uint8_t *buf, uint16_t cap, uint16_t seq, const sle_cargo_clock_msg_t *msg);
+
+/**
+ * @brief  不解码整帧，只取二进制帧的类型，供需要提前分流的接收路径使用
+ * @param  buf: 输入数据
+ * @param  len: 数据长度
+ * @retval 帧类型，非二进制帧返回0
+ */
+uint8_t sle_cargo_frame_type(const uint8_t *buf, uint16_t len);
+
+/**
+ * @brief  读取事件帧中的第 idx 条事件
+ * @note   frame 中的事件记录指向解码时的输入缓冲区，须在该缓冲区有效期间读取
+ * @param  frame: sle_cargo_decode 解码得到的事件帧
+ * @param  idx: 事件下标，小于 frame->event_count
+ * @param  event: 输出的事件
+ * @retval 是否读取成功
+ */
+bool sle_cargo_event_get(const sle_cargo_frame_t *frame, uint8_t idx, sle_cargo_event_t *event);
+
+/**
+ * @brief  解码一帧货物数据，二进制帧与旧版文本帧均可
+ * @note   直接在输入缓冲区上单遍扫描，不拷贝、不分配、不修改输入，可在多个回调中并发调用
+ * @param  buf: 输入数据 (如 write_cb_para->value 或 data->data)
+ * @param  len: 数据长度
+ * @param  frame: 输出的货物帧，仅在返回 SLE_CARGO_OK 时有效
+ * @retval 解码结果
+ */
+sle_cargo_err_t sle_cargo_decode(const uint8_t *buf, uint16_t len, sle_cargo_frame_t *frame);
+
+/**
+ * @brief  获取解码结果的描述字符串
+ * @param  err: 解码结果
+ * @retval 描述字符串
+ */
+const char *sle_cargo_err_str(sle_cargo_err_t err);
+
+/**
+ * @brief  判断数据是否为二进制帧 (文本帧首字节总是可打印字符)
+ * @param  buf: 输入数据
+ * @param  len: 数据长度
+ * @retval true=二进制帧
+ */
+bool sle_cargo_is_binary(const uint8_t *buf, uint16_t len);
+
+/**
+ * @brief  编码旧版文本帧 "J:xxx,Z:xxx,S:xxx,T:timestamp"
+ * @param  buf: 输出缓冲区
+ * @param  cap: 缓冲区容量
+ * @param  snap: 快照内容
+ * @retval 文本长度(不含结束符)，失败返回0
+ */
+uint16_t sle_cargo_encode_text(char *buf, uint16_t cap, const sle_cargo_snapshot_t *snap);
+
+/**
+ * @brief  在广播数据中追加协议能力字段，带本板的PHY能力位
+ * @param  buf: 广播数据缓冲区(从当前写入位置开始)
+ * @param  cap: 剩余容量
+ * @retval 写入的字节数，容量不足时返回0
+ */
+uint16_t sle_cargo_adv_put_proto(uint8_t *buf, uint16_t cap);
+
+/**
+ * @brief  从对端广播数据中查找协议能力字段，决定链路编码格式
+ * @param  data: 广播数据
+ * @param  len: 数据长度
+ * @retval 对端支持的编码格式，未找到时为旧版文本格式
+ */
+sle_cargo_wire_t sle_cargo_adv_find_proto(const uint8_t *data, uint16_t len);
+
+/**
+ * @brief  从对端广播数据的协议能力字段中读取PHY能力位
+ * @param  data: 广播数据
+ * @param  len: 数据长度
+ * @retval PHY能力位，字段不带能力位或未找到时为 SLE_CARGO_PHY_CAP_1M
+ */
+uint8_t sle_cargo_adv_find_phy_caps(const uint8_t *data, uint16_t len);
+
+/**
+ * @brief  在广播数据中追加16位服务UUID列表字段，只含货物服务
+ * @param  buf: 广播数据缓冲区(从当前写入位置开始)
+ * @param  cap: 剩余容量
+ * @retval 写入的字节数，容量不足时返回0
+ */
+uint16_t sle_cargo_adv_put_service(uint8_t *buf, uint16_t cap);
+
+/**
+ * @brief  在扫描响应数据中追加完整设备名称字段
+ * @param  buf: 扫描响应缓冲区(从当前写入位置开始)
+ * @param  cap: 剩余容量
+ * @retval 写入的字节数，容量不足时返回0
+ */
+uint16_t sle_cargo_adv_put_name(uint8_t *buf, uint16_t cap);
+
+/**
+ * @brief  判断广播或扫描响应数据是否来自货物服务器 (服务UUID或设备名称匹配)
+ * @param  data: 广播或扫描响应数据
+ * @param  len: 数据长度
+ * @retval 是否匹配
+ */
+bool sle_cargo_adv_match_server(const uint8_t *data, uint16_t len);
+
+#if SLE_CARGO_PROTO_BENCH
+/**
+ * @brief  在板上对比文本与二进制格式的空口字节数和编解码耗时，结果输出到日志；
+ *         编解码往返、随机语料和并发解码的校验见主机测试 sle_cargo_common/test
+ * @param  iterations: 每项测试的循环次数
+ */
+void sle_cargo_proto_bench(uint32_t iterations);
+#endif
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* __cplusplus */
+
+#endif /* SLE_CARGO_PROTO_H */
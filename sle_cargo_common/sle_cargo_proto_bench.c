@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2024 HiSilicon Technologies CO., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "sle_cargo_proto.h"
+
+#if SLE_CARGO_PROTO_BENCH
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "systick.h"
+
+// 旧版文本解析路径的参考实现: 拷贝到栈缓冲区 + strtok + atoi
+static bool bench_parse_text_legacy(const char *data, uint16_t len, sle_cargo_snapshot_t *snap)
+{
+    char buffer[256] = {0};
+    if (len >= sizeof(buffer)) {
+        len = sizeof(buffer) - 1;
+    }
+    memcpy(buffer, data, len);
+    buffer[len] = '\0';
+
+    int parsed_count = 0;
+    char *token = strtok(buffer, ",");
+    while (token != NULL && parsed_count < 4) {
+        if (strncmp(token, "J:", 2) == 0) {
+            snap->jiangsu = (uint32_t)atoi(token + 2);
+            parsed_count++;
+        } else if (strncmp(token, "Z:", 2) == 0) {
+            snap->zhejiang = (uint32_t)atoi(token + 2);
+            parsed_count++;
+        } else if (strncmp(token, "S:", 2) == 0) {
+            snap->shanghai = (uint32_t)atoi(token + 2);
+            parsed_count++;
+        } else if (strncmp(token, "T:", 2) == 0) {
+            snap->tick = (uint32_t)atoll(token + 2);
+            parsed_count++;
+        }
+        token = strtok(NULL, ",");
+    }
+    return parsed_count >= 3;
+}
+
+void sle_cargo_proto_bench(uint32_t iterations)
+{
+    // 使用典型的分拣现场计数，让文本长度接近实际
+    sle_cargo_snapshot_t snap = { 1234, 987, 2048, 3600000 };
+    sle_cargo_snapshot_t legacy = {0};
+    sle_cargo_frame_t frame;
+    char text[SLE_CARGO_TEXT_MAX_LEN] = {0};
+    uint8_t bin[SLE_CARGO_SNAPSHOT_LEN] = {0};
+    uint16_t text_len = 0;
+    uint16_t bin_len = 0;
+    uint32_t ok = 0;
+
+    if (iterations == 0) {
+        return;
+    }
+
+    uint64_t t0 = uapi_systick_get_us();
+    for (uint32_t i = 0; i < iterations; i++) {
+        snap.tick++;
+        text_len = sle_cargo_encode_text(text, sizeof(text), &snap);
+    }
+    uint64_t t1 = uapi_systick_get_us();
+    for (uint32_t i = 0; i < iterations; i++) {
+        ok += bench_parse_text_legacy(text, text_len, &legacy) ? 1 : 0;
+    }
+    uint64_t t2 = uapi_systick_get_us();
+    for (uint32_t i = 0; i < iterations; i++) {
+        ok += (sle_cargo_decode((const uint8_t *)text, text_len, &frame) == SLE_CARGO_OK) ? 1 : 0;
+    }
+    uint64_t t3 = uapi_systick_get_us();
+    for (uint32_t i = 0; i < iterations; i++) {
+        snap.tick++;
+        bin_len = sle_cargo_encode_snapshot(bin, sizeof(bin), (uint16_t)i, &snap);
+    }
+    uint64_t t4 = uapi_systick_get_us();
+    for (uint32_t i = 0; i < iterations; i++) {
+        ok += (sle_cargo_decode(bin, bin_len, &frame) == SLE_CARGO_OK) ? 1 : 0;
+    }
+    uint64_t t5 = uapi_systick_get_us();
+
+    // 耗时以每千次操作的微秒数输出，即单次操作的纳秒数
+    printf("[sle_cargo_bench] iterations=%u ok=%u/%u\r\n", iterations, ok, iterations * 3);
+    printf("[sle_cargo_bench] path            bytes  encode(ns/op)  decode(ns/op)\r\n");
+    printf("[sle_cargo_bench] text(strtok)    %5u  %13llu  %13llu\r\n", text_len,
+           (t1 - t0) * 1000 / iterations, (t2 - t1) * 1000 / iterations);
+    printf("[sle_cargo_bench] text(1-pass)    %5u  %13llu  %13llu\r\n", text_len,
+           (t1 - t0) * 1000 / iterations, (t3 - t2) * 1000 / iterations);
+    printf("[sle_cargo_bench] binary          %5u  %13llu  %13llu\r\n", bin_len,
+           (t4 - t3) * 1000 / iterations, (t5 - t4) * 1000 / iterations);
+}
+#endif
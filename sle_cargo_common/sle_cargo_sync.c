@@ -0,0 +1,268 @@
+/*
+ * Copyright (c) 2024 HiSilicon Technologies CO., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "sle_cargo_sync.h"
+#include <string.h>
+
+// 序号按16位回绕比较
+static int16_t seq_diff(uint16_t a, uint16_t b)
+{
+    return (int16_t)(uint16_t)(a - b);
+}
+
+// 与基准相比发生变化的字段
+static uint8_t diff_mask(const sle_cargo_snapshot_t *a, const sle_cargo_snapshot_t *b)
+{
+    uint8_t mask = 0;
+    if (a->jiangsu != b->jiangsu) {
+        mask |= SLE_CARGO_FIELD_JIANGSU;
+    }
+    if (a->zhejiang != b->zhejiang) {
+        mask |= SLE_CARGO_FIELD_ZHEJIANG;
+    }
+    if (a->shanghai != b->shanghai) {
+        mask |= SLE_CARGO_FIELD_SHANGHAI;
+    }
+    return mask;
+}
+
+void sle_cargo_tx_reset(sle_cargo_tx_t *tx)
+{
+    if (tx == NULL) {
+        return;
+    }
+    // 序号和统计跨连接保留，其余状态重新建立
+    tx->have_ack = false;
+    tx->force_key = true;
+    tx->have_sent = false;
+    tx->frames_since_key = 0;
+    tx->pending_head = 0;
+    tx->pending_count = 0;
+}
+
+uint16_t sle_cargo_tx_encode(sle_cargo_tx_t *tx, const sle_cargo_snapshot_t *cur, uint8_t *buf, uint16_t cap)
+{
+    if (tx == NULL || cur == NULL || buf == NULL || cap < SLE_CARGO_SNAPSHOT_LEN) {
+        return 0;
+    }
+
+    tx->bytes_full += SLE_CARGO_SNAPSHOT_LEN;
+
+    // 未确认帧过多时等待写确认，避免基准状态无法追踪
+    if (tx->pending_count >= SLE_CARGO_TX_UNACKED_MAX) {
+        tx->skipped++;
+        return 0;
+    }
+
+    bool changed = !tx->have_sent || diff_mask(cur, &tx->last_sent) != 0;
+    bool key = tx->force_key || (!tx->have_ack && tx->pending_count == 0) ||
+               tx->frames_since_key >= SLE_CARGO_KEYFRAME_INTERVAL ||
+               (uint32_t)(cur->tick - tx->last_key_tick) >= SLE_CARGO_KEYFRAME_MAX_MS;
+    if (!key && !changed) {
+        tx->skipped++;
+        return 0;
+    }
+    // 没有对端确认的基准时只能发关键帧
+    if (!tx->have_ack) {
+        key = true;
+    }
+
+    uint8_t mask = SLE_CARGO_FIELD_ALL;
+    uint16_t len;
+    uint16_t seq = tx->next_seq;
+    if (key) {
+        len = sle_cargo_encode_snapshot(buf, cap, seq, cur);
+    } else {
+        // 携带自确认基准以来变化过的全部字段(包括仍在途中的帧里的字段)，
+        // 对端只要持有基准状态，无论中间丢了哪一帧都能得到正确的绝对值
+        mask = diff_mask(cur, &tx->acked);
+        for (uint8_t i = 0; i < tx->pending_count; i++) {
+            mask |= tx->pending[(tx->pending_head + i) % SLE_CARGO_TX_UNACKED_MAX].mask;
+        }
+        len = sle_cargo_encode_delta(buf, cap, seq, tx->acked_seq, mask, cur);
+    }
+    if (len == 0) {
+        return 0;
+    }
+
+    sle_cargo_tx_pending_t *p = &tx->pending[(tx->pending_head + tx->pending_count) % SLE_CARGO_TX_UNACKED_MAX];
+    p->seq = seq;
+    p->mask = mask;
+    p->snap = *cur;
+    tx->pending_count++;
+
+    tx->next_seq++;
+    tx->last_sent = *cur;
+    tx->have_sent = true;
+    tx->bytes_sent += len;
+    if (key) {
+        tx->force_key = false;
+        tx->frames_since_key = 0;
+        tx->last_key_tick = cur->tick;
+        tx->key_frames++;
+    } else {
+        tx->frames_since_key++;
+        tx->delta_frames++;
+    }
+    return len;
+}
+
+void sle_cargo_tx_cancel(sle_cargo_tx_t *tx)
+{
+    if (tx == NULL || tx->pending_count == 0) {
+        return;
+    }
+    // 帧未发出: 丢弃记录并让下一次以关键帧重新发送，已消耗的序号在对端表现为一次缺口
+    tx->pending_count--;
+    tx->have_sent = false;
+    tx->force_key = true;
+}
+
+void sle_cargo_tx_request_keyframe(sle_cargo_tx_t *tx)
+{
+    if (tx == NULL) {
+        return;
+    }
+    tx->force_key = true;
+}
+
+void sle_cargo_tx_on_confirm(sle_cargo_tx_t *tx, bool success)
+{
+    if (tx == NULL || tx->pending_count == 0) {
+        return;
+    }
+
+    sle_cargo_tx_pending_t *p = &tx->pending[tx->pending_head];
+    tx->pending_head = (tx->pending_head + 1) % SLE_CARGO_TX_UNACKED_MAX;
+    tx->pending_count--;
+
+    if (success) {
+        tx->acked = p->snap;
+        tx->acked_seq = p->seq;
+        tx->have_ack = true;
+    } else {
+        // 对端可能没收到这一帧，用关键帧重新对齐
+        tx->force_key = true;
+    }
+}
+
+void sle_cargo_rx_reset(sle_cargo_rx_t *rx)
+{
+    if (rx == NULL) {
+        return;
+    }
+    memset(rx, 0, sizeof(*rx));
+}
+
+// 逐条计入事件帧，返回结果同 sle_cargo_rx_apply
+static sle_cargo_rx_result_t rx_apply_events(sle_cargo_rx_t *rx, const sle_cargo_frame_t *frame)
+{
+    // 事件编号以累计总数为基准，必须先有关键帧
+    if (!rx->synced) {
+        rx->dropped++;
+        return SLE_CARGO_RX_NEED_KEYFRAME;
+    }
+
+    sle_cargo_rx_result_t result = SLE_CARGO_RX_STALE;
+    sle_cargo_event_t ev;
+    for (uint8_t i = 0; sle_cargo_event_get(frame, i, &ev); i++) {
+        uint16_t expect = (uint16_t)(rx->state.jiangsu + rx->state.zhejiang + rx->state.shanghai + 1);
+        int16_t d = seq_diff(ev.no, expect);
+        if (d < 0) {
+            rx->event_dups++;
+            continue;
+        }
+        if (d > 0) {
+            // 中间的事件丢失: 不猜测缺失件的去向，剩余事件也无法对齐，等快照或增量帧补齐
+            rx->event_gaps++;
+            return SLE_CARGO_RX_NEED_KEYFRAME;
+        }
+        switch (ev.region & ~SLE_CARGO_EVENT_NO_ID) {
+            case SLE_CARGO_REGION_JIANGSU:
+                rx->state.jiangsu++;
+                break;
+            case SLE_CARGO_REGION_ZHEJIANG:
+                rx->state.zhejiang++;
+                break;
+            default:
+                rx->state.shanghai++;
+                break;
+        }
+        rx->state.tick = ev.tick;
+        rx->last_event = ev;
+        rx->events++;
+        result = SLE_CARGO_RX_APPLIED;
+    }
+    return result;
+}
+
+sle_cargo_rx_result_t sle_cargo_rx_apply(sle_cargo_rx_t *rx, const sle_cargo_frame_t *frame)
+{
+    if (rx == NULL || frame == NULL) {
+        return SLE_CARGO_RX_STALE;
+    }
+
+    if (frame->type == SLE_CARGO_FRAME_SNAPSHOT) {
+        // 关键帧总是覆盖本地状态；旧版文本帧没有序号，不参与缺口检测
+        if (frame->wire == SLE_CARGO_WIRE_BINARY) {
+            if (rx->synced && seq_diff(frame->seq, rx->last_seq) > 1) {
+                rx->gaps++;
+            }
+            rx->last_seq = frame->seq;
+        }
+        rx->state = frame->snapshot;
+        rx->synced = true;
+        rx->frames++;
+        return SLE_CARGO_RX_APPLIED;
+    }
+
+    if (frame->type == SLE_CARGO_FRAME_EVENTS) {
+        return rx_apply_events(rx, frame);
+    }
+
+    if (frame->type != SLE_CARGO_FRAME_DELTA) {
+        return SLE_CARGO_RX_STALE;
+    }
+
+    // 增量基于一个本端还没应用过的帧: 本地状态已不可信，等待关键帧
+    if (!rx->synced || seq_diff(frame->base_seq, rx->last_seq) > 0) {
+        rx->synced = false;
+        rx->dropped++;
+        return SLE_CARGO_RX_NEED_KEYFRAME;
+    }
+
+    int16_t d = seq_diff(frame->seq, rx->last_seq);
+    if (d <= 0) {
+        rx->stale++;
+        return SLE_CARGO_RX_STALE;
+    }
+    if (d > 1) {
+        rx->gaps++;
+    }
+
+    if (frame->mask & SLE_CARGO_FIELD_JIANGSU) {
+        rx->state.jiangsu = frame->snapshot.jiangsu;
+    }
+    if (frame->mask & SLE_CARGO_FIELD_ZHEJIANG) {
+        rx->state.zhejiang = frame->snapshot.zhejiang;
+    }
+    if (frame->mask & SLE_CARGO_FIELD_SHANGHAI) {
+        rx->state.shanghai = frame->snapshot.shanghai;
+    }
+    rx->state.tick = frame->snapshot.tick;
+    rx->last_seq = frame->seq;
+    rx->frames++;
+    return SLE_CARGO_RX_APPLIED;
+}
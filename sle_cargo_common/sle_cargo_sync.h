@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2024 HiSilicon Technologies CO., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SLE_CARGO_SYNC_H
+#define SLE_CARGO_SYNC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sle_cargo_proto.h"
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+#endif /* __cplusplus */
+
+// 关键帧策略: 每发送N帧或空闲超过指定时间插入一个完整快照
+#define SLE_CARGO_KEYFRAME_INTERVAL     10
+#define SLE_CARGO_KEYFRAME_MAX_MS       10000
+
+// 发送端记录的未确认帧数
+#define SLE_CARGO_TX_UNACKED_MAX        4
+
+// 已发出、等待确认的帧
+typedef struct {
+    uint16_t seq;
+    uint8_t mask;
+    sle_cargo_snapshot_t snap;
+} sle_cargo_tx_pending_t;
+
+// 发送端状态: 序号、已确认基准、关键帧计时，每条链路一份
+typedef struct {
+    uint16_t next_seq;
+    bool have_ack;                      // 是否已有对端确认的基准状态
+    bool force_key;                     // 下一帧强制发送关键帧
+    bool have_sent;
+    uint16_t acked_seq;
+    sle_cargo_snapshot_t acked;         // 对端确认的最新状态
+    sle_cargo_snapshot_t last_sent;     // 最近一次发出的状态
+    uint16_t frames_since_key;
+    uint32_t last_key_tick;
+    sle_cargo_tx_pending_t pending[SLE_CARGO_TX_UNACKED_MAX];
+    uint8_t pending_head;
+    uint8_t pending_count;
+    // 统计: 实际发送字节数与每次都发完整快照时的字节数对比
+    uint32_t key_frames;
+    uint32_t delta_frames;
+    uint32_t skipped;
+    uint32_t bytes_sent;
+    uint32_t bytes_full;
+} sle_cargo_tx_t;
+
+// 接收端处理结果
+typedef enum {
+    SLE_CARGO_RX_APPLIED = 0,       // 已更新状态
+    SLE_CARGO_RX_STALE,             // 重复或过期的帧，已忽略
+    SLE_CARGO_RX_NEED_KEYFRAME,     // 缺少增量所依赖的基准状态，等待关键帧
+} sle_cargo_rx_result_t;
+
+// 接收端状态: 由关键帧和增量帧重建的累计计数
+typedef struct {
+    sle_cargo_snapshot_t state;
+    bool synced;                    // 是否已从关键帧建立基准
+    uint16_t last_seq;              // 最近应用的帧序号
+    uint32_t frames;
+    uint32_t gaps;                  // 序号不连续的次数
+    uint32_t stale;
+    uint32_t dropped;               // 未同步时丢弃的增量帧和事件帧
+    // 逐件事件: 编号等于累计总数+1时才计入，重复或乱序的事件不会重复计数
+    uint32_t events;                // 已计入的事件数
+    uint32_t event_dups;            // 已由快照或先前事件计入而忽略的事件
+    uint32_t event_gaps;            // 编号跳跃的次数，缺失的件数由下一个快照/增量帧补齐
+    sle_cargo_event_t last_event;   // 最近计入的事件
+} sle_cargo_rx_t;
+
+/**
+ * @brief  复位发送端，下一帧为关键帧 (建立连接或重连时调用)
+ * @param  tx: 发送端状态
+ */
+void sle_cargo_tx_reset(sle_cargo_tx_t *tx);
+
+/**
+ * @brief  根据当前计数生成下一帧: 关键帧、增量帧，或无变化时不发送
+ * @param  tx: 发送端状态
+ * @param  cur: 当前计数，tick 用于关键帧计时
+ * @param  buf: 输出缓冲区，容量至少 SLE_CARGO_SNAPSHOT_LEN
+ * @param  cap: 缓冲区容量
+ * @retval 帧长度，返回0表示本次无需发送
+ */
+uint16_t sle_cargo_tx_encode(sle_cargo_tx_t *tx, const sle_cargo_snapshot_t *cur, uint8_t *buf, uint16_t cap);
+
+/**
+ * @brief  撤销最近一次 sle_cargo_tx_encode 生成的帧 (提交写请求失败时调用)
+ * @param  tx: 发送端状态
+ */
+void sle_cargo_tx_cancel(sle_cargo_tx_t *tx);
+
+/**
+ * @brief  下一帧强制发送关键帧 (对端回报缺少基准时调用)
+ * @param  tx: 发送端状态
+ */
+void sle_cargo_tx_request_keyframe(sle_cargo_tx_t *tx);
+
+/**
+ * @brief  处理最早一个未确认帧的写确认
+ * @param  tx: 发送端状态
+ * @param  success: 对端是否成功收到
+ */
+void sle_cargo_tx_on_confirm(sle_cargo_tx_t *tx, bool success);
+
+/**
+ * @brief  复位接收端，等待下一个关键帧
+ * @param  rx: 接收端状态
+ */
+void sle_cargo_rx_reset(sle_cargo_rx_t *rx);
+
+/**
+ * @brief  将一帧应用到接收端状态，检测序号缺口
+ * @note   事件帧按事件编号幂等计入: 重复收到同一事件或事件已包含在快照中时不会重复计数
+ * @param  rx: 接收端状态
+ * @param  frame: 已解码的帧
+ * @retval 处理结果
+ */
+sle_cargo_rx_result_t sle_cargo_rx_apply(sle_cargo_rx_t *rx, const sle_cargo_frame_t *frame);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* __cplusplus */
+
+#endif /* SLE_CARGO_SYNC_H */
@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2024 HiSilicon Technologies CO., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "sle_cargo_telemetry.h"
+#include <stdio.h>
+#include <string.h>
+
+void sle_cargo_telem_init(sle_cargo_telem_t *t, uint32_t now)
+{
+    if (t == NULL) {
+        return;
+    }
+    memset(t, 0, sizeof(*t));
+    t->link_state = SLE_CARGO_LINK_IDLE;
+    t->link_tick = now;
+}
+
+void sle_cargo_telem_rssi(sle_cargo_telem_t *t, int8_t rssi)
+{
+    if (t == NULL) {
+        return;
+    }
+    int32_t sample = (int32_t)rssi * SLE_CARGO_TELEM_RSSI_SCALE;
+    if (t->rssi_samples == 0) {
+        t->rssi_min = rssi;
+        t->rssi_max = rssi;
+        t->rssi_avg_q = sample;
+    } else {
+        t->rssi_min = (rssi < t->rssi_min) ? rssi : t->rssi_min;
+        t->rssi_max = (rssi > t->rssi_max) ? rssi : t->rssi_max;
+        t->rssi_avg_q += (sample - t->rssi_avg_q) / SLE_CARGO_TELEM_RSSI_WEIGHT;
+    }
+    t->rssi_last = rssi;
+    t->rssi_samples++;
+}
+
+int8_t sle_cargo_telem_rssi_avg(const sle_cargo_telem_t *t)
+{
+    if (t == NULL || t->rssi_samples == 0) {
+        return 0;
+    }
+    return (int8_t)(t->rssi_avg_q / SLE_CARGO_TELEM_RSSI_SCALE);
+}
+
+void sle_cargo_telem_issued(sle_cargo_telem_t *t)
+{
+    if (t != NULL) {
+        t->issued++;
+    }
+}
+
+uint8_t sle_cargo_telem_lat_bucket(uint32_t latency_us)
+{
+    // 按最高位定档，最多移位16次
+    uint8_t bucket = 0;
+    uint32_t v = latency_us >> SLE_CARGO_TELEM_LAT_BASE_SHIFT;
+    while (v != 0 && bucket < SLE_CARGO_TELEM_LAT_BUCKETS - 1) {
+        v >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+uint32_t sle_cargo_telem_lat_bound_us(uint8_t bucket)
+{
+    if (bucket >= SLE_CARGO_TELEM_LAT_BUCKETS - 1) {
+        return UINT32_MAX;
+    }
+    return 1UL << (SLE_CARGO_TELEM_LAT_BASE_SHIFT + bucket);
+}
+
+void sle_cargo_telem_confirmed(sle_cargo_telem_t *t, bool success, uint32_t latency_us)
+{
+    if (t == NULL) {
+        return;
+    }
+    if (success) {
+        t->confirmed++;
+    } else {
+        t->failed++;
+    }
+    t->lat_hist[sle_cargo_telem_lat_bucket(latency_us)]++;
+    if (latency_us > t->lat_max_us) {
+        t->lat_max_us = latency_us;
+    }
+}
+
+uint32_t sle_cargo_telem_hist_percentile(const uint32_t *hist, uint32_t count, uint32_t max_us, uint8_t pct)
+{
+    if (hist == NULL || count == 0) {
+        return 0;
+    }
+
+    // 第一个累计数达到 count*pct/100 (向上取整) 的档位
+    uint32_t rank = (uint32_t)(((uint64_t)count * pct + 99) / 100);
+    uint32_t seen = 0;
+    for (uint8_t i = 0; i < SLE_CARGO_TELEM_LAT_BUCKETS; i++) {
+        seen += hist[i];
+        if (seen >= rank && seen > 0) {
+            uint32_t bound = sle_cargo_telem_lat_bound_us(i);
+            return (bound < max_us) ? bound : max_us;
+        }
+    }
+    return max_us;
+}
+
+uint32_t sle_cargo_telem_lat_percentile(const sle_cargo_telem_t *t, uint8_t pct)
+{
+    if (t == NULL) {
+        return 0;
+    }
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < SLE_CARGO_TELEM_LAT_BUCKETS; i++) {
+        total += t->lat_hist[i];
+    }
+    return sle_cargo_telem_hist_percentile(t->lat_hist, total, t->lat_max_us, pct);
+}
+
+void sle_cargo_telem_connected(sle_cargo_telem_t *t)
+{
+    if (t != NULL) {
+        t->connects++;
+    }
+}
+
+void sle_cargo_telem_disconnected(sle_cargo_telem_t *t, uint8_t reason)
+{
+    if (t == NULL) {
+        return;
+    }
+    t->disconnects++;
+    for (uint8_t i = 0; i < t->disc_kinds; i++) {
+        if (t->disc[i].reason == reason) {
+            t->disc[i].count++;
+            return;
+        }
+    }
+    if (t->disc_kinds < SLE_CARGO_TELEM_DISC_REASONS) {
+        t->disc[t->disc_kinds].reason = reason;
+        t->disc[t->disc_kinds].count = 1;
+        t->disc_kinds++;
+        return;
+    }
+    t->disc_other++;
+}
+
+void sle_cargo_telem_set_link(sle_cargo_telem_t *t, uint8_t state, uint32_t now)
+{
+    if (t == NULL || state >= SLE_CARGO_LINK_STATE_MAX || state == t->link_state) {
+        return;
+    }
+    t->link_ms[t->link_state] += now - t->link_tick;
+    t->link_state = state;
+    t->link_tick = now;
+}
+
+uint32_t sle_cargo_telem_link_ms(const sle_cargo_telem_t *t, uint8_t state, uint32_t now)
+{
+    if (t == NULL || state >= SLE_CARGO_LINK_STATE_MAX) {
+        return 0;
+    }
+    uint32_t ms = t->link_ms[state];
+    if (state == t->link_state) {
+        ms += now - t->link_tick;
+    }
+    return ms;
+}
+
+uint16_t sle_cargo_telem_format(const sle_cargo_telem_t *t, uint32_t now, char *buf, uint16_t cap)
+{
+    if (t == NULL || buf == NULL || cap == 0) {
+        return 0;
+    }
+
+    uint32_t up = sle_cargo_telem_link_ms(t, SLE_CARGO_LINK_CONNECTED, now) / 1000;
+    uint32_t search = sle_cargo_telem_link_ms(t, SLE_CARGO_LINK_SEARCHING, now) / 1000;
+    int len = snprintf(buf, cap, "rssi=%d avg=%d min=%d max=%d n=%u req=%u ok=%u fail=%u "
+                       "lat_p50=%u lat_p99=%u lat_max=%u conn=%u disc=%u up=%us search=%us",
+                       t->rssi_last, sle_cargo_telem_rssi_avg(t), t->rssi_min, t->rssi_max, t->rssi_samples,
+                       t->issued, t->confirmed, t->failed, sle_cargo_telem_lat_percentile(t, 50),
+                       sle_cargo_telem_lat_percentile(t, 99), t->lat_max_us, t->connects, t->disconnects, up, search);
+
+    // 断开原因和直方图各档计数
+    for (uint8_t i = 0; i < t->disc_kinds && len > 0 && len < cap; i++) {
+        len += snprintf(buf + len, cap - len, "%s0x%02x:%u", (i == 0) ? " reasons=" : ",", t->disc[i].reason,
+                        t->disc[i].count);
+    }
+    if (t->disc_other > 0 && len > 0 && len < cap) {
+        len += snprintf(buf + len, cap - len, ",other:%u", t->disc_other);
+    }
+    for (uint8_t i = 0; i < SLE_CARGO_TELEM_LAT_BUCKETS && len > 0 && len < cap; i++) {
+        len += snprintf(buf + len, cap - len, "%s%u", (i == 0) ? " hist=" : ",", t->lat_hist[i]);
+    }
+    if (len < 0) {
+        buf[0] = '\0';
+        return 0;
+    }
+    return (uint16_t)((len < cap) ? len : cap - 1);
+}
@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2024 HiSilicon Technologies CO., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SLE_CARGO_TELEMETRY_H
+#define SLE_CARGO_TELEMETRY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+#endif /* __cplusplus */
+
+// 时延直方图: 第0档 < 128us，第k档 [2^(k+6), 2^(k+7)) us，最后一档收纳其余 (>= 约2s)
+#define SLE_CARGO_TELEM_LAT_BUCKETS     16
+#define SLE_CARGO_TELEM_LAT_BASE_SHIFT  7
+
+// 分别计数的断开原因种数，其余计入 disc_other
+#define SLE_CARGO_TELEM_DISC_REASONS    6
+
+// RSSI滑动平均: 新样本权重 1/8，平均值按 1/16 dBm 定点保存
+#define SLE_CARGO_TELEM_RSSI_WEIGHT     8
+#define SLE_CARGO_TELEM_RSSI_SCALE      16
+
+// sle_cargo_telem_format 输出一行所需的缓冲区长度
+#define SLE_CARGO_TELEM_LINE_LEN        384
+
+// 链路状态，用于统计已连接与寻找中的时长
+typedef enum {
+    SLE_CARGO_LINK_IDLE = 0,
+    SLE_CARGO_LINK_SEARCHING,               // 未连接，正在扫描或广播
+    SLE_CARGO_LINK_CONNECTED,               // 至少一条链路已连接
+    SLE_CARGO_LINK_STATE_MAX,
+} sle_cargo_link_state_t;
+
+// 一种断开原因 (sle_disc_reason_t) 的次数
+typedef struct {
+    uint8_t reason;
+    uint32_t count;
+} sle_cargo_disc_count_t;
+
+// 一块板的链路遥测: 每次更新只做常数次加减，可常开
+typedef struct {
+    // RSSI
+    uint32_t rssi_samples;
+    int8_t rssi_last;
+    int8_t rssi_min;
+    int8_t rssi_max;
+    int32_t rssi_avg_q;                     // 滑动平均 x SLE_CARGO_TELEM_RSSI_SCALE
+    // 请求到确认的时延
+    uint32_t lat_hist[SLE_CARGO_TELEM_LAT_BUCKETS];
+    uint32_t lat_max_us;
+    // 请求计数
+    uint32_t issued;
+    uint32_t confirmed;
+    uint32_t failed;
+    // 连接与断开
+    uint32_t connects;
+    uint32_t disconnects;
+    sle_cargo_disc_count_t disc[SLE_CARGO_TELEM_DISC_REASONS];
+    uint8_t disc_kinds;
+    uint32_t disc_other;
+    // 各链路状态的累计时长，当前状态的时长在查询时补上
+    uint8_t link_state;
+    uint32_t link_tick;
+    uint32_t link_ms[SLE_CARGO_LINK_STATE_MAX];
+} sle_cargo_telem_t;
+
+/**
+ * @brief  清空遥测，从空闲状态开始计时
+ * @param  t: 遥测
+ * @param  now: 当前时刻(ms)
+ */
+void sle_cargo_telem_init(sle_cargo_telem_t *t, uint32_t now);
+
+/**
+ * @brief  记录一次RSSI读数
+ * @param  t: 遥测
+ * @param  rssi: 读数(dBm)
+ */
+void sle_cargo_telem_rssi(sle_cargo_telem_t *t, int8_t rssi);
+
+/**
+ * @brief  RSSI滑动平均
+ * @param  t: 遥测
+ * @retval 平均值(dBm)，没有样本时返回0
+ */
+int8_t sle_cargo_telem_rssi_avg(const sle_cargo_telem_t *t);
+
+/**
+ * @brief  记录发出一个需要确认的请求
+ * @param  t: 遥测
+ */
+void sle_cargo_telem_issued(sle_cargo_telem_t *t);
+
+/**
+ * @brief  记录一次确认及其时延
+ * @param  t: 遥测
+ * @param  success: 是否成功
+ * @param  latency_us: 请求到确认的时延
+ */
+void sle_cargo_telem_confirmed(sle_cargo_telem_t *t, bool success, uint32_t latency_us);
+
+/**
+ * @brief  时延所在的直方图档位
+ * @param  latency_us: 时延
+ * @retval 档位，0 ~ SLE_CARGO_TELEM_LAT_BUCKETS-1
+ */
+uint8_t sle_cargo_telem_lat_bucket(uint32_t latency_us);
+
+/**
+ * @brief  直方图档位的上界
+ * @param  bucket: 档位
+ * @retval 上界(us)，最后一档返回 UINT32_MAX
+ */
+uint32_t sle_cargo_telem_lat_bound_us(uint8_t bucket);
+
+/**
+ * @brief  按任意一份时延直方图估计分位数，遥测和单向时延共用
+ * @param  hist: 直方图，SLE_CARGO_TELEM_LAT_BUCKETS 档
+ * @param  count: 样本总数
+ * @param  max_us: 记录到的最大值
+ * @param  pct: 分位 (1~100)
+ * @retval 该分位所在档位的上界(us)，不超过 max_us；没有样本时返回0
+ */
+uint32_t sle_cargo_telem_hist_percentile(const uint32_t *hist, uint32_t count, uint32_t max_us, uint8_t pct);
+
+/**
+ * @brief  按直方图估计时延分位数
+ * @param  t: 遥测
+ * @param  pct: 分位 (1~100)
+ * @retval 该分位所在档位的上界(us)，最后一档返回记录到的最大值；没有样本时返回0
+ */
+uint32_t sle_cargo_telem_lat_percentile(const sle_cargo_telem_t *t, uint8_t pct);
+
+/**
+ * @brief  记录一次连接建立
+ * @param  t: 遥测
+ */
+void sle_cargo_telem_connected(sle_cargo_telem_t *t);
+
+/**
+ * @brief  按原因记录一次断开
+ * @param  t: 遥测
+ * @param  reason: 断开原因 (sle_disc_reason_t)
+ */
+void sle_cargo_telem_disconnected(sle_cargo_telem_t *t, uint8_t reason);
+
+/**
+ * @brief  切换链路状态，上一状态的时长计入累计
+ * @param  t: 遥测
+ * @param  state: 新状态 (sle_cargo_link_state_t)
+ * @param  now: 当前时刻(ms)
+ */
+void sle_cargo_telem_set_link(sle_cargo_telem_t *t, uint8_t state, uint32_t now);
+
+/**
+ * @brief  某个链路状态的累计时长，包含当前仍在持续的时长
+ * @param  t: 遥测
+ * @param  state: 链路状态
+ * @param  now: 当前时刻(ms)
+ * @retval 累计时长(ms)
+ */
+uint32_t sle_cargo_telem_link_ms(const sle_cargo_telem_t *t, uint8_t state, uint32_t now);
+
+/**
+ * @brief  格式化为一行文本，用于日志和远程查询
+ * @param  t: 遥测
+ * @param  now: 当前时刻(ms)
+ * @param  buf: 输出缓冲区
+ * @param  cap: 缓冲区容量
+ * @retval 写入的长度(不含结尾的'\0')
+ */
+uint16_t sle_cargo_telem_format(const sle_cargo_telem_t *t, uint32_t now, char *buf, uint16_t cap);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* __cplusplus */
+
+#endif /* SLE_CARGO_TELEMETRY_H */
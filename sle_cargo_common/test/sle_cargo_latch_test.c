@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2024 HiSilicon Technologies CO., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// sle_cargo_latch 主机压力测试: 一个写者和若干读者各占一个线程在多核上紧密循环，
+// 校验每次读到的快照字段一致、代数与内容相符且不倒退。板上任务只在tick边界被抢占，
+// 读写不会真正并行，序号锁的竞争窗口只能在主机多核上覆盖
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "sle_cargo_latch.h"
+
+#define TEST_WORDS          32          // 快照大小，拷贝越长竞争窗口越大
+#define TEST_WRITES         2000000
+#define TEST_READERS_MAX    8
+
+typedef struct {
+    uint32_t word[TEST_WORDS];
+} test_view_t;
+
+typedef struct {
+    pthread_t thread;
+    uint32_t reads;
+    uint32_t fails;                     // 重读次数用尽，不算错误
+    uint32_t torn;
+    uint32_t backwards;
+    uint32_t mismatch;                  // 代数与内容不符
+} test_reader_t;
+
+static test_view_t g_copy[2];
+static sle_cargo_latch_t g_latch;
+static volatile bool g_stop = false;
+static uint32_t g_writes = TEST_WRITES;
+
+// 第n次发布的快照: 每个字段都由n推出
+static void test_fill(test_view_t *view, uint32_t n)
+{
+    for (uint32_t i = 0; i < TEST_WORDS; i++) {
+        view->word[i] = n * (i + 1) + i;
+    }
+}
+
+static bool test_check(const test_view_t *view, uint32_t *n)
+{
+    *n = view->word[0];
+    for (uint32_t i = 1; i < TEST_WORDS; i++) {
+        if (view->word[i] != *n * (i + 1) + i) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void *test_writer(void *arg)
+{
+    (void)arg;
+    test_view_t next;
+    for (uint32_t n = 1; n <= g_writes; n++) {
+        test_fill(&next, n);
+        sle_cargo_latch_publish(&g_latch, &next);
+    }
+    __atomic_store_n(&g_stop, true, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void *test_reader(void *arg)
+{
+    test_reader_t *r = (test_reader_t *)arg;
+    test_view_t view;
+    uint32_t last = 0;
+    while (!__atomic_load_n(&g_stop, __ATOMIC_ACQUIRE)) {
+        uint32_t gen = 0;
+        uint32_t n = 0;
+        r->reads++;
+        if (!sle_cargo_latch_read(&g_latch, &view, &gen)) {
+            r->fails++;
+            continue;
+        }
+        if (!test_check(&view, &n)) {
+            r->torn++;
+        } else if (n != gen) {
+            r->mismatch++;
+        }
+        if (gen < last) {
+            r->backwards++;
+        }
+        last = gen;
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    uint32_t readers = (cpus > 2) ? (uint32_t)(cpus - 1) : 2;
+    if (argc > 1) {
+        readers = (uint32_t)atoi(argv[1]);
+    }
+    if (argc > 2) {
+        g_writes = (uint32_t)atoi(argv[2]);
+    }
+    if (readers == 0 || readers > TEST_READERS_MAX) {
+        readers = TEST_READERS_MAX;
+    }
+
+    test_view_t initial;
+    test_fill(&initial, 0);
+    sle_cargo_latch_init(&g_latch, &g_copy[0], &g_copy[1], sizeof(test_view_t), &initial);
+
+    static test_reader_t r[TEST_READERS_MAX];
+    pthread_t writer;
+    for (uint32_t i = 0; i < readers; i++) {
+        pthread_create(&r[i].thread, NULL, test_reader, &r[i]);
+    }
+    pthread_create(&writer, NULL, test_writer, NULL);
+    pthread_join(writer, NULL);
+
+    uint32_t errors = 0;
+    for (uint32_t i = 0; i < readers; i++) {
+        pthread_join(r[i].thread, NULL);
+        printf("[latch_test] reader%u reads=%u fails=%u torn=%u mismatch=%u backwards=%u\n", i, r[i].reads,
+               r[i].fails, r[i].torn, r[i].mismatch, r[i].backwards);
+        errors += r[i].torn + r[i].mismatch + r[i].backwards;
+    }
+    uint32_t gen = sle_cargo_latch_generation(&g_latch);
+    printf("[latch_test] cpus=%ld readers=%u writes=%u generation=%u retries=%u %s\n", cpus, readers, g_writes, gen,
+           g_latch.retries, (errors == 0 && gen == g_writes) ? "PASS" : "FAIL");
+    return (errors == 0 && gen == g_writes) ? 0 : 1;
+}
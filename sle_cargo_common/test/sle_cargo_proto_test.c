@@ -0,0 +1,378 @@
+/*
+ * Copyright (c) 2024 HiSilicon Technologies CO., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// sle_cargo_proto 主机测试: 各类二进制帧与文本帧的编解码往返、随机语料的解码结果、
+// 多线程并发解码的一致性，以及编解码耗时。板上的 SLE_CARGO_PROTO_BENCH 只保留 systick 计时对比
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <time.h>
+#include "sle_cargo_proto.h"
+#include "sle_cargo_rand.h"
+
+#define TEST_ROUNDTRIPS         10000
+#define TEST_CORPUS_SIZE        64
+#define TEST_FRAME_MAX          48
+#define TEST_THREADS            4
+#define TEST_THREAD_ROUNDS      2000
+#define TEST_BENCH_ITERATIONS   1000000
+
+// 随机语料条目，expect 为预期解码结果
+typedef struct {
+    uint8_t data[TEST_FRAME_MAX];
+    uint16_t len;
+    sle_cargo_err_t expect;
+    sle_cargo_snapshot_t snap;
+} test_case_t;
+
+static test_case_t g_corpus[TEST_CORPUS_SIZE];
+static uint32_t g_rand_state = 0x20250601;
+static uint32_t g_fail = 0;
+
+// 固定初值，保证每次运行语料一致
+static uint32_t test_rand(void)
+{
+    return sle_cargo_rand(&g_rand_state);
+}
+
+static uint64_t test_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+#define TEST_EXPECT(cond, ...) do { \
+        if (!(cond)) { \
+            g_fail++; \
+            printf("[proto_test] FAIL %s:%d: ", __func__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+        } \
+    } while (0)
+
+static void test_random_snapshot(sle_cargo_snapshot_t *snap)
+{
+    // 高位也要覆盖到，避免只测到小数值
+    snap->jiangsu = test_rand() ^ (test_rand() << 16);
+    snap->zhejiang = test_rand() ^ (test_rand() << 16);
+    snap->shanghai = test_rand() ^ (test_rand() << 16);
+    snap->tick = test_rand() ^ (test_rand() << 16);
+}
+
+static void test_roundtrip_snapshot(void)
+{
+    uint8_t buf[SLE_CARGO_SNAPSHOT_LEN];
+    sle_cargo_frame_t frame;
+    for (uint32_t i = 0; i < TEST_ROUNDTRIPS; i++) {
+        sle_cargo_snapshot_t snap;
+        test_random_snapshot(&snap);
+        uint16_t len = sle_cargo_encode_snapshot(buf, sizeof(buf), (uint16_t)i, &snap);
+        sle_cargo_err_t err = sle_cargo_decode(buf, len, &frame);
+        TEST_EXPECT(len == SLE_CARGO_SNAPSHOT_LEN && err == SLE_CARGO_OK, "len=%u err=%s", len, sle_cargo_err_str(err));
+        TEST_EXPECT(frame.type == SLE_CARGO_FRAME_SNAPSHOT && frame.seq == (uint16_t)i &&
+                    frame.mask == SLE_CARGO_FIELD_ALL && memcmp(&frame.snapshot, &snap, sizeof(snap)) == 0,
+                    "round %u", i);
+    }
+    TEST_EXPECT(sle_cargo_encode_snapshot(buf, SLE_CARGO_SNAPSHOT_LEN - 1, 0, &g_corpus[0].snap) == 0,
+                "short buffer accepted");
+}
+
+static void test_roundtrip_delta(void)
+{
+    uint8_t buf[SLE_CARGO_DELTA_MAX_LEN];
+    sle_cargo_frame_t frame;
+    for (uint32_t i = 0; i < TEST_ROUNDTRIPS; i++) {
+        sle_cargo_snapshot_t snap;
+        test_random_snapshot(&snap);
+        uint8_t mask = (uint8_t)(1 + i % SLE_CARGO_FIELD_ALL);
+        uint16_t len = sle_cargo_encode_delta(buf, sizeof(buf), (uint16_t)i, (uint16_t)(i - 3), mask, &snap);
+        sle_cargo_err_t err = sle_cargo_decode(buf, len, &frame);
+        TEST_EXPECT(len != 0 && err == SLE_CARGO_OK, "mask=0x%x err=%s", mask, sle_cargo_err_str(err));
+        TEST_EXPECT(frame.type == SLE_CARGO_FRAME_DELTA && frame.seq == (uint16_t)i &&
+                    frame.base_seq == (uint16_t)(i - 3) && frame.mask == mask, "round %u", i);
+        TEST_EXPECT(frame.snapshot.jiangsu == ((mask & SLE_CARGO_FIELD_JIANGSU) ? snap.jiangsu : 0) &&
+                    frame.snapshot.zhejiang == ((mask & SLE_CARGO_FIELD_ZHEJIANG) ? snap.zhejiang : 0) &&
+                    frame.snapshot.shanghai == ((mask & SLE_CARGO_FIELD_SHANGHAI) ? snap.shanghai : 0) &&
+                    frame.snapshot.tick == snap.tick, "round %u mask=0x%x", i, mask);
+    }
+}
+
+static void test_roundtrip_events(void)
+{
+    uint8_t buf[SLE_CARGO_EVENTS_MAX_LEN];
+    sle_cargo_event_t events[SLE_CARGO_EVENT_BATCH_MAX];
+    sle_cargo_frame_t frame;
+    for (uint32_t i = 0; i < TEST_ROUNDTRIPS; i++) {
+        uint8_t count = (uint8_t)(1 + i % SLE_CARGO_EVENT_BATCH_MAX);
+        for (uint8_t k = 0; k < count; k++) {
+            events[k].no = (uint16_t)(i + k);
+            events[k].item_id = (uint8_t)test_rand();
+            events[k].region = (uint8_t)(test_rand() % SLE_CARGO_REGION_MAX);
+            if ((k & 3) == 0) {
+                events[k].region |= SLE_CARGO_EVENT_NO_ID;
+            }
+            events[k].tick = test_rand();
+        }
+        uint16_t len = sle_cargo_encode_events(buf, sizeof(buf), (uint16_t)i, events, count);
+        sle_cargo_err_t err = sle_cargo_decode(buf, len, &frame);
+        TEST_EXPECT(len != 0 && err == SLE_CARGO_OK && frame.type == SLE_CARGO_FRAME_EVENTS &&
+                    frame.event_count == count, "count=%u err=%s", count, sle_cargo_err_str(err));
+        for (uint8_t k = 0; k < frame.event_count; k++) {
+            sle_cargo_event_t ev;
+            TEST_EXPECT(sle_cargo_event_get(&frame, k, &ev) && ev.no == events[k].no &&
+                        ev.item_id == events[k].item_id && ev.region == events[k].region &&
+                        ev.tick == events[k].tick, "round %u event %u", i, k);
+        }
+    }
+    TEST_EXPECT(sle_cargo_encode_events(buf, sizeof(buf), 0, events, 0) == 0, "empty batch accepted");
+    TEST_EXPECT(sle_cargo_encode_events(buf, sizeof(buf), 0, events, SLE_CARGO_EVENT_BATCH_MAX + 1) == 0,
+                "oversized batch accepted");
+}
+
+static void test_roundtrip_ack_clock(void)
+{
+    uint8_t buf[SLE_CARGO_ACK_LEN > SLE_CARGO_CLOCK_LEN ? SLE_CARGO_ACK_LEN : SLE_CARGO_CLOCK_LEN];
+    sle_cargo_frame_t frame;
+    for (uint32_t i = 0; i < TEST_ROUNDTRIPS; i++) {
+        sle_cargo_ack_t ack = { (uint16_t)test_rand(), test_rand(), (uint8_t)test_rand(), (uint16_t)test_rand(),
+                                test_rand() };
+        uint16_t len = sle_cargo_encode_ack(buf, sizeof(buf), (uint16_t)i, &ack);
+        sle_cargo_err_t err = sle_cargo_decode(buf, len, &frame);
+        TEST_EXPECT(len == SLE_CARGO_ACK_LEN && err == SLE_CARGO_OK && frame.type == SLE_CARGO_FRAME_ACK &&
+                    frame.ack.last_seq == ack.last_seq && frame.ack.total == ack.total &&
+                    frame.ack.flags == ack.flags && frame.ack.display_lag_ms == ack.display_lag_ms &&
+                    frame.ack.echo_tick == ack.echo_tick, "ack round %u", i);
+
+        sle_cargo_clock_msg_t msg = { (uint8_t)(i & SLE_CARGO_CLOCK_PONG), test_rand(), test_rand(), test_rand() };
+        len = sle_cargo_encode_clock(buf, sizeof(buf), (uint16_t)i, &msg);
+        err = sle_cargo_decode(buf, len, &frame);
+        TEST_EXPECT(len == SLE_CARGO_CLOCK_LEN && err == SLE_CARGO_OK && frame.type == SLE_CARGO_FRAME_CLOCK &&
+                    frame.clock.flags == msg.flags && frame.clock.t1 == msg.t1 && frame.clock.t2 == msg.t2 &&
+                    frame.clock.t3 == msg.t3, "clock round %u", i);
+    }
+}
+
+static void test_roundtrip_text(void)
+{
+    char text[SLE_CARGO_TEXT_MAX_LEN];
+    sle_cargo_frame_t frame;
+    for (uint32_t i = 0; i < TEST_ROUNDTRIPS; i++) {
+        sle_cargo_snapshot_t snap;
+        test_random_snapshot(&snap);
+        uint16_t len = sle_cargo_encode_text(text, sizeof(text), &snap);
+        sle_cargo_err_t err = sle_cargo_decode((const uint8_t *)text, len, &frame);
+        TEST_EXPECT(len != 0 && err == SLE_CARGO_OK && frame.wire == SLE_CARGO_WIRE_TEXT &&
+                    memcmp(&frame.snapshot, &snap, sizeof(snap)) == 0, "round %u \"%.*s\" err=%s", i, len, text,
+                    sle_cargo_err_str(err));
+    }
+}
+
+// 按随机字段顺序生成文本帧，with_tick 为 false 时省略T字段
+static uint16_t test_make_text(test_case_t *c, bool with_tick)
+{
+    static const char keys[4] = { 'J', 'Z', 'S', 'T' };
+    uint32_t values[4] = { c->snap.jiangsu, c->snap.zhejiang, c->snap.shanghai, c->snap.tick };
+    uint8_t order[4] = { 0, 1, 2, 3 };
+    uint8_t count = with_tick ? 4 : 3;
+    int len = 0;
+
+    for (uint8_t i = count - 1; i > 0; i--) {
+        uint8_t j = (uint8_t)(test_rand() % (i + 1));
+        uint8_t tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        len += snprintf((char *)&c->data[len], sizeof(c->data) - len, "%s%c:%u",
+                        (i == 0) ? "" : ",", keys[order[i]], values[order[i]]);
+    }
+    if (!with_tick) {
+        c->snap.tick = 0;
+    }
+    return (uint16_t)len;
+}
+
+static void test_build_corpus(void)
+{
+    for (uint32_t i = 0; i < TEST_CORPUS_SIZE; i++) {
+        test_case_t *c = &g_corpus[i];
+        memset(c, 0, sizeof(*c));
+        c->snap.jiangsu = test_rand() % 100000;
+        c->snap.zhejiang = test_rand() % 100000;
+        c->snap.shanghai = test_rand() % 100000;
+        c->snap.tick = test_rand();
+        c->expect = SLE_CARGO_OK;
+
+        switch (i % 8) {
+            case 0:
+                c->len = test_make_text(c, true);
+                break;
+            case 1:
+                c->len = test_make_text(c, false);
+                break;
+            case 2:
+                c->len = sle_cargo_encode_snapshot(c->data, sizeof(c->data), (uint16_t)i, &c->snap);
+                break;
+            case 3:
+                // 超出32位的计数，旧解析器会静默截断
+                c->len = (uint16_t)snprintf((char *)c->data, sizeof(c->data), "J:%u%u,Z:1,S:2",
+                                            4294967U + test_rand() % 1000, 296 + test_rand() % 700);
+                c->expect = SLE_CARGO_ERR_OVERFLOW;
+                break;
+            case 4:
+                c->len = (uint16_t)snprintf((char *)c->data, sizeof(c->data), "J:%u,Z:%u,J:%u,S:%u",
+                                            c->snap.jiangsu, c->snap.zhejiang, c->snap.jiangsu, c->snap.shanghai);
+                c->expect = SLE_CARGO_ERR_DUP_KEY;
+                break;
+            case 5:
+                c->len = (uint16_t)snprintf((char *)c->data, sizeof(c->data), "J:%u,X:%u,S:%u",
+                                            c->snap.jiangsu, c->snap.zhejiang, c->snap.shanghai);
+                c->expect = SLE_CARGO_ERR_KEY;
+                break;
+            case 6:
+                c->len = sle_cargo_encode_snapshot(c->data, sizeof(c->data), (uint16_t)i, &c->snap);
+                c->len = (uint16_t)(test_rand() % c->len);
+                c->expect = (c->len == 0) ? SLE_CARGO_ERR_EMPTY : SLE_CARGO_ERR_TRUNCATED;
+                break;
+            default: {
+                // 随机翻转一个字节，预期结果由单线程解码确定，用于多线程一致性检查
+                sle_cargo_frame_t frame;
+                c->len = test_make_text(c, true);
+                c->data[test_rand() % c->len] = (uint8_t)test_rand();
+                c->expect = sle_cargo_decode(c->data, c->len, &frame);
+                if (c->expect == SLE_CARGO_OK) {
+                    c->snap = frame.snapshot;
+                }
+                break;
+            }
+        }
+    }
+}
+
+static bool test_check_case(const test_case_t *c)
+{
+    sle_cargo_frame_t frame;
+    sle_cargo_err_t err = sle_cargo_decode(c->data, c->len, &frame);
+    if (err != c->expect) {
+        return false;
+    }
+    if (err == SLE_CARGO_OK && memcmp(&frame.snapshot, &c->snap, sizeof(c->snap)) != 0) {
+        return false;
+    }
+    return true;
+}
+
+static void test_corpus(void)
+{
+    test_build_corpus();
+    for (uint32_t i = 0; i < TEST_CORPUS_SIZE; i++) {
+        TEST_EXPECT(test_check_case(&g_corpus[i]), "corpus case %u, expect=%s", i,
+                    sle_cargo_err_str(g_corpus[i].expect));
+    }
+}
+
+// 多个线程同时解码同一份语料，模拟多个星闪回调并发进入解码器
+static void *test_decode_thread(void *arg)
+{
+    uint32_t *mismatch = (uint32_t *)arg;
+    for (uint32_t round = 0; round < TEST_THREAD_ROUNDS; round++) {
+        for (uint32_t i = 0; i < TEST_CORPUS_SIZE; i++) {
+            *mismatch += test_check_case(&g_corpus[i]) ? 0 : 1;
+        }
+    }
+    return NULL;
+}
+
+static void test_concurrent_decode(void)
+{
+    pthread_t threads[TEST_THREADS];
+    uint32_t mismatch[TEST_THREADS] = {0};
+    for (uint32_t i = 0; i < TEST_THREADS; i++) {
+        pthread_create(&threads[i], NULL, test_decode_thread, &mismatch[i]);
+    }
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < TEST_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+        total += mismatch[i];
+    }
+    TEST_EXPECT(total == 0, "concurrent decode: threads=%u rounds=%u mismatch=%u", TEST_THREADS,
+                TEST_THREAD_ROUNDS, total);
+}
+
+// 主机上的编解码耗时，只作为相对参考；板上的绝对耗时见 SLE_CARGO_PROTO_BENCH
+static void test_bench(uint32_t iterations)
+{
+    sle_cargo_snapshot_t snap = { 1234, 987, 2048, 3600000 };
+    sle_cargo_frame_t frame;
+    char text[SLE_CARGO_TEXT_MAX_LEN] = {0};
+    uint8_t bin[SLE_CARGO_SNAPSHOT_LEN] = {0};
+    uint16_t text_len = 0;
+    uint16_t bin_len = 0;
+    uint32_t ok = 0;
+    volatile uint8_t sink = 0;              // 防止编码循环被优化掉
+
+    uint64_t t0 = test_now_ns();
+    for (uint32_t i = 0; i < iterations; i++) {
+        snap.tick++;
+        text_len = sle_cargo_encode_text(text, sizeof(text), &snap);
+        sink = (uint8_t)text[text_len - 1];
+    }
+    uint64_t t1 = test_now_ns();
+    for (uint32_t i = 0; i < iterations; i++) {
+        ok += (sle_cargo_decode((const uint8_t *)text, text_len, &frame) == SLE_CARGO_OK) ? 1 : 0;
+    }
+    uint64_t t2 = test_now_ns();
+    for (uint32_t i = 0; i < iterations; i++) {
+        snap.tick++;
+        bin_len = sle_cargo_encode_snapshot(bin, sizeof(bin), (uint16_t)i, &snap);
+        sink = bin[bin_len - 1];
+    }
+    uint64_t t3 = test_now_ns();
+    for (uint32_t i = 0; i < iterations; i++) {
+        ok += (sle_cargo_decode(bin, bin_len, &frame) == SLE_CARGO_OK) ? 1 : 0;
+    }
+    uint64_t t4 = test_now_ns();
+
+    (void)sink;
+    TEST_EXPECT(ok == iterations * 2, "bench decode ok=%u/%u", ok, iterations * 2);
+    printf("[proto_test] path      bytes  encode(ns/op)  decode(ns/op)\n");
+    printf("[proto_test] text      %5u  %13llu  %13llu\n", text_len,
+           (unsigned long long)((t1 - t0) / iterations), (unsigned long long)((t2 - t1) / iterations));
+    printf("[proto_test] binary    %5u  %13llu  %13llu\n", bin_len,
+           (unsigned long long)((t3 - t2) / iterations), (unsigned long long)((t4 - t3) / iterations));
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t iterations = (argc > 1) ? (uint32_t)atoi(argv[1]) : TEST_BENCH_ITERATIONS;
+
+    test_corpus();
+    test_roundtrip_snapshot();
+    test_roundtrip_delta();
+    test_roundtrip_events();
+    test_roundtrip_ack_clock();
+    test_roundtrip_text();
+    test_concurrent_decode();
+    if (iterations > 0) {
+        test_bench(iterations);
+    }
+    printf("[proto_test] %s, failures=%u\n", (g_fail == 0) ? "PASS" : "FAIL", g_fail);
+    return (g_fail == 0) ? 0 : 1;
+}